@@ -0,0 +1,35 @@
+
+# Zero-copy reader for the model's columnar output files (summary_X.wbc, output_X.wbc).
+# See src/columnar_file.cpp for the layout.
+
+import struct
+import numpy as np
+
+PREAMBLE = struct.Struct('<8sIIQI')
+ENTRY = struct.Struct('<64s8sII4QQQ')
+
+
+def load_columns(path):
+    """Return a dict of column name -> read-only numpy.memmap for a columnar output file."""
+    with open(path, 'rb') as f:
+        magic, version, num_columns, directory_offset, entry_size = PREAMBLE.unpack(f.read(PREAMBLE.size))
+        if magic != b'WBCOLUMN' or version != 1 or entry_size != ENTRY.size:
+            raise ValueError(path + ' is not a columnar output file')
+        f.seek(directory_offset)
+        directory = f.read(num_columns * ENTRY.size)
+    columns = {}
+    for c in range(num_columns):
+        name, dtype, ndim, _, s0, s1, s2, s3, offset, byte_length = ENTRY.unpack_from(directory, c * ENTRY.size)
+        name = name.rstrip(b'\0').decode()
+        shape = (s0, s1, s2, s3)[:ndim]
+        if byte_length == 0:
+            columns[name] = np.empty(shape, dtype=dtype.rstrip(b'\0').decode())
+        else:
+            columns[name] = np.memmap(path, dtype=dtype.rstrip(b'\0').decode(), mode='r', offset=offset, shape=shape)
+    return columns
+
+
+if __name__ == '__main__':
+    import sys
+    for name, values in load_columns(sys.argv[1]).items():
+        print(name, values.dtype, values.shape)
@@ -0,0 +1,239 @@
+#include "columnar_file.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char COLUMNAR_MAGIC[8] = {'W', 'B', 'C', 'O', 'L', 'U', 'M', 'N'};
+constexpr uint32_t COLUMNAR_VERSION = 1;
+constexpr size_t COLUMNAR_PREAMBLE_SIZE = 64;
+// Columns start on cache-line boundaries
+constexpr size_t COLUMNAR_ALIGNMENT = 64;
+constexpr size_t MAX_COLUMN_NAME = 64;
+constexpr size_t MAX_COLUMN_DIMS = 4;
+
+/*
+* File layout (little-endian):
+*   preamble (64 bytes): magic, version, numColumns, directoryOffset, entrySize
+*   column data, each column starting on a 64-byte boundary
+*   ColumnEntry[numColumns] at directoryOffset
+*/
+typedef struct ColumnarPreamble {
+    char magic[8];
+    uint32_t version;
+    uint32_t numColumns;
+    uint64_t directoryOffset;
+    uint32_t entrySize;
+    uint32_t reserved;
+} ColumnarPreamble;
+
+// 128 bytes; the name is NUL-padded and the unused shape entries are zero
+typedef struct ColumnEntry {
+    char name[MAX_COLUMN_NAME];
+    char dtype[8];
+    uint32_t ndim;
+    uint32_t reserved;
+    uint64_t shape[MAX_COLUMN_DIMS];
+    uint64_t offset;
+    uint64_t byteLength;
+} ColumnEntry;
+
+static_assert(sizeof(ColumnEntry) == 128, "ColumnEntry must be packed to 128 bytes");
+
+ColumnarWriter::ColumnarWriter(const std::string &path)
+    : path(path), out(path, std::ios::binary | std::ios::trunc), position(0), columnOpen(false), closed(false),
+      pendingElements(0), pendingElementSize(0)
+{
+    if (!this->out) {
+        throw std::runtime_error("Unable to write columnar file " + path);
+    }
+    // Placeholder until close() knows where the directory is
+    const char zeros[COLUMNAR_PREAMBLE_SIZE] = {0};
+    this->out.write(zeros, COLUMNAR_PREAMBLE_SIZE);
+    this->position = COLUMNAR_PREAMBLE_SIZE;
+}
+
+ColumnarWriter::~ColumnarWriter() {
+    if (!this->closed) {
+        try {
+            this->close();
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+}
+
+void ColumnarWriter::pad() {
+    const char zeros[COLUMNAR_ALIGNMENT] = {0};
+    size_t padding = (COLUMNAR_ALIGNMENT - this->position % COLUMNAR_ALIGNMENT) % COLUMNAR_ALIGNMENT;
+    this->out.write(zeros, padding);
+    this->position += padding;
+}
+
+void ColumnarWriter::beginColumnRaw(const std::string &name, const std::vector<uint64_t> &shape, const char *dtype, size_t elementSize) {
+    if (this->columnOpen || this->closed) {
+        throw std::runtime_error("Columnar file " + this->path + ": column " + name + " started while another is open");
+    }
+    if (name.empty() || name.size() >= MAX_COLUMN_NAME || shape.size() > MAX_COLUMN_DIMS) {
+        throw std::runtime_error("Columnar file " + this->path + ": invalid name or shape for column " + name);
+    }
+    this->pad();
+    size_t count = 1;
+    for (uint64_t dim : shape) {
+        count *= dim;
+    }
+    this->columns.push_back(ColumnInfo{name, dtype, shape, this->position, (uint64_t) (count * elementSize)});
+    this->pendingElements = count;
+    this->pendingElementSize = elementSize;
+    this->columnOpen = true;
+}
+
+void ColumnarWriter::appendRaw(const void *data, size_t count, const char *dtype) {
+    if (!this->columnOpen || this->columns.back().dtype != dtype) {
+        throw std::runtime_error("Columnar file " + this->path + ": values appended without a matching open column");
+    }
+    if (count > this->pendingElements) {
+        throw std::runtime_error("Columnar file " + this->path + ": too many values for column " + this->columns.back().name);
+    }
+    this->out.write(static_cast<const char *>(data), count * this->pendingElementSize);
+    this->position += count * this->pendingElementSize;
+    this->pendingElements -= count;
+}
+
+void ColumnarWriter::endColumn() {
+    if (!this->columnOpen) {
+        return;
+    }
+    this->columnOpen = false;
+    if (this->pendingElements != 0) {
+        throw std::runtime_error("Columnar file " + this->path + ": too few values for column " + this->columns.back().name);
+    }
+    if (!this->out) {
+        throw std::runtime_error("Unable to write columnar file " + this->path);
+    }
+}
+
+void ColumnarWriter::close() {
+    if (this->closed) {
+        return;
+    }
+    this->closed = true;
+    if (this->columnOpen) {
+        throw std::runtime_error("Columnar file " + this->path + ": closed with column " + this->columns.back().name + " unfinished");
+    }
+    this->pad();
+    ColumnarPreamble preamble;
+    std::memset(&preamble, 0, sizeof(preamble));
+    std::memcpy(preamble.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    preamble.version = COLUMNAR_VERSION;
+    preamble.numColumns = (uint32_t) this->columns.size();
+    preamble.directoryOffset = this->position;
+    preamble.entrySize = sizeof(ColumnEntry);
+    for (const ColumnInfo &info : this->columns) {
+        ColumnEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        std::memcpy(entry.name, info.name.data(), info.name.size());
+        std::memcpy(entry.dtype, info.dtype.data(), std::min(info.dtype.size(), sizeof(entry.dtype)));
+        entry.ndim = (uint32_t) info.shape.size();
+        for (size_t d = 0; d < info.shape.size(); ++d) {
+            entry.shape[d] = info.shape[d];
+        }
+        entry.offset = info.offset;
+        entry.byteLength = info.byteLength;
+        this->out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    }
+    char preambleBytes[COLUMNAR_PREAMBLE_SIZE] = {0};
+    std::memcpy(preambleBytes, &preamble, sizeof(preamble));
+    this->out.seekp(0);
+    this->out.write(preambleBytes, COLUMNAR_PREAMBLE_SIZE);
+    this->out.close();
+    if (!this->out) {
+        throw std::runtime_error("Unable to write columnar file " + this->path);
+    }
+}
+
+bool ColumnarReader::isColumnarFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(COLUMNAR_MAGIC)];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) == 0;
+}
+
+ColumnarReader::ColumnarReader(const std::string &path)
+    : fd(-1), mapping(nullptr), mappingSize(0)
+{
+    this->fd = open(path.c_str(), O_RDONLY);
+    if (this->fd == -1) {
+        throw std::runtime_error("Unable to open columnar file " + path);
+    }
+    struct stat info;
+    if (fstat(this->fd, &info) != 0 || (size_t) info.st_size < COLUMNAR_PREAMBLE_SIZE) {
+        close(this->fd);
+        throw std::runtime_error("Invalid columnar file " + path);
+    }
+    this->mappingSize = (size_t) info.st_size;
+    this->mapping = mmap(nullptr, this->mappingSize, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (this->mapping == MAP_FAILED) {
+        close(this->fd);
+        throw std::runtime_error("Unable to map columnar file " + path);
+    }
+    const char *base = static_cast<const char *>(this->mapping);
+    ColumnarPreamble preamble;
+    std::memcpy(&preamble, base, sizeof(preamble));
+    bool valid = std::memcmp(preamble.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) == 0
+        && preamble.version == COLUMNAR_VERSION
+        && preamble.entrySize == sizeof(ColumnEntry)
+        && preamble.directoryOffset <= this->mappingSize
+        && (this->mappingSize - preamble.directoryOffset) / sizeof(ColumnEntry) >= preamble.numColumns;
+    for (uint32_t c = 0; valid && c < preamble.numColumns; ++c) {
+        ColumnEntry entry;
+        std::memcpy(&entry, base + preamble.directoryOffset + c * sizeof(ColumnEntry), sizeof(entry));
+        if (entry.ndim > MAX_COLUMN_DIMS || entry.offset > this->mappingSize || entry.byteLength > this->mappingSize - entry.offset) {
+            valid = false;
+            break;
+        }
+        ColumnInfo column;
+        column.name = std::string(entry.name, strnlen(entry.name, sizeof(entry.name)));
+        column.dtype = std::string(entry.dtype, strnlen(entry.dtype, sizeof(entry.dtype)));
+        column.shape.assign(entry.shape, entry.shape + entry.ndim);
+        column.offset = entry.offset;
+        column.byteLength = entry.byteLength;
+        this->columns.push_back(column);
+    }
+    if (!valid) {
+        munmap(this->mapping, this->mappingSize);
+        close(this->fd);
+        throw std::runtime_error("Invalid columnar file " + path);
+    }
+}
+
+ColumnarReader::~ColumnarReader() {
+    munmap(this->mapping, this->mappingSize);
+    close(this->fd);
+}
+
+const ColumnInfo *ColumnarReader::findColumn(const std::string &name) const {
+    for (const ColumnInfo &column : this->columns) {
+        if (column.name == name) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+const void *ColumnarReader::getColumnRaw(const std::string &name, const char *dtype) const {
+    const ColumnInfo *column = this->findColumn(name);
+    if (column == nullptr) {
+        throw std::runtime_error("No column named " + name);
+    }
+    if (column->dtype != dtype) {
+        throw std::runtime_error("Column " + name + " holds " + column->dtype + ", not " + dtype);
+    }
+    return static_cast<const char *>(this->mapping) + column->offset;
+}
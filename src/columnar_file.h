@@ -0,0 +1,139 @@
+#ifndef __FISH_COLUMNAR_FILE_H
+#define __FISH_COLUMNAR_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Element types a column can hold, with their numpy type strings (native little-endian layout)
+template <typename T> struct ColumnDtype;
+template <> struct ColumnDtype<int32_t> { static constexpr const char *name = "<i4"; };
+template <> struct ColumnDtype<int64_t> { static constexpr const char *name = "<i8"; };
+template <> struct ColumnDtype<uint32_t> { static constexpr const char *name = "<u4"; };
+template <> struct ColumnDtype<float> { static constexpr const char *name = "<f4"; };
+template <> struct ColumnDtype<double> { static constexpr const char *name = "<f8"; };
+
+// Directory entry for one column
+typedef struct ColumnInfo {
+    std::string name;
+    std::string dtype;
+    // Row-major (C order) dimensions; empty for a scalar
+    std::vector<uint64_t> shape;
+    // Byte offset of the first element from the start of the file (a multiple of 64)
+    uint64_t offset;
+    uint64_t byteLength;
+} ColumnInfo;
+
+/*
+* Writes a columnar output file: a fixed 64-byte preamble, then each column's raw values
+* starting on a 64-byte boundary, then a directory of fixed-size entries (name, numpy dtype,
+* shape, offset) that the preamble points to. Each column can be read zero-copy with
+* numpy.memmap(path, dtype, mode='r', offset=offset, shape=shape); see columnar_output.py.
+*
+* Columns are written one after another and can be streamed in pieces (beginColumn/append/
+* endColumn), so callers only ever stage a small chunk of values. The directory goes at the
+* end because column sizes aren't known up front; the file is invalid until close().
+*/
+class ColumnarWriter {
+public:
+    // Values staged per chunk by writeColumnFrom
+    static constexpr size_t CHUNK_ELEMENTS = 16384;
+
+    // Create (or replace) the file; throws std::runtime_error if it can't be opened
+    explicit ColumnarWriter(const std::string &path);
+    // Closes the file if close() wasn't called (errors are only logged)
+    ~ColumnarWriter();
+    ColumnarWriter(const ColumnarWriter &) = delete;
+    ColumnarWriter &operator=(const ColumnarWriter &) = delete;
+
+    // Write a whole column from contiguous memory
+    template <typename T>
+    void writeColumn(const std::string &name, const std::vector<uint64_t> &shape, const T *data) {
+        this->beginColumn<T>(name, shape);
+        this->append(data, this->pendingElements);
+        this->endColumn();
+    }
+
+    // Write a column whose i-th element (in C order) is get(i), staging CHUNK_ELEMENTS values at a time
+    template <typename T, typename Getter>
+    void writeColumnFrom(const std::string &name, const std::vector<uint64_t> &shape, Getter get) {
+        this->beginColumn<T>(name, shape);
+        const size_t count = this->pendingElements;
+        std::vector<T> chunk(std::min(count, CHUNK_ELEMENTS));
+        for (size_t start = 0; start < count; start += chunk.size()) {
+            size_t len = std::min(chunk.size(), count - start);
+            for (size_t i = 0; i < len; ++i) {
+                chunk[i] = get(start + i);
+            }
+            this->append(chunk.data(), len);
+        }
+        this->endColumn();
+    }
+
+    // Start a column of the given shape; its values are then supplied in order by append()
+    template <typename T>
+    void beginColumn(const std::string &name, const std::vector<uint64_t> &shape) {
+        this->beginColumnRaw(name, shape, ColumnDtype<T>::name, sizeof(T));
+    }
+    template <typename T>
+    void append(const T *data, size_t count) {
+        this->appendRaw(data, count, ColumnDtype<T>::name);
+    }
+    // Finish the current column; throws if fewer or more values were appended than its shape holds
+    void endColumn();
+
+    // Write the directory and preamble; throws std::runtime_error on I/O errors
+    void close();
+
+private:
+    void beginColumnRaw(const std::string &name, const std::vector<uint64_t> &shape, const char *dtype, size_t elementSize);
+    void appendRaw(const void *data, size_t count, const char *dtype);
+    void pad();
+
+    std::string path;
+    std::ofstream out;
+    uint64_t position;
+    bool columnOpen;
+    bool closed;
+    size_t pendingElements;
+    size_t pendingElementSize;
+    std::vector<ColumnInfo> columns;
+};
+
+/*
+* Read-only, memory-mapped view of a file written by ColumnarWriter
+*/
+class ColumnarReader {
+public:
+    // Whether path names a columnar output file
+    static bool isColumnarFile(const std::string &path);
+
+    // Map an existing file; throws std::runtime_error if it's missing or malformed
+    explicit ColumnarReader(const std::string &path);
+    ~ColumnarReader();
+    ColumnarReader(const ColumnarReader &) = delete;
+    ColumnarReader &operator=(const ColumnarReader &) = delete;
+
+    const std::vector<ColumnInfo> &getColumns() const { return columns; }
+    // nullptr if there's no column with that name
+    const ColumnInfo *findColumn(const std::string &name) const;
+
+    // Values of a column; throws std::runtime_error if it's missing or T doesn't match its dtype
+    template <typename T>
+    const T *getColumn(const std::string &name) const {
+        return static_cast<const T *>(this->getColumnRaw(name, ColumnDtype<T>::name));
+    }
+
+private:
+    const void *getColumnRaw(const std::string &name, const char *dtype) const;
+
+    int fd;
+    void *mapping;
+    size_t mappingSize;
+    std::vector<ColumnInfo> columns;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "density_propagation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include "fish.h"
+#include "fish_movement_downstream.h"
+#include "model.h"
+
+size_t TransitionMatrix::findRow(const MapNode *origin) const {
+    auto it = std::lower_bound(this->origins.begin(), this->origins.end(), origin,
+                               [](const MapNode *a, const MapNode *b) { return a->id < b->id; });
+    if (it == this->origins.end() || *it != origin) {
+        return this->origins.size();
+    }
+    return (size_t) (it - this->origins.begin());
+}
+
+DensityPropagation::DensityPropagation(float classWidth) : classWidth(classWidth), indexedMap(nullptr) {
+    if (classWidth <= 0.0f) {
+        throw std::runtime_error("Density propagation size class width must be positive");
+    }
+}
+
+float DensityPropagation::getClassWidth() const {
+    return this->classWidth;
+}
+
+size_t DensityPropagation::sizeClass(float forkLength) const {
+    return (size_t) std::max(0.0f, std::floor(forkLength / this->classWidth));
+}
+
+float DensityPropagation::classForkLength(size_t sizeClass) const {
+    return ((float) sizeClass + 0.5f) * this->classWidth;
+}
+
+// Fill one class's matrix with a row per origin
+static void buildMatrix(Model &model, float forkLength, const std::unordered_map<const MapNode *, size_t> &mapIndices,
+                        TransitionMatrix &matrix) {
+    float swimSpeed = swimSpeedFromForkLength(forkLength);
+    float swimRange = swimSpeed*model.getSecondsPerTimestep();
+    FishMovementDownstream movement(model, swimSpeed, swimRange);
+    matrix.rowStart.clear();
+    matrix.destinations.clear();
+    matrix.destinationIndices.clear();
+    matrix.probabilities.clear();
+    matrix.costs.clear();
+    matrix.rowStart.push_back(0);
+    for (MapNode *origin : matrix.origins) {
+        for (const Destination &d : movement.getDestinationDistribution(origin, DENSITY_COST_BINS)) {
+            matrix.destinations.push_back(d.node);
+            matrix.destinationIndices.push_back(mapIndices.at(d.node));
+            matrix.probabilities.push_back(d.probability);
+            matrix.costs.push_back(d.cost);
+        }
+        matrix.rowStart.push_back(matrix.destinations.size());
+    }
+}
+
+void DensityPropagation::build(Model &model, std::vector<std::vector<MapNode *>> &origins, size_t maxThreads) {
+    if (this->indexedMap != model.map.data() || this->mapIndices.size() != model.map.size()) {
+        this->mapIndices.clear();
+        for (size_t i = 0; i < model.map.size(); ++i) {
+            this->mapIndices[model.map[i]] = i;
+        }
+        this->indexedMap = model.map.data();
+    }
+    this->matrices.resize(origins.size());
+    std::vector<size_t> work;
+    for (size_t c = 0; c < origins.size(); ++c) {
+        std::vector<MapNode *> &classOrigins = origins[c];
+        std::sort(classOrigins.begin(), classOrigins.end(),
+                  [](const MapNode *a, const MapNode *b) { return a->id < b->id; });
+        classOrigins.erase(std::unique(classOrigins.begin(), classOrigins.end()), classOrigins.end());
+        this->matrices[c].origins = classOrigins;
+        if (!classOrigins.empty()) {
+            work.push_back(c);
+        }
+    }
+    // Classes differ a lot in how many locations they cover, so threads take them one at a time
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < work.size(); i = next++) {
+            buildMatrix(model, this->classForkLength(work[i]), this->mapIndices, this->matrices[work[i]]);
+        }
+    };
+    size_t numThreads = std::max((size_t) 1, std::min(maxThreads, work.size()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &t : threads) {
+        t.join();
+    }
+}
+
+const TransitionMatrix &DensityPropagation::getMatrix(size_t sizeClass) const {
+    return this->matrices.at(sizeClass);
+}
+
+void DensityPropagation::propagate(const TransitionMatrix &matrix, const std::vector<double> &density,
+                                   size_t channels, std::vector<double> &out, std::vector<size_t> &touched) {
+    const size_t stride = channels + 1;
+    for (size_t i = 0; i < matrix.origins.size(); ++i) {
+        const double *x = &density[i * channels];
+        if (x[0] <= 0.0) {
+            continue;
+        }
+        for (size_t k = matrix.rowStart[i]; k < matrix.rowStart[i + 1]; ++k) {
+            const size_t j = matrix.destinationIndices[k];
+            const double p = matrix.probabilities[k];
+            double *y = &out[j * stride];
+            if (y[0] == 0.0) {
+                touched.push_back(j);
+            }
+            for (size_t c = 0; c < channels; ++c) {
+                y[c] += x[c] * p;
+            }
+            y[channels] += x[0] * p * matrix.costs[k];
+        }
+    }
+}
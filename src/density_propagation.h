@@ -0,0 +1,77 @@
+#ifndef __FISH_DENSITY_PROPAGATION_H
+#define __FISH_DENSITY_PROPAGATION_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "map.h"
+
+#ifndef __FISH_MODEL_CLS
+class Model;
+#endif
+
+// Walk states merged per 1/DENSITY_COST_BINS of the swim range when building transition rows
+constexpr size_t DENSITY_COST_BINS = 32;
+
+/*
+* One fork length class's movement for a timestep, in compressed sparse row form: row i lists where
+* fish starting at origins[i] end up (destinations[rowStart[i]] to destinations[rowStart[i + 1] - 1]),
+* with the probability of each and the mean meters swum to get there.
+*/
+typedef struct TransitionMatrix {
+    // Locations holding fish of this class, in ID order
+    std::vector<MapNode *> origins;
+    std::vector<size_t> rowStart;
+    std::vector<MapNode *> destinations;
+    // Position of each destination in Model::map (map node IDs aren't positions)
+    std::vector<size_t> destinationIndices;
+    std::vector<double> probabilities;
+    std::vector<float> costs;
+
+    // The row for origin (origins.size() if it has none)
+    size_t findRow(const MapNode *origin) const;
+} TransitionMatrix;
+
+/*
+* Eulerian movement for low agent awareness (movementEngine "density").
+*
+* With low awareness every movement option is equally fit and only downstream moves are allowed, so
+* where a fish ends up depends only on where it starts, its swim speed and the hydrology. Each
+* timestep one transition matrix is built per fork length class, over the locations holding fish of
+* that class, and the fish density is pushed through it with sparse products (see Model::moveAll)
+* instead of walking each fish.
+*/
+class DensityPropagation {
+public:
+    explicit DensityPropagation(float classWidth);
+
+    float getClassWidth() const;
+    size_t sizeClass(float forkLength) const;
+    // Fork length (mm) whose swim speed stands for the class (its midpoint)
+    float classForkLength(size_t sizeClass) const;
+
+    // Rebuild this timestep's matrices; origins[c] lists the locations holding fish of class c
+    // (in any order, with repeats). Classes are built on up to maxThreads threads.
+    void build(Model &model, std::vector<std::vector<MapNode *>> &origins, size_t maxThreads);
+    const TransitionMatrix &getMatrix(size_t sizeClass) const;
+
+    /*
+    * Push per-origin values through a matrix. density holds `channels` values per row of the matrix
+    * (channel 0 being the number of fish); out holds channels + 1 values per Model::map entry and must
+    * be zero on entry. For each destination j, out gets sum_i density[i] * P[i][j] in its first
+    * `channels` entries and the fish-weighted meters swum, sum_i density[i][0] * P[i][j] * cost[i][j],
+    * in the last. touched receives the Model::map positions of the locations reached, in first-reached
+    * order.
+    */
+    static void propagate(const TransitionMatrix &matrix, const std::vector<double> &density, size_t channels,
+                          std::vector<double> &out, std::vector<size_t> &touched);
+
+private:
+    float classWidth;
+    std::vector<TransitionMatrix> matrices;
+    // Position of each location in Model::map, and the map it was built for
+    std::unordered_map<const MapNode *, size_t> mapIndices;
+    const MapNode *const *indexedMap;
+};
+
+#endif
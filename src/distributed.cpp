@@ -0,0 +1,407 @@
+#include "distributed.h"
+
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "fish.h"
+
+namespace {
+
+// A fish's state as sent between processes (its location by MapNode::id); a tagged fish's histories follow it
+typedef struct FishRecord {
+    unsigned long id;
+    long spawnTime;
+    long exitTime;
+    float entryForkLength;
+    float entryMass;
+    float forkLength;
+    float mass;
+    int locationId;
+    float travel;
+    float weight;
+    float lostWeight;
+    FishStatus status;
+    FishStatus exitStatus;
+    float numExitHabitatHours;
+    float lastGrowth;
+    float lastPmax;
+    float lastMortality;
+    float lastTemp;
+    float lastDepth;
+    float lastFlowSpeed_old;
+    FlowVelocity lastFlowVelocity;
+    int massRank;
+    int arrivalTimeRank;
+    long taggedTime;
+} FishRecord;
+
+// An occupied location's statistics from its owner's count
+typedef struct NodeOccupancy {
+    int id;
+    float residentWeight;
+    float popDensity;
+    float maxMass;
+} NodeOccupancy;
+
+template <typename T>
+void putVector(MessageWriter &writer, const std::vector<T> &values) {
+    writer.put<uint64_t>(values.size());
+    for (const T &value : values) {
+        writer.put(value);
+    }
+}
+
+template <typename T>
+void getVector(MessageReader &reader, std::vector<T> &values) {
+    values.resize((size_t) reader.get<uint64_t>());
+    for (T &value : values) {
+        value = reader.get<T>();
+    }
+}
+
+void putFish(MessageWriter &writer, const Fish &f) {
+    FishRecord record = {};
+    record.id = f.id;
+    record.spawnTime = f.spawnTime;
+    record.exitTime = f.exitTime;
+    record.entryForkLength = f.entryForkLength;
+    record.entryMass = f.entryMass;
+    record.forkLength = f.forkLength;
+    record.mass = f.mass;
+    record.locationId = f.location->id;
+    record.travel = f.travel;
+    record.weight = f.weight;
+    record.lostWeight = f.lostWeight;
+    record.status = f.status;
+    record.exitStatus = f.exitStatus;
+    record.numExitHabitatHours = f.numExitHabitatHours;
+    record.lastGrowth = f.lastGrowth;
+    record.lastPmax = f.lastPmax;
+    record.lastMortality = f.lastMortality;
+    record.lastTemp = f.lastTemp;
+    record.lastDepth = f.lastDepth;
+    record.lastFlowSpeed_old = f.lastFlowSpeed_old;
+    record.lastFlowVelocity = f.lastFlowVelocity;
+    record.massRank = f.massRank;
+    record.arrivalTimeRank = f.arrivalTimeRank;
+    record.taggedTime = f.taggedTime;
+    writer.put(record);
+    if (f.taggedTime != -1) {
+        putVector(writer, *f.locationHistory);
+        putVector(writer, *f.pmaxHistory);
+        putVector(writer, *f.growthHistory);
+        putVector(writer, *f.mortalityHistory);
+        putVector(writer, *f.tempHistory);
+        putVector(writer, *f.depthHistory);
+        putVector(writer, *f.flowSpeedHistory_old);
+        putVector(writer, *f.flowVelocityHistory);
+    }
+}
+
+// Overwrite the fish's copy in individuals with the one read, returning its ID
+size_t getFish(MessageReader &reader, std::vector<Fish> &individuals, const std::vector<MapNode *> &nodeById) {
+    const FishRecord record = reader.get<FishRecord>();
+    if (record.id >= individuals.size() || record.locationId < 0 || (size_t) record.locationId >= nodeById.size()
+        || nodeById[record.locationId] == nullptr) {
+        throw std::runtime_error("Unknown fish or location in a message between processes");
+    }
+    Fish &f = individuals[record.id];
+    f.spawnTime = record.spawnTime;
+    f.exitTime = record.exitTime;
+    f.entryForkLength = record.entryForkLength;
+    f.entryMass = record.entryMass;
+    f.forkLength = record.forkLength;
+    f.mass = record.mass;
+    f.location = nodeById[record.locationId];
+    f.travel = record.travel;
+    f.weight = record.weight;
+    f.lostWeight = record.lostWeight;
+    f.status = record.status;
+    f.exitStatus = record.exitStatus;
+    f.numExitHabitatHours = record.numExitHabitatHours;
+    f.lastGrowth = record.lastGrowth;
+    f.lastPmax = record.lastPmax;
+    f.lastMortality = record.lastMortality;
+    f.lastTemp = record.lastTemp;
+    f.lastDepth = record.lastDepth;
+    f.lastFlowSpeed_old = record.lastFlowSpeed_old;
+    f.lastFlowVelocity = record.lastFlowVelocity;
+    f.massRank = record.massRank;
+    f.arrivalTimeRank = record.arrivalTimeRank;
+    f.taggedTime = record.taggedTime;
+    if (record.taggedTime != -1) {
+        if (f.locationHistory == nullptr) {
+            f.addHistoryBuffers();
+        }
+        getVector(reader, *f.locationHistory);
+        getVector(reader, *f.pmaxHistory);
+        getVector(reader, *f.growthHistory);
+        getVector(reader, *f.mortalityHistory);
+        getVector(reader, *f.tempHistory);
+        getVector(reader, *f.depthHistory);
+        getVector(reader, *f.flowSpeedHistory_old);
+        getVector(reader, *f.flowVelocityHistory);
+    }
+    return record.id;
+}
+
+// Add the (ascending) IDs in arrived to the ascending list living
+void mergeFishIds(std::vector<size_t> &living, std::vector<size_t> &arrived) {
+    if (arrived.empty()) {
+        return;
+    }
+    std::sort(arrived.begin(), arrived.end());
+    const size_t middle = living.size();
+    living.insert(living.end(), arrived.begin(), arrived.end());
+    std::inplace_merge(living.begin(), living.begin() + (std::ptrdiff_t) middle, living.end());
+}
+
+} // namespace
+
+DistributedStep::DistributedStep(Model &model, ProcessTransport &transport)
+    : model(model), transport(transport), claimedFishId(model.individuals.size()) {
+    this->partition = partitionMap(model.map, occupancyWeights(model.map), transport.getNumProcesses());
+    int maxId = -1;
+    for (MapNode *node : model.map) {
+        maxId = std::max(maxId, node->id);
+    }
+    this->ownerById.assign((size_t) (maxId + 1), 0);
+    this->nodeById.assign((size_t) (maxId + 1), nullptr);
+    for (size_t i = 0; i < model.map.size(); ++i) {
+        MapNode *node = model.map[i];
+        this->ownerById[node->id] = this->partition.regions[i];
+        this->nodeById[node->id] = node;
+        if (this->partition.regions[i] == this->getRank()) {
+            this->ownedNodes.push_back(node);
+        }
+    }
+    for (SamplingSite *site : model.samplingSites) {
+        for (MapNode *point : site->points) {
+            if (this->ownerOf(point) == this->getRank()
+                && std::find(this->ownedSamplingPoints.begin(), this->ownedSamplingPoints.end(), point)
+                   == this->ownedSamplingPoints.end()) {
+                this->ownedSamplingPoints.push_back(point);
+            }
+        }
+    }
+    // Fish already living (e.g. from a loaded state) start with the owners of their locations
+    std::vector<size_t> &living = model.livingIndividuals;
+    living.erase(std::remove_if(living.begin(), living.end(), [this](size_t id) {
+        return this->ownerOf(this->model.individuals[id].location) != this->getRank();
+    }), living.end());
+}
+
+void DistributedStep::claimRecruits() {
+    std::vector<size_t> &living = this->model.livingIndividuals;
+    auto first = std::lower_bound(living.begin(), living.end(), this->claimedFishId);
+    living.erase(std::remove_if(first, living.end(), [this](size_t id) {
+        return this->ownerOf(this->model.individuals[id].location) != this->getRank();
+    }), living.end());
+    this->claimedFishId = this->model.individuals.size();
+}
+
+void DistributedStep::exchangeMigrants() {
+    const size_t rank = this->getRank();
+    std::vector<std::vector<char>> outgoing(this->transport.getNumProcesses());
+    std::vector<MessageWriter> writers(outgoing.begin(), outgoing.end());
+    std::vector<size_t> &living = this->model.livingIndividuals;
+    auto target = living.begin();
+    for (size_t id : living) {
+        const Fish &f = this->model.individuals[id];
+        const size_t owner = this->ownerOf(f.location);
+        if (owner == rank) {
+            *target++ = id;
+        } else {
+            putFish(writers[owner], f);
+        }
+    }
+    living.erase(target, living.end());
+
+    std::vector<size_t> arrived;
+    for (const std::vector<char> &message : exchangeMessages(this->transport, outgoing)) {
+        MessageReader reader(message);
+        while (!reader.done()) {
+            arrived.push_back(getFish(reader, this->model.individuals, this->nodeById));
+        }
+    }
+    mergeFishIds(living, arrived);
+}
+
+void DistributedStep::exchangeOccupancy() {
+    const size_t rank = this->getRank();
+    const size_t numProcesses = this->transport.getNumProcesses();
+    std::vector<NodeOccupancy> occupied;
+    for (MapNode *node : this->ownedNodes) {
+        if (!node->residentIds.empty()) {
+            occupied.push_back({node->id, node->residentWeight, node->popDensity, node->maxMass});
+        }
+    }
+    std::vector<char> occupancy;
+    MessageWriter writer(occupancy);
+    writer.put(this->model.livingAbundance);
+    putVector(writer, occupied);
+    std::vector<std::vector<char>> outgoing(numProcesses, occupancy);
+    // Rank 0 samples the whole map, so it also gets the fish at this process's sampling site locations
+    if (rank != 0) {
+        MessageWriter residentWriter(outgoing[0]);
+        for (MapNode *point : this->ownedSamplingPoints) {
+            residentWriter.put(point->id);
+            residentWriter.put<uint64_t>(point->residentIds.size());
+            for (long id : point->residentIds) {
+                putFish(residentWriter, this->model.individuals[id]);
+            }
+        }
+    }
+    std::vector<std::vector<char>> incoming = exchangeMessages(this->transport, outgoing);
+
+    // Summed in rank order, so every process gets the same total
+    double livingAbundance = 0.0;
+    for (size_t peer = 0; peer < numProcesses; ++peer) {
+        if (peer == rank) {
+            livingAbundance += this->model.livingAbundance;
+            continue;
+        }
+        MessageReader reader(incoming[peer]);
+        livingAbundance += reader.get<double>();
+        getVector(reader, occupied);
+        for (const NodeOccupancy &stats : occupied) {
+            MapNode *node = this->nodeById.at((size_t) stats.id);
+            node->residentWeight = stats.residentWeight;
+            node->popDensity = stats.popDensity;
+            node->maxMass = stats.maxMass;
+        }
+        while (!reader.done()) {
+            MapNode *point = this->nodeById.at((size_t) reader.get<int>());
+            point->residentIds.resize((size_t) reader.get<uint64_t>());
+            for (long &id : point->residentIds) {
+                id = (long) getFish(reader, this->model.individuals, this->nodeById);
+            }
+        }
+    }
+    this->model.livingAbundance = livingAbundance;
+}
+
+void DistributedStep::gather() {
+    Model &model = this->model;
+    if (this->getRank() != 0) {
+        std::vector<char> message;
+        MessageWriter writer(message);
+        writer.put(model.deadCount);
+        writer.put(model.exitedCount);
+        writer.put(model.deadAbundance);
+        writer.put(model.exitedAbundance);
+        // This process's living fish, and the fish that died or exited here (elsewhere they're still alive)
+        for (size_t id : model.livingIndividuals) {
+            putFish(writer, model.individuals[id]);
+        }
+        for (const Fish &f : model.individuals) {
+            if (f.status != FishStatus::Alive) {
+                putFish(writer, f);
+            }
+        }
+        sendMessage(this->transport, 0, message);
+        return;
+    }
+    std::vector<size_t> arrived;
+    for (size_t peer = 1; peer < this->transport.getNumProcesses(); ++peer) {
+        std::vector<char> message = receiveMessage(this->transport, peer);
+        MessageReader reader(message);
+        model.deadCount += reader.get<int>();
+        model.exitedCount += reader.get<int>();
+        model.deadAbundance += reader.get<double>();
+        model.exitedAbundance += reader.get<double>();
+        while (!reader.done()) {
+            const size_t id = getFish(reader, model.individuals, this->nodeById);
+            if (model.individuals[id].status == FishStatus::Alive) {
+                arrived.push_back(id);
+            }
+        }
+    }
+    mergeFishIds(model.livingIndividuals, arrived);
+    // Every location's residents are here now
+    model.countAll(true);
+}
+
+// Step one process's share of the run, then gather the results to rank 0
+static void runRank(Model &model, ProcessTransport &transport, size_t rank, long timesteps) {
+    transport.attach(rank);
+    DistributedStep step(model, transport);
+    model.setDistributedStep(&step);
+    try {
+        while (model.time < timesteps) {
+            model.masterUpdate();
+        }
+        step.gather();
+    } catch (...) {
+        model.setDistributedStep(nullptr);
+        throw;
+    }
+    model.setDistributedStep(nullptr);
+}
+
+void runDistributed(Model &model, long timesteps) {
+    const size_t numProcesses = (size_t) model.getInt(ModelParamKey::Processes);
+    if (numProcesses <= 1) {
+        while (model.time < timesteps) {
+            model.masterUpdate();
+        }
+        return;
+    }
+    std::unique_ptr<ProcessTransport> transport =
+        makeProcessTransport(model.getString(ModelParamKey::ProcessTransport), numProcesses);
+    // Anything still buffered would be written again by every child
+    std::cout.flush();
+    std::vector<pid_t> children;
+    auto stopChildren = [&children]() {
+        for (pid_t child : children) {
+            kill(child, SIGTERM);
+            waitpid(child, nullptr, 0);
+        }
+    };
+    for (size_t rank = 1; rank < numProcesses; ++rank) {
+        pid_t child = fork();
+        if (child < 0) {
+            transport->abort();
+            stopChildren();
+            throw std::runtime_error("Couldn't start process " + std::to_string(rank) + " of a distributed run");
+        }
+        if (child == 0) {
+            int status = 0;
+            try {
+                runRank(model, *transport, rank, timesteps);
+            } catch (const std::exception &e) {
+                std::cerr << "Process " << rank << " of the distributed run failed: " << e.what() << std::endl;
+                transport->abort();
+                status = 1;
+            } catch (...) {
+                transport->abort();
+                status = 1;
+            }
+            std::cout.flush();
+            // Skip the parent's destructors and exit handlers
+            _exit(status);
+        }
+        children.push_back(child);
+    }
+    try {
+        runRank(model, *transport, 0, timesteps);
+    } catch (...) {
+        transport->abort();
+        stopChildren();
+        throw;
+    }
+    size_t failed = 0;
+    for (pid_t child : children) {
+        int status = 0;
+        if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ++failed;
+        }
+    }
+    if (failed > 0) {
+        throw std::runtime_error(std::to_string(failed) + " process(es) of the distributed run failed");
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef __FISH_DISTRIBUTED_H
+#define __FISH_DISTRIBUTED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "map.h"
+#include "map_partition.h"
+#include "model.h"
+#include "process_transport.h"
+
+/*
+* Distributed execution (processes > 1): one simulation spread over several processes forked from the
+* loaded model, so each starts with the full map, hydrology and recruitment inputs. The map is partitioned
+* into one region per process (see partitionMap and occupancyWeights), and each process owns the living
+* fish at its region's locations; it moves, grows and counts only those. Every process recruits every fish
+* (the draws are keyed by fish ID) and keeps the ones that enter in its region. Each step, around the
+* model's own phases (see Model::updateTimestep):
+*   - after movement, fish that moved into another region are sent to its process (exchangeMigrants)
+*   - after the final count, every process sends the others its occupied locations' densities, which the
+*     next step's moves look at, and its living abundance; rank 0 also gets the fish at its sampling sites'
+*     locations, so its samples and monitoring records cover the whole map (exchangeOccupancy)
+* At the end, the other processes send rank 0 their fish and counters (gather), so rank 0's model holds the
+* whole run's results and writes the usual outputs.
+*
+* With commonRandomNumbers = 1 every fish's draws are the same wherever it's processed, and each process
+* keeps its living fish in ascending ID order, so locations list their residents in the same order as in
+* one process: the results equal a single-process run's. Runs need superIndividualSize 1, movementEngine
+* "agent", no domainRegions and the hydrology fully in memory (see ModelConfigMap::validate).
+*/
+class DistributedStep {
+public:
+    // Call in each process once the transport is attached
+    DistributedStep(Model &model, ProcessTransport &transport);
+
+    size_t getRank() const { return this->transport.getRank(); }
+    const MapPartition &getPartition() const { return this->partition; }
+    // The rank of the process owning a location
+    size_t ownerOf(const MapNode *node) const { return this->ownerById[node->id]; }
+
+    // After recruitment: drop the new fish that entered outside this process's region
+    void claimRecruits();
+    // After movement: hand fish now in other regions to their processes and take theirs
+    void exchangeMigrants();
+    // After the final count: share location densities and abundances (and sampling site residents with rank 0)
+    void exchangeOccupancy();
+    // After the last step: bring every process's fish and counters to rank 0
+    void gather();
+
+private:
+    Model &model;
+    ProcessTransport &transport;
+    MapPartition partition;
+    // Owning rank and location of each MapNode::id
+    std::vector<uint32_t> ownerById;
+    std::vector<MapNode *> nodeById;
+    // This process's locations, and those of them that belong to sampling sites
+    std::vector<MapNode *> ownedNodes;
+    std::vector<MapNode *> ownedSamplingPoints;
+    // Fish with lower IDs have been claimed or dropped
+    size_t claimedFishId;
+};
+
+/*
+* Run the model until it reaches the given timestep over the configured number of processes (the
+* processes and processTransport parameters), returning with the results in model as after a
+* single-process run. The calling process is rank 0; the others are forked from it and exit when done.
+* Throws if any process fails. With processes = 1, just steps the model.
+*/
+void runDistributed(Model &model, long timesteps);
+
+#endif
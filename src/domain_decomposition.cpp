@@ -0,0 +1,50 @@
+#include "domain_decomposition.h"
+
+DomainDecomposition::DomainDecomposition(const std::vector<MapNode *> &map, size_t numRegions) : syncedFishId(0) {
+    this->partition = partitionMap(map, occupancyWeights(map), numRegions);
+
+    int maxId = -1;
+    for (MapNode *node : map) {
+        maxId = std::max(maxId, node->id);
+    }
+    this->regionById.assign((size_t) (maxId + 1), 0);
+    this->regionNodes.resize(this->partition.numRegions);
+    for (size_t i = 0; i < map.size(); ++i) {
+        this->regionById[map[i]->id] = this->partition.regions[i];
+        this->regionNodes[this->partition.regions[i]].push_back(map[i]);
+    }
+    this->regionFish.resize(this->partition.numRegions);
+    this->mailboxes.resize(this->partition.numRegions * this->partition.numRegions);
+}
+
+size_t DomainDecomposition::getNumFish() const {
+    size_t count = 0;
+    for (const std::vector<size_t> &fish : this->regionFish) {
+        count += fish.size();
+    }
+    return count;
+}
+
+void DomainDecomposition::adopt(size_t id, const MapNode *location) {
+    std::vector<size_t> &fish = this->regionFish[this->regionOf(location)];
+    if (fish.empty() || fish.back() < id) {
+        fish.push_back(id);
+    } else {
+        fish.insert(std::upper_bound(fish.begin(), fish.end(), id), id);
+    }
+}
+
+void DomainDecomposition::deliver(size_t region) {
+    std::vector<size_t> &fish = this->regionFish[region];
+    const size_t numRegions = this->getNumRegions();
+    for (size_t from = 0; from < numRegions; ++from) {
+        std::vector<size_t> &mailbox = this->mailboxes[from * numRegions + region];
+        if (mailbox.empty()) {
+            continue;
+        }
+        const size_t middle = fish.size();
+        fish.insert(fish.end(), mailbox.begin(), mailbox.end());
+        std::inplace_merge(fish.begin(), fish.begin() + (std::ptrdiff_t) middle, fish.end());
+        mailbox.clear();
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef __FISH_DOMAIN_DECOMPOSITION_H
+#define __FISH_DOMAIN_DECOMPOSITION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "map.h"
+#include "map_partition.h"
+
+/*
+* Domain-decomposed execution (domainRegions > 0): the map is partitioned once into regions (see
+* partitionMap), each location weighted by its expected occupancy (see occupancyWeights). Each region owns
+* the living fish at its locations, and one worker at a time processes a region's fish and locations,
+* so a worker's moves, growth and counts stay within one part of the map. Fish that move into another
+* region are posted to a per-pair mailbox and taken by their new region once every region has moved (the
+* step barrier).
+*
+* Each region's fish are kept in ascending ID order, as Model::livingIndividuals is, so locations list
+* their residents in the same order as without regions.
+*/
+class DomainDecomposition {
+public:
+    DomainDecomposition(const std::vector<MapNode *> &map, size_t numRegions);
+
+    size_t getNumRegions() const { return this->partition.numRegions; }
+    const MapPartition &getPartition() const { return this->partition; }
+    size_t regionOf(const MapNode *node) const { return this->regionById[node->id]; }
+    const std::vector<MapNode *> &getRegionNodes(size_t region) const { return this->regionNodes[region]; }
+    const std::vector<size_t> &getRegionFish(size_t region) const { return this->regionFish[region]; }
+    // Living fish owned by all regions
+    size_t getNumFish() const;
+
+    // Bring the regions up to date with living (ascending fish IDs): fish added since markSynced are adopted
+    // by the region of their location (locationOf(id)). If the older fish aren't the ones the regions own
+    // (e.g. after the model was reset), every fish is assigned afresh.
+    template <typename F>
+    void sync(const std::vector<size_t> &living, F locationOf);
+    // Fish with IDs below nextFishId are all accounted for
+    void markSynced(size_t nextFishId) { this->syncedFishId = nextFishId; }
+    // Give fish id to the region of location
+    void adopt(size_t id, const MapNode *location);
+
+    // After a region's fish have moved: drop those no longer alive and post those now in another region to
+    // its mailbox. locationOf(id) returns the fish's location, or null if it's no longer alive.
+    template <typename F>
+    void post(size_t region, F locationOf);
+    // Take the fish posted to region; call once every region has posted
+    void deliver(size_t region);
+    // Drop a region's fish that are no longer alive (isAlive(id))
+    template <typename F>
+    void drop(size_t region, F isAlive);
+
+    // Run work(region) for every region on up to maxThreads threads, returning once all are done
+    template <typename F>
+    void forEachRegion(size_t maxThreads, F work) const;
+
+private:
+    MapPartition partition;
+    // Region of each location, indexed by MapNode::id
+    std::vector<uint32_t> regionById;
+    std::vector<std::vector<MapNode *>> regionNodes;
+    std::vector<std::vector<size_t>> regionFish;
+    // Fish handed from region a to region b wait in mailboxes[a * numRegions + b]
+    std::vector<std::vector<size_t>> mailboxes;
+    size_t syncedFishId;
+};
+
+template <typename F>
+void DomainDecomposition::sync(const std::vector<size_t> &living, F locationOf) {
+    const size_t firstNew = std::lower_bound(living.begin(), living.end(), this->syncedFishId) - living.begin();
+    size_t first = firstNew;
+    if (this->getNumFish() != firstNew) {
+        for (std::vector<size_t> &fish : this->regionFish) {
+            fish.clear();
+        }
+        first = 0;
+    }
+    for (size_t i = first; i < living.size(); ++i) {
+        this->adopt(living[i], locationOf(living[i]));
+    }
+}
+
+template <typename F>
+void DomainDecomposition::post(size_t region, F locationOf) {
+    std::vector<size_t> &fish = this->regionFish[region];
+    const size_t numRegions = this->getNumRegions();
+    auto target = fish.begin();
+    for (size_t id : fish) {
+        const MapNode *location = locationOf(id);
+        if (location == nullptr) {
+            continue;
+        }
+        const size_t destination = this->regionOf(location);
+        if (destination == region) {
+            *target++ = id;
+        } else {
+            this->mailboxes[region * numRegions + destination].push_back(id);
+        }
+    }
+    fish.erase(target, fish.end());
+}
+
+template <typename F>
+void DomainDecomposition::drop(size_t region, F isAlive) {
+    std::vector<size_t> &fish = this->regionFish[region];
+    fish.erase(std::remove_if(fish.begin(), fish.end(), [&isAlive](size_t id) { return !isAlive(id); }), fish.end());
+}
+
+template <typename F>
+void DomainDecomposition::forEachRegion(size_t maxThreads, F work) const {
+    const size_t numRegions = this->getNumRegions();
+    const size_t numWorkers = std::max((size_t) 1, std::min(maxThreads, numRegions));
+    if (numWorkers == 1) {
+        for (size_t region = 0; region < numRegions; ++region) {
+            work(region);
+        }
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < numWorkers; ++w) {
+        workers.emplace_back([&work, w, numWorkers, numRegions]() {
+            for (size_t region = w; region < numRegions; region += numWorkers) {
+                work(region);
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+#endif
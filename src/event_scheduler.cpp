@@ -0,0 +1,60 @@
+#include "event_scheduler.h"
+
+#include <tuple>
+
+std::vector<SamplingCampaign> defaultSamplingSchedule() {
+    return {{{}, 12L, 14L * 24L, SamplingMethod::BeachSeine}};
+}
+
+bool EventScheduler::Later::operator()(const ScheduledEvent &a, const ScheduledEvent &b) const {
+    return std::tie(a.hour, a.type, a.campaign) > std::tie(b.hour, b.type, b.campaign);
+}
+
+EventScheduler::EventScheduler() : hour(-1L) {}
+
+void EventScheduler::reset(long startHour, const std::vector<SamplingCampaign> &campaigns) {
+    this->queue = {};
+    this->hour = startHour;
+    // Days start at multiples of 24 hours
+    this->schedule({(startHour + 23L) / 24L * 24L, EventType::PlanRecruitment, 0, 24L});
+    for (size_t i = 0; i < campaigns.size(); ++i) {
+        const SamplingCampaign &campaign = campaigns[i];
+        long first = campaign.firstHour;
+        if (first < startHour) {
+            if (campaign.repeatHours <= 0) {
+                continue;
+            }
+            // The first repeat at or after startHour
+            first += (startHour - first + campaign.repeatHours - 1) / campaign.repeatHours * campaign.repeatHours;
+        }
+        this->schedule({first, EventType::Sampling, i, campaign.repeatHours});
+    }
+}
+
+void EventScheduler::schedule(const ScheduledEvent &event) {
+    this->queue.push(event);
+}
+
+std::vector<ScheduledEvent> EventScheduler::advance(long endHour) {
+    std::vector<ScheduledEvent> due;
+    while (!this->queue.empty() && this->queue.top().hour < endHour) {
+        ScheduledEvent event = this->queue.top();
+        this->queue.pop();
+        if (event.repeatHours > 0) {
+            ScheduledEvent next = event;
+            next.hour += event.repeatHours;
+            this->queue.push(next);
+        }
+        due.push_back(event);
+    }
+    this->hour = endHour;
+    return due;
+}
+
+long EventScheduler::getHour() const {
+    return this->hour;
+}
+
+long EventScheduler::nextEventHour() const {
+    return this->queue.empty() ? -1L : this->queue.top().hour;
+}
@@ -0,0 +1,73 @@
+#ifndef __FISH_EVENT_SCHEDULER_H
+#define __FISH_EVENT_SCHEDULER_H
+
+#include <queue>
+#include <vector>
+
+/*
+* Calendar of the model's timed events (daily recruitment planning and sampling campaigns), kept in a
+* priority queue by hour since timestep 0. Model::masterUpdate takes the events falling in each step's
+* hours from here, so steps without one cost nothing extra however many campaigns are scheduled.
+*/
+
+enum class SamplingMethod {
+    // Samples the residents at the scheduled hour
+    BeachSeine,
+    // Samples at the first high tide from the scheduled hour to the end of that day (or not at all)
+    Fyke
+};
+
+typedef struct SamplingCampaign {
+    // Sites to sample (positions in Model::samplingSites); empty = every site
+    std::vector<size_t> siteIds;
+    // Hour (since timestep 0) of the first sampling
+    long firstHour;
+    // Hours between samplings (0 = only once)
+    long repeatHours;
+    SamplingMethod method;
+} SamplingCampaign;
+
+// The schedule used without a samplingScheduleFile: every site by beach seine at noon every 14th day
+std::vector<SamplingCampaign> defaultSamplingSchedule();
+
+enum class EventType {
+    PlanRecruitment,
+    Sampling
+};
+
+typedef struct ScheduledEvent {
+    long hour;
+    EventType type;
+    // Position in the campaign list (sampling only)
+    size_t campaign;
+    // Hours until the event comes round again (0 = only once)
+    long repeatHours;
+} ScheduledEvent;
+
+class EventScheduler {
+public:
+    EventScheduler();
+
+    // Schedule recruitment planning at the start of each day and the given campaigns' samplings, all from
+    // startHour on
+    void reset(long startHour, const std::vector<SamplingCampaign> &campaigns);
+    // Add an event (at or after getHour())
+    void schedule(const ScheduledEvent &event);
+    // Remove and return, in order, the events before endHour (rescheduling repeating ones), and move the
+    // calendar on to endHour
+    std::vector<ScheduledEvent> advance(long endHour);
+    // The hour the calendar has been advanced to (-1 before the first reset)
+    long getHour() const;
+    // Hour of the earliest scheduled event (-1 if there's none)
+    long nextEventHour() const;
+
+private:
+    // Earliest hour first; at the same hour, recruitment planning before sampling, then campaign order
+    struct Later {
+        bool operator()(const ScheduledEvent &a, const ScheduledEvent &b) const;
+    };
+    std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>, Later> queue;
+    long hour;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "fish.h"
 #include "fish_movement.h"
 
+#include <algorithm>
 #include <deque>
 #include <cmath>
 #include <iostream>
@@ -59,7 +60,7 @@ inline float massFromForkLength(float forkLength) {
 
 // Convert a mass value (in g) to a fork length value (in mm)
 // Note: the resulting value is slightly stochastic
-inline float forkLengthFromMass(float mass) {
+float forkLengthFromMass(float mass) {
     return fmax(20.0f, 47.828851f*pow(mass, 0.292476f) + unit_normal_rand()*2.07895f);
 }
 
@@ -70,7 +71,8 @@ Fish::Fish(
         unsigned long id,
         long spawnTime,
         float forkLength,
-        MapNode *location
+        MapNode *location,
+        float weight
     ) : id(id),
         spawnTime(spawnTime),
         entryForkLength(forkLength),
@@ -78,6 +80,8 @@ Fish::Fish(
         mass(massFromForkLength(forkLength)),
         location(location),
         travel(0),
+        weight(weight),
+        lostWeight(0),
         status(FishStatus::Alive),
         exitStatus(FishStatus::Alive),
         numExitHabitatHours(0),
@@ -171,7 +175,7 @@ Fish::Fish(
 void Fish::getReachableNodes(Model &model, std::unordered_map<MapNode *, float> &out)
 {
     float swimSpeed = swimSpeedFromForkLength(this->forkLength);
-    float swimRange = swimSpeed*SECONDS_PER_TIMESTEP;
+    float swimRange = swimSpeed*model.getSecondsPerTimestep();
 
     auto fitness_calculator = [this](Model& model, MapNode& node, float cost) { return this->getFitness(model, node, cost); };
     auto fishMovement = FishMovementFactory::createFishMovement(model, swimSpeed, swimRange, fitness_calculator, model.getConfigMap());
@@ -365,8 +369,8 @@ float Fish::getFitness(Model &model, MapNode &loc, float cost) {
     return this->getGrowth(model, loc, cost) / this->getMortality(model, loc);
 }
 
-void Fish::incrementExitHabitatHoursByOneTimestep() {
-    this->numExitHabitatHours += HOURS_PER_TIMESTEP;
+void Fish::incrementExitHabitatHoursByOneTimestep(const Model &model) {
+    this->numExitHabitatHours += (float) model.getHoursPerTimestep();
 }
 
 /*
@@ -374,18 +378,43 @@ void Fish::incrementExitHabitatHoursByOneTimestep() {
  * (Correlated random walk terminating at a node with locally maximal fitness-value)
  */
 
-bool Fish::move(Model &model) {
+bool Fish::move(Model &model, std::vector<Fish> *splits) {
+    KeyedRandScope keyed(model.usesCommonRandomNumbers(), RandPurpose::Movement, this->id, (uint64_t) model.time);
     float swimSpeed = swimSpeedFromForkLength(this->forkLength);
-    float swimRange = swimSpeed*SECONDS_PER_TIMESTEP;
+    float swimRange = swimSpeed*model.getSecondsPerTimestep();
     float lastFlowSpeed_node_old = model.hydroModel.getUnsignedFlowSpeedAt(*(this->location));
 
     auto fitness_calculator = [this](Model& model, MapNode& node, float cost) { return this->getFitness(model, node, cost); };
     auto fishMovement = FishMovementFactory::createFishMovement(model, swimSpeed, swimRange, fitness_calculator, model.getConfigMap());
 
     std::pair<MapNode *, float> result = fishMovement->determineNextLocation(this->location);
-    MapNode *point = result.first;
-    float accumulatedCost = result.second;
+    if (splits != nullptr && this->weight >= 2.0f && this->weight >= 2.0f * model.getMinSplitWeight()) {
+        // The fish in a super-individual would choose independently, so if a second draw disagrees
+        // with the first, half of them go the other way as a separate agent
+        std::pair<MapNode *, float> other = fishMovement->determineNextLocation(this->location);
+        if (other.first != result.first) {
+            this->weight *= 0.5f;
+            Fish half = *this;
+            // Only the original agent keeps any tagged history
+            half.taggedTime = -1L;
+            half.locationHistory = nullptr;
+            half.pmaxHistory = nullptr;
+            half.growthHistory = nullptr;
+            half.mortalityHistory = nullptr;
+            half.tempHistory = nullptr;
+            half.depthHistory = nullptr;
+            half.flowSpeedHistory_old = nullptr;
+            half.flowVelocityHistory = nullptr;
+            half.massHistory = nullptr;
+            half.forkLengthHistory = nullptr;
+            half.arriveAt(model, other.first, other.second, lastFlowSpeed_node_old);
+            splits->push_back(half);
+        }
+    }
+    return this->arriveAt(model, result.first, result.second, lastFlowSpeed_node_old);
+}
 
+bool Fish::arriveAt(Model &model, MapNode *point, float accumulatedCost, float lastFlowSpeed_node_old) {
     this->location = point;
     this->travel = accumulatedCost;
 
@@ -394,7 +423,7 @@ bool Fish::move(Model &model) {
     this->lastFlowSpeed_old = lastFlowSpeed_node_old;
     this->lastFlowVelocity = model.hydroModel.getScaledFlowVelocityAt(*point);;
     if (this->location->type == HabitatType::Nearshore) {
-        this->incrementExitHabitatHoursByOneTimestep();
+        this->incrementExitHabitatHoursByOneTimestep(model);
     } else {
         this->numExitHabitatHours = 0;
     }
@@ -493,7 +522,7 @@ float Fish::getGrowth(Model &model, MapNode &loc, float cost, float Pmax) const
     // Respiration (g*g^-1*d^-1)
     // cost is distance traveled this timestep, in m
     //TODO: if they are idling in a blind channel, do they swim around? Use standard vel?
-    const float Velocity = (cost / (60*60)) * 100;  // Converting swim speed from m/s to cm/s
+    const float Velocity = (cost / model.getSecondsPerTimestep()) * 100;  // Converting swim speed from m/s to cm/s
     //if my_temp > RTL:
     //  vel = RK1 * mass ** RK4
     //else:
@@ -505,8 +534,8 @@ float Fish::getGrowth(Model &model, MapNode &loc, float cost, float Pmax) const
 
     // (g*g^-1*d^-1)
     const float Delta = Consumption - Respiration - SpecificDynamicAction - Egestion - Excretion;
-    //96 timesteps a day -- 15min each
-    const float Growth = (Delta / 24) * mass ;
+    // Delta is per day; each timestep covers hoursPerTimestep hours of it
+    const float Growth = (Delta / 24) * (float) model.getHoursPerTimestep() * mass ;
     return Growth;
 }
 
@@ -524,12 +553,19 @@ float Fish::getMortality(Model &model, MapNode &loc) const {
     const double X = loc.popDensity; // * 1000; // convert m^2 to ha
     const double S = 250; // scaling factor numerator
     const double result = (((mort_min_c + (mort_max_d - mort_min_c) * exp(-exp(-b_m * (log(X) - log(e))))) * (S / (exp(b_s + a * log(L))) ))) * habTypeMortConst;
+    // result is the hourly risk; a longer timestep has to survive each of its hours
+    const int hours = model.getHoursPerTimestep();
+    if (hours > 1) {
+        return (float) (1.0 - pow(1.0 - std::min(result, 1.0), hours));
+    }
     return result;
 }
 
 // Calculate growth amount and mortality risk at this fish's current location,
 // then apply growth and check mortality risk (and die if that's the way it goes)
 bool Fish::growAndDie(Model &model) {
+    KeyedRandScope keyed(model.usesCommonRandomNumbers(), RandPurpose::GrowthAndMortality, this->id, (uint64_t) model.time);
+    this->lostWeight = 0.0f;
     const float pMax = this->getPmax(model, *(this->location));
     const float growth = this->getGrowth(model, *(this->location), this->travel, pMax);
     const float mortality = this->getMortality(model, *(this->location));
@@ -548,12 +584,29 @@ bool Fish::growAndDie(Model &model) {
         return false;
     }
 
-    // Sample from bernoulli(m) to check if fish should die from mortality risk,
-    const float mortalityProbability = mortality;
-    float sample = unit_rand();
-    if (sample <= mortalityProbability) {
-        this->dieMortality(model);
-        return false;
+    if (this->weight > 1.0f) {
+        // A super-individual loses its expected number of deaths. Once less than one fish would be
+        // left, it survives as a single fish with probability equal to the remainder, so expected
+        // abundance is unchanged
+        const float remaining = this->weight * (1.0f - mortality);
+        if (remaining >= 1.0f) {
+            this->lostWeight = this->weight - remaining;
+            this->weight = remaining;
+        } else if (unit_rand() < remaining) {
+            this->lostWeight = this->weight - 1.0f;
+            this->weight = 1.0f;
+        } else {
+            this->dieMortality(model);
+            return false;
+        }
+    } else {
+        // Sample from bernoulli(m) to check if fish should die from mortality risk,
+        const float mortalityProbability = mortality;
+        float sample = unit_rand();
+        if (sample <= mortalityProbability) {
+            this->dieMortality(model);
+            return false;
+        }
     }
 
     this->forkLength = forkLengthFromMass(this->mass);
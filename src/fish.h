@@ -2,6 +2,7 @@
 #define __FISH_FISH_H
 
 #include <unordered_map>
+#include <vector>
 
 #include "model.h"
 #include "map.h"
@@ -16,15 +17,17 @@
 *   as a result of consistent negative growth
 * Exited: No longer in Model::livingIndividuals
 *   as a result of reaching an exit node
+* Merged: No longer in Model::livingIndividuals
+*   as its fish were pooled into other agents by the density movement engine
 */
-enum class FishStatus {Alive, DeadMortality, DeadStranding, DeadStarvation, Exited};
+enum class FishStatus {Alive, DeadMortality, DeadStranding, DeadStarvation, Exited, Merged};
 
 #ifndef __FISH_MODEL_CLS
 class Model;
 #endif
 
-constexpr  float HOURS_PER_TIMESTEP = 1.0f;
-constexpr  float SECONDS_PER_TIMESTEP = HOURS_PER_TIMESTEP * 60.0f*60.0f;
+// The timestep length is configurable (hoursPerTimestep; see Model::getSecondsPerTimestep)
+constexpr  float SECONDS_PER_HOUR = 60.0f*60.0f;
 
 // Haefner et al. 2002
 // This is a sustained swim speed
@@ -36,6 +39,10 @@ inline float swimSpeedFromForkLength(float forkLength) {
     return SWIM_SPEED_BODY_LENGTHS_PER_SEC * forkLength * 0.001f;
 }
 
+// Convert a mass value (in g) to a fork length value (in mm)
+// Note: the resulting value is slightly stochastic
+float forkLengthFromMass(float mass);
+
 class Fish {
 public:
     // index in Model::individuals
@@ -56,6 +63,10 @@ public:
     MapNode *location;
     // meters this fish travelled last timestep
     float travel;
+    // number of fish this agent stands for (1 unless the model runs with superIndividualSize > 1)
+    float weight;
+    // part of weight lost to mortality in the last growth update (super-individuals only)
+    float lostWeight;
     // status; see FishStatus declaration above
     FishStatus status;
     // status on model exit; only used for keeping track of fish replays
@@ -99,7 +110,8 @@ public:
         unsigned long id,
         long spawnTime,
         float forkLength,
-        MapNode *location
+        MapNode *location,
+        float weight = 1.0f
     );
 
     /*
@@ -113,16 +125,22 @@ public:
     */
     void getDestinationProbs(Model &model, std::unordered_map<MapNode *, float> &out);
     // increment the number of hours in an exit habitat
-    void incrementExitHabitatHoursByOneTimestep();
+    void incrementExitHabitatHoursByOneTimestep(const Model &model);
 
     /*
     * Run this fish's movement update:
     *   Get all reachable nodes and their costs,
     *   then sample a destination weighted by its
     *   expected growth/mortality ratio and move there
+    * A super-individual (weight of at least two split sizes, see Model::getMinSplitWeight) picks a
+    * second destination for half of its fish; if that differs, the half that goes there is added to
+    * splits as a new agent (without an ID) instead of following the rest.
     * Returns true if this fish is alive post-update
     */
-    bool move(Model &model);
+    bool move(Model &model, std::vector<Fish> *splits = nullptr);
+    // Finish a move to point (cost = meters swum, lastFlowSpeedOld = flow speed at the starting location),
+    // exiting or stranding there if need be; returns true if this fish is alive post-move
+    bool arriveAt(Model &model, MapNode *point, float cost, float lastFlowSpeedOld);
     // Register this fish as exited
     void exit(Model &model);
     // Register this fish as dead due to mortality risk
@@ -120,7 +120,7 @@ bool FishMovement::canMoveInDirectionOfEndNode(float transitSpeed, float swimSpe
 
 float FishMovement::getRemainingTime(float spentCost) const {
     float elapsedTime = spentCost / swimSpeed;
-    return SECONDS_PER_TIMESTEP - elapsedTime;
+    return model.getSecondsPerTimestep() - elapsedTime;
 }
 
 float FishMovement::calculateStayCost(MapNode *point, float spentCost) const {
@@ -4,6 +4,13 @@
 
 #include "fish_movement_downstream.h"
 
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+// Branches less likely than this stop where they are instead of being followed further
+constexpr double MIN_BRANCH_PROBABILITY = 1e-12;
+
 FishMovementDownstream::FishMovementDownstream(Model &model, float swimSpeed, float swimRange) : FishMovement(
     model, swimSpeed, swimRange, [](Model &, MapNode &, float) -> float { return 1.0f; }) {
     fixedFitness = 1.0f;
@@ -22,3 +29,62 @@ void FishMovementDownstream::addCurrentLocation(std::vector<std::tuple<MapNode *
                                                 [[maybe_unused]] float current_location_fitness) const {
     FishMovement::addCurrentLocation(neighbors, point, spentCost, stay_cost, fixedFitness);
 }
+
+std::vector<Destination> FishMovementDownstream::getDestinationDistribution(MapNode *originalLocation,
+                                                                           size_t costBins) const {
+    // Walk states still moving, keyed by (cost bin, location ID): location, probability and
+    // probability-weighted cost. Ordered so the cheapest states are expanded first, giving later
+    // arrivals in the same bin a chance to merge before it's expanded.
+    std::map<std::pair<size_t, int>, std::tuple<MapNode *, double, double> > walking;
+    // Finished walks per location: probability and probability-weighted cost
+    std::unordered_map<MapNode *, std::pair<double, double> > stopped;
+    std::vector<MapNode *> stopOrder;
+
+    auto addWalking = [&](MapNode *point, float cost, double probability) {
+        size_t bin = (size_t) (cost / swimRange * (float) costBins);
+        auto &state = walking[{bin, point->id}];
+        std::get<0>(state) = point;
+        std::get<1>(state) += probability;
+        std::get<2>(state) += probability * cost;
+    };
+    auto addStopped = [&](MapNode *point, float cost, double probability) {
+        auto it = stopped.find(point);
+        if (it == stopped.end()) {
+            it = stopped.emplace(point, std::make_pair(0.0, 0.0)).first;
+            stopOrder.push_back(point);
+        }
+        it->second.first += probability;
+        it->second.second += probability * cost;
+    };
+
+    addWalking(originalLocation, 0.0f, 1.0);
+    while (!walking.empty()) {
+        auto it = walking.begin();
+        auto [point, probability, weightedCost] = it->second;
+        walking.erase(it);
+        float cost = (float) (weightedCost / probability);
+        if (getRemainingTime(cost) <= 0.0f) {
+            addStopped(point, cost, probability);
+            continue;
+        }
+        // Every option has the same fitness, so each is equally likely
+        auto neighbors = getReachableNeighbors(point, cost, originalLocation);
+        double share = probability / (double) (neighbors.size() + 1);
+        addStopped(point, cost + calculateStayCost(point, cost), share);
+        for (auto &[next, nextCost, fitness] : neighbors) {
+            if (share < MIN_BRANCH_PROBABILITY) {
+                addStopped(next, nextCost, share);
+            } else {
+                addWalking(next, nextCost, share);
+            }
+        }
+    }
+
+    std::vector<Destination> destinations;
+    destinations.reserve(stopOrder.size());
+    for (MapNode *point : stopOrder) {
+        auto [probability, weightedCost] = stopped[point];
+        destinations.push_back({point, (float) (weightedCost / probability), probability});
+    }
+    return destinations;
+}
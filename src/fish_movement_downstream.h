@@ -6,8 +6,17 @@
 #define FISHMOVEMENTDOWNSTREAM_H
 
 
+#include <vector>
 #include "fish_movement.h"
 
+// One outcome of a timestep's movement: where the fish ends up, the meters swum to get there, and how
+// likely that is
+typedef struct Destination {
+    MapNode *node;
+    float cost;
+    double probability;
+} Destination;
+
 class FishMovementDownstream : public FishMovement {
 public:
     explicit FishMovementDownstream(Model &model, float swimSpeed, float swimRange);
@@ -15,6 +24,13 @@ public:
     bool canMoveInDirectionOfEndNode(float transitSpeed, float swimSpeed) const override;
     void addCurrentLocation(std::vector<std::tuple<MapNode *, float, float> > &neighbors, MapNode * point, float spentCost, float stay_cost, float current_location_fitness) const override;
 
+    /*
+    * Every outcome of determineNextLocation from originalLocation, with its probability (summing to 1).
+    * All branches of the walk are followed at once; walk states at the same location whose swim costs
+    * fall in the same 1/costBins of the swim range are merged at their mean cost.
+    */
+    std::vector<Destination> getDestinationDistribution(MapNode *originalLocation, size_t costBins) const;
+
 private:
     bool isTravelDirectionDownstream(float transitSpeed, float swimSpeed) const;
 
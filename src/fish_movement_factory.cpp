@@ -28,7 +28,8 @@ std::unique_ptr<FishMovement> FishMovementFactory::createFishMovement(
     }
 
     if (awareness == "high") {
-        return std::make_unique<FishMovementHighAwareness>(model, swimSpeed, swimRange, fitnessCalculator);
+        return std::make_unique<FishMovementHighAwareness>(model, swimSpeed, swimRange, fitnessCalculator,
+                                                           model.getReachabilityIndex());
     }
 
     throw std::runtime_error("Unknown AgentAwareness value: " + awareness);
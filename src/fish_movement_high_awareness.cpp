@@ -3,6 +3,8 @@
 //
 
 #include "fish_movement_high_awareness.h"
+#include <algorithm>
+#include <limits>
 #include <queue>
 #include <map>
 
@@ -24,7 +26,31 @@ std::vector<std::tuple<MapNode *, float, float> > FishMovementHighAwareness::get
     float spentCost, [[maybe_unused]] MapNode *initialFishLocation) const {
     // Dijkstra walk to find all nodes within swim range for this timestep, regardless of how many hops away.
     // include shortest distance (cost) for each
+    const double pathLength = this->reachablePathLength();
+    const bool indexed = this->reachability != nullptr && startPoint->id >= 0
+        && (size_t) startPoint->id < this->reachability->getNumNodes()
+        && this->reachability->covers((size_t) startPoint->id, pathLength);
+    std::vector<std::tuple<MapNode *, float, float> > candidates = indexed
+        ? this->searchNeighborhood(startPoint, pathLength)
+        : this->searchMap(startPoint);
 
+    for (auto &candidate: candidates) {
+        MapNode *node = std::get<0>(candidate);
+        float candCost = std::get<1>(candidate);
+
+        float fitness = fitnessCalculator(model, *node, candCost);
+        std::get<2>(candidate) = fitness;
+    }
+
+    return candidates;
+}
+
+double FishMovementHighAwareness::reachablePathLength() const {
+    const double maxFlowSpeed = this->hydroModel->getMaxFlowSpeed();
+    return (double) swimRange * ((double) swimSpeed + maxFlowSpeed) / (double) swimSpeed * 1.001 + 0.01;
+}
+
+std::vector<std::tuple<MapNode *, float, float> > FishMovementHighAwareness::searchMap(MapNode *startPoint) const {
     DijkstraMinQueue dijkstraMinQueue{MinPriorityTupleComparator()};
     dijkstraMinQueue.emplace(0.0f, startPoint);
 
@@ -62,15 +88,90 @@ std::vector<std::tuple<MapNode *, float, float> > FishMovementHighAwareness::get
             }
         }
     }
+    return candidates;
+}
 
-    for (auto &candidate: candidates) {
-        MapNode *node = std::get<0>(candidate);
-        float candCost = std::get<1>(candidate);
-
-        float fitness = fitnessCalculator(model, *node, candCost);
-        std::get<2>(candidate) = fitness;
+// Per-thread search state over a neighborhood: each location's slot (its position in the neighborhood),
+// valid while its stamp is the current search's generation, and the cheapest cost found to each slot
+typedef struct NeighborhoodScratch {
+    std::vector<uint32_t> stamps;
+    std::vector<uint32_t> slots;
+    std::vector<float> minCosts;
+    uint32_t generation = 0;
+} NeighborhoodScratch;
+
+std::vector<std::tuple<MapNode *, float, float> > FishMovementHighAwareness::searchNeighborhood(MapNode *startPoint,
+    double pathLength) const {
+    thread_local NeighborhoodScratch scratch;
+    const size_t start = (size_t) startPoint->id;
+    const uint32_t *ids = this->reachability->neighborIds(start);
+    const float *lengths = this->reachability->neighborLengths(start);
+    // Neighborhoods are nearest first, so the locations within reach are a prefix
+    const size_t count = std::upper_bound(lengths, lengths + this->reachability->neighborCount(start), pathLength,
+                                          [](double reach, float length) { return reach < (double) length; }) - lengths;
+    if (scratch.stamps.size() != this->reachability->getNumNodes()) {
+        scratch.stamps.assign(this->reachability->getNumNodes(), 0);
+        scratch.slots.resize(this->reachability->getNumNodes());
+        scratch.generation = 0;
+    }
+    if (++scratch.generation == 0) {
+        std::fill(scratch.stamps.begin(), scratch.stamps.end(), 0);
+        scratch.generation = 1;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        scratch.stamps[ids[k]] = scratch.generation;
+        scratch.slots[ids[k]] = (uint32_t) k;
     }
+    scratch.minCosts.assign(count, std::numeric_limits<float>::infinity());
+    scratch.minCosts[0] = 0.0f;
+
+    DijkstraMinQueue dijkstraMinQueue{MinPriorityTupleComparator()};
+    dijkstraMinQueue.emplace(0.0f, startPoint);
+    std::vector<std::tuple<MapNode *, float, float> > candidates;
+    candidates.reserve(count);
+
+    // The same walk and edge costs as searchMap (see FishMovement::getReachableNeighbors), without the
+    // per-edge fitness, which searchMap discards
+    while (!dijkstraMinQueue.empty()) {
+        // Not a structured binding, as the lambda below captures these
+        const float currentCost = std::get<0>(dijkstraMinQueue.top());
+        MapNode *const node = std::get<1>(dijkstraMinQueue.top());
+        dijkstraMinQueue.pop();
+        if (currentCost > scratch.minCosts[scratch.slots[node->id]]) continue;
 
+        if (node != startPoint) {
+            candidates.emplace_back(node, currentCost, 0.0);
+        }
+
+        auto relax = [&](const Edge &edge) {
+            MapNode *endNode = (node == edge.source ? edge.target : edge.source);
+            const size_t endId = (size_t) endNode->id;
+            // Locations outside the neighborhood prefix are out of reach this step
+            if (endId >= scratch.stamps.size() || scratch.stamps[endId] != scratch.generation) return;
+            if (model.hydroModel.getDepth(*endNode) < MOVEMENT_DEPTH_CUTOFF) return;
+
+            float transitSpeed = (float) calculateTransitSpeed(edge, node, swimSpeed);
+            if (!canMoveInDirectionOfEndNode(transitSpeed, swimSpeed)) return;
+            float edgeCost = (edge.length / transitSpeed) * swimSpeed;
+            if (isDistributary(endNode->type) && node == startPoint) {
+                edgeCost = std::min(edgeCost, swimRange - currentCost);
+            }
+            float totalCost = currentCost + edgeCost;
+            if (!(totalCost <= swimRange)) return;
+
+            float &minCost = scratch.minCosts[scratch.slots[endId]];
+            if (totalCost < minCost) {
+                minCost = totalCost;
+                dijkstraMinQueue.emplace(totalCost, endNode);
+            }
+        };
+        for (const Edge &edge : node->edgesIn) {
+            relax(edge);
+        }
+        for (const Edge &edge : node->edgesOut) {
+            relax(edge);
+        }
+    }
     return candidates;
 }
 
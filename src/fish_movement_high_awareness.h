@@ -6,12 +6,16 @@
 #define HEADLESS_GUI_FISHMOVEMENTHIGHAWARENESS_H
 
 #include "fish_movement.h"
+#include "reachability_index.h"
 
 class FishMovementHighAwareness : public FishMovement {
 public:
+    // With a reachability index of the model's map (see reachability_index.h), searches are limited to the
+    // start's neighborhood whenever it covers everything the fish could reach
     explicit FishMovementHighAwareness(Model &model, float swimSpeed, float swimRange,
-                                       const std::function<float(Model &, MapNode &, float)> &fitnessCalculator)
-        : FishMovement(model, swimSpeed, swimRange, fitnessCalculator) {}
+                                       const std::function<float(Model &, MapNode &, float)> &fitnessCalculator,
+                                       const ReachabilityIndex *reachability = nullptr)
+        : FishMovement(model, swimSpeed, swimRange, fitnessCalculator), reachability(reachability) {}
 
     std::vector<std::tuple<MapNode *, float, float> > getReachableNeighbors(
         MapNode *startPoint,
@@ -20,6 +24,16 @@ public:
     ) const override;
 
     std::pair<MapNode *, float> determineNextLocation(MapNode *originalLocation) override;
+
+private:
+    const ReachabilityIndex *reachability;
+
+    // Path length beyond which nothing can be reached this step, with slack for rounding in the swim costs
+    double reachablePathLength() const;
+    // The Dijkstra walk over the whole map, and over the start's indexed neighborhood (the same locations in
+    // the same order, as it only skips locations beyond reachablePathLength)
+    std::vector<std::tuple<MapNode *, float, float> > searchMap(MapNode *startPoint) const;
+    std::vector<std::tuple<MapNode *, float, float> > searchNeighborhood(MapNode *startPoint, double pathLength) const;
 };
 
 
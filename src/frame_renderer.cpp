@@ -0,0 +1,228 @@
+#include "frame_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Occupied locations are marked with a filled circle when zoomed in (the GUI uses an icon)
+constexpr RgbColor FISH_MARKER_RGB{32U, 32U, 32U};
+constexpr int FISH_MARKER_RADIUS = 3;
+
+static void setPixel(std::vector<unsigned char> &rgb, int width, int height, int x, int y, RgbColor c) {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return;
+    }
+    size_t i = ((size_t) y * width + x) * 3;
+    rgb[i] = c.r;
+    rgb[i + 1] = c.g;
+    rgb[i + 2] = c.b;
+}
+
+static void blendPixel(std::vector<unsigned char> &rgb, int width, int height, int x, int y, RgbColor c, float alpha) {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return;
+    }
+    size_t i = ((size_t) y * width + x) * 3;
+    rgb[i] = (unsigned char) (rgb[i] * (1.0f - alpha) + c.r * alpha);
+    rgb[i + 1] = (unsigned char) (rgb[i + 1] * (1.0f - alpha) + c.g * alpha);
+    rgb[i + 2] = (unsigned char) (rgb[i + 2] * (1.0f - alpha) + c.b * alpha);
+}
+
+// Clip a line to the image rectangle (Liang-Barsky); returns false if nothing is left
+static bool clipLine(float &x0, float &y0, float &x1, float &y1, int width, int height) {
+    float t0 = 0.0f;
+    float t1 = 1.0f;
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float p[4] = {-dx, dx, -dy, dy};
+    float q[4] = {x0, (float) (width - 1) - x0, y0, (float) (height - 1) - y0};
+    for (int k = 0; k < 4; ++k) {
+        if (p[k] == 0.0f) {
+            if (q[k] < 0.0f) {
+                return false;
+            }
+            continue;
+        }
+        float r = q[k] / p[k];
+        if (p[k] < 0.0f) {
+            t0 = std::max(t0, r);
+        } else {
+            t1 = std::min(t1, r);
+        }
+    }
+    if (t0 > t1) {
+        return false;
+    }
+    float sx = x0;
+    float sy = y0;
+    x0 = sx + t0 * dx;
+    y0 = sy + t0 * dy;
+    x1 = sx + t1 * dx;
+    y1 = sy + t1 * dy;
+    return true;
+}
+
+// Bresenham line, one pixel wide
+static void drawLine(std::vector<unsigned char> &rgb, int width, int height, int ax, int ay, int bx, int by, RgbColor c) {
+    float x0 = (float) ax, y0 = (float) ay, x1 = (float) bx, y1 = (float) by;
+    if (!clipLine(x0, y0, x1, y1, width, height)) {
+        return;
+    }
+    int px = (int) std::lround(x0);
+    int py = (int) std::lround(y0);
+    int qx = (int) std::lround(x1);
+    int qy = (int) std::lround(y1);
+    int dx = std::abs(qx - px);
+    int dy = -std::abs(qy - py);
+    int stepX = px < qx ? 1 : -1;
+    int stepY = py < qy ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+        setPixel(rgb, width, height, px, py, c);
+        if (px == qx && py == qy) {
+            break;
+        }
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            px += stepX;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            py += stepY;
+        }
+    }
+}
+
+static void fillCircle(std::vector<unsigned char> &rgb, int width, int height, int cx, int cy, int r, RgbColor c, float alpha = 1.0f) {
+    for (int y = -r; y <= r; ++y) {
+        for (int x = -r; x <= r; ++x) {
+            if (x*x + y*y <= r*r) {
+                if (alpha >= 1.0f) {
+                    setPixel(rgb, width, height, cx + x, cy + y, c);
+                } else {
+                    blendPixel(rgb, width, height, cx + x, cy + y, c, alpha);
+                }
+            }
+        }
+    }
+}
+
+FrameRenderer::FrameRenderer(
+    const std::vector<MapNode *> &map,
+    const std::vector<SamplingSite *> &samplingSites,
+    int width,
+    int height,
+    FrameViewport viewport
+) : map(map), width(width), height(height), viewport(viewport)
+{
+    float viewW = std::max(viewport.maxX - viewport.minX, 1e-3f);
+    float viewH = std::max(viewport.maxY - viewport.minY, 1e-3f);
+    this->scale = std::min(((float) width) / viewW, ((float) height) / viewH);
+    this->offsetX = (((float) width) - viewW * this->scale) / 2.0f;
+    this->offsetY = (((float) height) - viewH * this->scale) / 2.0f;
+
+    // Everything that can show up in the frame, including markers centred just outside it
+    float pad = 8.0f / this->scale;
+    float queryMinX = viewport.minX - this->offsetX / this->scale - pad;
+    float queryMaxX = viewport.maxX + this->offsetX / this->scale + pad;
+    float queryMinY = viewport.minY - this->offsetY / this->scale - pad;
+    float queryMaxY = viewport.maxY + this->offsetY / this->scale + pad;
+    SpatialGrid grid(map);
+    grid.queryNodes(queryMinX, queryMinY, queryMaxX, queryMaxY, this->visibleNodes);
+    std::vector<size_t> segments;
+    grid.querySegments(queryMinX, queryMinY, queryMaxX, queryMaxY, segments);
+
+    this->mapLayer.assign((size_t) width * height * 3, 255U);
+    for (size_t si : segments) {
+        const MapSegment &seg = grid.getSegments()[si];
+        MapNode *a = map[seg.sourceIndex];
+        MapNode *b = map[seg.targetIndex];
+        drawLine(this->mapLayer, width, height, toPixelX(a->x), toPixelY(a->y), toPixelX(b->x), toPixelY(b->y), getHabitatRgb(seg.type));
+    }
+    for (int nodeId : grid.getDanglingNodes()) {
+        fillCircle(this->mapLayer, width, height, toPixelX(map[nodeId]->x), toPixelY(map[nodeId]->y), 3, DANGLING_EDGE_RGB);
+    }
+    for (SamplingSite *site : samplingSites) {
+        for (MapNode *n : site->points) {
+            fillCircle(this->mapLayer, width, height, toPixelX(n->x), toPixelY(n->y), 4, SAMPLING_SITE_RGB, 0.5f);
+        }
+    }
+}
+
+FrameViewport FrameRenderer::fitMap(const std::vector<MapNode *> &map) {
+    FrameViewport v{0.0f, 0.0f, 1.0f, 1.0f};
+    for (size_t i = 0; i < map.size(); ++i) {
+        if (i == 0) {
+            v.minX = v.maxX = map[i]->x;
+            v.minY = v.maxY = map[i]->y;
+        } else {
+            v.minX = std::min(v.minX, map[i]->x);
+            v.minY = std::min(v.minY, map[i]->y);
+            v.maxX = std::max(v.maxX, map[i]->x);
+            v.maxY = std::max(v.maxY, map[i]->y);
+        }
+    }
+    return v;
+}
+
+// Points far outside the frame are clamped so the int conversion can't overflow (lines are clipped anyway)
+constexpr float MAX_PIXEL_COORD = 1.0e7f;
+
+int FrameRenderer::toPixelX(float x) const {
+    float px = std::floor(this->offsetX + (x - this->viewport.minX) * this->scale);
+    return (int) std::max(-MAX_PIXEL_COORD, std::min(MAX_PIXEL_COORD, px));
+}
+
+int FrameRenderer::toPixelY(float y) const {
+    float py = std::floor(this->offsetY + (this->viewport.maxY - y) * this->scale);
+    return (int) std::max(-MAX_PIXEL_COORD, std::min(MAX_PIXEL_COORD, py));
+}
+
+void FrameRenderer::render(const RenderSnapshot &snapshot, std::vector<unsigned char> &rgb) const {
+    rgb = this->mapLayer;
+    if (this->visibleNodes.size() <= DENSITY_LAYER_NODE_THRESHOLD) {
+        for (int nodeId : this->visibleNodes) {
+            if (snapshot.occupancy[nodeId] > 0U) {
+                fillCircle(rgb, this->width, this->height, toPixelX(this->map[nodeId]->x), toPixelY(this->map[nodeId]->y),
+                    FISH_MARKER_RADIUS, FISH_MARKER_RGB);
+            }
+        }
+        return;
+    }
+    // Zoomed out: bin occupancy in screen space and shade by log(count), as MapView does
+    int binCols = this->width / DENSITY_BIN_SIZE + 1;
+    int binRows = this->height / DENSITY_BIN_SIZE + 1;
+    std::vector<unsigned> bins((size_t) binCols * binRows, 0U);
+    unsigned maxCount = 0U;
+    for (int nodeId : this->visibleNodes) {
+        if (snapshot.occupancy[nodeId] == 0U) {
+            continue;
+        }
+        int x0 = toPixelX(this->map[nodeId]->x);
+        int y0 = toPixelY(this->map[nodeId]->y);
+        if (x0 < 0 || x0 >= this->width || y0 < 0 || y0 >= this->height) {
+            continue;
+        }
+        unsigned &bin = bins[(size_t) (y0 / DENSITY_BIN_SIZE) * binCols + x0 / DENSITY_BIN_SIZE];
+        bin += snapshot.occupancy[nodeId];
+        maxCount = std::max(maxCount, bin);
+    }
+    if (maxCount == 0U) {
+        return;
+    }
+    float logMax = std::log(1.0f + (float) maxCount);
+    for (int by = 0; by < binRows; ++by) {
+        for (int bx = 0; bx < binCols; ++bx) {
+            unsigned count = bins[(size_t) by * binCols + bx];
+            if (count == 0U) {
+                continue;
+            }
+            RgbColor c = getDensityRgb(std::log(1.0f + (float) count) / logMax);
+            for (int y = by * DENSITY_BIN_SIZE; y < std::min(this->height, (by + 1) * DENSITY_BIN_SIZE); ++y) {
+                for (int x = bx * DENSITY_BIN_SIZE; x < std::min(this->width, (bx + 1) * DENSITY_BIN_SIZE); ++x) {
+                    setPixel(rgb, this->width, this->height, x, y, c);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef __FISH_FRAME_RENDERER_H
+#define __FISH_FRAME_RENDERER_H
+
+#include <memory>
+#include <vector>
+#include "map.h"
+#include "map_colors.h"
+#include "render_snapshot.h"
+#include "spatial_index.h"
+
+// Map-coordinate rectangle shown in a frame
+typedef struct FrameViewport {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+} FrameViewport;
+
+/*
+* Software rasterizer for animation frames: draws the map (edges coloured by habitat,
+* dangling-edge markers, sampling sites) and a snapshot's occupancy into an RGB buffer,
+* with no GUI toolkit involved. The map layer is drawn once at construction; render()
+* only copies it and adds occupancy, and is safe to call from several threads at once.
+*/
+class FrameRenderer {
+public:
+    // Past this many locations in the viewport, occupancy is drawn as a density layer (as in the GUI)
+    static constexpr size_t DENSITY_LAYER_NODE_THRESHOLD = 1500;
+    // Edge length (pixels) of a density layer bin
+    static constexpr int DENSITY_BIN_SIZE = 12;
+
+    FrameRenderer(
+        const std::vector<MapNode *> &map,
+        const std::vector<SamplingSite *> &samplingSites,
+        int width,
+        int height,
+        FrameViewport viewport
+    );
+
+    // Viewport covering the whole map
+    static FrameViewport fitMap(const std::vector<MapNode *> &map);
+
+    // Fill rgb (width*height*3 bytes, rows top to bottom) with the map and the snapshot's occupancy
+    void render(const RenderSnapshot &snapshot, std::vector<unsigned char> &rgb) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // Pixel coordinates of a map point
+    int toPixelX(float x) const;
+    int toPixelY(float y) const;
+
+private:
+    const std::vector<MapNode *> &map;
+    int width;
+    int height;
+    FrameViewport viewport;
+    // Pixels per map unit (equal on both axes; the viewport is centred if its aspect ratio differs)
+    float scale;
+    float offsetX;
+    float offsetY;
+    std::vector<unsigned char> mapLayer;
+    // Map indices of the locations inside the viewport
+    std::vector<int> visibleNodes;
+};
+
+#endif
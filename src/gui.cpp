@@ -13,8 +13,11 @@
 #include <wx/dcbuffer.h>
 #include <wx/frame.h>
 #include <wx/filedlg.h>
+#include <wx/slider.h>
 
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -25,19 +28,27 @@
 #include "model.h"
 #include "fish.h"
 #include "hydro.h"
+#include "render_snapshot.h"
+#include "simulation_runner.h"
+#include "spatial_index.h"
+#include "map_colors.h"
 
 wxPen infoBorderPen(wxColour(72, 72, 72));
 wxBrush infoBgBrush(wxColour(255, 255, 255, 192), wxSOLID);
 
-wxColour IMPOUNDMENT_COLOUR(64U, 255U, 128U);
-wxColour DISTRIBUTARY_COLOUR(0U, 0U, 255U);
-wxColour DISTRIBUTARY_EDGE_COLOUR(0U, 128U, 255U);
-wxColour BLIND_CHANNEL_COLOUR(0U, 128U, 0U);
-wxColour LOW_TIDE_TERRACE_COLOUR(64U, 128U, 128U);
-wxColour NEARSHORE_COLOUR(128U, 0U, 128U);
-wxColour BOAT_HARBOR_COLOUR(128U, 128U, 0U);
+wxColour toWxColour(RgbColor c, unsigned char alpha = wxALPHA_OPAQUE) {
+    return wxColour(c.r, c.g, c.b, alpha);
+}
+
+wxColour IMPOUNDMENT_COLOUR = toWxColour(IMPOUNDMENT_RGB);
+wxColour DISTRIBUTARY_COLOUR = toWxColour(DISTRIBUTARY_RGB);
+wxColour DISTRIBUTARY_EDGE_COLOUR = toWxColour(DISTRIBUTARY_EDGE_RGB);
+wxColour BLIND_CHANNEL_COLOUR = toWxColour(BLIND_CHANNEL_RGB);
+wxColour LOW_TIDE_TERRACE_COLOUR = toWxColour(LOW_TIDE_TERRACE_RGB);
+wxColour NEARSHORE_COLOUR = toWxColour(NEARSHORE_RGB);
+wxColour BOAT_HARBOR_COLOUR = toWxColour(BOAT_HARBOR_RGB);
 
-wxBrush samplingSiteHighlightBrush(wxColour(255, 192, 0, 128), wxSOLID);
+wxBrush samplingSiteHighlightBrush(toWxColour(SAMPLING_SITE_RGB, 128), wxSOLID);
 
 wxPen upstreamHighlightPen(wxColour(255, 0, 0, 64), 2);
 wxPen downstreamHighlightPen(wxColour(0, 0, 255, 64), 2);
@@ -104,6 +115,8 @@ std::string getStatusName(FishStatus s) {
         return "Dead (Starvation)";
     case FishStatus::Exited:
         return "Exited";
+    case FishStatus::Merged:
+        return "Merged";
     }
 }
 
@@ -134,12 +147,12 @@ void getMonthAndDayOfMonth(int day, std::string &monthOut, int &dayOfMonthOut) {
 }
 
 std::string formatTimestep(Model &model, int timestep) {
-    int globalTimestep = timestep + model.globalTimeIntercept;
-    int day = globalTimestep / 24;
+    int globalHour = timestep * model.getHoursPerTimestep() + model.globalTimeIntercept;
+    int day = globalHour / 24;
     std::string month;
     int dayOfMonth;
     getMonthAndDayOfMonth(day, month, dayOfMonth);
-    int hour = globalTimestep % 24;
+    int hour = globalHour % 24;
     std::string amPm = hour < 12 ? "am" : "pm";
     int minute = 0;
     std::string minuteStr = std::to_string(minute);
@@ -161,18 +174,23 @@ wxColour getRangeColor(float rangeVal) {
     return wxColour(r, g, 0U, 128U);
 }
 
-std::vector<std::string> getLocInfo(Model &model, MapNode &node) {
+// Node geometry and habitat never change during a run, so they're read from the node itself;
+// everything time-varying comes from the snapshot
+std::vector<std::string> getLocInfo(Model &model, MapNode &node, const RenderSnapshot &snapshot) {
     std::vector<std::string> result;
     std::ostringstream os;
     os << "Node ID: " << node.id + 1; result.push_back(os.str()); os.str("");
-    os << "Pop. density: " << node.popDensity; result.push_back(os.str()); os.str("");
+    os << "Pop. density: " << snapshot.popDensity[node.id]; result.push_back(os.str()); os.str("");
     os << "Habitat type: " << getHabTypeName(node.type); result.push_back(os.str()); os.str("");
     os << "Elevation: " << node.elev << "m"; result.push_back(os.str()); os.str("");
     os << "Area: " << node.area << "m2"; result.push_back(os.str()); os.str("");
-    os << "Depth: " << model.hydroModel.getDepth(node) << "m"; result.push_back(os.str()); os.str("");
-    os << "Temp: " << model.hydroModel.getTemp(node) << "C"; result.push_back(os.str()); os.str("");
-    os << "Flow speed: " << model.hydroModel.getUnsignedFlowSpeedAt(node) << "m/s"; result.push_back(os.str()); os.str("");
-    os << "Flow velocity (u, v): " << model.hydroModel.getCurrentU(node) << ", " << model.hydroModel.getCurrentV(node) << "m/s"; result.push_back(os.str()); os.str("");
+    if (snapshot.selectedNodeId == node.id) {
+        const NodeRenderState &env = snapshot.selectedNode;
+        os << "Depth: " << env.depth << "m"; result.push_back(os.str()); os.str("");
+        os << "Temp: " << env.temp << "C"; result.push_back(os.str()); os.str("");
+        os << "Flow speed: " << env.flowSpeed << "m/s"; result.push_back(os.str()); os.str("");
+        os << "Flow velocity (u, v): " << env.flowVelocity.u << ", " << env.flowVelocity.v << "m/s"; result.push_back(os.str()); os.str("");
+    }
     for (SamplingSite *site : model.samplingSites) {
         for (MapNode *point : site->points) {
             if (point->id == node.id) {
@@ -183,7 +201,7 @@ std::vector<std::string> getLocInfo(Model &model, MapNode &node) {
     return result;
 }
 
-std::vector<std::string> getFishInfo(Model &model, Fish &fish) {
+std::vector<std::string> getFishInfo(Model &model, const FishRenderState &fish) {
     std::vector<std::string> result;
     std::ostringstream os;
     os << "Fish ID: " << fish.id; result.push_back(os.str()); os.str("");
@@ -204,20 +222,23 @@ std::vector<std::string> getFishInfo(Model &model, Fish &fish) {
     return result;
 }
 
-std::vector<std::string> getPopInfo(Model &model) {
+std::vector<std::string> getPopInfo(const RenderSnapshot &snapshot) {
     std::vector<std::string> result;
     std::ostringstream os;
-    os << "Living pop.: " << model.livingIndividuals.size(); result.push_back(os.str()); os.str("");
-    os << "Dead pop.: " << model.deadCount; result.push_back(os.str()); os.str("");
-    os << "Exited pop.: " << model.exitedCount; result.push_back(os.str()); os.str("");
+    os << "Living pop.: " << snapshot.livingCount; result.push_back(os.str()); os.str("");
+    os << "Dead pop.: " << snapshot.deadCount; result.push_back(os.str()); os.str("");
+    os << "Exited pop.: " << snapshot.exitedCount; result.push_back(os.str()); os.str("");
     return result;
 }
 
-std::vector<std::string> getTimeInfo(Model &model) {
+std::vector<std::string> getTimeInfo(Model &model, const RenderSnapshot &snapshot, bool running) {
     std::vector<std::string> result;
     std::ostringstream os;
-    os << "Time: " << formatTimestep(model, model.time); result.push_back(os.str()); os.str("");
-    os << "Timestep: " << model.time; result.push_back(os.str()); os.str("");
+    os << "Time: " << formatTimestep(model, snapshot.time); result.push_back(os.str()); os.str("");
+    os << "Timestep: " << snapshot.time; result.push_back(os.str()); os.str("");
+    if (running) {
+        os << "Running..."; result.push_back(os.str()); os.str("");
+    }
     return result;
 }
 
@@ -258,10 +279,29 @@ public:
     virtual bool OnInit();
 };
 
+// Edge length (pixels) of the square map tiles cached per zoom level
+constexpr int TILE_SIZE = 256;
+// Tiles kept across all zoom levels before least recently used levels are dropped
+constexpr size_t MAX_CACHED_TILES = 384;
+// Past this many locations on screen, occupancy is drawn as a density layer instead of per-location icons
+constexpr size_t DENSITY_LAYER_NODE_THRESHOLD = 1500;
+// Edge length (pixels) of a density layer bin
+constexpr int DENSITY_BIN_SIZE = 12;
+
+// Rendered map tiles for one zoom level, keyed by packed tile column/row
+typedef struct TileLevel {
+    std::unordered_map<long long, wxBitmap> tiles;
+    unsigned long lastUsed;
+} TileLevel;
+
 class MapView : public wxPanel {
 public:
-    MapView(wxWindow *parent, Model *model, wxChoice *fishSelector, wxButton *tagButton, int w, int h);
+    MapView(wxWindow *parent, Model *model, SimulationRunner *runner, wxChoice *fishSelector, wxButton *tagButton, int w, int h);
     Model *model;
+    // Steps the model in the background and publishes the snapshots drawn by OnPaint
+    SimulationRunner *runner;
+    // The most recent snapshot received from the runner
+    std::unique_ptr<RenderSnapshot> snapshot;
     float minX;
     float minY;
     float maxX;
@@ -271,29 +311,42 @@ public:
     float mapCenterX;
     float mapCenterY;
     float viewZoom;
-    wxBitmap *_buffer;
+    // Zoom that fits the whole map in the initial view; tile zoom levels are powers of 1.5 from here
+    float baseZoom;
+    // Spatial index over the (fixed) map, so painting and hit-testing only visit what's on screen
+    std::unique_ptr<SpatialGrid> grid;
+    // Cached map tiles by zoom level
+    std::map<int, TileLevel> tileLevels;
+    size_t cachedTileCount;
+    unsigned long paintCount;
     wxBitmap *fishIcon;
     bool isGrabbed;
     wxPoint mouseGrabCoords;
     float preGrabCenterX;
     float preGrabCenterY;
     MapNode *selectedNode;
-    std::unordered_set<MapNode *> mapSet;
     long selectedFishId;
-    std::unordered_map<MapNode *, float> selectedFishRange;
+    // Fish IDs currently listed in fishSelector
+    std::vector<long> listedResidents;
     wxChoice *fishSelector;
     wxButton *tagButton;
     void OnSize(wxSizeEvent &evt);
     void OnPaint(wxPaintEvent &evt);
-    void redraw(wxDC &drawContext, float centerX, float centerY, float viewW, float viewH);
+    int getZoomLevel();
+    float getLevelZoom(int level);
+    const wxBitmap &getTile(int level, int tx, int ty);
+    void renderTile(wxDC &dc, float levelZoom, int tx, int ty);
+    void evictTiles(int keepLevel);
+    void drawDensityLayer(wxDC &dc, const RenderSnapshot &snap, const std::vector<int> &visibleNodes, int w, int h);
     void grab(wxMouseEvent &evt);
     void release(wxMouseEvent &evt);
     void mouseMove(wxMouseEvent &evt);
     void selectNode(wxMouseEvent &evt);
     void updateDropdown();
     void selectFish(wxCommandEvent &evt);
-    void updateSelectedFishRange();
     void tagFish(wxCommandEvent &event);
+    void consumeSnapshot();
+    void requestSnapshot();
     void onModelUpdate();
     void onModelReset();
 
@@ -309,35 +362,27 @@ wxBEGIN_EVENT_TABLE(MapView, wxPanel)
     EVT_LEFT_DCLICK(MapView::selectNode)
 wxEND_EVENT_TABLE()
 
-MapView::MapView(wxWindow *parent, Model *model, wxChoice *fishSelector, wxButton *tagButton, int w, int h)
-    : wxPanel(parent), model(model), _buffer(nullptr),
+MapView::MapView(wxWindow *parent, Model *model, SimulationRunner *runner, wxChoice *fishSelector, wxButton *tagButton, int w, int h)
+    : wxPanel(parent), model(model), runner(runner), grid(new SpatialGrid(model->map)), cachedTileCount(0), paintCount(0),
     isGrabbed(false), selectedNode(nullptr), selectedFishId(-1L), fishSelector(fishSelector), tagButton(tagButton)
 {
-    bool first = true;
-    for (MapNode *n : model->map) {
-        this->mapSet.insert(n);
-        if (first) {
-            this->minX = this->maxX = n->x;
-            this->minY = this->maxY = n->y;
-            first = false;
-        } else {
-            this->minX = std::min(this->minX, n->x);
-            this->minY = std::min(this->minY, n->y);
-            this->maxX = std::max(this->maxX, n->x);
-            this->maxY = std::max(this->maxY, n->y);
-        }
-    }
+    this->minX = this->grid->getMinX();
+    this->minY = this->grid->getMinY();
+    this->maxX = this->grid->getMaxX();
+    this->maxY = this->grid->getMaxY();
     this->mapW = this->maxX - this->minX;
     this->mapH = this->maxY - this->minY;
     this->mapCenterX = this->minX + this->mapW / 2.0f;
     this->mapCenterY = this->minY + this->mapH / 2.0f;
     this->viewZoom = std::min(((float) w) / this->mapW, ((float) h) / this->mapH);
+    this->baseZoom = this->viewZoom;
     this->SetBackgroundStyle(wxBG_STYLE_PAINT);
     this->SetBackgroundColour(*wxWHITE);
     wxImage::AddHandler(new wxPNGHandler);
     this->fishIcon = new wxBitmap(wxImage("fish_icon.png", wxBITMAP_TYPE_PNG));
     this->fishSelector->Bind(wxEVT_COMMAND_CHOICE_SELECTED, &MapView::selectFish, this);
     this->tagButton->Bind(wxEVT_COMMAND_BUTTON_CLICKED, &MapView::tagFish, this);
+    this->snapshot = captureRenderSnapshot(*this->model, -1, -1L);
     this->Show();
 }
 
@@ -361,24 +406,50 @@ void MapView::OnPaint(wxPaintEvent &evt) {
     wxAutoBufferedPaintDC dc((wxWindow *) this);
     dc.SetBackground(*wxWHITE_BRUSH);
     dc.Clear();
-    if (this->_buffer == nullptr) {
-        int fullW = (int) (this->viewZoom * this->mapW);
-        int fullH = (int) (this->viewZoom * this->mapH);
-        if (fullW > 2*w && fullH > 2*h) {
-            this->redraw(dc, this->mapCenterX, this->mapCenterY, (float) w, (float) h);
-        } else {
-            this->_buffer = new wxBitmap(fullW, fullH);
-            wxMemoryDC mdc(*this->_buffer);
-            mdc.SetBackground(*wxWHITE_BRUSH);
-            mdc.Clear();
-            this->redraw(mdc, this->minX + this->mapW/2.0f, this->minY + this->mapH/2.0f, (float) fullW, (float) fullH);
+    this->consumeSnapshot();
+    const RenderSnapshot &snap = *this->snapshot;
+    ++this->paintCount;
+
+    // Blit the visible tiles of the current zoom level (tile pixel coordinates are measured from the map's top left)
+    int level = this->getZoomLevel();
+    float levelZoom = this->getLevelZoom(level);
+    float left = (this->mapCenterX - this->minX) * levelZoom - ((float) w)/2.0f;
+    float top = (this->maxY - this->mapCenterY) * levelZoom - ((float) h)/2.0f;
+    int tileCols = (int) std::ceil(this->mapW * levelZoom / (float) TILE_SIZE) + 1;
+    int tileRows = (int) std::ceil(this->mapH * levelZoom / (float) TILE_SIZE) + 1;
+    int tx0 = std::max(0, (int) std::floor(left / (float) TILE_SIZE));
+    int ty0 = std::max(0, (int) std::floor(top / (float) TILE_SIZE));
+    int tx1 = std::min(tileCols - 1, (int) std::floor((left + (float) w) / (float) TILE_SIZE));
+    int ty1 = std::min(tileRows - 1, (int) std::floor((top + (float) h) / (float) TILE_SIZE));
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            dc.DrawBitmap(this->getTile(level, tx, ty), (int) std::floor(tx*TILE_SIZE - left), (int) std::floor(ty*TILE_SIZE - top));
         }
     }
-    if (this->_buffer != nullptr) {
-        dc.DrawBitmap(*this->_buffer,
-            (int) zoom(this->minX, this->mapCenterX, ((float) w)/2.0f, this->viewZoom),
-            (int) zoom(this->maxY, this->mapCenterY, ((float) h)/2.0f, -this->viewZoom)
-        );
+    this->evictTiles(level);
+
+    // Occupancy: per-location fish icons when zoomed in, an aggregated density layer when zoomed out
+    std::vector<int> visibleNodes;
+    float marginX = 8.0f / this->viewZoom;
+    float marginY = 8.0f / this->viewZoom;
+    this->grid->queryNodes(
+        unzoom(0.0f, this->mapCenterX, ((float) w)/2.0f, this->viewZoom) - marginX,
+        unzoom((float) h, this->mapCenterY, ((float) h)/2.0f, -this->viewZoom) - marginY,
+        unzoom((float) w, this->mapCenterX, ((float) w)/2.0f, this->viewZoom) + marginX,
+        unzoom(0.0f, this->mapCenterY, ((float) h)/2.0f, -this->viewZoom) + marginY,
+        visibleNodes
+    );
+    if (visibleNodes.size() > DENSITY_LAYER_NODE_THRESHOLD) {
+        this->drawDensityLayer(dc, snap, visibleNodes, w, h);
+    } else {
+        for (int nodeId : visibleNodes) {
+            if (snap.occupancy[nodeId] > 0U) {
+                MapNode *n = this->model->map[nodeId];
+                int x0 = (int) zoom(n->x, this->mapCenterX, ((float) w)/2.0f, this->viewZoom);
+                int y0 = (int) zoom(n->y, this->mapCenterY, ((float) h)/2.0f, -this->viewZoom);
+                dc.DrawBitmap(*this->fishIcon, x0-8, y0-8);
+            }
+        }
     }
     if (this->selectedNode != nullptr) {
         dc.SetBrush(wxNullBrush);
@@ -428,46 +499,38 @@ void MapView::OnPaint(wxPaintEvent &evt) {
         }
         dc.SetTextForeground(*wxBLACK);
         dc.SetPen(wxNullPen);
-        if (this->selectedFishId != -1) {
-            for (auto it = this->selectedFishRange.begin(); it != this->selectedFishRange.end(); ++it) {
-                MapNode *n = it->first;
+        if (snap.selectedFishId != -1) {
+            dc.SetBrush(wxBrush(getRangeColor(0.0f)));
+            for (int nodeId : snap.selectedFishRange) {
+                MapNode *n = this->model->map[nodeId];
                 int x0 = (int) zoom(n->x, this->mapCenterX, ((float) w)/2.0f, this->viewZoom);
                 int y0 = (int) zoom(n->y, this->mapCenterY, ((float) h)/2.0f, -this->viewZoom);
-                dc.SetBrush(wxBrush(getRangeColor(it->second)));
                 dc.DrawCircle(x0, y0, 6);
             }
         }
         dc.SetPen(infoBorderPen);
         dc.SetBrush(infoBgBrush);
-        std::vector<std::string> text = getLocInfo(*this->model, *this->selectedNode);
+        std::vector<std::string> text = getLocInfo(*this->model, *this->selectedNode, snap);
         int textW; int textH;
         getTextExtentMultiline(dc, text, textW, textH);
         dc.DrawRectangle(w - textW - 5 - 10, 5, textW + 10, textH + 10);
         dc.DrawText(strJoin("\n", text), w - textW - 10, 10);
-        if (this->selectedFishId != -1) {
-            Fish &selectedFish = this->model->individuals[this->selectedFishId];
-            std::vector<std::string> text2 = getFishInfo(*this->model, selectedFish);
+        if (snap.selectedFishId != -1) {
+            std::vector<std::string> text2 = getFishInfo(*this->model, snap.selectedFish);
             int text2W; int text2H;
             getTextExtentMultiline(dc, text2, text2W, text2H);
             dc.DrawRectangle(w - text2W - 5 - 10, 5 + textH + 10 + 5, text2W + 10, text2H + 10);
             dc.DrawText(strJoin("\n", text2), w - text2W - 10, textH + 10 + 5 + 10);
         }
     }
-    for (MapNode *n : this->model->map) {
-        if (n->popDensity > 0.0f) {
-            int x0 = (int) zoom(n->x, this->mapCenterX, ((float) w)/2.0f, this->viewZoom);
-            int y0 = (int) zoom(n->y, this->mapCenterY, ((float) h)/2.0f, -this->viewZoom);
-            dc.DrawBitmap(*this->fishIcon, x0-8, y0-8);
-        }
-    }
     dc.SetPen(infoBorderPen);
     dc.SetBrush(infoBgBrush);
-    std::vector<std::string> popText = getPopInfo(*this->model);
+    std::vector<std::string> popText = getPopInfo(snap);
     int popTextW; int popTextH;
     getTextExtentMultiline(dc, popText, popTextW, popTextH);
     dc.DrawRectangle(5, h - popTextH - 5 - 10, popTextW + 10, popTextH + 10);
     dc.DrawText(strJoin("\n", popText), 10, h - popTextH - 10);
-    std::vector<std::string> timeText = getTimeInfo(*this->model);
+    std::vector<std::string> timeText = getTimeInfo(*this->model, snap, this->runner->isRunning());
     int timeTextW; int timeTextH;
     getTextExtentMultiline(dc, timeText, timeTextW, timeTextH);
     dc.DrawRectangle(5, 5, timeTextW + 10, timeTextH + 10);
@@ -489,74 +552,144 @@ void MapView::OnPaint(wxPaintEvent &evt) {
     }
 }
 
-void MapView::redraw(wxDC &dc, float centerX, float centerY, float viewW, float viewH) {
-    for (MapNode *n : this->model->map) {
-        int x0 = (int) zoom(n->x, centerX, viewW/2.0f, this->viewZoom);
-        int y0 = (int) zoom(n->y, centerY, viewH/2.0f, -this->viewZoom);
-        if (x0 < 0 || x0 > ((int) viewW) || y0 < 0 || y0 > ((int) viewH)) {
-            continue;
-        }
-        for (Edge &e : n->edgesOut) {
-            if (!this->mapSet.count(e.target)) {
-                dc.SetBrush(*wxRED_BRUSH);
-                dc.DrawCircle(x0, y0, 3);
-                dc.SetBrush(wxNullBrush);
-                continue;
-            }
-            if (n->type == HabitatType::DistributaryEdge && e.target->type == HabitatType::DistributaryEdge) {
-                dc.SetPen(wxPen(*getHabitatColor(HabitatType::DistributaryEdge)));
-            } else {
-                dc.SetPen(wxPen(*getHabitatColor(n->type)));
-            }
-            int x1 = (int) zoom(e.target->x, centerX, viewW/2.0f, this->viewZoom);
-            int y1 = (int) zoom(e.target->y, centerY, viewH/2.0f, -this->viewZoom);
-            dc.DrawLine(x0, y0, x1, y1);
-        }
-        for (Edge &e : n->edgesIn) {
-            if (!this->mapSet.count(e.source)) {
-                dc.SetBrush(*wxRED_BRUSH);
-                dc.DrawCircle(x0, y0, 3);
-                dc.SetBrush(wxNullBrush);
-                continue;
-            }
-            int x1 = (int) zoom(e.source->x, centerX, viewW/2.0f, this->viewZoom);
-            int y1 = (int) zoom(e.source->y, centerY, viewH/2.0f, -this->viewZoom);
-            if (x1 < 0 || x1 > ((int) viewW) || y1 < 0 || y1 > ((int) viewH)) {
-                if (n->type == HabitatType::DistributaryEdge && e.source->type == HabitatType::DistributaryEdge) {
-                    dc.SetPen(wxPen(*getHabitatColor(HabitatType::DistributaryEdge)));
-                } else {
-                    dc.SetPen(wxPen(*getHabitatColor(e.source->type)));
-                }
-                dc.DrawLine(x0, y0, x1, y1);
-            }
+// Zoom levels are steps of the 1.5x zoom buttons away from the initial (whole map) zoom
+int MapView::getZoomLevel() {
+    return (int) std::lround(std::log(this->viewZoom / this->baseZoom) / std::log(1.5f));
+}
+
+float MapView::getLevelZoom(int level) {
+    return this->baseZoom * std::pow(1.5f, (float) level);
+}
+
+const wxBitmap &MapView::getTile(int level, int tx, int ty) {
+    TileLevel &tileLevel = this->tileLevels[level];
+    tileLevel.lastUsed = this->paintCount;
+    long long key = (((long long) tx) << 32) | (unsigned int) ty;
+    auto it = tileLevel.tiles.find(key);
+    if (it != tileLevel.tiles.end()) {
+        return it->second;
+    }
+    wxBitmap &tile = tileLevel.tiles[key];
+    tile.Create(TILE_SIZE, TILE_SIZE);
+    wxMemoryDC mdc(tile);
+    mdc.SetBackground(*wxWHITE_BRUSH);
+    mdc.Clear();
+    this->renderTile(mdc, this->getLevelZoom(level), tx, ty);
+    mdc.SelectObject(wxNullBitmap);
+    ++this->cachedTileCount;
+    return tile;
+}
+
+// Draw the map edges, dangling-edge markers and sampling sites falling inside one tile
+void MapView::renderTile(wxDC &dc, float levelZoom, int tx, int ty) {
+    // Tile bounds in map coordinates, padded by the largest marker radius
+    float pad = 4.0f / levelZoom;
+    float tileMinX = this->minX + ((float) (tx*TILE_SIZE)) / levelZoom;
+    float tileMaxX = this->minX + ((float) ((tx + 1)*TILE_SIZE)) / levelZoom;
+    float tileMaxY = this->maxY - ((float) (ty*TILE_SIZE)) / levelZoom;
+    float tileMinY = this->maxY - ((float) ((ty + 1)*TILE_SIZE)) / levelZoom;
+    auto toTileX = [&](float x) { return (int) std::floor((x - this->minX) * levelZoom) - tx*TILE_SIZE; };
+    auto toTileY = [&](float y) { return (int) std::floor((this->maxY - y) * levelZoom) - ty*TILE_SIZE; };
+    auto inTile = [&](MapNode *n) {
+        return n->x >= tileMinX - pad && n->x <= tileMaxX + pad && n->y >= tileMinY - pad && n->y <= tileMaxY + pad;
+    };
+
+    std::vector<size_t> segments;
+    this->grid->querySegments(tileMinX - pad, tileMinY - pad, tileMaxX + pad, tileMaxY + pad, segments);
+    for (size_t si : segments) {
+        const MapSegment &seg = this->grid->getSegments()[si];
+        MapNode *a = this->model->map[seg.sourceIndex];
+        MapNode *b = this->model->map[seg.targetIndex];
+        dc.SetPen(wxPen(*getHabitatColor(seg.type)));
+        dc.DrawLine(toTileX(a->x), toTileY(a->y), toTileX(b->x), toTileY(b->y));
+    }
+    dc.SetBrush(*wxRED_BRUSH);
+    for (int nodeId : this->grid->getDanglingNodes()) {
+        MapNode *n = this->model->map[nodeId];
+        if (inTile(n)) {
+            dc.DrawCircle(toTileX(n->x), toTileY(n->y), 3);
         }
     }
     dc.SetPen(wxNullPen);
     dc.SetBrush(samplingSiteHighlightBrush);
     for (SamplingSite *site : this->model->samplingSites) {
         for (MapNode *n : site->points) {
-            int x0 = (int) zoom(n->x, centerX, viewW/2.0f, this->viewZoom);
-            int y0 = (int) zoom(n->y, centerY, viewH/2.0f, -this->viewZoom);
-            if (x0 < 0 || x0 > ((int) viewW) || y0 < 0 || y0 > ((int) viewH)) {
-                continue;
+            if (inTile(n)) {
+                dc.DrawCircle(toTileX(n->x), toTileY(n->y), 4);
             }
-            dc.DrawCircle(x0, y0, 4);
         }
     }
     #ifdef DRAW_HYDRO_NODES
     dc.SetPen(*wxRED_PEN);
     dc.SetBrush(wxNullBrush);
     for (DistribHydroNode &n : this->model->hydroModel.hydroNodes) {
-        int x0 = (int) zoom(n.x, centerX, viewW/2.0f, this->viewZoom);
-        int y0 = (int) zoom(n.y, centerY, viewH/2.0f, -this->viewZoom);
-        if (x0 < 0 || x0 > ((int) viewW) || y0 < 0 || y0 > ((int) viewH)) {
+        if (n.x < tileMinX - pad || n.x > tileMaxX + pad || n.y < tileMinY - pad || n.y > tileMaxY + pad) {
             continue;
         }
-        dc.DrawCircle(x0, y0, 4);
+        dc.DrawCircle(toTileX(n.x), toTileY(n.y), 4);
     }
     #endif
 }
 
+// Drop whole zoom levels, least recently used first, until the cache is back under its limit
+// (the level being displayed is kept even if it alone exceeds the limit)
+void MapView::evictTiles(int keepLevel) {
+    while (this->cachedTileCount > MAX_CACHED_TILES && this->tileLevels.size() > 1) {
+        auto oldest = this->tileLevels.end();
+        for (auto it = this->tileLevels.begin(); it != this->tileLevels.end(); ++it) {
+            if (it->first != keepLevel && (oldest == this->tileLevels.end() || it->second.lastUsed < oldest->second.lastUsed)) {
+                oldest = it;
+            }
+        }
+        this->cachedTileCount -= oldest->second.tiles.size();
+        this->tileLevels.erase(oldest);
+    }
+    if (this->cachedTileCount > MAX_CACHED_TILES) {
+        // Only the current level is left: start it over (visible tiles are re-rendered on the next paint)
+        this->cachedTileCount = 0;
+        this->tileLevels.clear();
+    }
+}
+
+// Sum occupancy into screen-space bins and shade each bin by log(count) relative to the busiest bin
+void MapView::drawDensityLayer(wxDC &dc, const RenderSnapshot &snap, const std::vector<int> &visibleNodes, int w, int h) {
+    int binCols = w / DENSITY_BIN_SIZE + 1;
+    int binRows = h / DENSITY_BIN_SIZE + 1;
+    std::vector<unsigned> bins((size_t) binCols * binRows, 0U);
+    unsigned maxCount = 0U;
+    for (int nodeId : visibleNodes) {
+        if (snap.occupancy[nodeId] == 0U) {
+            continue;
+        }
+        MapNode *n = this->model->map[nodeId];
+        int x0 = (int) zoom(n->x, this->mapCenterX, ((float) w)/2.0f, this->viewZoom);
+        int y0 = (int) zoom(n->y, this->mapCenterY, ((float) h)/2.0f, -this->viewZoom);
+        if (x0 < 0 || x0 >= w || y0 < 0 || y0 >= h) {
+            continue;
+        }
+        unsigned &bin = bins[(size_t) (y0 / DENSITY_BIN_SIZE) * binCols + x0 / DENSITY_BIN_SIZE];
+        bin += snap.occupancy[nodeId];
+        maxCount = std::max(maxCount, bin);
+    }
+    if (maxCount == 0U) {
+        return;
+    }
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    float logMax = std::log(1.0f + (float) maxCount);
+    for (int by = 0; by < binRows; ++by) {
+        for (int bx = 0; bx < binCols; ++bx) {
+            unsigned count = bins[(size_t) by * binCols + bx];
+            if (count == 0U) {
+                continue;
+            }
+            float intensity = std::log(1.0f + (float) count) / logMax;
+            dc.SetBrush(wxBrush(toWxColour(getDensityRgb(intensity))));
+            dc.DrawRectangle(bx*DENSITY_BIN_SIZE, by*DENSITY_BIN_SIZE, DENSITY_BIN_SIZE, DENSITY_BIN_SIZE);
+        }
+    }
+    dc.SetBrush(wxNullBrush);
+}
+
 void MapView::grab(wxMouseEvent &evt) {
     this->mouseGrabCoords = evt.GetPosition();
     this->preGrabCenterX = this->mapCenterX;
@@ -585,73 +718,86 @@ void MapView::selectNode(wxMouseEvent &evt) {
     this->GetClientSize(&w, &h);
     float x = unzoom((float) evt.GetX(), this->mapCenterX, ((float) w) / 2.0f, this->viewZoom);
     float y = unzoom((float) evt.GetY(), this->mapCenterY, ((float) h) / 2.0f, -this->viewZoom);
-    this->selectedNode = nullptr;
-    float minDistance;
-    for (MapNode *n : this->model->map) {
-        float dx = n->x - x;
-        float dy = n->y - y;
-        float distance = sqrt((dx*dx) + (dy*dy));
-        if (this->selectedNode == nullptr || distance < minDistance) {
-            minDistance = distance;
-            this->selectedNode = n;
-        }
-    }
-    this->updateDropdown();
-    this->Refresh();
+    int nearest = this->grid->nearestNode(x, y);
+    this->selectedNode = nearest == -1 ? nullptr : this->model->map[nearest];
+    this->selectedFishId = -1;
+    this->tagButton->Enable(false);
+    this->requestSnapshot();
 }
 
+// Refill the fish dropdown from the current snapshot's resident list (only when the list changed,
+// so an open dropdown isn't rebuilt on every frame while the model is running)
 void MapView::updateDropdown() {
-    this->fishSelector->Clear();
-    if (this->selectedNode == nullptr) {
+    const std::vector<long> &residents = this->snapshot->selectedNodeResidents;
+    if (this->selectedNode == nullptr || this->snapshot->selectedNodeId != this->selectedNode->id) {
+        if (!this->listedResidents.empty()) {
+            this->fishSelector->Clear();
+            this->listedResidents.clear();
+        }
         return;
     }
-    for (size_t i = 0; i < this->selectedNode->residentIds.size() && i < 25; ++i) {
-        size_t id = this->selectedNode->residentIds[i];
-        this->fishSelector->Append(std::to_string(id));
+    if (residents == this->listedResidents) {
+        return;
     }
-}
-
-void MapView::updateSelectedFishRange() {
-    std::unordered_map<MapNode *, float> reachable;
-    std::unordered_map<MapNode *, float> destinationProbs;
-    Fish &selectedFish = this->model->individuals[this->selectedFishId];
-    selectedFish.getReachableNodes(*this->model, reachable);
-    // selectedFish.getDestinationProbs(*this->model, destinationProbs);
-    this->selectedFishRange.clear();
-    for (auto it = reachable.begin(); it != reachable.end(); ++it) {
-        this->selectedFishRange[it->first] = 0.0;
-        // if (destinationProbs.count(it->first)) {
-        //     this->selectedFishRange[it->first] = destinationProbs[it->first];
-        // }
+    this->fishSelector->Clear();
+    for (long id : residents) {
+        this->fishSelector->Append(std::to_string(id));
     }
+    this->listedResidents = residents;
 }
 
 void MapView::selectFish(wxCommandEvent &evt) {
     int selection = this->fishSelector->GetCurrentSelection();
-    this->selectedFishId = (long) this->selectedNode->residentIds[selection];
-    this->tagButton->Enable(true);
-    this->updateSelectedFishRange();
-    this->Refresh();
+    if (selection < 0 || (size_t) selection >= this->listedResidents.size()) {
+        return;
+    }
+    this->selectedFishId = this->listedResidents[selection];
+    this->tagButton->Enable(!this->runner->isRunning());
+    this->requestSnapshot();
 }
 
 void MapView::tagFish(wxCommandEvent &evt) {
+    // Tagging writes to the model, so it's only allowed while the runner is idle
+    if (this->selectedFishId == -1 || this->runner->isRunning()) {
+        return;
+    }
     this->model->tagIndividual(this->selectedFishId);
+    this->requestSnapshot();
 }
 
-void MapView::onModelUpdate() {
-    if (this->selectedFishId != -1) {
-        this->selectedNode = this->model->individuals[this->selectedFishId].location;
-        this->updateSelectedFishRange();
+// Swap in the newest published snapshot (if any) and update the state that depends on it
+void MapView::consumeSnapshot() {
+    std::unique_ptr<RenderSnapshot> latest = this->runner->takeLatest();
+    if (latest == nullptr) {
+        return;
+    }
+    this->snapshot = std::move(latest);
+    if (this->selectedFishId != -1 && this->snapshot->selectedFishId == this->selectedFishId
+        && this->snapshot->selectedNodeId >= 0) {
+        // Follow the selected fish
+        this->selectedNode = this->model->map[this->snapshot->selectedNodeId];
     }
     this->updateDropdown();
+}
+
+// Tell the runner what's selected and get a fresh snapshot: immediately if the model is idle,
+// otherwise the worker's next per-step snapshot will pick up the new selection
+void MapView::requestSnapshot() {
+    this->runner->setSelection(this->selectedNode == nullptr ? -1 : this->selectedNode->id, this->selectedFishId);
+    this->runner->publishNow();
     this->Refresh();
 }
 
+void MapView::onModelUpdate() {
+    this->requestSnapshot();
+}
+
 void MapView::onModelReset() {
     this->selectedNode = nullptr;
     this->selectedFishId = -1;
     this->fishSelector->Clear();
-    this->Refresh();
+    this->listedResidents.clear();
+    this->requestSnapshot();
 }
 
 class FishFrame : public wxFrame {
@@ -661,14 +807,31 @@ private:
     int updateRate;
     wxChoice *updateRateSelector;
     wxButton *updateButton;
+    wxButton *playButton;
+    wxChoice *playRateSelector;
+    wxButton *cancelButton;
     wxButton *forwardButton;
     wxButton *backButton;
+    // Jumps straight to any timestep of a loaded tag replay
+    wxSlider *scrubber;
+    wxButton *tagButton;
     Model *model;
+    SimulationRunner *runner;
+    // Set by the worker when it schedules a redraw, cleared once the redraw is handled,
+    // so a fast-running model can't flood the event queue
+    std::atomic<bool> redrawPending;
     MapView *view;
     bool replayMode;
 
     void setUpdateIncrement(wxCommandEvent &event);
     void updateModel(wxCommandEvent &event);
+    void togglePlay(wxCommandEvent &event);
+    void setPlayRate(wxCommandEvent &event);
+    void cancelRun(wxCommandEvent &event);
+    void onRunnerPublished();
+    void setRunControlsEnabled(bool idle);
+    double getPlayRate();
+    void onClose(wxCloseEvent &event);
     void zoomIn(wxCommandEvent &event);
     void zoomOut(wxCommandEvent &event);
     void loadState(wxCommandEvent &event);
@@ -678,6 +841,7 @@ private:
     void enterReplayMode();
     void stepForward(wxCommandEvent &event);
     void stepBackward(wxCommandEvent &event);
+    void scrubTo(wxCommandEvent &event);
 
     wxDECLARE_EVENT_TABLE();
 };
@@ -688,7 +852,7 @@ wxBEGIN_EVENT_TABLE(FishFrame, wxFrame)
 wxEND_EVENT_TABLE()
 
 FishFrame::FishFrame(const wxString &title, const wxPoint &pos, const wxSize& size, const int argc, const wxCmdLineArgsArray &argv)
-    : wxFrame(nullptr, -1, title, pos, size), updateRate(1), replayMode(false)
+    : wxFrame(nullptr, -1, title, pos, size), updateRate(1), runner(nullptr), redrawPending(false), replayMode(false)
 {
     wxMenu *fileMenu = new wxMenu;
     fileMenu->Append(wxID_OPEN);
@@ -711,6 +875,22 @@ FishFrame::FishFrame(const wxString &title, const wxPoint &pos, const wxSize& si
     this->updateButton = new wxButton(this, -1, "Update");
     this->updateButton->Bind(wxEVT_COMMAND_BUTTON_CLICKED, &FishFrame::updateModel, this);
 
+    this->playButton = new wxButton(this, -1, "Play");
+    this->playButton->Bind(wxEVT_COMMAND_BUTTON_CLICKED, &FishFrame::togglePlay, this);
+
+    this->playRateSelector = new wxChoice(this, -1);
+    this->playRateSelector->Append("1 step/s");
+    this->playRateSelector->Append("6 steps/s");
+    this->playRateSelector->Append("24 steps/s");
+    this->playRateSelector->Append("96 steps/s");
+    this->playRateSelector->Append("Max");
+    this->playRateSelector->SetSelection(2);
+    this->playRateSelector->Bind(wxEVT_COMMAND_CHOICE_SELECTED, &FishFrame::setPlayRate, this);
+
+    this->cancelButton = new wxButton(this, -1, "Cancel");
+    this->cancelButton->Bind(wxEVT_COMMAND_BUTTON_CLICKED, &FishFrame::cancelRun, this);
+    this->cancelButton->Enable(false);
+
     this->forwardButton = new wxButton(this, -1, "Step Forward");
     this->forwardButton->Bind(wxEVT_COMMAND_BUTTON_CLICKED, &FishFrame::stepForward, this);
     this->forwardButton->Hide();
@@ -719,6 +899,10 @@ FishFrame::FishFrame(const wxString &title, const wxPoint &pos, const wxSize& si
     this->backButton->Bind(wxEVT_COMMAND_BUTTON_CLICKED, &FishFrame::stepBackward, this);
     this->backButton->Hide();
 
+    this->scrubber = new wxSlider(this, -1, 0, 0, 1);
+    this->scrubber->Bind(wxEVT_SLIDER, &FishFrame::scrubTo, this);
+    this->scrubber->Hide();
+
     this->updateRateSelector = new wxChoice(this, -1);
     this->updateRateSelector->Append("1hr");
     this->updateRateSelector->Append("24hr");
@@ -746,10 +930,18 @@ FishFrame::FishFrame(const wxString &title, const wxPoint &pos, const wxSize& si
         return;
     }
 
-    wxButton *tagButton = new wxButton(this, -1, "Tag Fish");
-    tagButton->Enable(false);
+    this->tagButton = new wxButton(this, -1, "Tag Fish");
+    this->tagButton->Enable(false);
 
-    this->view = new MapView(this, this->model, fishSelector, tagButton, 720, 640);
+    this->runner = new SimulationRunner(this->model, [this]() {
+        // Runs on the worker thread: only schedule a redraw on the UI thread
+        if (!this->redrawPending.exchange(true)) {
+            this->CallAfter(&FishFrame::onRunnerPublished);
+        }
+    });
+    this->Bind(wxEVT_CLOSE_WINDOW, &FishFrame::onClose, this);
+
+    this->view = new MapView(this, this->model, this->runner, fishSelector, this->tagButton, 720, 640);
 
     wxBoxSizer *sizerVert = new wxBoxSizer(wxVERTICAL);
     wxBoxSizer *sizerHrz1 = new wxBoxSizer(wxHORIZONTAL);
@@ -757,13 +949,17 @@ FishFrame::FishFrame(const wxString &title, const wxPoint &pos, const wxSize& si
     sizerHrz1->Add(this->forwardButton, 2, wxEXPAND);
     sizerHrz1->Add(this->backButton, 2, wxEXPAND);
     sizerHrz1->Add(this->updateRateSelector, 1, wxEXPAND);
+    sizerHrz1->Add(this->playButton, 2, wxEXPAND);
+    sizerHrz1->Add(this->playRateSelector, 2, wxEXPAND);
+    sizerHrz1->Add(this->cancelButton, 2, wxEXPAND);
     sizerHrz1->Add(zoomInButton, 2, wxEXPAND);
     sizerHrz1->Add(zoomOutButton, 2, wxEXPAND);
     sizerHrz1->Add(fishSelector, 4, wxEXPAND);
-    sizerHrz1->Add(tagButton, 1, wxEXPAND);
+    sizerHrz1->Add(this->tagButton, 1, wxEXPAND);
     wxBoxSizer *sizerHrz2 = new wxBoxSizer(wxHORIZONTAL);
     sizerHrz2->Add(this->view, 1, wxEXPAND);
     sizerVert->Add(sizerHrz1, 0, wxEXPAND);
+    sizerVert->Add(this->scrubber, 0, wxEXPAND);
     sizerVert->Add(sizerHrz2, 1, wxEXPAND);
 
     this->SetSizer(sizerVert);
@@ -786,24 +982,93 @@ void FishFrame::setUpdateIncrement(wxCommandEvent &evt) {
     }
 }
 
+// Run updateRate steps on the worker thread as fast as possible; the view redraws as snapshots arrive
 void FishFrame::updateModel(wxCommandEvent &evt) {
-    for (int i = 0; i < this->updateRate; ++i) {
-        this->model->masterUpdate();
+    if (this->runner->start(this->updateRate, SimulationRunner::UNTHROTTLED)) {
+        this->setRunControlsEnabled(false);
+    }
+}
+
+// Start continuous play at the selected rate, or pause if already running
+void FishFrame::togglePlay(wxCommandEvent &evt) {
+    if (this->runner->isRunning()) {
+        this->runner->cancel();
+        this->setRunControlsEnabled(true);
+        this->view->onModelUpdate();
+        return;
+    }
+    if (this->runner->start(SimulationRunner::RUN_UNTIL_CANCELLED, this->getPlayRate())) {
+        this->setRunControlsEnabled(false);
+    }
+}
+
+void FishFrame::setPlayRate(wxCommandEvent &evt) {
+    this->runner->setTargetStepsPerSec(this->getPlayRate());
+}
+
+double FishFrame::getPlayRate() {
+    switch (this->playRateSelector->GetCurrentSelection()) {
+        case 0:
+            return 1.0;
+        case 1:
+            return 6.0;
+        case 2:
+            return 24.0;
+        case 3:
+            return 96.0;
+        default:
+            return SimulationRunner::UNTHROTTLED;
     }
+}
+
+// Stop the active run after its current step
+void FishFrame::cancelRun(wxCommandEvent &evt) {
+    this->runner->cancel();
+    this->setRunControlsEnabled(true);
     this->view->onModelUpdate();
 }
 
+// Called on the UI thread after the worker publishes a snapshot (or finishes a run)
+void FishFrame::onRunnerPublished() {
+    this->redrawPending = false;
+    if (this->runner == nullptr) {
+        // Window is closing
+        return;
+    }
+    if (!this->runner->isRunning() && this->cancelButton->IsEnabled()) {
+        // The run finished on its own
+        this->setRunControlsEnabled(true);
+    }
+    this->view->Refresh();
+}
+
+// Controls that would touch the model are only usable while the runner is idle
+void FishFrame::setRunControlsEnabled(bool idle) {
+    this->updateButton->Enable(idle);
+    this->updateRateSelector->Enable(idle);
+    this->playButton->SetLabel(idle ? "Play" : "Pause");
+    this->cancelButton->Enable(!idle);
+    this->tagButton->Enable(idle && this->view->selectedFishId != -1);
+    this->GetMenuBar()->EnableTop(0, idle);
+}
+
+void FishFrame::onClose(wxCloseEvent &evt) {
+    // The worker must not outlive the model or the windows it posts redraws to
+    if (this->runner != nullptr) {
+        this->runner->cancel();
+        delete this->runner;
+        this->runner = nullptr;
+    }
+    evt.Skip();
+}
+
 void FishFrame::zoomIn(wxCommandEvent &evt) {
     this->view->viewZoom *= 1.5f;
-    delete this->view->_buffer;
-    this->view->_buffer = nullptr;
     this->view->Refresh();
 }
 
 void FishFrame::zoomOut(wxCommandEvent &evt) {
     this->view->viewZoom /= 1.5f;
-    delete this->view->_buffer;
-    this->view->_buffer = nullptr;
     this->view->Refresh();
 }
 
@@ -812,6 +1077,8 @@ void FishFrame::loadState(wxCommandEvent &evt) {
     if (openFileDlg.ShowModal() == wxID_CANCEL) {
         return;
     }
+    this->runner->cancel();
+    this->setRunControlsEnabled(true);
     this->model->loadState(openFileDlg.GetPath().ToStdString());
     //wxMessageBox("Invalid state file!", "Unable to load model state", wxICON_ERROR | wxOK, this);
     this->view->onModelReset();
@@ -822,15 +1089,27 @@ void FishFrame::saveState(wxCommandEvent &evt) {
     if (saveFileDlg.ShowModal() == wxID_CANCEL) {
         return;
     }
+    this->runner->cancel();
+    this->setRunControlsEnabled(true);
     this->model->saveState(saveFileDlg.GetPath().ToStdString());
 }
 
 void FishFrame::loadHistories(wxCommandEvent &evt) {
-    wxFileDialog openFileDlg(this, "Open tagged fish history file", "", "", "netCDF files (*.nc)|*.nc", wxFD_OPEN|wxFD_FILE_MUST_EXIST);
+    wxFileDialog openFileDlg(this, "Open tagged fish history file", "", "",
+        "netCDF files (*.nc)|*.nc|Replay files (*.replay)|*.replay", wxFD_OPEN|wxFD_FILE_MUST_EXIST);
     if (openFileDlg.ShowModal() == wxID_CANCEL) {
         return;
     }
-    this->model->loadTaggedHistories(openFileDlg.GetPath().ToStdString());
+    this->runner->cancel();
+    this->setRunControlsEnabled(true);
+    try {
+        this->model->loadTaggedHistories(openFileDlg.GetPath().ToStdString());
+    } catch (std::exception &e) {
+        wxMessageBox(e.what(), "Unable to load tag replay", wxICON_ERROR | wxOK, this);
+        this->model->reset();
+        this->view->onModelReset();
+        return;
+    }
     this->enterReplayMode();
     this->view->onModelReset();
 }
@@ -840,24 +1119,39 @@ void FishFrame::saveHistories(wxCommandEvent &evt) {
     if (saveFileDlg.ShowModal() == wxID_CANCEL) {
         return;
     }
+    this->runner->cancel();
+    this->setRunControlsEnabled(true);
     this->model->saveTaggedHistories(saveFileDlg.GetPath().ToStdString());
 }
 
 void FishFrame::enterReplayMode() {
     this->replayMode = true;
     this->updateButton->Hide();
+    this->playButton->Hide();
+    this->playRateSelector->Hide();
+    this->cancelButton->Hide();
     this->forwardButton->Show();
     this->backButton->Show();
+    this->scrubber->SetRange(0, std::max(1, (int) this->model->replayStore->getNumTimesteps() - 1));
+    this->scrubber->SetValue((int) this->model->time);
+    this->scrubber->Show();
     this->Layout();
 }
 
 void FishFrame::stepForward(wxCommandEvent &evt) {
     this->model->setHistoryTimestep(this->model->time + this->updateRate);
+    this->scrubber->SetValue((int) this->model->time);
     this->view->onModelUpdate();
 }
 
 void FishFrame::stepBackward(wxCommandEvent &evt) {
     this->model->setHistoryTimestep(std::max(0L, this->model->time - this->updateRate));
+    this->scrubber->SetValue((int) this->model->time);
+    this->view->onModelUpdate();
+}
+
+void FishFrame::scrubTo(wxCommandEvent &evt) {
+    this->model->setHistoryTimestep((long) this->scrubber->GetValue());
     this->view->onModelUpdate();
 }
 
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <memory>
 #include <vector>
 #include <chrono>
 #include <csignal>
@@ -10,7 +11,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "model.h"
+#include "distributed.h"
 #include "load.h"
+#include "telemetry.h"
 
 sig_atomic_t halt = 0;
 
@@ -211,20 +214,75 @@ int main(int argc, char **argv) {
     hydroMappingFile << outputPath << "/hydro_mapping_" << runID << ".csv";
     m->saveHydroMapping(hydroMappingFile.str());
 
+    if (!m->mapCoarsening.empty()) {
+        std::stringstream coarseningFile;
+        coarseningFile << outputPath << "/map_coarsening_" << runID << ".csv";
+        m->saveMapCoarsening(coarseningFile.str());
+    }
+
+    const std::string threadPinning = m->getString(ModelParamKey::ThreadPinning);
+    const std::string hydroPlacement = m->getString(ModelParamKey::HydroPlacement);
+    if (threadPinning != "off" || hydroPlacement != "default") {
+        std::cout << detectNumaTopology().describe() << "; thread pinning " << threadPinning
+                  << ", hydrology placement " << hydroPlacement << std::endl;
+    }
+
     std::stringstream ss;
     ss << outputPath << "/output_" << runID << ".nc";
     std::cout << "Sample data will be saved to " << ss.str() << std::endl;
 
+    std::stringstream ss2;
+    ss2 << outputPath << "/summary_" << runID << ".nc";
+    // outputFormat selects NetCDF files, columnar (.wbc) files, or both
+    std::string outputFormat = m->getString(ModelParamKey::OutputFormat);
+
+    // 166 days, however long a timestep is
+    const long TOTAL_STEPS = 166*24 / m->getHoursPerTimestep();
+    // A distributed run's other processes are forked from this one (see distributed.h)
+    const int processes = m->getInt(ModelParamKey::Processes);
+    // Monitoring rows go into the summary file as the run goes (saveSummary finishes it), unless other
+    // processes would inherit the open file
+    if (outputFormat != "columnar" && processes == 1) {
+        m->streamMonitoring(ss2.str());
+    }
+    m->reserveHistory(TOTAL_STEPS);
+
+    std::unique_ptr<TelemetryServer> telemetry;
+    std::string telemetrySocket = m->getString(ModelParamKey::TelemetrySocket);
+    if (!telemetrySocket.empty() && processes > 1) {
+        std::cout << "Telemetry isn't published by distributed runs" << std::endl;
+    } else if (!telemetrySocket.empty()) {
+        size_t placeholder = telemetrySocket.find("{runID}");
+        if (placeholder != std::string::npos) {
+            telemetrySocket.replace(placeholder, 7, std::to_string(runID));
+        }
+        telemetry = std::make_unique<TelemetryServer>(telemetrySocket);
+        std::cout << "Publishing telemetry on " << telemetrySocket << std::endl;
+        telemetry->publish(formatStartupRecord(*m, runID));
+    }
+    size_t samplesPublished = m->sampleHistory.size();
+
+    double totalElapsed = 0.0;
+    if (processes > 1) {
+        // Runs to the end (an interrupt stops every process)
+        std::cout << "Running on " << processes << " processes (" << m->getString(ModelParamKey::ProcessTransport)
+                  << " transport)" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        runDistributed(*m, TOTAL_STEPS);
+        totalElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
     void (*prevHandler)(int);
     prevHandler = signal(SIGINT, handleInterrupt);
-    double totalElapsed = 0.0;
-    const long TOTAL_STEPS = 166*24;
     while (m->time < TOTAL_STEPS) {
         auto start = std::chrono::steady_clock::now();
         m->masterUpdate();
         auto end = std::chrono::steady_clock::now();
         double elapsed = std::chrono::duration<double>(end-start).count();
         totalElapsed += elapsed;
+        if (telemetry) {
+            telemetry->publish(formatStepRecord(*m, runID, elapsed, samplesPublished));
+            samplesPublished = m->sampleHistory.size();
+        }
         double remaining = (totalElapsed/((double) m->time)) * (double) (TOTAL_STEPS - m->time);
         std::string remainingStr = "";
         if (remaining > 60*60) {
@@ -268,12 +326,19 @@ int main(int argc, char **argv) {
 
     std::cout << std::endl << "Finished at step " << m->time << "; " << totalElapsed << "s elapsed since start" << std::endl;
 
-    std::stringstream ss2;
-    ss2 << outputPath << "/summary_" << runID << ".nc";
-
-    m->saveSummary(ss2.str());
-    //std::cout << "Summary statistics saved to summary.nc" << std::endl;
-    m->saveSampleData(ss.str());
+    if (outputFormat != "columnar") {
+        m->saveSummary(ss2.str());
+        //std::cout << "Summary statistics saved to summary.nc" << std::endl;
+        m->saveSampleData(ss.str());
+    }
+    if (outputFormat != "netcdf") {
+        std::stringstream summaryColumnar;
+        summaryColumnar << outputPath << "/summary_" << runID << ".wbc";
+        m->saveSummaryColumnar(summaryColumnar.str());
+        std::stringstream sampleColumnar;
+        sampleColumnar << outputPath << "/output_" << runID << ".wbc";
+        m->saveSampleDataColumnar(sampleColumnar.str());
+    }
 
     std::stringstream th;
     th << outputPath << "/taggedhist_" << runID << ".nc";
@@ -1,8 +1,13 @@
 #include "hydro.h"
+#include "hydro_stream.h"
 #include "load.h"
+#include "util.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <utility>
 
 #define WSE_intercept 0.3373725
 #define WSE_flow_m3ps 0.00011386 // flow = m3/s
@@ -55,19 +60,46 @@ HydroModel::HydroModel(
     airTempData(loadFloatListInterleaved(airTempFilename, 4)),
     hydroNodes(),
     useSimData(false),
-    hydroTimeIntercept(hydroTimeIntercept)
+    hydroTimeIntercept(hydroTimeIntercept),
+    stepHours(1),
+    currentUs(nullptr), currentVs(nullptr), currentWses(nullptr), currentTemps(nullptr),
+    maxFlowSpeed(0.0f)
 {
     loadDistribHydro(flowSpeedFilename, distribWseTempFilename, this->hydroNodes);
     this->updateTime(0L);
 }
 
+HydroModel::HydroModel(
+    std::vector<float> cresTideData,
+    std::vector<float> flowVolData,
+    std::vector<float> airTempData,
+    std::vector<DistribHydroNode> hydroNodes,
+    int hydroTimeIntercept,
+    std::unique_ptr<HydroStream> stream
+) :
+    cresTideData(std::move(cresTideData)),
+    flowVolData(std::move(flowVolData)),
+    airTempData(std::move(airTempData)),
+    hydroNodes(std::move(hydroNodes)),
+    useSimData(false),
+    hydroTimeIntercept(hydroTimeIntercept),
+    stepHours(1),
+    stream(std::move(stream)),
+    currentUs(nullptr), currentVs(nullptr), currentWses(nullptr), currentTemps(nullptr),
+    maxFlowSpeed(0.0f)
+{
+    this->updateTime(0L);
+}
+
 HydroModel::HydroModel(
     std::vector<MapNode *> &map,
     std::vector<std::vector<float>> &depths,
     std::vector<std::vector<float>> &temps,
     float distFlow
 ) :
-    useSimData(true), simDepths(), simTemps(), simDistFlow(distFlow), hydroTimeIntercept(0)
+    useSimData(true), simDepths(), simTemps(), simDistFlow(distFlow), hydroTimeIntercept(0), stepHours(1),
+    currentUs(nullptr), currentVs(nullptr), currentWses(nullptr), currentTemps(nullptr),
+    maxFlowSpeed(0.0f)
 {
     this->updateTime(0L);
     for (size_t i = 0; i < map.size(); ++i) {
@@ -76,39 +108,223 @@ HydroModel::HydroModel(
     }
 }
 
+HydroModel::~HydroModel() = default;
+
 long HydroModel::getTime() const {
     return currTimestep + hydroTimeIntercept;
 }
 
-void HydroModel::updateTime(long newTime) {
+template <typename T>
+static void placeArray(const std::function<void(const void *, size_t)> &place, const std::vector<T> &values) {
+    if (!values.empty()) {
+        place(values.data(), values.size() * sizeof(T));
+    }
+}
+
+void HydroModel::forEachArray(const std::function<void(const void *, size_t)> &place) const {
+    placeArray(place, this->cresTideData);
+    placeArray(place, this->flowVolData);
+    placeArray(place, this->airTempData);
+    placeArray(place, this->hydroNodes);
+    for (const DistribHydroNode &hydroNode : this->hydroNodes) {
+        placeArray(place, hydroNode.us);
+        placeArray(place, hydroNode.vs);
+        placeArray(place, hydroNode.wses);
+        placeArray(place, hydroNode.temps);
+    }
+    placeArray(place, this->stepUs);
+    placeArray(place, this->stepVs);
+    placeArray(place, this->stepWses);
+    placeArray(place, this->stepTemps);
+    for (const auto &entry : this->simDepths) {
+        placeArray(place, entry.second);
+    }
+    for (const auto &entry : this->simTemps) {
+        placeArray(place, entry.second);
+    }
+}
+
+void HydroModel::updateTime(long newTime, int stepHours) {
     this->currTimestep = newTime;
+    this->stepHours = std::max(stepHours, 1);
     if (!this->useSimData) {
         this->currCresTide = this->cresTideData[getTime()];
         this->currFlowVol = this->flowVolData[getTime()];
         this->currAirTemp = this->airTempData[getTime()];
     }
+    if (this->stream) {
+        this->updateStreamTime();
+    } else if (this->stepHours > 1) {
+        this->stepUs.resize(this->hydroNodes.size());
+        this->stepVs.resize(this->hydroNodes.size());
+        this->stepWses.resize(this->hydroNodes.size());
+        this->stepTemps.resize(this->hydroNodes.size());
+        for (size_t i = 0; i < this->hydroNodes.size(); ++i) {
+            const DistribHydroNode &hydroNode = this->hydroNodes[i];
+            size_t first, last;
+            this->stepWindow(hydroNode.us.size(), first, last);
+            float u = 0.0f, v = 0.0f, temp = 0.0f, wse = hydroNode.wses[first];
+            for (size_t t = first; t < last; ++t) {
+                u += hydroNode.us[t];
+                v += hydroNode.vs[t];
+                temp += hydroNode.temps[t];
+                wse = std::min(wse, hydroNode.wses[t]);
+            }
+            this->stepUs[i] = u / (float) (last - first);
+            this->stepVs[i] = v / (float) (last - first);
+            this->stepTemps[i] = temp / (float) (last - first);
+            this->stepWses[i] = wse;
+        }
+    }
+    this->updateMaxFlowSpeed();
+}
+
+void HydroModel::updateMaxFlowSpeed() {
+    if (this->useSimData) {
+        this->maxFlowSpeed = std::numeric_limits<float>::infinity();
+        return;
+    }
+    float maxSpeed = 0.0f;
+    for (const DistribHydroNode &hydroNode : this->hydroNodes) {
+        const float u = this->getCurrentU(hydroNode);
+        const float v = this->getCurrentV(hydroNode);
+        const float speed = std::sqrt(u * u + v * v);
+        if (speed > maxSpeed) {
+            maxSpeed = speed;
+        }
+    }
+    this->maxFlowSpeed = maxSpeed;
+}
+
+float HydroModel::getMaxFlowSpeed() const {
+    return this->maxFlowSpeed;
+}
+
+// The streamed hydrology is time-major, so a step's aggregates are built an hour at a time (adding in the
+// same order as the per-node loop in updateTime, so they come out the same)
+void HydroModel::updateStreamTime() {
+    size_t first, last;
+    this->stepWindow(this->stream->getNumHours(), first, last);
+    this->stream->seek(first, last - first);
+    const size_t nodeCount = this->stream->getNumNodes();
+    const float *slab = this->stream->hour(first);
+    this->currentUs = slab;
+    this->currentVs = slab + nodeCount;
+    this->currentWses = slab + 2 * nodeCount;
+    this->currentTemps = slab + 3 * nodeCount;
+    if (this->stepHours > 1) {
+        this->stepUs.assign(nodeCount, 0.0f);
+        this->stepVs.assign(nodeCount, 0.0f);
+        this->stepTemps.assign(nodeCount, 0.0f);
+        this->stepWses.assign(this->currentWses, this->currentWses + nodeCount);
+        for (size_t t = first; t < last; ++t) {
+            slab = this->stream->hour(t);
+            for (size_t i = 0; i < nodeCount; ++i) {
+                this->stepUs[i] += slab[i];
+                this->stepVs[i] += slab[nodeCount + i];
+                this->stepWses[i] = std::min(this->stepWses[i], slab[2 * nodeCount + i]);
+                this->stepTemps[i] += slab[3 * nodeCount + i];
+            }
+        }
+        for (size_t i = 0; i < nodeCount; ++i) {
+            this->stepUs[i] /= (float) (last - first);
+            this->stepVs[i] /= (float) (last - first);
+            this->stepTemps[i] /= (float) (last - first);
+        }
+    }
+}
+
+void HydroModel::stepWindow(size_t dataLength, size_t &first, size_t &last) const {
+    first = (size_t) this->getTime();
+    // The run's last step may reach past the end of the data
+    last = std::max(first + 1, std::min(first + (size_t) this->stepHours, dataLength));
 }
 
 bool HydroModel::isHighTide() {
-    return this->getTime() - 1 > 0 && this->getTime() + 1 < (long) this->cresTideData.size()
-        && this->currCresTide > this->cresTideData[this->getTime() - 1]
-        && this->currCresTide > this->cresTideData[this->getTime() + 1];
+    const long first = this->getTime();
+    for (long t = first; t < first + this->stepHours; ++t) {
+        if (t - 1 > 0 && t + 1 < (long) this->cresTideData.size()
+            && this->cresTideData[t] > this->cresTideData[t - 1]
+            && this->cresTideData[t] > this->cresTideData[t + 1]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HydroModel::prefetchHydroNode(const MapNode &node) const {
+    // Only the loaded series are reached through the DistribHydroNode
+    if (!this->useSimData && this->stepHours == 1 && !this->stream && node.nearestHydroNodeID < this->hydroNodes.size()) {
+        const DistribHydroNode &hydroNode = this->hydroNodes[node.nearestHydroNodeID];
+        prefetchRead(&hydroNode);
+        prefetchRead(&hydroNode.temps);
+    }
+}
+
+void HydroModel::prefetchConditions(const MapNode &node) const {
+    const size_t id = node.nearestHydroNodeID;
+    if (this->useSimData || id >= this->hydroNodes.size()) {
+        return;
+    }
+    if (this->stepHours > 1) {
+        if (id >= this->stepUs.size()) {
+            return;
+        }
+        prefetchRead(this->stepUs.data() + id);
+        prefetchRead(this->stepVs.data() + id);
+        prefetchRead(this->stepWses.data() + id);
+        prefetchRead(this->stepTemps.data() + id);
+    } else if (this->stream) {
+        if (this->currentUs == nullptr) {
+            return;
+        }
+        prefetchRead(this->currentUs + id);
+        prefetchRead(this->currentVs + id);
+        prefetchRead(this->currentWses + id);
+        prefetchRead(this->currentTemps + id);
+    } else {
+        const DistribHydroNode &hydroNode = this->hydroNodes[id];
+        const size_t time = (size_t) this->getTime();
+        for (const std::vector<float> *series : {&hydroNode.us, &hydroNode.vs, &hydroNode.wses, &hydroNode.temps}) {
+            if (time < series->size()) {
+                prefetchRead(series->data() + time);
+            }
+        }
+    }
 }
 
 // Get the current horizontal (E/W) flow velocity in m/s at the given node
 float HydroModel::getCurrentU(const MapNode &node) const {
-    return this->getCurrentU(this->hydroNodes[node.nearestHydroNodeID]);
+    return this->currentU(node.nearestHydroNodeID);
 }
 float HydroModel::getCurrentU(const DistribHydroNode &hydroNode) const {
-    return hydroNode.us[this->getTime()];
+    return this->currentU((size_t) (&hydroNode - this->hydroNodes.data()));
+}
+float HydroModel::currentU(size_t index) const {
+    if (this->stepHours > 1) {
+        return this->stepUs[index];
+    }
+    if (this->stream) {
+        return this->currentUs[index];
+    }
+    return this->hydroNodes[index].us[this->getTime()];
 }
 
 // Get the current vertical (N/S) flow velocity in m/s at the given node
 float HydroModel::getCurrentV(const MapNode &node) const {
-    return this->getCurrentV(this->hydroNodes[node.nearestHydroNodeID]);
+    return this->currentV(node.nearestHydroNodeID);
 }
 float HydroModel::getCurrentV(const DistribHydroNode &hydroNode) const {
-    return hydroNode.vs[this->getTime()];
+    return this->currentV((size_t) (&hydroNode - this->hydroNodes.data()));
+}
+float HydroModel::currentV(size_t index) const {
+    if (this->stepHours > 1) {
+        return this->stepVs[index];
+    }
+    if (this->stream) {
+        return this->currentVs[index];
+    }
+    return this->hydroNodes[index].vs[this->getTime()];
 }
 
 // Get the total flow velocity in m/s at the given node
@@ -173,10 +389,19 @@ float limitWaterTemp(float waterTemp, HabitatType nodeType) {
 // Get the current temperature (C) at the given node
 float HydroModel::getTemp(MapNode &node) {
     if (this->useSimData) {
-        return this->simTemps[&node][this->getTime()];
+        const std::vector<float> &temps = this->simTemps[&node];
+        size_t first, last;
+        this->stepWindow(temps.size(), first, last);
+        float temp = 0.0f;
+        for (size_t t = first; t < last; ++t) {
+            temp += temps[t];
+        }
+        return temp / (float) (last - first);
     }
 
-    const float hydroTemp = this->hydroNodes[node.nearestHydroNodeID].temps[this->getTime()];
+    const float hydroTemp = this->stepHours > 1 ? this->stepTemps[node.nearestHydroNodeID]
+                          : this->stream ? this->currentTemps[node.nearestHydroNodeID]
+                                         : this->hydroNodes[node.nearestHydroNodeID].temps[this->getTime()];
     return limitWaterTemp(hydroTemp, node.type);
 }
 
@@ -190,9 +415,15 @@ float limitDepth(const float depth, const HabitatType nodeType) {
 // (based on blind channel model everywhere else)
 float HydroModel::getDepth(MapNode &node) {
     if (this->useSimData) {
-        return this->simDepths[&node][this->getTime()];
+        const std::vector<float> &depths = this->simDepths[&node];
+        size_t first, last;
+        this->stepWindow(depths.size(), first, last);
+        return *std::min_element(depths.begin() + first, depths.begin() + last);
     }
 
-    const float depth = this->hydroNodes[node.nearestHydroNodeID].wses[this->getTime()] - node.elev;
+    const float wse = this->stepHours > 1 ? this->stepWses[node.nearestHydroNodeID]
+                    : this->stream ? this->currentWses[node.nearestHydroNodeID]
+                                   : this->hydroNodes[node.nearestHydroNodeID].wses[this->getTime()];
+    const float depth = wse - node.elev;
     return limitDepth(depth, node.type);
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #ifndef __FISH_HYDRO_H
 #define __FISH_HYDRO_H
 
+#include <functional>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include "map.h"
 
+class HydroStream;
+
 // This struct stores cached hydrology model predictions for a single map location
 typedef struct HydroNode {
     float temp; // temperature in degrees C
@@ -20,7 +24,18 @@ public:
         std::string airTempFilename,
         std::string flowSpeedFilename,
         std::string distribWseTempFilename,
-        int hydroTimeIntercept // Timesteps between midnight on Jan 1 and the start of the cresTide, flowVol, and airTemp data
+        int hydroTimeIntercept // Hours between midnight on Jan 1 and the start of the cresTide, flowVol, and airTemp data
+    );
+
+    // From data already loaded (see startup.h). With a stream (see hydro_stream.h), the distributary hydrology
+    // is read from it a block at a time, and hydroNodes only hold the nodes' ids and positions.
+    HydroModel(
+        std::vector<float> cresTideData,
+        std::vector<float> flowVolData,
+        std::vector<float> airTempData,
+        std::vector<DistribHydroNode> hydroNodes,
+        int hydroTimeIntercept,
+        std::unique_ptr<HydroStream> stream = nullptr
     );
 
     HydroModel(
@@ -30,7 +45,7 @@ public:
         float distFlow
     );
 
-    virtual ~HydroModel() = default;
+    virtual ~HydroModel();
 
     // Return the flow speed in m/s at a given location
     float getUnsignedFlowSpeedAt(MapNode &node);
@@ -44,14 +59,31 @@ public:
     virtual float getTemp(MapNode &node);
     // Return the water depth in meters at a given location
     virtual float getDepth(MapNode &node);
-    // Check if the current timestep is a high tide
-    bool isHighTide();
-
-    // Set the hydro model's timestep to a given timestep
-    void updateTime(long newTime);
+    // Check if any hour of the current timestep is a high tide (a local maximum of the crescent tide)
+    virtual bool isHighTide();
+    // Hours covered by the current timestep (see updateTime)
+    int getStepHours() const { return stepHours; }
+    // An upper bound on the flow speed (m/s) anywhere in the current timestep (infinity for simulated data)
+    virtual float getMaxFlowSpeed() const;
+
+    // Set the hydro model's time to a given hour. With stepHours > 1 (multi-hour model timesteps), the
+    // conditions reported are aggregated over the stepHours hours starting there: mean flow velocity,
+    // minimum depth (so brief low water still strands fish) and mean temperature.
+    // Streamed hydrology waits here if the step's hours haven't been read yet.
+    void updateTime(long newTime, int stepHours = 1);
 
     long getTime() const;
 
+    // Call place(data, bytes) for each array of loaded hydrology and per-step aggregates (e.g. to spread them
+    // over the NUMA nodes; see numa.h). Streamed blocks aren't included.
+    void forEachArray(const std::function<void(const void *, size_t)> &place) const;
+
+    // Start loading a location's current conditions into cache ahead of reading them (see movement_prefetch.h):
+    // prefetchHydroNode fetches its DistribHydroNode, which prefetchConditions then reads to fetch the current
+    // step's values. Neither has any other effect.
+    void prefetchHydroNode(const MapNode &node) const;
+    void prefetchConditions(const MapNode &node) const;
+
 public:
     virtual float getCurrentU(const MapNode& node) const; // m/s
     virtual float getCurrentV(const MapNode& node) const; // m/s
@@ -80,6 +112,30 @@ private:
     float currFlowVol;
     float currAirTemp;
     long currTimestep;
+    int stepHours;
+    // Per DistribHydroNode aggregates over the current step's hours (only filled when stepHours > 1), indexed like
+    // nearestHydroNodeID by position in hydroNodes. That's not DistribHydroNode::id, the node's index in the hydrology
+    // file, once unusable nodes have been skipped at load.
+    std::vector<float> stepUs;
+    std::vector<float> stepVs;
+    std::vector<float> stepWses;
+    std::vector<float> stepTemps;
+    // Streamed distributary hydrology (null when it's all in hydroNodes) and, when stepHours is 1, the current
+    // hour's values of each DistribHydroNode
+    std::unique_ptr<HydroStream> stream;
+    const float *currentUs;
+    const float *currentVs;
+    const float *currentWses;
+    const float *currentTemps;
+    // The fastest DistribHydroNode flow in the current step (set by updateTime)
+    float maxFlowSpeed;
+    void updateStreamTime();
+    void updateMaxFlowSpeed();
+    // The current step's flow at hydroNodes[index]
+    float currentU(size_t index) const;
+    float currentV(size_t index) const;
+    // Hours [first, last) of the data covered by the current step
+    void stepWindow(size_t dataLength, size_t &first, size_t &last) const;
 
 };
 
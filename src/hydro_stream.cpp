@@ -0,0 +1,231 @@
+#include "hydro_stream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+constexpr char HYDRO_STREAM_MAGIC[8] = {'W', 'B', 'H', 'Y', 'D', 'S', 'T', 'R'};
+constexpr uint32_t HYDRO_STREAM_VERSION = 1;
+constexpr size_t HYDRO_STREAM_HEADER_SIZE = 64;
+
+typedef struct HydroStreamHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t numNodes;
+    uint64_t numHours;
+} HydroStreamHeader;
+
+static size_t align8(size_t offset) {
+    return (offset + 7) & ~((size_t) 7);
+}
+
+// Offset of the first hour's slab
+static size_t dataOffsetFor(size_t numNodes) {
+    return HYDRO_STREAM_HEADER_SIZE + 3 * align8(numNodes * sizeof(float));
+}
+
+static void writePadded(std::ofstream &out, const std::vector<float> &values) {
+    out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(float));
+    const char zeros[8] = {0};
+    out.write(zeros, align8(values.size() * sizeof(float)) - values.size() * sizeof(float));
+}
+
+HydroStreamWriter::HydroStreamWriter(const std::string &path, const std::vector<float> &xs, const std::vector<float> &ys)
+    : path(path), out(path + ".tmp", std::ios::binary | std::ios::trunc), numNodes(xs.size()), numHours(0),
+      minWses(xs.size(), std::numeric_limits<float>::infinity()), slab(4 * xs.size()) {
+    if (!this->out) {
+        throw std::runtime_error("Unable to write hydro stream file " + path);
+    }
+    // The header and minimum elevations are filled in by finish()
+    char headerBytes[HYDRO_STREAM_HEADER_SIZE] = {0};
+    this->out.write(headerBytes, HYDRO_STREAM_HEADER_SIZE);
+    writePadded(this->out, xs);
+    writePadded(this->out, ys);
+    writePadded(this->out, this->minWses);
+}
+
+void HydroStreamWriter::addHour(const float *us, const float *vs, const float *wses, const float *temps) {
+    const size_t n = this->numNodes;
+    std::copy(us, us + n, this->slab.begin());
+    std::copy(vs, vs + n, this->slab.begin() + n);
+    std::copy(wses, wses + n, this->slab.begin() + 2 * n);
+    std::copy(temps, temps + n, this->slab.begin() + 3 * n);
+    for (size_t i = 0; i < n; ++i) {
+        this->minWses[i] = std::min(this->minWses[i], wses[i]);
+    }
+    this->out.write(reinterpret_cast<const char *>(this->slab.data()), this->slab.size() * sizeof(float));
+    ++this->numHours;
+}
+
+void HydroStreamWriter::finish() {
+    HydroStreamHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, HYDRO_STREAM_MAGIC, sizeof(HYDRO_STREAM_MAGIC));
+    header.version = HYDRO_STREAM_VERSION;
+    header.numNodes = this->numNodes;
+    header.numHours = this->numHours;
+    this->out.seekp(0);
+    this->out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    this->out.seekp(HYDRO_STREAM_HEADER_SIZE + 2 * align8(this->numNodes * sizeof(float)));
+    writePadded(this->out, this->minWses);
+    this->out.close();
+    if (!this->out || std::rename((this->path + ".tmp").c_str(), this->path.c_str()) != 0) {
+        throw std::runtime_error("Unable to write hydro stream file " + this->path);
+    }
+}
+
+HydroStream::HydroStream(const std::string &path, size_t budgetBytes)
+    : path(path), numNodes(0), numHours(0), blockHours(0), numBlocks(0), dataOffset(0), residentBlocks{{0, 0}},
+      residentData{{nullptr, nullptr}}, stopping(false) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("Unable to open hydro stream file " + path);
+    }
+    const size_t fileSize = (size_t) in.tellg();
+    in.seekg(0);
+    HydroStreamHeader header;
+    if (fileSize < HYDRO_STREAM_HEADER_SIZE || !in.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || std::memcmp(header.magic, HYDRO_STREAM_MAGIC, sizeof(HYDRO_STREAM_MAGIC)) != 0
+        || header.version != HYDRO_STREAM_VERSION) {
+        throw std::runtime_error("Not a hydro stream file: " + path);
+    }
+    this->numNodes = (size_t) header.numNodes;
+    this->numHours = (size_t) header.numHours;
+    this->dataOffset = dataOffsetFor(this->numNodes);
+    const size_t slabBytes = 4 * this->numNodes * sizeof(float);
+    if (this->numHours == 0 || fileSize != this->dataOffset + this->numHours * slabBytes) {
+        throw std::runtime_error("Damaged hydro stream file " + path);
+    }
+    in.seekg(HYDRO_STREAM_HEADER_SIZE);
+    for (std::vector<float> *values : {&this->xs, &this->ys, &this->minWses}) {
+        values->resize(this->numNodes);
+        in.read(reinterpret_cast<char *>(values->data()), this->numNodes * sizeof(float));
+        in.seekg(align8(this->numNodes * sizeof(float)) - this->numNodes * sizeof(float), std::ios::cur);
+    }
+    if (!in) {
+        throw std::runtime_error("Damaged hydro stream file " + path);
+    }
+
+    this->blockHours = std::min(budgetBytes / (MAX_BLOCKS * std::max(slabBytes, (size_t) 1)), this->numHours);
+    if (this->blockHours < std::min(MAX_STEP_HOURS, this->numHours)) {
+        const size_t neededMB = (MAX_BLOCKS * MAX_STEP_HOURS * slabBytes + (1 << 20) - 1) >> 20;
+        throw std::runtime_error("hydroMemoryBudgetMB is too small for " + std::to_string(this->numNodes)
+                                 + " hydro nodes (needs at least " + std::to_string(neededMB) + ")");
+    }
+    this->numBlocks = (this->numHours + this->blockHours - 1) / this->blockHours;
+    for (Block &block : this->blocks) {
+        block.index = 0;
+        block.state = BlockState::Empty;
+    }
+    this->ioThread = std::thread(&HydroStream::ioLoop, this);
+}
+
+HydroStream::~HydroStream() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    this->ioThread.join();
+}
+
+void HydroStream::seek(size_t first, size_t count) {
+    if (first >= this->numHours) {
+        throw std::runtime_error("Hour " + std::to_string(first) + " is past the end of the hydrology data ("
+                                 + std::to_string(this->numHours) + " hours)");
+    }
+    const size_t last = std::min(first + std::max(count, (size_t) 1), this->numHours) - 1;
+    const size_t firstBlock = first / this->blockHours;
+    const size_t lastBlock = last / this->blockHours;
+    const size_t endBlock = std::min(lastBlock + 2, this->numBlocks);
+    auto wanted = [firstBlock, endBlock](size_t index) { return index >= firstBlock && index < endBlock; };
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    bool requested = false;
+    while (true) {
+        if (!this->ioError.empty()) {
+            throw std::runtime_error(this->ioError);
+        }
+        for (Block &block : this->blocks) {
+            if (block.state == BlockState::Ready && !wanted(block.index)) {
+                block.state = BlockState::Empty;
+            }
+        }
+        // Needed blocks first, then the prefetch
+        for (size_t index = firstBlock; index < endBlock; ++index) {
+            bool present = false;
+            for (const Block &block : this->blocks) {
+                present = present || (block.state != BlockState::Empty && block.index == index);
+            }
+            for (Block &block : this->blocks) {
+                if (!present && block.state == BlockState::Empty) {
+                    block.index = index;
+                    block.state = BlockState::Loading;
+                    present = requested = true;
+                }
+            }
+        }
+        if (requested) {
+            this->changed.notify_all();
+            requested = false;
+        }
+        const Block *firstReady = nullptr;
+        const Block *lastReady = nullptr;
+        for (const Block &block : this->blocks) {
+            if (block.state == BlockState::Ready && block.index == firstBlock) {
+                firstReady = &block;
+            }
+            if (block.state == BlockState::Ready && block.index == lastBlock) {
+                lastReady = &block;
+            }
+        }
+        if (firstReady != nullptr && lastReady != nullptr) {
+            this->residentBlocks = {firstBlock, lastBlock};
+            this->residentData = {firstReady->data.data(), lastReady->data.data()};
+            return;
+        }
+        this->changed.wait(lock);
+    }
+}
+
+void HydroStream::ioLoop() {
+    std::ifstream in(this->path, std::ios::binary);
+    const size_t slabFloats = 4 * this->numNodes;
+    while (true) {
+        Block *block = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->changed.wait(lock, [this, &block]() {
+                for (Block &b : this->blocks) {
+                    if (b.state == BlockState::Loading) {
+                        block = &b;
+                        break;
+                    }
+                }
+                return this->stopping || block != nullptr;
+            });
+            if (this->stopping) {
+                return;
+            }
+        }
+        // The main thread leaves a loading block alone until it's ready
+        const size_t firstHour = block->index * this->blockHours;
+        const size_t hours = std::min(this->blockHours, this->numHours - firstHour);
+        block->data.resize(this->blockHours * slabFloats);
+        in.seekg((std::streamoff) (this->dataOffset + firstHour * slabFloats * sizeof(float)));
+        in.read(reinterpret_cast<char *>(block->data.data()), (std::streamsize) (hours * slabFloats * sizeof(float)));
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!in) {
+                this->ioError = "Unable to read hydro stream file " + this->path;
+                in.clear();
+            }
+            block->state = BlockState::Ready;
+        }
+        this->changed.notify_all();
+    }
+}
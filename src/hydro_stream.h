@@ -0,0 +1,112 @@
+#ifndef __FISH_HYDRO_STREAM_H
+#define __FISH_HYDRO_STREAM_H
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+* Streaming distributary hydrology for runs whose hydro series won't fit in memory (hydroMemoryBudgetMB).
+* The NetCDF inputs are converted once (convertDistribHydro in load.h) to a time-major binary stream file:
+*   header (64 bytes): magic, version, node count, hour count
+*   float x[nodes], y[nodes], minimum water surface elevation[nodes] (each padded to 8 bytes)
+*   then one slab per hour: float u[nodes], v[nodes], wse[nodes], temp[nodes]
+* HydroStream keeps a sliding window of fixed-size blocks of hours from that file in memory: the block(s)
+* covering the current step, plus the next block, which a background I/O thread reads while the current
+* one is simulated. Blocks behind the window are evicted, so memory stays within the budget however long
+* the run is. The file is read with plain file I/O, so the I/O thread never calls into the (not
+* thread-safe) NetCDF library.
+*/
+
+// Writes a hydro stream file an hour at a time (to path + ".tmp", renamed into place by finish())
+class HydroStreamWriter {
+public:
+    HydroStreamWriter(const std::string &path, const std::vector<float> &xs, const std::vector<float> &ys);
+
+    // Append one hour of values, nodes in the order of xs and ys
+    void addHour(const float *us, const float *vs, const float *wses, const float *temps);
+    // Write the hour count and minimum water surface elevations and move the file into place; throws
+    // std::runtime_error if the file can't be written
+    void finish();
+
+private:
+    std::string path;
+    std::ofstream out;
+    size_t numNodes;
+    size_t numHours;
+    std::vector<float> minWses;
+    std::vector<float> slab;
+};
+
+class HydroStream {
+public:
+    // Blocks held at once: the one or two covering the current step and one being prefetched
+    static constexpr size_t MAX_BLOCKS = 3;
+    // Longest step a window must cover (the largest hoursPerTimestep)
+    static constexpr size_t MAX_STEP_HOURS = 6;
+
+    // Open a stream file, with blocks sized so MAX_BLOCKS of them fit in budgetBytes; throws
+    // std::runtime_error if the file is missing or damaged, or if the budget can't hold MAX_BLOCKS blocks
+    // of MAX_STEP_HOURS hours
+    HydroStream(const std::string &path, size_t budgetBytes);
+    ~HydroStream();
+    HydroStream(const HydroStream &) = delete;
+    HydroStream &operator=(const HydroStream &) = delete;
+
+    size_t getNumNodes() const { return numNodes; }
+    size_t getNumHours() const { return numHours; }
+    size_t getBlockHours() const { return blockHours; }
+    const std::vector<float> &getXs() const { return xs; }
+    const std::vector<float> &getYs() const { return ys; }
+    // Each node's lowest water surface elevation over the whole series
+    const std::vector<float> &getMinWses() const { return minWses; }
+
+    // Make hours [first, first + count) resident, waiting for the I/O thread if they aren't already, evict
+    // blocks before them and start prefetching the block after them. count must be at most MAX_STEP_HOURS;
+    // throws std::runtime_error if first is past the end of the data or the file can't be read
+    void seek(size_t first, size_t count);
+    // The slab of an hour in the last seek's range: u, v, wse and temp, getNumNodes() values each
+    const float *hour(size_t t) const {
+        const size_t block = t / this->blockHours;
+        const float *data = block == this->residentBlocks[0] ? this->residentData[0] : this->residentData[1];
+        return data + (t - block * this->blockHours) * 4 * this->numNodes;
+    }
+
+private:
+    enum class BlockState { Empty, Loading, Ready };
+    typedef struct Block {
+        size_t index;
+        BlockState state;
+        std::vector<float> data;
+    } Block;
+
+    std::string path;
+    size_t numNodes;
+    size_t numHours;
+    size_t blockHours;
+    size_t numBlocks;
+    size_t dataOffset;
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> minWses;
+
+    std::array<Block, MAX_BLOCKS> blocks;
+    // The blocks covering the last seek's range (the same block twice if it fits in one) and their data
+    std::array<size_t, 2> residentBlocks;
+    std::array<const float *, 2> residentData;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping;
+    std::string ioError;
+    std::thread ioThread;
+
+    void ioLoop();
+};
+
+#endif
@@ -11,12 +11,15 @@
 #include <queue>
 #include <tuple>
 #include <algorithm>
+#include <stdexcept>
+#include <future>
 #include <netcdf>
 
 #include "load.h"
 #include "custom_exceptions.h"
 #include "load_utils.h"
 #include "hydro.h"
+#include "hydro_stream.h"
 #include "model_config_map.h"
 
 // calculate distance between <x1, y1> and <x2, y2>
@@ -26,11 +29,56 @@ inline float distance(float x1, float y1, float x2, float y2) {
     return sqrt(dx*dx + dy*dy);
 }
 
+// Fill mode parameters read once up front, so missing values can be fixed off the thread that reads the files
+// (the NetCDF library isn't thread-safe)
+class CachedFillMode : public NcVarFillModeInterface {
+public:
+    explicit CachedFillMode(const netCDF::NcVar &ncVar) : fillActive(false), fillValue(0.0f) {
+        ncVar.getFillModeParameters(this->fillActive, &this->fillValue);
+    }
+
+    void getFillModeParameters(bool &fillActive, float *fillValue) const override {
+        fillActive = this->fillActive;
+        *fillValue = this->fillValue;
+    }
+
+private:
+    bool fillActive;
+    float fillValue;
+};
+
+// Largest block of a time-by-node variable read at once
+constexpr size_t HYDRO_READ_BLOCK_BYTES = 64UL * 1024UL * 1024UL;
+
+// The first failure (if any) and the warnings from fixing one hydro variable at every node
+typedef struct HydroFixResult {
+    std::vector<std::string> failures;
+    std::vector<std::vector<std::string>> warnings;
+} HydroFixResult;
+
+static HydroFixResult fixHydroVariable(std::vector<DistribHydroNode> &nodes, std::vector<float> DistribHydroNode::*values,
+                                       size_t timeCount, const CachedFillMode &fillMode, const std::string &description) {
+    HydroFixResult result;
+    result.failures.resize(nodes.size());
+    result.warnings.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        try {
+            fix_all_missing_values(timeCount, fillMode, nodes[i].*values, description + ", node: " + std::to_string(i+1),
+                                   &result.warnings[i]);
+        } catch (CustomExceptionWithMessage &e) {
+            result.failures[i] = e.what();
+        }
+    }
+    return result;
+}
+
 // Load the distributary hydrology data from two NetCDF files
 // the "nodesOut" argument is an output
 // After this method is called, it will contain a list of
 // "DistribHydroNode" objects, each of which has a 2d position and a list of hourly flow vectors,
 // water surface elevations, and water temperatures
+// The variables are read in blocks of nodes (one call per block rather than per node), then the missing
+// values of u, v, wse and temp are fixed concurrently
 void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vector<DistribHydroNode> &nodesOut) {
     netCDF::NcFile flowSourceFile(flowPath, netCDF::NcFile::FileMode::read);
     netCDF::NcFile wseTempSourceFile(wseTempPath, netCDF::NcFile::FileMode::read);
@@ -44,45 +92,84 @@ void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vect
     netCDF::NcVar temp = wseTempSourceFile.getVar("temp");
     // Create each node
     std::cout << std::endl;
-    std::vector<std::string> error_log;
-
+    std::vector<DistribHydroNode> nodes;
+    nodes.reserve(nodeCount);
+    std::vector<float> xs(nodeCount), ys(nodeCount);
+    if (nodeCount > 0) {
+        x.getVar(std::vector<size_t>{0}, std::vector<size_t>{nodeCount}, xs.data());
+        y.getVar(std::vector<size_t>{0}, std::vector<size_t>{nodeCount}, ys.data());
+    }
     for (size_t i = 0; i < nodeCount; ++i) {
-        std::cout << "\rloading distributary hydrology data: " << (i+1) << "/" << nodeCount;
+        nodes.emplace_back(i);
+        nodes.back().x = xs[i];
+        nodes.back().y = ys[i];
+        nodes.back().us.resize(timeCount);
+        nodes.back().vs.resize(timeCount);
+        nodes.back().wses.resize(timeCount);
+        nodes.back().temps.resize(timeCount);
+    }
+
+    // Variables are stored time-major, so each block is [time][node] and is scattered into the nodes
+    const size_t blockNodes = std::max((size_t) 1, HYDRO_READ_BLOCK_BYTES / (sizeof(float) * std::max(timeCount, (size_t) 1)));
+    std::vector<float> block;
+    const std::pair<const netCDF::NcVar *, std::vector<float> DistribHydroNode::*> variables[] = {
+        {&u, &DistribHydroNode::us}, {&v, &DistribHydroNode::vs},
+        {&wse, &DistribHydroNode::wses}, {&temp, &DistribHydroNode::temps}
+    };
+    for (size_t first = 0; first < nodeCount && timeCount > 0; first += blockNodes) {
+        const size_t count = std::min(blockNodes, nodeCount - first);
+        std::cout << "\rloading distributary hydrology data: " << (first + count) << "/" << nodeCount;
         std::cout.flush();
-        nodesOut.emplace_back(i);
+        block.resize(timeCount * count);
+        for (const auto &[ncVar, values] : variables) {
+            ncVar->getVar(std::vector<size_t>{0, first}, std::vector<size_t>{timeCount, count}, block.data());
+            for (size_t t = 0; t < timeCount; ++t) {
+                const float *row = &block[t * count];
+                for (size_t k = 0; k < count; ++k) {
+                    (nodes[first + k].*values)[t] = row[k];
+                }
+            }
+        }
+    }
+
+    const CachedFillMode xFill(x), yFill(y), uFill(u), vFill(v), wseFill(wse), tempFill(temp);
+    auto fixVariable = [&nodes, timeCount](std::vector<float> DistribHydroNode::*values, const CachedFillMode *fillMode,
+                                           const char *description) {
+        return fixHydroVariable(nodes, values, timeCount, *fillMode, description);
+    };
+    std::vector<std::future<HydroFixResult>> fixes;
+    fixes.push_back(std::async(std::launch::async, fixVariable, &DistribHydroNode::us, &uFill, "u (hydro u velocity)"));
+    fixes.push_back(std::async(std::launch::async, fixVariable, &DistribHydroNode::vs, &vFill, "v (hydro v velocity)"));
+    fixes.push_back(std::async(std::launch::async, fixVariable, &DistribHydroNode::wses, &wseFill, "wse (water surface elevation)"));
+    fixes.push_back(std::async(std::launch::async, fixVariable, &DistribHydroNode::temps, &tempFill, "temp (hydro temperature)"));
+    std::vector<HydroFixResult> results;
+    for (std::future<HydroFixResult> &fix : fixes) {
+        results.push_back(fix.get());
+    }
+
+    // Report in the order the nodes were checked one at a time: a node's coordinates, then u, v, wse and temp,
+    // with any warnings from the variables before the one that failed
+    std::vector<std::string> error_log;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        std::string failure;
         try {
-            DistribHydroNode &node = nodesOut.back();
-            std::vector<size_t> coordIndex{i};
-            x.getVar(coordIndex, &node.x);
-            y.getVar(coordIndex, &node.y);
-            validate_required_value(NetCDFVarFillAdapter(x), node.x, "Unrecoverable error: missing geo 'x' for hydro node: " + std::to_string(i+1));
-            validate_required_value(NetCDFVarFillAdapter(y), node.y, "Unrecoverable error: missing geo 'y' for hydro node: " + std::to_string(i+1));
-
-            // These vectors are passed as indices to getVar to retrieve the NetCDF data
-            std::vector<size_t> flowIndex{0, i};
-            std::vector<size_t> flowCounts{timeCount, 1};
-            // resize the lists' memory footprint ahead of time to fit the right number of timesteps
-            node.us.resize(timeCount);
-            node.vs.resize(timeCount);
-            node.wses.resize(timeCount);
-            node.temps.resize(timeCount);
-            // Retrieve the data from the NetCDF file, store it in the node's flow component lists
-            u.getVar(flowIndex, flowCounts, node.us.data());
-            v.getVar(flowIndex, flowCounts, node.vs.data());
-            wse.getVar(flowIndex, flowCounts, node.wses.data());
-            temp.getVar(flowIndex, flowCounts, node.temps.data());
-
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(u), node.us, "u (hydro u velocity), node: " + std::to_string(i+1), &error_log);
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(v), node.vs, "v (hydro v velocity), node: " + std::to_string(i+1), &error_log);
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(wse), node.wses, "wse (water surface elevation), node: " + std::to_string(i+1), &error_log);
-            fix_all_missing_values(timeCount, NetCDFVarFillAdapter(temp), node.temps, "temp (hydro temperature), node: " + std::to_string(i+1), &error_log);
+            validate_required_value(xFill, nodes[i].x, "Unrecoverable error: missing geo 'x' for hydro node: " + std::to_string(i+1));
+            validate_required_value(yFill, nodes[i].y, "Unrecoverable error: missing geo 'y' for hydro node: " + std::to_string(i+1));
         } catch (CustomExceptionWithMessage &e) {
+            failure = e.what();
+        }
+        for (size_t var = 0; var < results.size() && failure.empty(); ++var) {
+            const std::vector<std::string> &warnings = results[var].warnings[i];
+            error_log.insert(error_log.end(), warnings.begin(), warnings.end());
+            failure = results[var].failures[i];
+        }
+        if (!failure.empty()) {
             std::cout << std::endl;
-            std::cout << "ERROR! " << e.what() << "; skipping hydro node " << i+1 << "..." << std::endl;
+            std::cout << "ERROR! " << failure << "; skipping hydro node " << i+1 << "..." << std::endl;
             std::cout << "Please fix this error in " << flowPath << " or " << wseTempPath << std::endl << std::endl;
-
-            nodesOut.pop_back();
+            continue;
         }
+        nodesOut.push_back(std::move(nodes[i]));
     }
     std::cout << std::endl << "done loading hydro" << std::endl;
     if (error_log.size() > 0) {
@@ -94,6 +181,133 @@ void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vect
     }
 }
 
+// Warnings about fixed values printed per variable by convertDistribHydro (a multi-year series can have
+// very many); the rest are only counted
+constexpr size_t MAX_HYDRO_STREAM_WARNINGS = 100;
+
+// Convert the distributary hydrology NetCDF files to a hydro stream file (see hydro_stream.h), fixing missing
+// values and skipping unusable nodes as loadDistribHydro does. Both passes (finding each node's first good
+// value, then fixing and writing each hour) read blocks of hours that fit in budgetBytes, so the whole
+// series is never in memory.
+void convertDistribHydro(std::string &flowPath, std::string &wseTempPath, const std::string &streamPath,
+                         size_t budgetBytes) {
+    netCDF::NcFile flowSourceFile(flowPath, netCDF::NcFile::FileMode::read);
+    netCDF::NcFile wseTempSourceFile(wseTempPath, netCDF::NcFile::FileMode::read);
+    size_t nodeCount = flowSourceFile.getDim("node").getSize();
+    size_t timeCount = flowSourceFile.getDim("time").getSize();
+    netCDF::NcVar x = flowSourceFile.getVar("x");
+    netCDF::NcVar y = flowSourceFile.getVar("y");
+    const netCDF::NcVar variables[] = {
+        flowSourceFile.getVar("u"), flowSourceFile.getVar("v"),
+        wseTempSourceFile.getVar("wse"), wseTempSourceFile.getVar("temp")
+    };
+    const char *descriptions[] = {
+        "u (hydro u velocity)", "v (hydro v velocity)", "wse (water surface elevation)", "temp (hydro temperature)"
+    };
+    const CachedFillMode xFill(x), yFill(y);
+    std::vector<float> missing;
+    for (const netCDF::NcVar &ncVar : variables) {
+        bool fillActive;
+        float missingIndicator;
+        CachedFillMode(ncVar).getFillModeParameters(fillActive, &missingIndicator);
+        missing.push_back(missingIndicator);
+    }
+    std::vector<float> xs(nodeCount), ys(nodeCount);
+    if (nodeCount > 0) {
+        x.getVar(std::vector<size_t>{0}, std::vector<size_t>{nodeCount}, xs.data());
+        y.getVar(std::vector<size_t>{0}, std::vector<size_t>{nodeCount}, ys.data());
+    }
+
+    const size_t blockHours = std::max((size_t) 1, budgetBytes / (4 * sizeof(float) * std::max(nodeCount, (size_t) 1)));
+    std::vector<std::vector<float>> blocks(4);
+    auto readBlock = [&](size_t first, size_t count) {
+        for (size_t var = 0; var < 4; ++var) {
+            blocks[var].resize(count * nodeCount);
+            variables[var].getVar(std::vector<size_t>{first, 0}, std::vector<size_t>{count, nodeCount},
+                                  blocks[var].data());
+        }
+    };
+
+    // Pass 1: each variable's first good value at each node, which fills any missing values before it
+    std::vector<std::vector<float>> lastGood(4, std::vector<float>(nodeCount));
+    std::vector<std::vector<bool>> found(4, std::vector<bool>(nodeCount, false));
+    size_t unresolved = 4 * nodeCount;
+    for (size_t first = 0; first < timeCount && unresolved > 0; first += blockHours) {
+        const size_t count = std::min(blockHours, timeCount - first);
+        readBlock(first, count);
+        for (size_t var = 0; var < 4; ++var) {
+            for (size_t k = 0; k < count * nodeCount; ++k) {
+                const size_t i = k % nodeCount;
+                if (!found[var][i] && !is_missing_indicator(blocks[var][k], missing[var])) {
+                    found[var][i] = true;
+                    lastGood[var][i] = blocks[var][k];
+                    --unresolved;
+                }
+            }
+        }
+    }
+
+    std::vector<size_t> kept;
+    std::vector<float> keptXs, keptYs;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        std::string failure;
+        try {
+            validate_required_value(xFill, xs[i], "Unrecoverable error: missing geo 'x' for hydro node: " + std::to_string(i+1));
+            validate_required_value(yFill, ys[i], "Unrecoverable error: missing geo 'y' for hydro node: " + std::to_string(i+1));
+        } catch (CustomExceptionWithMessage &e) {
+            failure = e.what();
+        }
+        for (size_t var = 0; var < 4 && failure.empty(); ++var) {
+            if (!found[var][i]) {
+                failure = AllMissingValuesException(std::string(descriptions[var]) + ", node: " + std::to_string(i+1)).what();
+            }
+        }
+        if (!failure.empty()) {
+            std::cout << "ERROR! " << failure << "; skipping hydro node " << i+1 << "..." << std::endl;
+            std::cout << "Please fix this error in " << flowPath << " or " << wseTempPath << std::endl << std::endl;
+            continue;
+        }
+        kept.push_back(i);
+        keptXs.push_back(xs[i]);
+        keptYs.push_back(ys[i]);
+    }
+
+    // Pass 2: fix and write each hour
+    HydroStreamWriter writer(streamPath, keptXs, keptYs);
+    std::vector<std::vector<float>> hour(4, std::vector<float>(kept.size()));
+    std::vector<size_t> fixedCounts(4, 0);
+    for (size_t first = 0; first < timeCount; first += blockHours) {
+        const size_t count = std::min(blockHours, timeCount - first);
+        std::cout << "\rconverting distributary hydrology data: " << (first + count) << "/" << timeCount << " hours";
+        std::cout.flush();
+        readBlock(first, count);
+        for (size_t t = 0; t < count; ++t) {
+            for (size_t var = 0; var < 4; ++var) {
+                const float *row = &blocks[var][t * nodeCount];
+                for (size_t k = 0; k < kept.size(); ++k) {
+                    float value = row[kept[k]];
+                    if (fix_missing_value(value, lastGood[var][kept[k]], missing[var])) {
+                        if (++fixedCounts[var] <= MAX_HYDRO_STREAM_WARNINGS) {
+                            std::cout << std::endl << "WARNING!! Fixing missing vector data in " << descriptions[var]
+                                      << ", node: " << kept[k] + 1 << " at step " << first + t;
+                        }
+                    }
+                    hour[var][k] = value;
+                }
+            }
+            writer.addHour(hour[0].data(), hour[1].data(), hour[2].data(), hour[3].data());
+        }
+    }
+    writer.finish();
+    std::cout << std::endl << "done converting hydro to " << streamPath << std::endl;
+    for (size_t var = 0; var < 4; ++var) {
+        if (fixedCounts[var] > MAX_HYDRO_STREAM_WARNINGS) {
+            std::cout << "WARNING!! " << fixedCounts[var] << " missing values fixed in " << descriptions[var]
+                      << " (the first " << MAX_HYDRO_STREAM_WARNINGS << " are listed above). Please fix." << std::endl;
+        }
+    }
+}
+
 void assignHydroNodeToMapNodeWithDistance(const unsigned hydroNodeIndex, MapNode *mapNode, const float distance) {
     mapNode->nearestHydroNodeID = hydroNodeIndex;
     mapNode->hydroNodeDistance = distance;
@@ -209,17 +423,15 @@ void assignNearestHydroNodes(std::vector<MapNode *> &map, std::vector<DistribHyd
 }
 
 // Adjust the map's elevation values to make the minimum depth in distributary channels
-// at least a cutoff value (20cm)
-void fixElevations(std::vector<MapNode *> &map, std::vector<DistribHydroNode> &hydroNodes) {
+// at least a cutoff value (20cm), from each hydro node's lowest water surface elevation
+void fixElevations(std::vector<MapNode *> &map, const std::vector<float> &minWses) {
     const float cutoffDepth = 0.2f;
     float minDistribDepth = cutoffDepth;
     for (MapNode *node : map) {
         if (isDistributary(node->type)) {
-            for (float wse : hydroNodes[node->nearestHydroNodeID].wses) {
-                float depth = wse - node->elev;
-                if (depth < minDistribDepth) {
-                    minDistribDepth = depth;
-                }
+            float depth = minWses[node->nearestHydroNodeID] - node->elev;
+            if (depth < minDistribDepth) {
+                minDistribDepth = depth;
             }
         }
     }
@@ -229,6 +441,17 @@ void fixElevations(std::vector<MapNode *> &map, std::vector<DistribHydroNode> &h
     }
 }
 
+// As above, from each hydro node's full water surface elevation series
+void fixElevations(std::vector<MapNode *> &map, std::vector<DistribHydroNode> &hydroNodes) {
+    std::vector<float> minWses(hydroNodes.size(), std::numeric_limits<float>::infinity());
+    for (size_t i = 0; i < hydroNodes.size(); ++i) {
+        for (float wse : hydroNodes[i].wses) {
+            minWses[i] = std::min(minWses[i], wse);
+        }
+    }
+    fixElevations(map, minWses);
+}
+
 // Split a string into a list of strings delimited by the character given in argument "c"
 std::vector<std::string> split(std::string &s, char c) {
     std::vector<std::string> result;
@@ -291,6 +514,62 @@ std::vector<int> loadIntList(std::string &filePath) {
     return result;
 }
 
+// Load sampling campaigns from a CSV file (see load.h for the format)
+void loadSamplingSchedule(std::string &filePath, const std::vector<SamplingSite *> &samplingSites,
+                          std::vector<SamplingCampaign> &out) {
+    std::ifstream f(filePath);
+    if (!f) {
+        throw std::runtime_error("Could not open sampling schedule file " + filePath);
+    }
+    std::unordered_map<std::string, size_t> siteIdsByName;
+    for (size_t i = 0; i < samplingSites.size(); ++i) {
+        siteIdsByName[samplingSites[i]->siteName] = i;
+    }
+    std::string line;
+    bool first = true;
+    while (std::getline(f, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (first) {
+            // Skip the header
+            first = false;
+            continue;
+        }
+        if (line.empty()) {
+            continue;
+        }
+        std::vector<std::string> chunks = split(line, ',');
+        if (chunks.size() < 4) {
+            throw std::runtime_error("Sampling schedule row needs site, day, hour and method: " + line);
+        }
+        SamplingCampaign campaign;
+        if (chunks[0] != "all") {
+            auto site = siteIdsByName.find(chunks[0]);
+            if (site == siteIdsByName.end()) {
+                throw std::runtime_error("Unknown sampling site in sampling schedule: " + chunks[0]);
+            }
+            campaign.siteIds.push_back(site->second);
+        }
+        long day = std::stol(chunks[1]);
+        long hour = std::stol(chunks[2]);
+        long repeatDays = chunks.size() > 4 && !chunks[4].empty() ? std::stol(chunks[4]) : 0L;
+        if (day < 0 || hour < 0 || hour > 23 || repeatDays < 0) {
+            throw std::runtime_error("Out-of-range day, hour or repeatDays in sampling schedule: " + line);
+        }
+        campaign.firstHour = day * 24L + hour;
+        campaign.repeatHours = repeatDays * 24L;
+        if (chunks[3] == "beach seine") {
+            campaign.method = SamplingMethod::BeachSeine;
+        } else if (chunks[3] == "fyke") {
+            campaign.method = SamplingMethod::Fyke;
+        } else {
+            throw std::runtime_error("Unknown sampling method in sampling schedule: " + chunks[3]);
+        }
+        out.push_back(campaign);
+    }
+}
+
 // Load a list of floats from a file (where each float is on its own line)
 // The argument "out" is where the results will be stored
 void loadFloatList(std::string &filePath, std::vector<float> &out) {
@@ -448,7 +727,8 @@ void removeAllEdgesBetween(MapNode *node, MapNode *neighbor) {
 // Combine two nodes
 MapNode *mergeNodes(MapNode *a, MapNode *b) {
     // Construct a new node to replace them
-    MapNode *newNode = new MapNode(a->type, a->area + b->area, (a->elev + b->elev)*0.5f, (a->pathDist + b->pathDist)*0.5f);
+    MapNode *newNode = new MapNode(a->type, a->area + b->area, (a->elev + b->elev)*0.5f, (a->pathDist + b->pathDist)*0.5f,
+                                   a->edgesOut.get_allocator().resource());
     newNode->id = a->id;
     // Place it at the average location of the two merged nodes
     newNode->x = (a->x + b->x) / 2.0f;
@@ -576,7 +856,8 @@ MapNode *elaborateEdge(Edge e) {
     float newArea = areaFromSource + areaFromTarget;
     e.source->area -= areaFromSource;
     e.target->area -= areaFromTarget;
-    MapNode *newNode = new MapNode(e.target->type, newArea, (e.source->elev + e.target->elev)*0.5f, (e.source->pathDist + e.target->pathDist)*0.5f);
+    MapNode *newNode = new MapNode(e.target->type, newArea, (e.source->elev + e.target->elev)*0.5f, (e.source->pathDist + e.target->pathDist)*0.5f,
+                                   e.target->edgesIn.get_allocator().resource());
     newNode->x = (e.source->x + e.target->x) * 0.5f;
     newNode->y = (e.source->y + e.target->y) * 0.5f;
     e.source->edgesOut.emplace_back(e.source, newNode, e.length/2.0f);
@@ -992,14 +1273,14 @@ bool hasReversedEdgeOf(const Edge &newEdge) {
         });
 }
 
-bool hasMatchingEdge(const std::vector<Edge>& edges, const Edge& e) {
+bool hasMatchingEdge(const EdgeList& edges, const Edge& e) {
     return std::any_of(edges.begin(), edges.end(),
         [&](const Edge& old_edge) {
             return old_edge.source == e.source && old_edge.target == e.target;
         });
 }
 
-void addEdgeIfNotDuplicate(std::vector<Edge>& edges, const Edge& e) {
+void addEdgeIfNotDuplicate(EdgeList& edges, const Edge& e) {
     if (!hasMatchingEdge(edges, e)) {
         edges.push_back(e);
     }
@@ -1022,18 +1303,19 @@ void checkAndAddEdge(Edge e) {
 
 // Load a map from vertex, edge, and geometry files
 // (additionally runs cleanup on the resulting map graph)
-void loadMap(
+void parseMap(
     std::vector<MapNode *> &dest,
     std::string& locationFilePath,
     std::string& edgeFilePath,
     std::string& geometryFilePath,
-    std::vector<DistribHydroNode> &hydroNodes,
     std::vector<unsigned> &recPointIds,
     std::vector<MapNode *> &recPoints,
     std::vector<MapNode *> &monitoringPoints,
     std::vector<SamplingSite *> &samplingSites,
     float blindChannelSimplificationRadius,
-    const ModelConfigMap& configMap
+    const ModelConfigMap& configMap,
+    MapCoarsening &coarsening,
+    std::pmr::memory_resource *edgeMemory
 ) {
     std::ifstream locationFile;
     locationFile.open(locationFilePath);
@@ -1071,7 +1353,7 @@ void loadMap(
         HabitatType habType = std::stoi(chunks[11]) == 1 ? HabitatType::DistributaryEdge : habTypeByName.at(chunks[6]);
 
         dest.push_back(new MapNode(
-            habType, area, elev, sourceDistance
+            habType, area, elev, sourceDistance, edgeMemory
         ));
         MapNode *node = dest.back();
         node->id = csvId;
@@ -1164,7 +1446,45 @@ void loadMap(
     };
     //assignCrossChannelEdges(dest); // OBSOLETE
     fixDisjointDistributaries(dest, recPoints, protectedNodes); //TODO:GROT - deprecate? can change distributaries to blind channels, reports on disconnected and orphaned nodes
+    int coarsenTargetNodes = configMap.getInt(ModelParamKey::MapCoarsenTargetNodes);
+    if (coarsenTargetNodes > 0) {
+        CoarsenCriteria criteria;
+        criteria.targetNodes = (size_t) coarsenTargetNodes;
+        criteria.maxElevationDifference = configMap.getFloat(ModelParamKey::MapCoarsenMaxElevationDifference);
+        criteria.maxPathDistDifference = configMap.getFloat(ModelParamKey::MapCoarsenMaxPathDistDifference);
+        coarsening = coarsenMap(dest, protectedNodes, criteria);
+    }
+}
+
+void assignMapHydro(std::vector<MapNode *> &dest, std::vector<DistribHydroNode> &hydroNodes) {
     assignNearestHydroNodes(dest, hydroNodes);
     fixElevations(dest, hydroNodes);
     outputNodeCounts(dest, "Map");
+}
+
+void assignMapHydro(std::vector<MapNode *> &dest, std::vector<DistribHydroNode> &hydroNodes,
+                    const std::vector<float> &minWses) {
+    assignNearestHydroNodes(dest, hydroNodes);
+    fixElevations(dest, minWses);
+    outputNodeCounts(dest, "Map");
+}
+
+void loadMap(
+    std::vector<MapNode *> &dest,
+    std::string& locationFilePath,
+    std::string& edgeFilePath,
+    std::string& geometryFilePath,
+    std::vector<DistribHydroNode> &hydroNodes,
+    std::vector<unsigned> &recPointIds,
+    std::vector<MapNode *> &recPoints,
+    std::vector<MapNode *> &monitoringPoints,
+    std::vector<SamplingSite *> &samplingSites,
+    float blindChannelSimplificationRadius,
+    const ModelConfigMap& configMap,
+    MapCoarsening &coarsening,
+    std::pmr::memory_resource *edgeMemory
+) {
+    parseMap(dest, locationFilePath, edgeFilePath, geometryFilePath, recPointIds, recPoints, monitoringPoints,
+             samplingSites, blindChannelSimplificationRadius, configMap, coarsening, edgeMemory);
+    assignMapHydro(dest, hydroNodes);
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <unordered_map>
 
 #include "map.h"
+#include "map_coarsen.h"
+#include "event_scheduler.h"
 
 class ModelConfigMap;
 // Utility function to split a string into chunks delimited by a given character
@@ -15,6 +17,11 @@ std::vector<std::string> split(std::string& s, char c);
 // See CONFIG_README for a description of the file formats
 void loadDistribHydro(std::string &flowPath, std::string &wseTempPath, std::vector<DistribHydroNode> &nodesOut);
 
+// Converts the same files to a hydro stream file (see hydro_stream.h) at streamPath, for runs that stream the
+// hydrology instead of loading it (hydroMemoryBudgetMB), holding about budgetBytes of it at a time
+void convertDistribHydro(std::string &flowPath, std::string &wseTempPath, const std::string &streamPath,
+                         size_t budgetBytes);
+
 // Loads recruit size distributions from a CSV file into a 2d float vector
 // See CONFIG_README for a description of the file format
 void loadRecSizeDists(std::string &filePath, std::vector<std::vector<float>> &out);
@@ -32,11 +39,21 @@ std::vector<float> loadFloatListInterleaved(std::string &filePath, int n);
 
 void checkAndAddEdge(Edge e);
 
+// Loads sampling campaigns from a CSV file with the header line "site,day,hour,method,repeatDays", one campaign
+// per row: the site name (or "all"), the first sampling's day (0 = the model's first day) and hour (0-23), the
+// method ("beach seine" or "fyke") and the days between samplings (0 or omitted = only once)
+// Throws if a row names an unknown site or method or has an out-of-range value
+void loadSamplingSchedule(std::string &filePath, const std::vector<SamplingSite *> &samplingSites,
+                          std::vector<SamplingCampaign> &out);
+
 // Loads a list of sampling sites from a CSV file into a vector of SamplingSites (defined in map.h)
 //void loadSamplingSites(std::string &filePath, std::vector<MapNode *> &map, std::vector<SamplingSite> &out);
 
 // Loads the map from a CSV location file, a CSV edge file, and a CSV geometry file
-// The resulting heap-allocatd MapNodes are placed in the vector 'dest'
+// The resulting heap-allocatd MapNodes are placed in the vector 'dest', their edge lists allocated from
+// edgeMemory (a MapArena's build memory, say; see map_arena.h)
+// If mapCoarsenTargetNodes is set, the map is then coarsened (see map_coarsen.h) and the fine-to-coarse
+// correspondence is placed in 'coarsening'
 // See CONFIG_README for a description of file formats
 void loadMap(
     std::vector<MapNode *> &dest,
@@ -49,6 +66,30 @@ void loadMap(
     std::vector<MapNode *> &monitoringPoints,
     std::vector<SamplingSite *> &samplingSites,
     float blindChannelSimplificationRadius,
-    const ModelConfigMap& configMap);
+    const ModelConfigMap& configMap,
+    MapCoarsening &coarsening,
+    std::pmr::memory_resource *edgeMemory = std::pmr::get_default_resource());
+
+// The two halves of loadMap: parseMap reads, cleans up and (optionally) coarsens the map, which doesn't need
+// the hydrology, so it can run while the hydrology loads; assignMapHydro then links each location to its
+// nearest hydro node and fixes elevations against the water surface
+void parseMap(
+    std::vector<MapNode *> &dest,
+    std::string& locationFilePath,
+    std::string& edgeFilePath,
+    std::string& geometryFilePath,
+    std::vector<unsigned> &recPointIds,
+    std::vector<MapNode *> &recPoints,
+    std::vector<MapNode *> &monitoringPoints,
+    std::vector<SamplingSite *> &samplingSites,
+    float blindChannelSimplificationRadius,
+    const ModelConfigMap& configMap,
+    MapCoarsening &coarsening,
+    std::pmr::memory_resource *edgeMemory = std::pmr::get_default_resource());
+void assignMapHydro(std::vector<MapNode *> &dest, std::vector<DistribHydroNode> &hydroNodes);
+// For streamed hydrology, whose hydroNodes have no series: elevations are fixed from each hydro node's lowest
+// water surface elevation (HydroStream::getMinWses)
+void assignMapHydro(std::vector<MapNode *> &dest, std::vector<DistribHydroNode> &hydroNodes,
+                    const std::vector<float> &minWses);
 
 #endif
\ No newline at end of file
@@ -47,11 +47,20 @@ Edge::Edge(MapNode *source, MapNode *target, float length)
      : source(source), target(target), length(length)
      {}
 
-MapNode::MapNode(HabitatType type, float area, float elev, float pathDist)
-        : id(-1), type(type), area(area), elev(elev), pathDist(pathDist),
+MapNode::MapNode(HabitatType type, float area, float elev, float pathDist, std::pmr::memory_resource *edgeMemory)
+        : id(-1), edgesIn(edgeMemory), edgesOut(edgeMemory), type(type), area(area), elev(elev), pathDist(pathDist),
         crossChannelA(nullptr), crossChannelB(nullptr),
         nearestHydroNodeID(std::numeric_limits<unsigned>::max()), hydroNodeDistance(std::numeric_limits<float>::max()),
-        popDensity(0.0f)
+        residentWeight(0.0f), popDensity(0.0f)
+{}
+
+MapNode::MapNode(const MapNode &other, std::pmr::memory_resource *edgeMemory)
+        : id(other.id), edgesIn(other.edgesIn, edgeMemory), edgesOut(other.edgesOut, edgeMemory), x(other.x),
+        y(other.y), type(other.type), area(other.area), elev(other.elev), pathDist(other.pathDist),
+        crossChannelA(other.crossChannelA), crossChannelB(other.crossChannelB),
+        nearestHydroNodeID(other.nearestHydroNodeID), hydroNodeDistance(other.hydroNodeDistance),
+        residentIds(other.residentIds), residentWeight(other.residentWeight), popDensity(other.popDensity),
+        medMass(other.medMass), maxMass(other.maxMass)
 {}
 
 SamplingSite::SamplingSite(std::string siteName, size_t id) : siteName(siteName), id(id), points() {}
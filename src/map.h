@@ -1,6 +1,7 @@
 #ifndef __FISH_MAP_H
 #define __FISH_MAP_H
 
+#include <memory_resource>
 #include <vector>
 #include <string>
 
@@ -63,14 +64,18 @@ public:
     Edge(MapNode *source, MapNode *target, float length);
 };
 
+// A location's edge list; its memory comes from the heap unless the location was built in a MapArena
+// (see map_arena.h)
+typedef std::pmr::vector<Edge> EdgeList;
+
 class MapNode {
 public:
     // ID (index in the map node list)
     int id;
     // List of edges for which Edge::target == this
-    std::vector<Edge> edgesIn;
+    EdgeList edgesIn;
     // List of edges for which Edge::source == this
-    std::vector<Edge> edgesOut;
+    EdgeList edgesOut;
     float x; // horizontal (longitudinal) UTM Zone 10N coordinate
     float y; // vertical (latitudinal) UTM Zone 10N coordinate
     // see HabitatType declaration above
@@ -90,6 +95,8 @@ public:
     float hydroNodeDistance;
     // List of Fish::id of living fish such that Fish::location == this -- updated in Model::countAll
     std::vector<long> residentIds;
+    // Number of living fish at this location (the sum of the residents' Fish::weight) -- updated in Model::countAll
+    float residentWeight;
     // Population density of living fish at this location, in individuals/m^2 -- updated in Model::countAll
     float popDensity;
     // Median fish mass at this location (g) -- updated in Model::countAll
@@ -97,12 +104,16 @@ public:
     // Maximum fish mass at this location (g) -- updated in Model::countAll
     float maxMass;
 
-    MapNode(HabitatType type, float area, float elev, float pathDist);
+    // Edge lists are allocated from edgeMemory (the heap by default)
+    MapNode(HabitatType type, float area, float elev, float pathDist,
+            std::pmr::memory_resource *edgeMemory = std::pmr::get_default_resource());
+    // A copy of other whose edge lists are allocated from edgeMemory (still pointing at other's neighbors)
+    MapNode(const MapNode &other, std::pmr::memory_resource *edgeMemory);
 };
 
 float getDistance(MapNode *a, MapNode *b);
 
-// This struct represents a site at which biweekly sampling is conducted
+// This struct represents a site at which sampling is conducted (see samplingCampaigns in model.h for when)
 typedef struct SamplingSite {
     // The human-readable site name
     std::string siteName;
@@ -0,0 +1,99 @@
+#include "map_arena.h"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+
+MapArena::MapArena()
+    : building(std::make_unique<std::pmr::monotonic_buffer_resource>()), edges(), nodes(nullptr), numNodes(0) {}
+
+MapArena::~MapArena() {
+    // Only the resident lists free anything here; the edge lists go with their block
+    for (size_t i = 0; i < this->numNodes; ++i) {
+        this->nodes[i].~MapNode();
+    }
+    ::operator delete(this->nodes);
+}
+
+std::pmr::memory_resource *MapArena::buildMemory() {
+    if (!this->building) {
+        throw std::runtime_error("Map arena has already been compacted");
+    }
+    return this->building.get();
+}
+
+void MapArena::compact(std::vector<MapNode *> &map, const std::vector<std::vector<MapNode *> *> &others) {
+    if (this->nodes != nullptr) {
+        throw std::runtime_error("Map arena already holds a map");
+    }
+    size_t numEdges = 0;
+    for (const MapNode *node : map) {
+        numEdges += node->edgesIn.size() + node->edgesOut.size();
+    }
+    // Room for every list even if each needs aligning, so the edges take a single upstream allocation
+    this->edges = std::make_unique<std::pmr::monotonic_buffer_resource>(
+        (numEdges + 2 * map.size() + 1) * sizeof(Edge));
+    this->nodes = static_cast<MapNode *>(::operator new(sizeof(MapNode) * std::max(map.size(), (size_t) 1)));
+    std::unordered_map<const MapNode *, MapNode *> moved;
+    moved.reserve(map.size());
+    for (size_t i = 0; i < map.size(); ++i) {
+        new (&this->nodes[i]) MapNode(*map[i], this->edges.get());
+        this->numNodes = i + 1;
+        moved[map[i]] = &this->nodes[i];
+    }
+    auto movedNode = [&moved](const MapNode *node) {
+        auto it = moved.find(node);
+        if (it == moved.end()) {
+            throw std::runtime_error("Location isn't in the map being compacted");
+        }
+        return it->second;
+    };
+    // An edge of the original map lives in its source's outgoing list or its target's incoming list
+    auto movedEdge = [&movedNode](const Edge *edge) -> Edge * {
+        if (edge == nullptr) {
+            return nullptr;
+        }
+        const EdgeList &out = edge->source->edgesOut;
+        if (edge >= out.data() && edge < out.data() + out.size()) {
+            return &movedNode(edge->source)->edgesOut[edge - out.data()];
+        }
+        const EdgeList &in = edge->target->edgesIn;
+        if (edge >= in.data() && edge < in.data() + in.size()) {
+            return &movedNode(edge->target)->edgesIn[edge - in.data()];
+        }
+        throw std::runtime_error("Cross-channel edge isn't in its locations' edge lists");
+    };
+    for (size_t i = 0; i < this->numNodes; ++i) {
+        MapNode &node = this->nodes[i];
+        for (EdgeList *list : {&node.edgesIn, &node.edgesOut}) {
+            for (Edge &edge : *list) {
+                edge.source = movedNode(edge.source);
+                edge.target = movedNode(edge.target);
+            }
+        }
+        node.crossChannelA = movedEdge(map[i]->crossChannelA);
+        node.crossChannelB = movedEdge(map[i]->crossChannelB);
+    }
+    std::vector<std::vector<MapNode *>> movedLists;
+    for (const std::vector<MapNode *> *list : others) {
+        movedLists.emplace_back();
+        for (const MapNode *node : *list) {
+            movedLists.back().push_back(movedNode(node));
+        }
+    }
+
+    // Nothing can fail from here on
+    for (size_t i = 0; i < others.size(); ++i) {
+        *others[i] = std::move(movedLists[i]);
+    }
+    for (size_t i = 0; i < map.size(); ++i) {
+        delete map[i];
+        map[i] = &this->nodes[i];
+    }
+    this->building.reset();
+}
+
+bool MapArena::owns(const MapNode *node) const {
+    return this->numNodes > 0 && node >= this->nodes && node < this->nodes + this->numNodes;
+}
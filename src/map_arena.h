@@ -0,0 +1,49 @@
+#ifndef __FISH_MAP_ARENA_H
+#define __FISH_MAP_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+#include "map.h"
+
+/*
+* Storage for a finished map.
+*
+* While a map is built (parseMap, generateMap, and the merging and splitting of locations during cleanup), its
+* locations' edge lists grow one edge at a time and locations come and go, so the edge lists are allocated
+* from the arena's build memory, a monotonic buffer that never frees and so never fragments the heap. Once
+* the map is finished, compact copies every location into one contiguous block in map order and every edge
+* list into a second block sized for exactly the map's edges (each location's incoming then outgoing edges),
+* then deletes the originals and drops the build memory in one go. Walking the map then touches neighboring
+* memory, and tearing it down frees two blocks rather than every location and edge list.
+*
+* Edge lists of compacted locations can still grow (for instance in tests); growth comes from the heap.
+*/
+class MapArena {
+public:
+    MapArena();
+    ~MapArena();
+    MapArena(const MapArena &) = delete;
+    MapArena &operator=(const MapArena &) = delete;
+
+    // Edge list memory for locations under construction (pass it to MapNode's constructor); gone after compact
+    std::pmr::memory_resource *buildMemory();
+    // Move the (heap-allocated) locations of map into the arena as described above, deleting the originals.
+    // Edge endpoints, cross-channel edges, map itself and the location lists in others (recruit points,
+    // monitoring points, sampling site points and so on) are re-pointed at the moved locations. Throws if the
+    // arena already holds a map or if a list in others names a location that isn't in map.
+    void compact(std::vector<MapNode *> &map, const std::vector<std::vector<MapNode *> *> &others);
+    // Whether node is one of the compacted locations
+    bool owns(const MapNode *node) const;
+    // Number of compacted locations (0 before compact)
+    size_t size() const { return this->numNodes; }
+
+private:
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> building;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> edges;
+    MapNode *nodes;
+    size_t numNodes;
+};
+
+#endif
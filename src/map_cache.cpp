@@ -0,0 +1,349 @@
+#include "map_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <sys/stat.h>
+
+constexpr char MAP_CACHE_MAGIC[8] = {'W', 'B', 'M', 'A', 'P', 'C', 'A', 'C'};
+constexpr uint32_t MAP_CACHE_VERSION = 2;
+constexpr size_t MAP_CACHE_HEADER_SIZE = 128;
+
+/*
+* File layout (native byte order; every section starts on an 8-byte boundary):
+*   header (128 bytes): magic, version, then the section counts below
+*   MapCacheNode[numNodes], in map order
+*   MapCacheEdge[numEdgesOut] (each node's edgesOut in order, nodes in map order), then MapCacheEdge[numEdgesIn]
+*   uint32 recruit point, monitoring point and sampling site point map positions
+*   MapCacheSite[numSamplingSites], then the site names, concatenated
+*   int32 fine IDs[numFine], int32 coarse IDs[numFine], float fine areas[numFine]
+*   if reachabilityNeighborhoodSize isn't 0, the reachability index: uint64 offsets[numNodes + 1],
+*   float radii[numNodes], uint32 ids[numReachabilityEntries], float lengths[numReachabilityEntries]
+*/
+typedef struct MapCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t numNodes;
+    uint64_t numEdgesOut;
+    uint64_t numEdgesIn;
+    uint64_t numRecPoints;
+    uint64_t numMonitoringPoints;
+    uint64_t numSamplingSites;
+    uint64_t numSitePoints;
+    uint64_t numSiteNameBytes;
+    uint64_t numFine;
+    uint64_t reachabilityNeighborhoodSize;
+    uint64_t numReachabilityEntries;
+} MapCacheHeader;
+
+typedef struct MapCacheNode {
+    int32_t id;
+    int32_t type;
+    float x;
+    float y;
+    float area;
+    float elev;
+    float pathDist;
+    uint32_t nearestHydroNodeID;
+    float hydroNodeDistance;
+    uint32_t numEdgesOut;
+    uint32_t numEdgesIn;
+    uint32_t reserved;
+} MapCacheNode;
+
+typedef struct MapCacheEdge {
+    // Map position of the other end of the edge
+    uint32_t other;
+    float length;
+} MapCacheEdge;
+
+typedef struct MapCacheSite {
+    uint64_t id;
+    uint32_t nameLength;
+    uint32_t numPoints;
+} MapCacheSite;
+
+static size_t align8(size_t offset) {
+    return (offset + 7) & ~((size_t) 7);
+}
+
+template <typename T>
+static void writeSection(std::ofstream &out, const std::vector<T> &values) {
+    out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    size_t padding = align8(values.size() * sizeof(T)) - values.size() * sizeof(T);
+    const char zeros[8] = {0};
+    out.write(zeros, padding);
+}
+
+// Copy the next section out of a cache file; false if the file is too short
+template <typename T>
+static bool readSection(const std::vector<char> &bytes, size_t &offset, size_t count, std::vector<T> &values) {
+    size_t size = count * sizeof(T);
+    if (offset + size > bytes.size()) {
+        return false;
+    }
+    values.resize(count);
+    std::memcpy(values.data(), bytes.data() + offset, size);
+    offset += align8(size);
+    return true;
+}
+
+std::string mapCacheKey(const std::vector<std::string> &inputPaths, const std::vector<unsigned> &recPointIds,
+                        const std::string &settings) {
+    std::ostringstream description;
+    description << MAP_CACHE_VERSION;
+    for (const std::string &path : inputPaths) {
+        struct stat info;
+        description << '|' << path;
+        if (stat(path.c_str(), &info) == 0) {
+            description << ':' << info.st_size << ':' << info.st_mtime;
+        }
+    }
+    description << '|';
+    for (unsigned id : recPointIds) {
+        description << id << ',';
+    }
+    description << '|' << settings;
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : description.str()) {
+        hash ^= (unsigned char) c;
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+}
+
+void writeMapCache(const std::string &path, const std::vector<MapNode *> &map, const std::vector<MapNode *> &recPoints,
+                   const std::vector<MapNode *> &monitoringPoints, const std::vector<SamplingSite *> &samplingSites,
+                   const MapCoarsening &coarsening, const ReachabilityIndex &reachability) {
+    std::unordered_map<const MapNode *, uint32_t> positions;
+    for (size_t i = 0; i < map.size(); ++i) {
+        positions[map[i]] = (uint32_t) i;
+    }
+    auto position = [&positions](const MapNode *node) {
+        auto it = positions.find(node);
+        if (it == positions.end()) {
+            throw std::runtime_error("Map cache: location " + std::to_string(node->id) + " is linked but not in the map");
+        }
+        return it->second;
+    };
+    std::vector<MapCacheNode> nodes;
+    std::vector<MapCacheEdge> edgesOut;
+    std::vector<MapCacheEdge> edgesIn;
+    for (const MapNode *node : map) {
+        nodes.push_back({node->id, (int32_t) node->type, node->x, node->y, node->area, node->elev, node->pathDist,
+                         node->nearestHydroNodeID, node->hydroNodeDistance, (uint32_t) node->edgesOut.size(),
+                         (uint32_t) node->edgesIn.size(), 0});
+        for (const Edge &e : node->edgesOut) {
+            edgesOut.push_back({position(e.target), e.length});
+        }
+        for (const Edge &e : node->edgesIn) {
+            edgesIn.push_back({position(e.source), e.length});
+        }
+    }
+    std::vector<uint32_t> points;
+    for (const MapNode *node : recPoints) {
+        points.push_back(position(node));
+    }
+    for (const MapNode *node : monitoringPoints) {
+        points.push_back(position(node));
+    }
+    std::vector<MapCacheSite> sites;
+    std::vector<char> siteNames;
+    for (const SamplingSite *site : samplingSites) {
+        sites.push_back({(uint64_t) site->id, (uint32_t) site->siteName.size(), (uint32_t) site->points.size()});
+        siteNames.insert(siteNames.end(), site->siteName.begin(), site->siteName.end());
+        for (const MapNode *node : site->points) {
+            points.push_back(position(node));
+        }
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Unable to write map cache file " + path);
+    }
+    MapCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAP_CACHE_MAGIC, sizeof(MAP_CACHE_MAGIC));
+    header.version = MAP_CACHE_VERSION;
+    header.numNodes = nodes.size();
+    header.numEdgesOut = edgesOut.size();
+    header.numEdgesIn = edgesIn.size();
+    header.numRecPoints = recPoints.size();
+    header.numMonitoringPoints = monitoringPoints.size();
+    header.numSamplingSites = sites.size();
+    header.numSitePoints = points.size() - recPoints.size() - monitoringPoints.size();
+    header.numSiteNameBytes = siteNames.size();
+    header.numFine = coarsening.fineIds.size();
+    const bool withReachability = !reachability.empty() && reachability.getNumNodes() == map.size();
+    if (withReachability) {
+        header.reachabilityNeighborhoodSize = reachability.getNeighborhoodSize();
+        header.numReachabilityEntries = reachability.getIds().size();
+    }
+    char headerBytes[MAP_CACHE_HEADER_SIZE] = {0};
+    std::memcpy(headerBytes, &header, sizeof(header));
+    out.write(headerBytes, MAP_CACHE_HEADER_SIZE);
+    writeSection(out, nodes);
+    writeSection(out, edgesOut);
+    writeSection(out, edgesIn);
+    writeSection(out, points);
+    writeSection(out, sites);
+    writeSection(out, siteNames);
+    writeSection(out, coarsening.fineIds);
+    writeSection(out, coarsening.coarseIds);
+    writeSection(out, coarsening.fineAreas);
+    if (withReachability) {
+        writeSection(out, reachability.getOffsets());
+        writeSection(out, reachability.getRadii());
+        writeSection(out, reachability.getIds());
+        writeSection(out, reachability.getLengths());
+    }
+    if (!out) {
+        throw std::runtime_error("Unable to write map cache file " + path);
+    }
+}
+
+// Parse a cache file into the output vectors; false if it's damaged
+static bool parseMapCache(const std::vector<char> &bytes, std::vector<MapNode *> &map, std::vector<MapNode *> &recPoints,
+                          std::vector<MapNode *> &monitoringPoints, std::vector<SamplingSite *> &samplingSites,
+                          MapCoarsening &coarsening, ReachabilityIndex *reachability) {
+    if (bytes.size() < MAP_CACHE_HEADER_SIZE) {
+        return false;
+    }
+    MapCacheHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAP_CACHE_MAGIC, sizeof(MAP_CACHE_MAGIC)) != 0
+        || header.version != MAP_CACHE_VERSION) {
+        return false;
+    }
+    size_t offset = MAP_CACHE_HEADER_SIZE;
+    std::vector<MapCacheNode> nodes;
+    std::vector<MapCacheEdge> edgesOut;
+    std::vector<MapCacheEdge> edgesIn;
+    std::vector<uint32_t> points;
+    std::vector<MapCacheSite> sites;
+    std::vector<char> siteNames;
+    if (!readSection(bytes, offset, header.numNodes, nodes)
+        || !readSection(bytes, offset, header.numEdgesOut, edgesOut)
+        || !readSection(bytes, offset, header.numEdgesIn, edgesIn)
+        || !readSection(bytes, offset, header.numRecPoints + header.numMonitoringPoints + header.numSitePoints, points)
+        || !readSection(bytes, offset, header.numSamplingSites, sites)
+        || !readSection(bytes, offset, header.numSiteNameBytes, siteNames)
+        || !readSection(bytes, offset, header.numFine, coarsening.fineIds)
+        || !readSection(bytes, offset, header.numFine, coarsening.coarseIds)
+        || !readSection(bytes, offset, header.numFine, coarsening.fineAreas)) {
+        return false;
+    }
+    for (const MapCacheNode &n : nodes) {
+        MapNode *node = new MapNode((HabitatType) n.type, n.area, n.elev, n.pathDist);
+        node->id = n.id;
+        node->x = n.x;
+        node->y = n.y;
+        node->nearestHydroNodeID = n.nearestHydroNodeID;
+        node->hydroNodeDistance = n.hydroNodeDistance;
+        map.push_back(node);
+    }
+    size_t nextOut = 0;
+    size_t nextIn = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nextOut + nodes[i].numEdgesOut > edgesOut.size() || nextIn + nodes[i].numEdgesIn > edgesIn.size()) {
+            return false;
+        }
+        for (uint32_t k = 0; k < nodes[i].numEdgesOut; ++k, ++nextOut) {
+            if (edgesOut[nextOut].other >= map.size()) {
+                return false;
+            }
+            map[i]->edgesOut.emplace_back(map[i], map[edgesOut[nextOut].other], edgesOut[nextOut].length);
+        }
+        for (uint32_t k = 0; k < nodes[i].numEdgesIn; ++k, ++nextIn) {
+            if (edgesIn[nextIn].other >= map.size()) {
+                return false;
+            }
+            map[i]->edgesIn.emplace_back(map[edgesIn[nextIn].other], map[i], edgesIn[nextIn].length);
+        }
+    }
+    for (uint32_t position : points) {
+        if (position >= map.size()) {
+            return false;
+        }
+    }
+    size_t nextPoint = 0;
+    for (; nextPoint < header.numRecPoints; ++nextPoint) {
+        recPoints.push_back(map[points[nextPoint]]);
+    }
+    for (; nextPoint < header.numRecPoints + header.numMonitoringPoints; ++nextPoint) {
+        monitoringPoints.push_back(map[points[nextPoint]]);
+    }
+    size_t nextName = 0;
+    for (const MapCacheSite &s : sites) {
+        if (nextName + s.nameLength > siteNames.size() || nextPoint + s.numPoints > points.size()) {
+            return false;
+        }
+        SamplingSite *site = new SamplingSite(std::string(siteNames.data() + nextName, s.nameLength), (size_t) s.id);
+        samplingSites.push_back(site);
+        nextName += s.nameLength;
+        for (uint32_t k = 0; k < s.numPoints; ++k) {
+            site->points.push_back(map[points[nextPoint++]]);
+        }
+    }
+    if (header.reachabilityNeighborhoodSize > 0) {
+        std::vector<uint64_t> offsets;
+        std::vector<float> radii;
+        std::vector<uint32_t> ids;
+        std::vector<float> lengths;
+        if (!readSection(bytes, offset, header.numNodes + 1, offsets)
+            || !readSection(bytes, offset, header.numNodes, radii)
+            || !readSection(bytes, offset, header.numReachabilityEntries, ids)
+            || !readSection(bytes, offset, header.numReachabilityEntries, lengths)
+            || offsets.front() != 0 || offsets.back() != ids.size()
+            || !std::is_sorted(offsets.begin(), offsets.end())) {
+            return false;
+        }
+        for (uint32_t id : ids) {
+            if (id >= map.size()) {
+                return false;
+            }
+        }
+        if (reachability != nullptr) {
+            *reachability = ReachabilityIndex((size_t) header.reachabilityNeighborhoodSize, std::move(offsets),
+                                              std::move(radii), std::move(ids), std::move(lengths));
+        }
+    } else if (reachability != nullptr) {
+        *reachability = ReachabilityIndex();
+    }
+    return true;
+}
+
+bool readMapCache(const std::string &path, std::vector<MapNode *> &map, std::vector<MapNode *> &recPoints,
+                  std::vector<MapNode *> &monitoringPoints, std::vector<SamplingSite *> &samplingSites,
+                  MapCoarsening &coarsening, ReachabilityIndex *reachability) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (parseMapCache(bytes, map, recPoints, monitoringPoints, samplingSites, coarsening, reachability)) {
+        return true;
+    }
+    for (MapNode *node : map) {
+        delete node;
+    }
+    for (SamplingSite *site : samplingSites) {
+        delete site;
+    }
+    map.clear();
+    recPoints.clear();
+    monitoringPoints.clear();
+    samplingSites.clear();
+    coarsening = MapCoarsening();
+    return false;
+}
@@ -0,0 +1,33 @@
+#ifndef __FISH_MAP_CACHE_H
+#define __FISH_MAP_CACHE_H
+
+#include <string>
+#include <vector>
+#include "map.h"
+#include "map_coarsen.h"
+#include "reachability_index.h"
+
+/*
+* Binary cache of a fully prepared map (after loadMap's cleanup, hydro node assignment and any
+* coarsening), so repeated runs on the same inputs skip parsing and simplifying the CSVs. The reachability
+* index built for high-awareness movement (see reachability_index.h) is cached along with it.
+*/
+
+// Cache key (16 hex digits) for the given input files (identified by path, size and modification time),
+// recruit points and any other settings that change the prepared map
+std::string mapCacheKey(const std::vector<std::string> &inputPaths, const std::vector<unsigned> &recPointIds,
+                        const std::string &settings);
+
+// Write a prepared map (and its reachability index, if not empty) to path; throws if the file can't be written
+void writeMapCache(const std::string &path, const std::vector<MapNode *> &map, const std::vector<MapNode *> &recPoints,
+                   const std::vector<MapNode *> &monitoringPoints, const std::vector<SamplingSite *> &samplingSites,
+                   const MapCoarsening &coarsening, const ReachabilityIndex &reachability = ReachabilityIndex());
+
+// Replace the contents of the output vectors with a cached map; returns false (leaving them empty) if
+// path is missing, from another version or damaged. If reachability is given, it's set to the cached index
+// (empty if none was cached).
+bool readMapCache(const std::string &path, std::vector<MapNode *> &map, std::vector<MapNode *> &recPoints,
+                  std::vector<MapNode *> &monitoringPoints, std::vector<SamplingSite *> &samplingSites,
+                  MapCoarsening &coarsening, ReachabilityIndex *reachability = nullptr);
+
+#endif
@@ -0,0 +1,165 @@
+#include "map_coarsen.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+#include <unordered_map>
+
+bool MapCoarsening::empty() const {
+    return this->fineIds.empty();
+}
+
+typedef struct CoarsenCandidate {
+    float length;
+    size_t a; // map position of the first member (the one that survives)
+    size_t b; // map position of the second member
+} CoarsenCandidate;
+
+static bool canMerge(const MapNode *a, const MapNode *b, const std::unordered_set<MapNode *> &protectedNodes,
+                     const CoarsenCriteria &criteria) {
+    return a != b
+           && a->type == b->type
+           && !protectedNodes.count(const_cast<MapNode *>(a))
+           && !protectedNodes.count(const_cast<MapNode *>(b))
+           && std::fabs(a->elev - b->elev) <= criteria.maxElevationDifference
+           && std::fabs(a->pathDist - b->pathDist) <= criteria.maxPathDistDifference;
+}
+
+// Merge matched pairs (absorbed -> survivor) and rebuild every edge list
+static void contract(std::vector<MapNode *> &map, std::unordered_map<MapNode *, MapNode *> &absorbed) {
+    // How far each surviving location moves, so edges can be lengthened to match
+    std::unordered_map<MapNode *, float> displacement;
+    std::unordered_map<MapNode *, std::pair<float, float>> oldPositions;
+    for (const auto &[b, a] : absorbed) {
+        oldPositions[a] = {a->x, a->y};
+        oldPositions[b] = {b->x, b->y};
+    }
+    for (const auto &[b, a] : absorbed) {
+        float area = a->area + b->area;
+        float wa = area > 0.0f ? a->area / area : 0.5f;
+        float wb = 1.0f - wa;
+        a->x = a->x * wa + b->x * wb;
+        a->y = a->y * wa + b->y * wb;
+        a->elev = a->elev * wa + b->elev * wb;
+        a->pathDist = a->pathDist * wa + b->pathDist * wb;
+        a->area = area;
+    }
+    for (const auto &[node, position] : oldPositions) {
+        MapNode *survivor = absorbed.count(node) ? absorbed.at(node) : node;
+        displacement[node] = std::hypot(survivor->x - position.first, survivor->y - position.second);
+    }
+    auto survivorOf = [&absorbed](MapNode *node) {
+        auto it = absorbed.find(node);
+        return it == absorbed.end() ? node : it->second;
+    };
+    auto moved = [&displacement](MapNode *node) {
+        auto it = displacement.find(node);
+        return it == displacement.end() ? 0.0f : it->second;
+    };
+
+    // Every edge once (from its source's edgesOut, in map order), re-pointed at the survivors. Parallel
+    // and reversed edges between the same two locations collapse onto the first one seen, keeping the
+    // shortest length.
+    std::vector<Edge> edges;
+    std::unordered_map<MapNode *, std::unordered_map<MapNode *, size_t>> edgeIndex;
+    for (MapNode *node : map) {
+        for (const Edge &e : node->edgesOut) {
+            MapNode *source = survivorOf(e.source);
+            MapNode *target = survivorOf(e.target);
+            if (source == target) {
+                continue;
+            }
+            float length = e.length + moved(e.source) + moved(e.target);
+            auto existing = edgeIndex[source].find(target);
+            if (existing == edgeIndex[source].end()) {
+                existing = edgeIndex[target].find(source);
+                if (existing == edgeIndex[target].end()) {
+                    edgeIndex[source][target] = edges.size();
+                    edges.emplace_back(source, target, length);
+                    continue;
+                }
+            }
+            edges[existing->second].length = std::min(edges[existing->second].length, length);
+        }
+    }
+    for (MapNode *node : map) {
+        node->edgesOut.clear();
+        node->edgesIn.clear();
+        node->crossChannelA = nullptr;
+        node->crossChannelB = nullptr;
+    }
+    for (const Edge &e : edges) {
+        e.source->edgesOut.push_back(e);
+        e.target->edgesIn.push_back(e);
+    }
+
+    map.erase(std::remove_if(map.begin(), map.end(), [&absorbed](MapNode *node) {
+        if (absorbed.count(node)) {
+            delete node;
+            return true;
+        }
+        return false;
+    }), map.end());
+}
+
+MapCoarsening coarsenMap(std::vector<MapNode *> &map, const std::unordered_set<MapNode *> &protectedNodes,
+                         const CoarsenCriteria &criteria) {
+    MapCoarsening coarsening;
+    // The location each fine location is currently part of
+    std::vector<MapNode *> groups(map.begin(), map.end());
+    for (MapNode *node : map) {
+        coarsening.fineIds.push_back(node->id);
+        coarsening.fineAreas.push_back(node->area);
+    }
+    unsigned passes = 0;
+    while (map.size() > criteria.targetNodes) {
+        std::unordered_map<MapNode *, size_t> positions;
+        for (size_t i = 0; i < map.size(); ++i) {
+            positions[map[i]] = i;
+        }
+        std::vector<CoarsenCandidate> candidates;
+        for (size_t i = 0; i < map.size(); ++i) {
+            for (const Edge &e : map[i]->edgesOut) {
+                auto target = positions.find(e.target);
+                if (target != positions.end() && canMerge(e.source, e.target, protectedNodes, criteria)) {
+                    size_t j = target->second;
+                    candidates.push_back({e.length, std::min(i, j), std::max(i, j)});
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const CoarsenCandidate &x, const CoarsenCandidate &y) {
+            return std::tie(x.length, x.a, x.b) < std::tie(y.length, y.a, y.b);
+        });
+        // Greedy matching: each location takes part in at most one merge per pass
+        std::vector<bool> matched(map.size(), false);
+        std::unordered_map<MapNode *, MapNode *> absorbed;
+        const size_t wanted = map.size() - criteria.targetNodes;
+        for (const CoarsenCandidate &c : candidates) {
+            if (absorbed.size() == wanted) {
+                break;
+            }
+            if (!matched[c.a] && !matched[c.b]) {
+                matched[c.a] = matched[c.b] = true;
+                absorbed[map[c.b]] = map[c.a];
+            }
+        }
+        if (absorbed.empty()) {
+            break;
+        }
+        for (MapNode *&group : groups) {
+            auto it = absorbed.find(group);
+            if (it != absorbed.end()) {
+                group = it->second;
+            }
+        }
+        contract(map, absorbed);
+        ++passes;
+    }
+    for (MapNode *group : groups) {
+        coarsening.coarseIds.push_back(group->id);
+    }
+    std::cout << "Coarsened " << coarsening.fineIds.size() << " locations to " << map.size()
+              << " in " << passes << " passes" << std::endl;
+    return coarsening;
+}
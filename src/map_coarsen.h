@@ -0,0 +1,78 @@
+#ifndef __FISH_MAP_COARSEN_H
+#define __FISH_MAP_COARSEN_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "map.h"
+
+// Which neighboring locations coarsenMap may merge
+typedef struct CoarsenCriteria {
+    // Stop once the map has this many locations (or nothing else can be merged)
+    size_t targetNodes;
+    // Largest elevation difference (m) between two merged locations
+    float maxElevationDifference;
+    // Largest pathDist difference (m) between two merged locations
+    float maxPathDistDifference;
+} CoarsenCriteria;
+
+/*
+* Fine-to-coarse correspondence left by coarsenMap: fine location i (in the order of the map before
+* coarsening) had ID fineIds[i] and area fineAreas[i], and is now part of the location with ID coarseIds[i].
+* Used to project per-location outputs of a coarse run back onto the full map.
+*/
+typedef struct MapCoarsening {
+    std::vector<int> fineIds;
+    std::vector<int> coarseIds;
+    std::vector<float> fineAreas;
+
+    bool empty() const;
+    // Share a per-coarse-location amount (e.g. fish) out over its fine locations by area; coarseValue
+    // returns the amount for a coarse location ID. Result is indexed like fineIds.
+    template <typename F>
+    std::vector<double> projectAmount(F coarseValue) const;
+    // Give each fine location its coarse location's value (for densities, temperatures, etc.)
+    template <typename F>
+    std::vector<double> projectValue(F coarseValue) const;
+} MapCoarsening;
+
+/*
+* Repeatedly contract edges of map until it has at most criteria.targetNodes locations: each pass
+* matches unmerged neighbors of the same habitat type whose elevation and pathDist are within the
+* criteria, shortest edges first, and merges every matched pair. Protected locations (recruit points,
+* monitoring points and sampling sites) are never merged, so pointers to them stay valid.
+*
+* A merged location keeps the ID of whichever of its members comes first in the map, sums their areas,
+* takes their area-weighted position, elevation and pathDist, and inherits every edge leaving the
+* group, lengthened by how far each endpoint moved (parallel edges keep the shortest).
+*/
+MapCoarsening coarsenMap(std::vector<MapNode *> &map, const std::unordered_set<MapNode *> &protectedNodes,
+                         const CoarsenCriteria &criteria);
+
+template <typename F>
+std::vector<double> MapCoarsening::projectAmount(F coarseValue) const {
+    std::unordered_map<int, double> coarseAreas;
+    for (size_t i = 0; i < this->fineIds.size(); ++i) {
+        coarseAreas[this->coarseIds[i]] += this->fineAreas[i];
+    }
+    std::vector<double> out(this->fineIds.size(), 0.0);
+    for (size_t i = 0; i < this->fineIds.size(); ++i) {
+        double area = coarseAreas[this->coarseIds[i]];
+        if (area > 0.0) {
+            out[i] = (double) coarseValue(this->coarseIds[i]) * this->fineAreas[i] / area;
+        }
+    }
+    return out;
+}
+
+template <typename F>
+std::vector<double> MapCoarsening::projectValue(F coarseValue) const {
+    std::vector<double> out(this->fineIds.size());
+    for (size_t i = 0; i < this->fineIds.size(); ++i) {
+        out[i] = (double) coarseValue(this->coarseIds[i]);
+    }
+    return out;
+}
+
+#endif
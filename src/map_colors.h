@@ -0,0 +1,51 @@
+#ifndef __FISH_MAP_COLORS_H
+#define __FISH_MAP_COLORS_H
+
+#include "map.h"
+
+// Colour scheme shared by the GUI map view and the offscreen frame renderer
+
+typedef struct RgbColor {
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+} RgbColor;
+
+constexpr RgbColor IMPOUNDMENT_RGB{64U, 255U, 128U};
+constexpr RgbColor DISTRIBUTARY_RGB{0U, 0U, 255U};
+constexpr RgbColor DISTRIBUTARY_EDGE_RGB{0U, 128U, 255U};
+constexpr RgbColor BLIND_CHANNEL_RGB{0U, 128U, 0U};
+constexpr RgbColor LOW_TIDE_TERRACE_RGB{64U, 128U, 128U};
+constexpr RgbColor NEARSHORE_RGB{128U, 0U, 128U};
+constexpr RgbColor BOAT_HARBOR_RGB{128U, 128U, 0U};
+
+// Sampling site highlight and dangling (off-map) edge marker colours
+constexpr RgbColor SAMPLING_SITE_RGB{255U, 192U, 0U};
+constexpr RgbColor DANGLING_EDGE_RGB{255U, 0U, 0U};
+
+inline RgbColor getHabitatRgb(HabitatType t) {
+    switch(t) {
+    case HabitatType::Impoundment:
+        return IMPOUNDMENT_RGB;
+    case HabitatType::Distributary:
+        return DISTRIBUTARY_RGB;
+    case HabitatType::DistributaryEdge:
+        return DISTRIBUTARY_EDGE_RGB;
+    case HabitatType::BlindChannel:
+        return BLIND_CHANNEL_RGB;
+    case HabitatType::LowTideTerrace:
+        return LOW_TIDE_TERRACE_RGB;
+    case HabitatType::Nearshore:
+        return NEARSHORE_RGB;
+    case HabitatType::Harbor:
+        return BOAT_HARBOR_RGB;
+    }
+    return DISTRIBUTARY_RGB;
+}
+
+// Occupancy density layer colour for an intensity in [0, 1] (yellow through orange to red)
+inline RgbColor getDensityRgb(float intensity) {
+    return RgbColor{255U, (unsigned char) (255.0f * (1.0f - intensity)), 0U};
+}
+
+#endif
@@ -228,7 +228,8 @@ void generateMap(
     int n,
     float a,
     float p_dist,
-    float p_blind
+    float p_blind,
+    std::pmr::memory_resource *edgeMemory
 ) {
     std::unordered_map<map_coord_t, MapNode *, coord_hash, coord_equal> nodes;
     std::vector<MapNode *> nodeList;
@@ -258,7 +259,7 @@ void generateMap(
                 }
             }
             // Make the new node
-            MapNode *node = new MapNode(habType, area, 0.0f, 0.0f);
+            MapNode *node = new MapNode(habType, area, 0.0f, 0.0f, edgeMemory);
             node->x = ((float) j) * a;
             node->y = ((float) (n - i)) * a;
             nodes[map_coord_t(i, j)] = node;
@@ -11,7 +11,9 @@ void generateMap(
     int n,
     float a,
     float p_dist,
-    float p_blind
+    float p_blind,
+    // Memory for the locations' edge lists (a MapArena's build memory, say; see map_arena.h)
+    std::pmr::memory_resource *edgeMemory = std::pmr::get_default_resource()
 );
 
 #endif
\ No newline at end of file
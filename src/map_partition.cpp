@@ -0,0 +1,328 @@
+#include "map_partition.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+// Graph size at which coarsening stops, per region
+static constexpr size_t COARSEST_VERTICES_PER_REGION = 16;
+// Coarsening stops early once a level shrinks the graph by less than this fraction
+static constexpr double MIN_COARSENING = 0.05;
+// Most boundary refinement passes per level
+static constexpr int REFINEMENT_PASSES = 8;
+
+static constexpr uint32_t UNASSIGNED = std::numeric_limits<uint32_t>::max();
+
+// An undirected graph in compressed rows: vertex v's neighbors are adjacency[offsets[v], offsets[v + 1]),
+// joined by edges standing for edgeWeights[...] map edges
+typedef struct PartitionGraph {
+    std::vector<double> weights;
+    std::vector<size_t> offsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<double> edgeWeights;
+    size_t size() const { return this->weights.size(); }
+} PartitionGraph;
+
+typedef std::tuple<uint32_t, uint32_t, double> GraphEdge;
+
+// Rows from a list of directed edges (each undirected edge listed both ways), merging parallel edges
+static PartitionGraph buildGraph(std::vector<double> weights, std::vector<GraphEdge> &edges) {
+    std::sort(edges.begin(), edges.end());
+    PartitionGraph graph;
+    graph.weights = std::move(weights);
+    graph.offsets.assign(graph.size() + 1, 0);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const auto [from, to, weight] = edges[i];
+        if (i > 0 && std::get<0>(edges[i - 1]) == from && std::get<1>(edges[i - 1]) == to) {
+            graph.edgeWeights.back() += weight;
+            continue;
+        }
+        graph.adjacency.push_back(to);
+        graph.edgeWeights.push_back(weight);
+        ++graph.offsets[from + 1];
+    }
+    for (size_t v = 0; v < graph.size(); ++v) {
+        graph.offsets[v + 1] += graph.offsets[v];
+    }
+    return graph;
+}
+
+// Heavy-edge matching: each vertex (fewest neighbors first) is paired with the unmatched neighbor it shares
+// the heaviest edge with, unless their combined weight would pass maxVertexWeight. Fills coarseOf.
+static PartitionGraph coarsen(const PartitionGraph &graph, double maxVertexWeight, std::vector<uint32_t> &coarseOf) {
+    std::vector<uint32_t> order(graph.size());
+    for (uint32_t v = 0; v < order.size(); ++v) {
+        order[v] = v;
+    }
+    std::stable_sort(order.begin(), order.end(), [&graph](uint32_t a, uint32_t b) {
+        return graph.offsets[a + 1] - graph.offsets[a] < graph.offsets[b + 1] - graph.offsets[b];
+    });
+    coarseOf.assign(graph.size(), UNASSIGNED);
+    std::vector<double> coarseWeights;
+    for (uint32_t v : order) {
+        if (coarseOf[v] != UNASSIGNED) {
+            continue;
+        }
+        uint32_t best = UNASSIGNED;
+        double bestWeight = 0.0;
+        for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+            const uint32_t u = graph.adjacency[e];
+            if (coarseOf[u] != UNASSIGNED || graph.weights[u] + graph.weights[v] > maxVertexWeight) {
+                continue;
+            }
+            if (best == UNASSIGNED || graph.edgeWeights[e] > bestWeight
+                || (graph.edgeWeights[e] == bestWeight && graph.weights[u] < graph.weights[best])) {
+                best = u;
+                bestWeight = graph.edgeWeights[e];
+            }
+        }
+        coarseOf[v] = (uint32_t) coarseWeights.size();
+        coarseWeights.push_back(graph.weights[v]);
+        if (best != UNASSIGNED) {
+            coarseOf[best] = coarseOf[v];
+            coarseWeights.back() += graph.weights[best];
+        }
+    }
+    std::vector<GraphEdge> edges;
+    edges.reserve(graph.adjacency.size());
+    for (uint32_t v = 0; v < graph.size(); ++v) {
+        for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+            const uint32_t u = graph.adjacency[e];
+            if (coarseOf[u] != coarseOf[v]) {
+                edges.emplace_back(coarseOf[v], coarseOf[u], graph.edgeWeights[e]);
+            }
+        }
+    }
+    return buildGraph(std::move(coarseWeights), edges);
+}
+
+// Greedy region growing: each region in turn starts from an unassigned vertex next to the regions already
+// grown (or the first unassigned one) and takes the frontier vertex most connected to it until it reaches
+// its share of the remaining weight; the last region takes whatever is left
+static std::vector<uint32_t> growRegions(const PartitionGraph &graph, size_t numRegions) {
+    typedef std::pair<double, uint32_t> FrontierEntry;
+    std::vector<uint32_t> parts(graph.size(), UNASSIGNED);
+    std::vector<double> connection(graph.size(), 0.0);
+    double remainingWeight = 0.0;
+    for (double w : graph.weights) {
+        remainingWeight += w;
+    }
+    size_t firstUnassigned = 0;
+    auto nextSeed = [&]() {
+        for (uint32_t v = 0; v < graph.size(); ++v) {
+            if (parts[v] != UNASSIGNED) {
+                continue;
+            }
+            for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+                if (parts[graph.adjacency[e]] != UNASSIGNED) {
+                    return v;
+                }
+            }
+        }
+        while (firstUnassigned < graph.size() && parts[firstUnassigned] != UNASSIGNED) {
+            ++firstUnassigned;
+        }
+        return firstUnassigned < graph.size() ? (uint32_t) firstUnassigned : UNASSIGNED;
+    };
+
+    for (uint32_t p = 0; p + 1 < numRegions; ++p) {
+        const double target = remainingWeight / (double) (numRegions - p);
+        double weight = 0.0;
+        // Most connected first, then lowest index
+        std::priority_queue<FrontierEntry, std::vector<FrontierEntry>, std::function<bool(const FrontierEntry &,
+            const FrontierEntry &)>> frontier([](const FrontierEntry &a, const FrontierEntry &b) {
+                return a.first < b.first || (a.first == b.first && a.second > b.second);
+            });
+        std::vector<uint32_t> touched;
+        auto add = [&](uint32_t v) {
+            parts[v] = p;
+            weight += graph.weights[v];
+            for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+                const uint32_t u = graph.adjacency[e];
+                if (parts[u] == UNASSIGNED) {
+                    connection[u] += graph.edgeWeights[e];
+                    touched.push_back(u);
+                    frontier.emplace(connection[u], u);
+                }
+            }
+        };
+        while (weight < target) {
+            uint32_t v = UNASSIGNED;
+            while (!frontier.empty()) {
+                const FrontierEntry top = frontier.top();
+                frontier.pop();
+                if (parts[top.second] == UNASSIGNED && top.first == connection[top.second]) {
+                    v = top.second;
+                    break;
+                }
+            }
+            if (v == UNASSIGNED) {
+                v = nextSeed();
+                if (v == UNASSIGNED) {
+                    break;
+                }
+            }
+            // Stop short if taking v would overshoot the target by more than stopping undershoots it
+            if (weight > 0.0 && weight + graph.weights[v] - target > target - weight) {
+                break;
+            }
+            add(v);
+        }
+        for (uint32_t u : touched) {
+            connection[u] = 0.0;
+        }
+        remainingWeight -= weight;
+    }
+    for (uint32_t &part : parts) {
+        if (part == UNASSIGNED) {
+            part = (uint32_t) numRegions - 1;
+        }
+    }
+    return parts;
+}
+
+// Greedy boundary refinement: move each vertex to the neighboring region it has more edges to, if that
+// region stays within maxWeight; an overweight region gives vertices to lighter neighbors even at a loss
+static void refine(const PartitionGraph &graph, size_t numRegions, double maxWeight, std::vector<uint32_t> &parts) {
+    std::vector<double> partWeights(numRegions, 0.0);
+    for (uint32_t v = 0; v < graph.size(); ++v) {
+        partWeights[parts[v]] += graph.weights[v];
+    }
+    std::vector<double> connection(numRegions, 0.0);
+    std::vector<uint32_t> neighborParts;
+    for (int pass = 0; pass < REFINEMENT_PASSES; ++pass) {
+        size_t moved = 0;
+        for (uint32_t v = 0; v < graph.size(); ++v) {
+            const uint32_t from = parts[v];
+            const double w = graph.weights[v];
+            neighborParts.clear();
+            for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+                const uint32_t part = parts[graph.adjacency[e]];
+                if (connection[part] == 0.0) {
+                    neighborParts.push_back(part);
+                }
+                connection[part] += graph.edgeWeights[e];
+            }
+            const bool overweight = partWeights[from] > maxWeight;
+            uint32_t best = from;
+            double bestGain = overweight ? -std::numeric_limits<double>::infinity() : 0.0;
+            for (uint32_t to : neighborParts) {
+                if (to == from || partWeights[from] - w <= 0.0) {
+                    continue;
+                }
+                const double gain = connection[to] - connection[from];
+                const bool fits = partWeights[to] + w <= maxWeight;
+                const bool balances = partWeights[to] + w < partWeights[from];
+                const bool allowed = overweight ? balances : fits && (gain > 0.0 || (gain == 0.0 && balances));
+                if (allowed && (gain > bestGain || (gain == bestGain && best == from)
+                                || (gain == bestGain && partWeights[to] < partWeights[best]))) {
+                    best = to;
+                    bestGain = gain;
+                }
+            }
+            for (uint32_t part : neighborParts) {
+                connection[part] = 0.0;
+            }
+            if (best != from) {
+                parts[v] = best;
+                partWeights[from] -= w;
+                partWeights[best] += w;
+                ++moved;
+            }
+        }
+        if (moved == 0) {
+            break;
+        }
+    }
+}
+
+MapPartition partitionMap(const std::vector<MapNode *> &map, const std::vector<double> &weights, size_t numRegions) {
+    MapPartition partition;
+    partition.numRegions = std::max((size_t) 1, numRegions);
+    partition.regions.assign(map.size(), 0);
+    partition.regionWeights.assign(partition.numRegions, 0.0);
+    if (map.size() <= partition.numRegions) {
+        for (size_t i = 0; i < map.size(); ++i) {
+            partition.regions[i] = (uint32_t) i;
+            partition.regionWeights[i] = weights[i];
+        }
+        return partition;
+    }
+
+    std::unordered_map<const MapNode *, uint32_t> positions;
+    for (size_t i = 0; i < map.size(); ++i) {
+        positions[map[i]] = (uint32_t) i;
+    }
+    std::vector<GraphEdge> edges;
+    double totalWeight = 0.0;
+    for (size_t i = 0; i < map.size(); ++i) {
+        totalWeight += weights[i];
+        for (const Edge &edge : map[i]->edgesOut) {
+            auto it = positions.find(edge.target);
+            if (it != positions.end() && it->second != i) {
+                edges.emplace_back((uint32_t) i, it->second, 1.0);
+                edges.emplace_back(it->second, (uint32_t) i, 1.0);
+            }
+        }
+    }
+
+    // Coarsen, keeping each level's graph and fine-to-coarse mapping
+    std::vector<PartitionGraph> levels;
+    std::vector<std::vector<uint32_t>> coarseOf;
+    levels.push_back(buildGraph(weights, edges));
+    const size_t coarsestSize = COARSEST_VERTICES_PER_REGION * partition.numRegions;
+    const double maxVertexWeight = totalWeight / (double) (4 * partition.numRegions);
+    while (levels.back().size() > coarsestSize) {
+        std::vector<uint32_t> mapping;
+        PartitionGraph coarse = coarsen(levels.back(), maxVertexWeight, mapping);
+        if ((double) coarse.size() > (1.0 - MIN_COARSENING) * (double) levels.back().size()) {
+            break;
+        }
+        levels.push_back(std::move(coarse));
+        coarseOf.push_back(std::move(mapping));
+    }
+
+    // Split the coarsest graph, then project back up, refining at each level
+    const double maxWeight = (1.0 + PARTITION_IMBALANCE) * totalWeight / (double) partition.numRegions;
+    std::vector<uint32_t> parts = growRegions(levels.back(), partition.numRegions);
+    refine(levels.back(), partition.numRegions, maxWeight, parts);
+    for (size_t level = levels.size() - 1; level > 0; --level) {
+        const std::vector<uint32_t> &mapping = coarseOf[level - 1];
+        std::vector<uint32_t> finer(mapping.size());
+        for (size_t v = 0; v < mapping.size(); ++v) {
+            finer[v] = parts[mapping[v]];
+        }
+        parts = std::move(finer);
+        refine(levels[level - 1], partition.numRegions, maxWeight, parts);
+    }
+
+    partition.regions = std::move(parts);
+    for (size_t i = 0; i < map.size(); ++i) {
+        partition.regionWeights[partition.regions[i]] += weights[i];
+        for (const Edge &edge : map[i]->edgesOut) {
+            auto it = positions.find(edge.target);
+            if (it != positions.end() && partition.regions[it->second] != partition.regions[i]) {
+                ++partition.edgeCut;
+            }
+        }
+    }
+    return partition;
+}
+
+std::vector<double> occupancyWeights(const std::vector<MapNode *> &map) {
+    double totalArea = 0.0;
+    for (MapNode *node : map) {
+        totalArea += std::max(0.0f, node->area);
+    }
+    const double meanArea = map.empty() ? 0.0 : totalArea / (double) map.size();
+    std::vector<double> weights;
+    weights.reserve(map.size());
+    for (MapNode *node : map) {
+        weights.push_back(1.0 + (meanArea > 0.0 ? std::max(0.0f, node->area) / meanArea : 0.0));
+    }
+    return weights;
+}
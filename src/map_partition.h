@@ -0,0 +1,37 @@
+#ifndef __FISH_MAP_PARTITION_H
+#define __FISH_MAP_PARTITION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "map.h"
+
+/*
+* A split of the map into regions of about equal weight with few edges between them (see DomainDecomposition).
+* regions[i] is the region of map[i]; edgeCut counts the map's edges joining two regions.
+*/
+typedef struct MapPartition {
+    size_t numRegions;
+    std::vector<uint32_t> regions;
+    std::vector<double> regionWeights;
+    size_t edgeCut;
+    MapPartition() : numRegions(0), edgeCut(0) {}
+} MapPartition;
+
+/*
+* Multilevel k-way partitioning: the map's graph (edges in either direction, unweighted) is repeatedly
+* coarsened by heavy-edge matching, the coarsest graph is split by greedy region growing, and the split is
+* projected back level by level, moving boundary locations to cut fewer edges while keeping every region's
+* weight within PARTITION_IMBALANCE of the mean (where the locations' weights allow it). weights[i] is the
+* weight of map[i]. Deterministic, so every run of a map gets the same regions.
+*/
+MapPartition partitionMap(const std::vector<MapNode *> &map, const std::vector<double> &weights, size_t numRegions);
+
+// Each location's expected share of the fish: they spread out by density, so it grows with the location's area,
+// plus a constant for the per-location work (1 + area / mean area)
+std::vector<double> occupancyWeights(const std::vector<MapNode *> &map);
+
+// Allowed excess of a region's weight over the mean, as a fraction of the mean
+constexpr double PARTITION_IMBALANCE = 0.05;
+
+#endif
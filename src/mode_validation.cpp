@@ -0,0 +1,136 @@
+#include "mode_validation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+double ksDistance(std::vector<std::pair<float, float>> a, std::vector<std::pair<float, float>> b) {
+    if (a.empty() || b.empty()) {
+        return a.empty() && b.empty() ? 0.0 : 1.0;
+    }
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    double totalA = 0.0, totalB = 0.0;
+    for (auto &p : a) totalA += p.second;
+    for (auto &p : b) totalB += p.second;
+    double cdfA = 0.0, cdfB = 0.0, distance = 0.0;
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        float x = std::min(i < a.size() ? a[i].first : b[j].first, j < b.size() ? b[j].first : a[i].first);
+        while (i < a.size() && a[i].first == x) cdfA += a[i++].second / totalA;
+        while (j < b.size() && b[j].first == x) cdfB += b[j++].second / totalB;
+        distance = std::max(distance, std::fabs(cdfA - cdfB));
+    }
+    return distance;
+}
+
+void meanSd(const std::vector<double> &values, double &mean, double &sd) {
+    mean = 0.0;
+    for (double v : values) mean += v;
+    mean /= (double) values.size();
+    double ss = 0.0;
+    for (double v : values) ss += (v - mean) * (v - mean);
+    sd = values.size() > 1 ? std::sqrt(ss / (double) (values.size() - 1)) : 0.0;
+}
+
+template <typename Get>
+static std::vector<double> column(const std::vector<ValidationRun> &runs, Get get) {
+    std::vector<double> values;
+    for (const ValidationRun &r : runs) values.push_back(get(r));
+    return values;
+}
+
+// Print one metric's summary for both modes; returns |z|
+static double compare(const std::string &name, const std::vector<double> &exact, const std::vector<double> &approximate) {
+    double m1, s1, m2, s2;
+    meanSd(exact, m1, s1);
+    meanSd(approximate, m2, s2);
+    double se = std::sqrt(s1 * s1 / (double) exact.size() + s2 * s2 / (double) approximate.size());
+    double z = se > 0.0 ? (m2 - m1) / se : (m1 == m2 ? 0.0 : INFINITY);
+    std::cout << std::left << std::setw(34) << name << std::right << std::setprecision(4)
+              << std::setw(12) << m1 << " +- " << std::setw(10) << s1
+              << std::setw(12) << m2 << " +- " << std::setw(10) << s2
+              << std::setw(9) << std::setprecision(2) << z << std::endl;
+    return std::fabs(z);
+}
+
+// Every living fish's (value, weight) across the runs
+static std::vector<std::pair<float, float>> pooled(const std::vector<ValidationRun> &runs,
+                                                   std::vector<std::pair<float, float>> ValidationRun::*sizes) {
+    std::vector<std::pair<float, float>> all;
+    for (const ValidationRun &r : runs) {
+        all.insert(all.end(), (r.*sizes).begin(), (r.*sizes).end());
+    }
+    return all;
+}
+
+double compareModes(const std::string &exactName, const std::vector<ValidationRun> &exact,
+                    const std::string &approximateName, const std::vector<ValidationRun> &approximate,
+                    const std::string &sampleTimeLabel, const std::string &trajectoryName) {
+    std::cout << std::endl << std::left << std::setw(34) << "metric" << std::right
+              << std::setw(26) << exactName + " (mean +- sd)" << std::setw(26) << approximateName + " (mean +- sd)"
+              << std::setw(9) << "z" << std::endl;
+    double maxZ = 0.0;
+    compare("agents", column(exact, [](const ValidationRun &r) { return (double) r.agents; }),
+            column(approximate, [](const ValidationRun &r) { return (double) r.agents; }));
+    compare("seconds", column(exact, [](const ValidationRun &r) { return r.seconds; }),
+            column(approximate, [](const ValidationRun &r) { return r.seconds; }));
+    maxZ = std::max(maxZ, compare("living", column(exact, [](const ValidationRun &r) { return r.living; }),
+                                  column(approximate, [](const ValidationRun &r) { return r.living; })));
+    maxZ = std::max(maxZ, compare("dead", column(exact, [](const ValidationRun &r) { return r.dead; }),
+                                  column(approximate, [](const ValidationRun &r) { return r.dead; })));
+    maxZ = std::max(maxZ, compare("exited", column(exact, [](const ValidationRun &r) { return r.exited; }),
+                                  column(approximate, [](const ValidationRun &r) { return r.exited; })));
+
+    // Sampling results present in every run
+    const char *statNames[] = {"population", "mean length", "mean mass"};
+    for (const auto &[key, sample] : exact[0].samples) {
+        bool everywhere = true;
+        for (const ValidationRun &r : exact) everywhere = everywhere && r.samples.count(key);
+        for (const ValidationRun &r : approximate) everywhere = everywhere && r.samples.count(key);
+        if (!everywhere) {
+            continue;
+        }
+        for (size_t stat = 0; stat < 3; ++stat) {
+            std::string name = "site " + std::to_string(key.first) + " " + sampleTimeLabel
+                + std::to_string(key.second) + " " + statNames[stat];
+            auto get = [&key, stat](const ValidationRun &r) { return r.samples.at(key)[stat]; };
+            maxZ = std::max(maxZ, compare(name, column(exact, get), column(approximate, get)));
+        }
+    }
+
+    // Trajectory: largest |z| and largest relative difference of the means
+    double trajectoryZ = 0.0, trajectoryRelative = 0.0;
+    for (size_t t = 0; t < exact[0].trajectory.size(); ++t) {
+        double m1, s1, m2, s2;
+        auto get = [t](const ValidationRun &r) { return r.trajectory[t]; };
+        meanSd(column(exact, get), m1, s1);
+        meanSd(column(approximate, get), m2, s2);
+        double se = std::sqrt(s1 * s1 / (double) exact.size() + s2 * s2 / (double) approximate.size());
+        if (se > 0.0) {
+            trajectoryZ = std::max(trajectoryZ, std::fabs(m2 - m1) / se);
+        }
+        if (m1 > 0.0) {
+            trajectoryRelative = std::max(trajectoryRelative, std::fabs(m2 - m1) / m1);
+        }
+    }
+    std::cout << std::left << std::setw(34) << trajectoryName + " (max |z|)" << std::right
+              << std::setw(61) << std::setprecision(2) << trajectoryZ << std::endl;
+    std::cout << std::left << std::setw(34) << trajectoryName + " (max rel. diff)" << std::right
+              << std::setw(61) << std::setprecision(3) << trajectoryRelative << std::endl;
+
+    std::cout << std::endl << "KS distance, final fork length distribution: " << std::setprecision(4)
+              << ksDistance(pooled(exact, &ValidationRun::forkLengths), pooled(approximate, &ValidationRun::forkLengths))
+              << std::endl;
+    std::cout << "KS distance, final mass distribution: "
+              << ksDistance(pooled(exact, &ValidationRun::masses), pooled(approximate, &ValidationRun::masses))
+              << std::endl;
+    double exactSeconds, approximateSeconds, unused;
+    meanSd(column(exact, [](const ValidationRun &r) { return r.seconds; }), exactSeconds, unused);
+    meanSd(column(approximate, [](const ValidationRun &r) { return r.seconds; }), approximateSeconds, unused);
+    std::cout << "Speedup: " << std::setprecision(3)
+              << (approximateSeconds > 0.0 ? exactSeconds / approximateSeconds : 0.0) << "x" << std::endl;
+    std::cout << "Largest |z| over abundances and samples: " << std::setprecision(2) << maxZ << std::endl;
+    return maxZ;
+}
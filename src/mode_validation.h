@@ -0,0 +1,46 @@
+#ifndef __FISH_MODE_VALIDATION_H
+#define __FISH_MODE_VALIDATION_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+* Shared statistics and report for the tools that validate an approximate model mode against the exact one
+* over several seeds (super_individual_validation, timestep_validation). Each tool fills one ValidationRun
+* per seed and mode; compareModes prints both modes side by side.
+*/
+
+typedef struct ValidationRun {
+    double seconds;
+    size_t agents;
+    double living;
+    double dead;
+    double exited;
+    // Population at the points the tool compares (every step, or the end of each day)
+    std::vector<double> trajectory;
+    // (site, time) -> sampled population, mean fork length and mean mass
+    std::map<std::pair<size_t, long>, std::vector<double>> samples;
+    // (fork length, weight) and (mass, weight) of each living fish
+    std::vector<std::pair<float, float>> forkLengths;
+    std::vector<std::pair<float, float>> masses;
+} ValidationRun;
+
+// Largest difference between the weighted empirical CDFs of two samples
+double ksDistance(std::vector<std::pair<float, float>> a, std::vector<std::pair<float, float>> b);
+// Mean and sample standard deviation
+void meanSd(const std::vector<double> &values, double &mean, double &sd);
+
+/*
+* Print, per mode, the mean and standard deviation across seeds of the agents, run time, final abundances and
+* each sampling result present in every run (labelled "site <id> <sampleTimeLabel><time>"), with the difference
+* in standard errors; then the largest divergence of the trajectory, the Kolmogorov-Smirnov distances between the
+* pooled final size distributions and the speedup. Returns the largest |z| over the abundances and samples.
+*/
+double compareModes(const std::string &exactName, const std::vector<ValidationRun> &exact,
+                    const std::string &approximateName, const std::vector<ValidationRun> &approximate,
+                    const std::string &sampleTimeLabel, const std::string &trajectoryName);
+
+#endif
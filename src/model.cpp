@@ -2,12 +2,20 @@
 
 #include <thread>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
 #include "util.h"
 #include "load.h"
 #include "map_gen.h"
 #include "env_sim.h"
+#include "columnar_file.h"
+#include "output_storage.h"
+#include "distributed.h"
+#include "movement_prefetch.h"
 #include <cstdio>
 #include <fstream>
+#include <filesystem>
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/filereadstream.h>
@@ -25,18 +33,19 @@ constexpr float DEFAULT_EXIT_CONDITION_HOURS = 2.0;
  * Constructs a model instance from parameters and data filenames.
  * The model is initialized to be empty, and at timestep 0.
  * Loading saved states is handled by a separate function after construction. (Model::loadState)
+ * The inputs load concurrently (see startup.h); their timings are kept in startupTimings.
  */
 Model::Model(
     // Offset of this model's timestep 0 from midnight on January 1st (timestep 0 of the year)
-    // (measured in timesteps)
+    // (measured in hours)
     // Note: This is only used to determine the displayed date in the GUI
     int globalTimeIntercept,
 
     // The offset into the hydrological data corresponding to this model's first timestep
-    // (measured in timesteps)
+    // (measured in hours)
     int hydroTimeIntercept,
     // The offset into the recruitment data corresponding to this model's first timestep
-    // (measured in timesteps)
+    // (measured in hours)
     int recTimeIntercept,
 
     // The maximum number of threads to spawn for multithreaded computation of movement + growth/death
@@ -68,48 +77,65 @@ Model::Model(
     // Path of the distributary WSE/temp data (netCDF)
     std::string distribWseTempFilename,
     const ModelConfigMap &config
-) : defaultHydroModel(std::make_unique<HydroModel>(cresTideFilename, flowVolFilename, airTempFilename,
-                                                   flowSpeedFilename, distribWseTempFilename, hydroTimeIntercept)),
+) : Model(loadStartupInputs({recCountFilename, recSizeDistsFilename, recPointIds, mapLocationFilename, mapEdgeFilename,
+                                mapGeometryFilename, blindChannelSimplificationRadius, cresTideFilename, flowVolFilename,
+                                airTempFilename, flowSpeedFilename, distribWseTempFilename, hydroTimeIntercept}, config),
+            globalTimeIntercept, recTimeIntercept, maxThreads, habitatTypeExitConditionHours, config) {}
+
+Model::Model(
+    StartupInputs &&inputs,
+    int globalTimeIntercept,
+    int recTimeIntercept,
+    size_t maxThreads,
+    float habitatTypeExitConditionHours,
+    const ModelConfigMap &config
+) : mapArena(std::move(inputs.mapArena)),
+    map(std::move(inputs.map)),
+    defaultHydroModel(std::move(inputs.hydroModel)),
     hydroModel(*defaultHydroModel),
+    recCounts(std::move(inputs.recCounts)),
+    recSizeDists(std::move(inputs.recSizeDists)),
+    recPoints(std::move(inputs.recPoints)),
+    samplingSites(std::move(inputs.samplingSites)),
+    samplingCampaigns(defaultSamplingSchedule()),
+    monitoringPoints(std::move(inputs.monitoringPoints)),
+    mapCoarsening(std::move(inputs.mapCoarsening)),
+    reachabilityIndex(std::move(inputs.reachability)),
     recTimeIntercept(recTimeIntercept),
     globalTimeIntercept(globalTimeIntercept),
-    firstHighTide(false),
     time(0UL),
     deadCount(0),
     exitedCount(0),
+    livingAbundance(0.0),
+    deadAbundance(0.0),
+    exitedAbundance(0.0),
+    startupTimings(inputs.timings),
     mortConstA(MORT_CONST_A),
     mortConstC(MORT_CONST_C),
     habitatTypeExitConditionHours(habitatTypeExitConditionHours),
     nextFishID(0UL),
     maxThreads(maxThreads),
     recruitTagRate(0.5f),
-    configMap(config) {
+    configMap(config),
+    countedEmpty(false),
+    distributedStep(nullptr),
+    numaPlacedFish(nullptr),
+    numaPlacedDay(-1),
+    numaHydroInterleaved(false) {
     if (getInt(ModelParamKey::DirectionlessEdges)) std::cout << "directionless edges!" << std::endl;
-
-    // Load the map
-    loadMap(
-        // The resulting nodes are stored in the model's "map" field
-        this->map,
-        mapLocationFilename,
-        mapEdgeFilename,
-        mapGeometryFilename,
-        hydroModel.hydroNodes,
-        recPointIds,
-        this->recPoints,
-        this->monitoringPoints,
-        this->samplingSites,
-        blindChannelSimplificationRadius,
-        configMap
-    );
-    for (size_t i = 0; i < this->monitoringPoints.size(); ++i) {
-        this->monitoringHistory.emplace_back();
+    this->monitoringHistory.reset(this->monitoringPoints.size());
+    std::string samplingScheduleFilename = getString(ModelParamKey::SamplingScheduleFile);
+    if (!samplingScheduleFilename.empty()) {
+        this->samplingCampaigns.clear();
+        loadSamplingSchedule(samplingScheduleFilename, this->samplingSites, this->samplingCampaigns);
     }
-    // Load the recruit counts, the data is stored in the model's "recCounts" field
-    loadIntList(recCountFilename, this->recCounts);
-    // Ditto for recruit sizes and sampling sites
-    loadRecSizeDists(recSizeDistsFilename, this->recSizeDists);
-    // Make room in the recruit plan vector (per-timestep recruit counts for the current day)
+    // Make room in the recruit plan vector (per-hour recruit counts for the current day)
     this->recDayPlan.resize(24, 0UL);
+    this->hydroModel.updateTime(this->getHour(), this->getHoursPerTimestep());
+    std::cout << "Inputs loaded in " << this->startupTimings.total << "s (hydrology tables "
+              << this->startupTimings.hydroTables << "s, hydrology " << this->startupTimings.hydroGrid << "s, map "
+              << this->startupTimings.map << "s, recruitment " << this->startupTimings.recruitment
+              << "s concurrently; then hydro assignment " << this->startupTimings.hydroAssignment << "s)" << std::endl;
 }
 
 // Load model components from simulated data (map & environmental conditions)
@@ -128,80 +154,141 @@ Model::Model(
     recCounts(recCounts),
     recSizeDists(recSizeDists),
     recPoints(recPoints),
+    samplingCampaigns(defaultSamplingSchedule()),
     recTimeIntercept(0),
     globalTimeIntercept(0),
-    firstHighTide(false),
     time(0UL),
     deadCount(0),
     exitedCount(0),
+    livingAbundance(0.0),
+    deadAbundance(0.0),
+    exitedAbundance(0.0),
     mortConstA(MORT_CONST_A),
     mortConstC(MORT_CONST_C),
     habitatTypeExitConditionHours(DEFAULT_EXIT_CONDITION_HOURS),
     nextFishID(0UL),
     maxThreads(maxThreads),
-    recruitTagRate(0.5f) {
-    // Make room in the recruit plan vector (per-timestep recruit counts for the current day)
+    recruitTagRate(0.5f),
+    countedEmpty(false),
+    distributedStep(nullptr),
+    numaPlacedFish(nullptr),
+    numaPlacedDay(-1),
+    numaHydroInterleaved(false) {
+    // Make room in the recruit plan vector (per-hour recruit counts for the current day)
     this->recDayPlan.resize(24, 0UL);
 }
 
 Model::Model(HydroModel *hydroModel)
     : defaultHydroModel(nullptr),
       hydroModel(*hydroModel),
+      samplingCampaigns(defaultSamplingSchedule()),
       recTimeIntercept(0),
       globalTimeIntercept(0),
-      firstHighTide(false),
       time(0UL),
       deadCount(0),
       exitedCount(0),
+      livingAbundance(0.0),
+      deadAbundance(0.0),
+      exitedAbundance(0.0),
       mortConstA(MORT_CONST_A),
       mortConstC(MORT_CONST_C),
       habitatTypeExitConditionHours(DEFAULT_EXIT_CONDITION_HOURS),
       nextFishID(0UL),
       maxThreads(1),
-      recruitTagRate(0.5f) {}
+      recruitTagRate(0.5f),
+      countedEmpty(false),
+    distributedStep(nullptr),
+    numaPlacedFish(nullptr),
+    numaPlacedDay(-1),
+    numaHydroInterleaved(false) {}
+
+// Seconds since start, which is then moved up to now (so consecutive calls time consecutive phases)
+static double lapSeconds(std::chrono::steady_clock::time_point &start) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - start).count();
+    start = now;
+    return seconds;
+}
 
 void Model::masterUpdate() {
-    if (this->time % 24 == 0) {
-        this->update24h();
+    const int hours = this->getHoursPerTimestep();
+    const long hour = this->getHour();
+    if (this->scheduler.getHour() != hour) {
+        // First step, or time was moved by reset, replay or a test: rebuild the calendar from here
+        this->scheduler.reset(hour, this->samplingCampaigns);
     }
-    if ((this->time / 24) % 14 == 0) { // GROT changed to 7
-        // On a sampling day
-        // TODO add sampling parameters to config
-        if (this->time % 24 == 12) {
-            this->sampling();
-        }
-        // Currently all sites are treated as beach seine
-        /*if (this->hydroModel.isHighTide() && firstHighTide) {
-            this->firstHighTide = false;
-            this->sampling(SamplingMode::Fyke);
-        }*/
+    this->lastStepTimings.sampling = 0.0;
+    // Recruitment planning and samplings falling in this step's hours (every allowed step length divides
+    // a day, so each day starts on a step)
+    for (const ScheduledEvent &event : this->scheduler.advance(hour + hours)) {
+        this->handleEvent(event);
     }
-    this->update1h();
+    this->updateTimestep();
     this->time += 1;
     // Sync the hydro model's time with the main model time
-    this->hydroModel.updateTime(this->time);
+    this->hydroModel.updateTime(this->getHour(), hours);
 }
 
-void Model::update1h() {
+void Model::handleEvent(const ScheduledEvent &event) {
+    if (event.type == EventType::PlanRecruitment) {
+        this->update24h();
+        return;
+    }
+    const SamplingCampaign &campaign = this->samplingCampaigns[event.campaign];
+    if (campaign.method == SamplingMethod::Fyke && !this->hydroModel.isHighTide()) {
+        // Wait for a high tide, until the end of the day
+        const long nextStep = this->getHour() + this->getHoursPerTimestep();
+        if (nextStep < (event.hour / 24 + 1) * 24) {
+            this->scheduler.schedule({nextStep, EventType::Sampling, event.campaign, 0L});
+        }
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    this->sampling(campaign.siteIds);
+    this->lastStepTimings.sampling += lapSeconds(start);
+}
+
+void Model::updateTimestep() {
+    auto start = std::chrono::steady_clock::now();
     // Introduce new recruits
     this->recruit();
-    // We aren't recalculating density between recruitment and movement since we want to turn a blind eye
-    // to the recruit entry node bottleneck (by letting them move before counting, we pretend they don't bunch up)
-    this->moveAll();
-    // Calculate density, size distributions for each node to provide info needed for consumption/mortality calculations
-    // The "false" here means the sampling trackers won't be updated (to avoid double-counting fish)
-    this->countAll(false);
-    this->growAndDieAll();
-    // Recalculate densities to reflect mortality, this time with sampling tracking enabled
-    this->countAll(true);
+    if (this->distributedStep != nullptr) {
+        this->distributedStep->claimRecruits();
+    }
+    this->lastStepTimings.recruit = lapSeconds(start);
+    // (A distributed run's processes always take part, as fish may arrive from the others)
+    if (this->livingIndividuals.empty() && this->countedEmpty && this->distributedStep == nullptr) {
+        // Nothing to move, grow or count (before the first recruits or after the last fish has left)
+        this->lastStepTimings.move = 0.0;
+        this->lastStepTimings.count = 0.0;
+        this->lastStepTimings.growAndDie = 0.0;
+    } else {
+        // We aren't recalculating density between recruitment and movement since we want to turn a blind eye
+        // to the recruit entry node bottleneck (by letting them move before counting, we pretend they don't bunch up)
+        this->moveAll();
+        if (this->distributedStep != nullptr) {
+            this->distributedStep->exchangeMigrants();
+        }
+        this->lastStepTimings.move = lapSeconds(start);
+        // Calculate density, size distributions for each node to provide info needed for consumption/mortality calculations
+        // The "false" here means the sampling trackers won't be updated (to avoid double-counting fish)
+        this->countAll(false);
+        this->lastStepTimings.count = lapSeconds(start);
+        this->growAndDieAll();
+        this->lastStepTimings.growAndDie = lapSeconds(start);
+        // Recalculate densities to reflect mortality, this time with sampling tracking enabled
+        this->countAll(true);
+        if (this->distributedStep != nullptr) {
+            this->distributedStep->exchangeOccupancy();
+        }
+        this->lastStepTimings.count += lapSeconds(start);
+    }
     // Add an entry to the population history
-    this->populationHistory.push_back(this->livingIndividuals.size());
+    this->populationHistory.push_back((int) std::lround(this->livingAbundance));
     // Record monitoring sites
     //this->checkMonitoringNodes(); // TODO: GROT
-    for (size_t i = 0; i < this->monitoringPoints.size(); ++i) {
-        MapNode *n = this->monitoringPoints[i];
-        this->monitoringHistory[i].emplace_back(n->residentIds.size(), n->popDensity, hydroModel.getDepth(*n), hydroModel.getTemp(*n));
-    }
+    this->monitoringHistory.record(this->monitoringPoints, this->hydroModel, this->maxThreads);
+    this->lastStepTimings.record = lapSeconds(start);
 }
 
 // TODO: longer timestep, move based on current state, explore discretely? <-- think about this more
@@ -209,32 +296,84 @@ void Model::update1h() {
 void Model::update24h() {
     // Generate the per-timestep recruit counts for the day
     this->planRecruitment();
-    this->firstHighTide = true;
 }
 
 // Alias for an iterator of a list of fish IDs (position in the list)
 typedef std::vector<size_t>::iterator FishIdIter;
 
+// Pin a movement or growth worker (worker of numWorkers) to its CPU and, with placeFish, move the pages
+// holding its batch of fish to its NUMA node (see numa.h)
+static void placeWorker(
+    Model *model,
+    const NumaPlacement *numa,
+    FishIdIter start,
+    FishIdIter end,
+    unsigned worker,
+    unsigned numWorkers,
+    bool placeFish
+) {
+    if (numa == nullptr) {
+        return;
+    }
+    numa->pinWorker(worker, numWorkers);
+    if (placeFish && start != end) {
+        numa->moveToNode(&model->individuals[*start], &model->individuals[*(end - 1)] + 1,
+                         numa->nodeForWorker(worker, numWorkers));
+    }
+}
+
 // Run in each movement thread, processes movement for a subset of fish
+// (super-individuals that split put their new halves in splits)
 void moveThread(
     Model *model,
     FishIdIter start,
-    FishIdIter end
+    FishIdIter end,
+    std::vector<Fish> *splits,
+    const NumaPlacement *numa,
+    unsigned worker,
+    unsigned numWorkers,
+    bool placeFish,
+    size_t prefetchDistance
 ) {
-    for (auto it = start; it != end; ++it) {
-        model->individuals[*it].move(*model);
+    placeWorker(model, numa, start, end, worker, numWorkers, placeFish);
+    MovementPrefetch prefetch(*model, start, end, prefetchDistance);
+    for (size_t i = 0; start + i != end; ++i) {
+        prefetch.advance(i);
+        model->individuals[*(start + i)].move(*model, splits);
     }
 }
 
 
 // Handles launching of movement threads
 void Model::moveAll() {
+    if (this->getString(ModelParamKey::MovementEngine) == "density") {
+        this->moveAllDensity();
+        return;
+    }
+    if (this->getInt(ModelParamKey::DomainRegions) > 0) {
+        this->moveAllDomains();
+        return;
+    }
+    this->domains.reset();
     // Each thread should handle at minimum 4096 fish
     unsigned threadBatchSize = std::max(4096U, (unsigned) (this->livingIndividuals.size() / this->maxThreads));
     // Figure out how many threads to launch based on the calculated per-thread fish count
     unsigned numThreads = std::max(1U, (unsigned) (this->livingIndividuals.size() / threadBatchSize));
+    // Pinning, and whether the workers' fish need moving to their nodes (each day, or when recruits have moved
+    // the fish storage)
+    const NumaPlacement *numa = this->numaPlacement();
+    const long day = this->getHour() / 24;
+    const bool placeFish = numa != nullptr && numa->getPinning() != ThreadPinning::Off
+                           && (this->individuals.data() != this->numaPlacedFish || day != this->numaPlacedDay);
+    if (placeFish) {
+        this->numaPlacedFish = this->individuals.data();
+        this->numaPlacedDay = day;
+    }
+    const size_t prefetchDistance = (size_t) this->getInt(ModelParamKey::MovementPrefetchDistance);
     // Allocate storage for thread datastructures
     std::thread *threads = new std::thread[numThreads];
+    // Agents split off by each thread, added to the fish lists once all threads are done
+    std::vector<std::vector<Fish>> splits(numThreads);
     // Iterator for the beginning of the living fish list
     auto start = this->livingIndividuals.begin();
     size_t remaining = this->livingIndividuals.size();
@@ -245,7 +384,8 @@ void Model::moveAll() {
         // Iterator for the end of the current batch of fish to be processed
         auto end = start + batch;
         // Launch a thread
-        threads[i] = std::thread(moveThread, this, start, end);
+        threads[i] = std::thread(moveThread, this, start, end, &splits[i], numa, i, numThreads, placeFish,
+                                 prefetchDistance);
         // Shift the start point for the next batch to just past this batch's end
         start = end;
     }
@@ -255,7 +395,41 @@ void Model::moveAll() {
     }
     // Free the thread storage (it was allocated on the heap)
     delete[] threads;
+    this->collectMoved(splits);
+}
+
+void Model::moveAllDomains() {
+    const size_t numRegions = (size_t) this->getInt(ModelParamKey::DomainRegions);
+    if (!this->domains || this->domains->getNumRegions() != numRegions) {
+        this->domains = std::make_unique<DomainDecomposition>(this->map, numRegions);
+    }
+    DomainDecomposition &domains = *this->domains;
+    domains.sync(this->livingIndividuals, [this](size_t id) { return this->individuals[id].location; });
+    std::vector<std::vector<Fish>> splits(numRegions);
+    const size_t prefetchDistance = (size_t) this->getInt(ModelParamKey::MovementPrefetchDistance);
+    domains.forEachRegion(this->maxThreads, [this, &domains, &splits, prefetchDistance](size_t region) {
+        const std::vector<size_t> &regionFish = domains.getRegionFish(region);
+        MovementPrefetch prefetch(*this, regionFish.begin(), regionFish.end(), prefetchDistance);
+        for (size_t i = 0; i < regionFish.size(); ++i) {
+            prefetch.advance(i);
+            this->individuals[regionFish[i]].move(*this, &splits[region]);
+        }
+        domains.post(region, [this](size_t id) -> const MapNode * {
+            const Fish &f = this->individuals[id];
+            return f.status == FishStatus::Alive ? f.location : nullptr;
+        });
+    });
+    // Every region has moved, so the mailboxes are full
+    domains.forEachRegion(this->maxThreads, [&domains](size_t region) { domains.deliver(region); });
+    this->collectMoved(splits);
+    domains.markSynced(this->nextFishID);
+}
 
+DomainDecomposition *Model::activeDomains() const {
+    return this->getInt(ModelParamKey::DomainRegions) > 0 ? this->domains.get() : nullptr;
+}
+
+void Model::collectMoved(std::vector<std::vector<Fish>> &splits) {
     // Re-pack the living fish into the first part of the living fish list
 
     // Tracker for where to put living fish in the list (start at the start)
@@ -268,20 +442,188 @@ void Model::moveAll() {
             ++targetIt;
         } else if (f.status == FishStatus::Exited) {
             ++this->exitedCount;
+            this->exitedAbundance += f.weight;
         }
     }
     // Erase remaining (dead) fish
     if (targetIt != this->livingIndividuals.end()) {
         this->livingIndividuals.erase(targetIt, this->livingIndividuals.end());
     }
+
+    // Add split-off agents (in thread order, so a single-threaded run stays reproducible)
+    for (std::vector<Fish> &batch : splits) {
+        for (Fish &f : batch) {
+            f.id = this->nextFishID++;
+            this->individuals.push_back(f);
+            if (f.status == FishStatus::Alive) {
+                this->livingIndividuals.push_back(f.id);
+                if (this->domains) {
+                    this->domains->adopt(f.id, f.location);
+                }
+            } else if (f.status == FishStatus::Exited) {
+                ++this->exitedCount;
+                this->exitedAbundance += f.weight;
+            }
+        }
+    }
+}
+
+// Per-origin values pushed through the transition matrices by moveAllDensity, each multiplied by the
+// agent's weight (DENSITY_FISH must come first; see DensityPropagation::propagate)
+enum DensityChannel {
+    DENSITY_FISH,
+    DENSITY_MASS,
+    DENSITY_FORK_LENGTH,
+    DENSITY_SPAWN_TIME,
+    DENSITY_ENTRY_MASS,
+    DENSITY_ENTRY_FORK_LENGTH,
+    DENSITY_FLOW_SPEED,
+    DENSITY_CHANNELS
+};
+
+void Model::moveAllDensity() {
+    const float classWidth = this->getFloat(ModelParamKey::DensitySizeClassWidth);
+    if (!this->densityPropagation || this->densityPropagation->getClassWidth() != classWidth) {
+        this->densityPropagation = std::make_unique<DensityPropagation>(classWidth);
+    }
+    DensityPropagation &propagation = *this->densityPropagation;
+
+    // Sort the living fish into pools of untagged fish that move together, keyed by (size class,
+    // exit habitat hours), and tagged fish that move alone
+    std::map<std::pair<size_t, float>, std::vector<size_t>> pools;
+    std::vector<size_t> tagged;
+    std::vector<std::vector<MapNode *>> origins;
+    for (size_t id : this->livingIndividuals) {
+        const Fish &f = this->individuals[id];
+        size_t sizeClass = propagation.sizeClass(f.forkLength);
+        if (sizeClass >= origins.size()) {
+            origins.resize(sizeClass + 1);
+        }
+        origins[sizeClass].push_back(f.location);
+        if (f.taggedTime >= 0) {
+            tagged.push_back(id);
+        } else {
+            pools[{sizeClass, f.numExitHabitatHours}].push_back(id);
+        }
+    }
+    propagation.build(*this, origins, this->maxThreads);
+
+    // Tagged fish draw their destination from their origin's row
+    for (size_t id : tagged) {
+        Fish &f = this->individuals[id];
+        const TransitionMatrix &matrix = propagation.getMatrix(propagation.sizeClass(f.forkLength));
+        size_t row = matrix.findRow(f.location);
+        size_t k = matrix.rowStart[row];
+        KeyedRandScope keyed(this->usesCommonRandomNumbers(), RandPurpose::Movement, f.id, (uint64_t) this->time);
+        double draw = unit_rand();
+        while (k + 1 < matrix.rowStart[row + 1] && draw >= matrix.probabilities[k]) {
+            draw -= matrix.probabilities[k];
+            ++k;
+        }
+        float lastFlowSpeed = this->hydroModel.getUnsignedFlowSpeedAt(*f.location);
+        f.arriveAt(*this, matrix.destinations[k], matrix.costs[k], lastFlowSpeed);
+    }
+
+    const size_t firstNewId = this->individuals.size();
+    const size_t stride = DENSITY_CHANNELS + 1;
+    std::vector<double> arrivals(this->map.size() * stride, 0.0);
+    std::vector<double> density;
+    std::vector<size_t> touched;
+    for (auto &[key, ids] : pools) {
+        const TransitionMatrix &matrix = propagation.getMatrix(key.first);
+        density.assign(matrix.origins.size() * DENSITY_CHANNELS, 0.0);
+        for (size_t id : ids) {
+            const Fish &f = this->individuals[id];
+            double *x = &density[matrix.findRow(f.location) * DENSITY_CHANNELS];
+            x[DENSITY_FISH] += f.weight;
+            x[DENSITY_MASS] += f.weight * f.mass;
+            x[DENSITY_FORK_LENGTH] += f.weight * f.forkLength;
+            x[DENSITY_SPAWN_TIME] += f.weight * (double) f.spawnTime;
+            x[DENSITY_ENTRY_MASS] += f.weight * f.entryMass;
+            x[DENSITY_ENTRY_FORK_LENGTH] += f.weight * f.entryForkLength;
+            x[DENSITY_FLOW_SPEED] += f.weight * this->hydroModel.getUnsignedFlowSpeedAt(*f.location);
+        }
+        touched.clear();
+        DensityPropagation::propagate(matrix, density, DENSITY_CHANNELS, arrivals, touched);
+
+        // One agent per location reached, reusing the pool's agents first
+        size_t reused = 0;
+        for (size_t mapIndex : touched) {
+            double *y = &arrivals[mapIndex * stride];
+            double fish = y[DENSITY_FISH];
+            double weight = fish;
+            if (weight < 1.0) {
+                KeyedRandScope keyed(this->usesCommonRandomNumbers(), RandPurpose::DensityPool, mapIndex,
+                                     (uint64_t) this->time, key.first * 1000003ULL + (uint64_t) key.second);
+                weight = unit_rand() < weight ? 1.0 : 0.0;
+            }
+            if (weight > 0.0) {
+                size_t id;
+                if (reused < ids.size()) {
+                    id = ids[reused++];
+                } else {
+                    Fish pooled = this->individuals[ids.front()];
+                    pooled.id = this->nextFishID++;
+                    this->individuals.push_back(pooled);
+                    id = pooled.id;
+                }
+                Fish &f = this->individuals[id];
+                f.weight = (float) weight;
+                f.lostWeight = 0.0f;
+                f.mass = (float) (y[DENSITY_MASS] / fish);
+                f.forkLength = (float) (y[DENSITY_FORK_LENGTH] / fish);
+                f.spawnTime = std::lround(y[DENSITY_SPAWN_TIME] / fish);
+                f.entryMass = (float) (y[DENSITY_ENTRY_MASS] / fish);
+                f.entryForkLength = (float) (y[DENSITY_ENTRY_FORK_LENGTH] / fish);
+                f.numExitHabitatHours = key.second;
+                f.status = FishStatus::Alive;
+                f.arriveAt(*this, this->map[mapIndex], (float) (y[DENSITY_CHANNELS] / fish),
+                           (float) (y[DENSITY_FLOW_SPEED] / fish));
+            }
+            std::fill(y, y + stride, 0.0);
+        }
+        for (; reused < ids.size(); ++reused) {
+            Fish &f = this->individuals[ids[reused]];
+            f.status = FishStatus::Merged;
+            f.exitTime = this->time;
+            f.weight = 0.0f;
+        }
+    }
+
+    // Re-pack the living list as in moveAll, then add the new agents
+    auto targetIt = this->livingIndividuals.begin();
+    for (auto sourceIt = this->livingIndividuals.begin(); sourceIt != this->livingIndividuals.end(); ++sourceIt) {
+        Fish &f = this->individuals[*sourceIt];
+        if (f.status == FishStatus::Alive) {
+            *targetIt = *sourceIt;
+            ++targetIt;
+        } else if (f.status == FishStatus::Exited) {
+            ++this->exitedCount;
+            this->exitedAbundance += f.weight;
+        }
+    }
+    this->livingIndividuals.erase(targetIt, this->livingIndividuals.end());
+    for (size_t id = firstNewId; id < this->individuals.size(); ++id) {
+        Fish &f = this->individuals[id];
+        if (f.status == FishStatus::Alive) {
+            this->livingIndividuals.push_back(id);
+        } else if (f.status == FishStatus::Exited) {
+            ++this->exitedCount;
+            this->exitedAbundance += f.weight;
+        }
+    }
 }
 
 // Run in each growth+death thread, processes growth and death for a subset of fish
 void growAndDieThread(
     Model *model,
     FishIdIter start,
-    FishIdIter end
+    FishIdIter end,
+    const NumaPlacement *numa,
+    unsigned worker,
+    unsigned numWorkers
 ) {
+    placeWorker(model, numa, start, end, worker, numWorkers, false);
     for (auto it = start; it != end; ++it) {
         model->individuals[*it].growAndDie(*model);
     }
@@ -289,10 +631,23 @@ void growAndDieThread(
 
 // Handles launching of growth+death threads
 void Model::growAndDieAll() {
+    DomainDecomposition *domains = this->activeDomains();
+    if (domains != nullptr) {
+        domains->forEachRegion(this->maxThreads, [this, domains](size_t region) {
+            for (size_t id : domains->getRegionFish(region)) {
+                this->individuals[id].growAndDie(*this);
+            }
+            domains->drop(region, [this](size_t id) { return this->individuals[id].status == FishStatus::Alive; });
+        });
+        this->collectGrown();
+        return;
+    }
     // Each thread should handle at minimum 4096 fish
     unsigned threadBatchSize = std::max(4096U, (unsigned) (this->livingIndividuals.size() / this->maxThreads));
     // Figure out how many threads to launch based on the calculated per-thread fish count
     unsigned numThreads = std::max(1U, (unsigned) (this->livingIndividuals.size() / threadBatchSize));
+    // Workers are pinned as in moveAll, so most take the fish they moved (see numa.h)
+    const NumaPlacement *numa = this->numaPlacement();
     // Allocate storage for thread datastructures
     std::thread *threads = new std::thread[numThreads];
     // Iterator for the beginning of the living fish list
@@ -305,7 +660,7 @@ void Model::growAndDieAll() {
         // Iterator for the end of the current batch of fish to be processed
         auto end = start + batch;
         // Launch a thread
-        threads[i] = std::thread(growAndDieThread, this, start, end);
+        threads[i] = std::thread(growAndDieThread, this, start, end, numa, i, numThreads);
         // Shift the start point for the next batch to just past this batch's end
         start = end;
     }
@@ -315,21 +670,29 @@ void Model::growAndDieAll() {
     }
     // Free thread storage
     delete[] threads;
+    this->collectGrown();
+}
 
+void Model::collectGrown() {
     // Re-pack the living fish into the first part of the living fish list, remove dead fish
 
     // Tracker for where to put living fish in the list (start at the start)
     auto targetIt = this->livingIndividuals.begin();
+    this->livingAbundance = 0.0;
     for (auto sourceIt = this->livingIndividuals.begin(); sourceIt != this->livingIndividuals.end(); ++sourceIt) {
         Fish &f = this->individuals[*sourceIt];
         // If a fish is alive, move it to the target tracker, then shift the target position over 1
         if (f.status == FishStatus::Alive) {
             *targetIt = *sourceIt;
             ++targetIt;
+            this->livingAbundance += f.weight;
+            this->deadAbundance += f.lostWeight;
         } else if (f.status == FishStatus::Exited) {
             ++this->exitedCount;
+            this->exitedAbundance += f.weight;
         } else {
             ++this->deadCount;
+            this->deadAbundance += f.weight;
         }
     }
     // Erase remaining (dead) fish
@@ -348,53 +711,103 @@ struct FishSortDummy {
     }
 };
 
+// Compute a location's population density and its residents' mass and arrival time ranks
+// (residentIds must already be filled in; the sort vectors are scratch space)
+static void computeNodeStats(
+    std::vector<Fish> &individuals,
+    MapNode *node,
+    std::vector<FishSortDummy> &residentMasses,
+    std::vector<FishSortDummy> &residentArrivalTimes
+) {
+    // Calculate population density (pop/area)
+    node->popDensity = node->residentWeight / node->area;
+    // Calculate median mass
+    if (node->residentIds.size() > 0) {
+        residentMasses.clear();
+        residentArrivalTimes.clear();
+        // Make a list of node's resident masses
+        for (long id: node->residentIds) {
+            residentMasses.emplace_back(id, individuals[id].mass);
+            residentArrivalTimes.emplace_back(id, individuals[id].travel);
+        }
+        // Set the median to the nth-largest element of the mass list, where n is half the length of the list
+        std::sort(residentMasses.begin(), residentMasses.end());
+        std::sort(residentArrivalTimes.begin(), residentArrivalTimes.end());
+        for (size_t i = 0; i < residentMasses.size(); ++i) {
+            individuals[residentMasses[i].id].massRank = i;
+            individuals[residentArrivalTimes[i].id].arrivalTimeRank = residentMasses.size() - i - 1;
+        }
+    }
+}
+
+// Clear a location's resident trackers
+static void clearResidents(MapNode *node) {
+    node->residentIds.clear();
+    node->residentWeight = 0.0f;
+    node->maxMass = 0.0f;
+}
+
+// Place a fish in the trackers for its location
+static void addResident(std::vector<Fish> &individuals, size_t id) {
+    Fish &f = individuals[id];
+    f.location->residentIds.push_back(id);
+    f.location->residentWeight += f.weight;
+    f.location->maxMass = std::max(f.location->maxMass, f.mass);
+}
+
 // Calculate per-node population and median mass
 void Model::countAll(bool updateTracking) {
+    DomainDecomposition *domains = this->activeDomains();
+    if (domains != nullptr && domains->getNumFish() == this->livingIndividuals.size()) {
+        // Each region's fish are all at its own locations
+        domains->forEachRegion(this->maxThreads, [this, domains](size_t region) {
+            for (MapNode *node : domains->getRegionNodes(region)) {
+                clearResidents(node);
+            }
+            for (size_t id : domains->getRegionFish(region)) {
+                addResident(this->individuals, id);
+            }
+            std::vector<FishSortDummy> residentMasses;
+            std::vector<FishSortDummy> residentArrivalTimes;
+            for (MapNode *node : domains->getRegionNodes(region)) {
+                computeNodeStats(this->individuals, node, residentMasses, residentArrivalTimes);
+            }
+        });
+        this->countedEmpty = this->livingIndividuals.empty();
+        return;
+    }
     // Reset node tracker values
     for (MapNode *node: this->map) {
-        node->residentIds.clear();
-        node->maxMass = 0.0f;
+        clearResidents(node);
     }
     // Place each fish in the trackers for its node
     for (long i: this->livingIndividuals) {
-        Fish &f = this->individuals[i];
-        f.location->residentIds.push_back(i);
-        f.location->maxMass = std::max(f.location->maxMass, f.mass);
+        addResident(this->individuals, i);
     }
     std::vector<FishSortDummy> residentMasses;
     std::vector<FishSortDummy> residentArrivalTimes;
     for (MapNode *node: this->map) {
-        // Calculate population density (pop/area)
-        node->popDensity = ((float) node->residentIds.size()) / node->area;
-        // Calculate median mass
-        if (node->residentIds.size() > 0) {
-            residentMasses.clear();
-            residentArrivalTimes.clear();
-            // Make a list of node's resident masses
-            for (long id: node->residentIds) {
-                residentMasses.emplace_back(id, this->individuals[id].mass);
-                residentArrivalTimes.emplace_back(id, this->individuals[id].travel);
-            }
-            // Set the median to the nth-largest element of the mass list, where n is half the length of the list
-            std::sort(residentMasses.begin(), residentMasses.end());
-            std::sort(residentArrivalTimes.begin(), residentArrivalTimes.end());
-            for (size_t i = 0; i < residentMasses.size(); ++i) {
-                this->individuals[residentMasses[i].id].massRank = i;
-                this->individuals[residentArrivalTimes[i].id].arrivalTimeRank = residentMasses.size() - i - 1;
-            }
-        }
+        computeNodeStats(this->individuals, node, residentMasses, residentArrivalTimes);
     }
+    this->countedEmpty = this->livingIndividuals.empty();
+}
+
+// The recruit size distribution for the current week
+static std::vector<float> &currentRecSizeDist(Model &model) {
+    constexpr unsigned HOURS_IN_DAY = 24;
+    constexpr unsigned DAYS_IN_WEEK = 7;
+    constexpr unsigned HOURS_IN_WEEK = HOURS_IN_DAY * DAYS_IN_WEEK;
+    const size_t recruitWeek = (model.getHour() + model.recTimeIntercept) / (HOURS_IN_WEEK);
+    const size_t recruitWeekIndex = std::min(recruitWeek, model.recSizeDists.size() - 1);
+    return model.recSizeDists[recruitWeekIndex];
 }
 
 // Generates a single recruit and adds it to a random recruit start node
 void Model::recruitSingle() {
+    // A recruit's draws (including its mass in the Fish constructor) are keyed by its ID
+    KeyedRandScope keyed(this->usesCommonRandomNumbers(), RandPurpose::Recruit, this->nextFishID, 0);
     // Get the current slice of the recruit size distribution data
-    constexpr unsigned TIMESTEPS_IN_DAY = 24;
-    constexpr unsigned DAYS_IN_WEEK = 7;
-    constexpr unsigned TIMESTEPS_IN_WEEK = TIMESTEPS_IN_DAY * DAYS_IN_WEEK;
-    const size_t recruitWeek = (this->time + this->recTimeIntercept) / (TIMESTEPS_IN_WEEK);
-    const size_t recruitWeekIndex = std::min(recruitWeek, this->recSizeDists.size() - 1);
-    std::vector<float> &recSizeDist = this->recSizeDists[recruitWeekIndex];
+    std::vector<float> &recSizeDist = currentRecSizeDist(*this);
 
     // Sample the fork length bucket index from the distribution
     unsigned flIdx = sample(recSizeDist.data(), recSizeDist.size());
@@ -419,13 +832,47 @@ void Model::recruitSingle() {
 // Recruit all recruits for the current timestep
 void Model::recruit() {
     // Get the current timestep's recruit count from the day's recruit "plan"
-    size_t currRecCount = this->recDayPlan[this->time % 24];
+    size_t currRecCount = 0;
+    for (long hour = this->getHour(); hour < this->getHour() + this->getHoursPerTimestep(); ++hour) {
+        currRecCount += this->recDayPlan[hour % 24];
+    }
+    const size_t superIndividualSize = (size_t) this->getInt(ModelParamKey::SuperIndividualSize);
+    if (superIndividualSize > 1) {
+        this->recruitGrouped(currRecCount, superIndividualSize);
+        return;
+    }
     // Recruit that many fish
     for (size_t i = 0; i < currRecCount; ++i) {
         this->recruitSingle();
     }
 }
 
+// Each recruit draws an entry point and size bucket as in recruitSingle, then the recruits sharing
+// both are divided evenly among as few agents as hold at most superIndividualSize each
+void Model::recruitGrouped(size_t count, size_t superIndividualSize) {
+    // The groups are drawn together, so they're keyed by the hour
+    KeyedRandScope keyed(this->usesCommonRandomNumbers(), RandPurpose::Recruit, (uint64_t) this->getHour(), 0);
+    std::vector<float> &recSizeDist = currentRecSizeDist(*this);
+    // Recruits per (entry point, fork length bucket); ordered, so agents are created in a fixed order
+    std::map<std::pair<size_t, unsigned>, size_t> groups;
+    for (size_t i = 0; i < count; ++i) {
+        size_t entry = (size_t) GlobalRand::int_rand(0, (int) this->recPoints.size() - 1);
+        unsigned flIdx = sample(recSizeDist.data(), recSizeDist.size());
+        ++groups[{entry, flIdx}];
+    }
+    for (const auto &[key, recruits] : groups) {
+        const size_t agents = (recruits + superIndividualSize - 1) / superIndividualSize;
+        const float weight = (float) recruits / (float) agents;
+        for (size_t i = 0; i < agents; ++i) {
+            float forkLength = 35.0f + 5.0f * key.second + unit_rand() * 5.0f;
+            this->individuals.emplace_back(this->nextFishID++, this->time, forkLength, this->recPoints[key.first], weight);
+            const size_t last_id = this->individuals.back().id;
+            this->tagIndividual(last_id);
+            this->livingIndividuals.push_back(last_id);
+        }
+    }
+}
+
 // Generate the day's per-timestep recruit counts
 void Model::planRecruitment() {
     // Wipe whatever's in the plan array right now
@@ -433,8 +880,10 @@ void Model::planRecruitment() {
         this->recDayPlan[i] = 0;
     }
     // Get the day's daily recruit count
-    size_t count = this->recCounts[(this->time + this->recTimeIntercept) / 24];
-    // For each recruit in the day, place it in a random timestep's slot
+    const size_t day = (this->getHour() + this->recTimeIntercept) / 24;
+    size_t count = this->recCounts[day];
+    KeyedRandScope keyed(this->usesCommonRandomNumbers(), RandPurpose::RecruitPlan, day, 0);
+    // For each recruit in the day, place it in a random hour's slot
     for (size_t i = 0; i < count; ++i) {
         size_t timestep = GlobalRand::int_rand(0, 23);
         ++this->recDayPlan[timestep];
@@ -443,43 +892,82 @@ void Model::planRecruitment() {
 
 // Collect sampling data from the sampling sites
 void Model::sampling() {
-    for (SamplingSite *site: this->samplingSites) {
-        // At each site, calculate the statistics of interest:
-        float totalMass = 0.0f;
-        float totalLength = 0.0f;
-        int totalSpawnTime = 0;
-        size_t totalPop = 0;
-        // "Instant" sampling (just use the current timestep's resident info) for both modes
-        // (difference is in how sampling nodes are assigned)
-        for (MapNode *point: site->points) {
-            for (long id: point->residentIds) {
-                totalMass += this->individuals[id].mass;
-                totalLength += this->individuals[id].forkLength;
-                totalSpawnTime += this->individuals[id].spawnTime;
-            }
-            totalPop += point->residentIds.size();
+    this->sampling({});
+}
+
+// Fill in a sample's statistics from the fish at its site
+static void sampleSite(const std::vector<Fish> &individuals, const SamplingSite &site, Sample &s) {
+    // At each site, calculate the statistics of interest:
+    // Statistics are weighted by Fish::weight, so super-individuals count as the fish they stand for
+    float totalMass = 0.0f;
+    float totalLength = 0.0f;
+    double totalSpawnTime = 0.0;
+    float totalPop = 0.0f;
+    // "Instant" sampling (just use the current timestep's resident info) for both modes
+    // (difference is in how sampling nodes are assigned)
+    for (MapNode *point: site.points) {
+        for (long id: point->residentIds) {
+            const Fish &f = individuals[id];
+            totalMass += f.mass * f.weight;
+            totalLength += f.forkLength * f.weight;
+            totalSpawnTime += (double) f.spawnTime * f.weight;
+            s.sizes.add(f.forkLength, f.mass, f.weight);
         }
-        float meanMass = totalPop > 0 ? totalMass / ((float) totalPop) : 0.0f;
-        float meanLength = totalPop > 0 ? totalLength / ((float) totalPop) : 0.0f;
-        float meanSpawnTime = totalPop > 0 ? ((float) totalSpawnTime) / ((float) totalPop) : 0.0f;
-        // Create a sample data structure from the statistics
-        Sample s{
-            site->id,
-            this->time,
-            totalPop,
-            meanMass,
-            meanLength,
-            meanSpawnTime
-        };
-        // Add the new sample to the sample history
-        this->sampleHistory.push_back(s);
+        totalPop += point->residentWeight;
     }
+    s.sizes.compress();
+    s.population = (size_t) std::lround(totalPop);
+    s.meanMass = totalPop > 0.0f ? totalMass / totalPop : 0.0f;
+    s.meanLength = totalPop > 0.0f ? totalLength / totalPop : 0.0f;
+    s.meanSpawnTime = totalPop > 0.0f ? ((float) totalSpawnTime) / totalPop : 0.0f;
+}
+
+void Model::sampling(const std::vector<size_t> &siteIds) {
+    std::vector<SamplingSite *> sites;
+    if (siteIds.empty()) {
+        sites = this->samplingSites;
+    } else {
+        for (size_t id : siteIds) {
+            sites.push_back(this->samplingSites[id]);
+        }
+    }
+    std::vector<Sample> samples;
+    size_t residents = 0;
+    for (SamplingSite *site : sites) {
+        samples.emplace_back(site->id, this->time, 0, 0.0f, 0.0f, 0.0f);
+        for (MapNode *point : site->points) {
+            residents += point->residentIds.size();
+        }
+    }
+    // Sites are shared out between threads when there are enough fish to be worth it (at least 4096 per thread)
+    unsigned numThreads = (unsigned) std::min({this->maxThreads, sites.size(), std::max((size_t) 1, residents / 4096)});
+    if (numThreads <= 1) {
+        for (size_t i = 0; i < sites.size(); ++i) {
+            sampleSite(this->individuals, *sites[i], samples[i]);
+        }
+    } else {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t) {
+            threads.emplace_back([this, &sites, &samples, t, numThreads]() {
+                for (size_t i = t; i < sites.size(); i += numThreads) {
+                    sampleSite(this->individuals, *sites[i], samples[i]);
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+    // Add the new samples to the sample history
+    this->sampleHistory.insert(this->sampleHistory.end(), samples.begin(), samples.end());
 }
 
 // Destructor for the model (frees all model resources that aren't automatically freed)
 Model::~Model() {
     for (MapNode *node: this->map) {
-        delete node;
+        if (!this->mapArena || !this->mapArena->owns(node)) {
+            delete node;
+        }
     }
     for (SamplingSite *site: this->samplingSites) {
         delete site;
@@ -489,19 +977,28 @@ Model::~Model() {
 // Reset timestep to 0, clear all individual lists
 void Model::reset() {
     this->time = 0L;
-    this->hydroModel.updateTime(this->time);
+    this->hydroModel.updateTime(this->getHour(), this->getHoursPerTimestep());
     this->individuals.clear();
     this->livingIndividuals.clear();
     this->deadCount = 0;
     this->exitedCount = 0;
+    this->livingAbundance = 0.0;
+    this->deadAbundance = 0.0;
+    this->exitedAbundance = 0.0;
+    // Fish IDs are indices into individuals
+    this->nextFishID = 0UL;
     this->populationHistory.clear();
     this->sampleHistory.clear();
+    this->monitoringHistory.reset(this->monitoringPoints.size());
+    this->replayStore.reset();
+    this->domains.reset();
     this->countAll(false);
 }
 
 // Save model state to a given filename
 void Model::saveState(std::string savePath) {
     netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    NcStorageOptions storage = NcStorageOptions::parse(this->configMap.getString(ModelParamKey::StateStorage));
     size_t N = this->individuals.size();
     // Add dimensions
     std::vector<netCDF::NcDim> noDims;
@@ -524,29 +1021,31 @@ void Model::saveState(std::string savePath) {
 
     // Record model fields
     std::vector<size_t> noIndex;
-    netCDF::NcVar modelTime = targetFile.addVar("modelTime", netCDF::ncInt, noDims);
+    netCDF::NcVar modelTime = addStoredVar(targetFile, "modelTime", netCDF::ncInt, noDims, storage);
     modelTime.putVar(noIndex, this->time);
 
     // Record fish
-    int *recruitTimeOut = new int[N];
-    int *exitTimeOut = new int[N];
-    float *entryForkLengthOut = new float[N];
-    float *entryMassOut = new float[N];
-    float *forkLengthOut = new float[N];
-    float *massOut = new float[N];
-    int *statusOut = new int[N];
-    int *locationOut = new int[N];
-    float *travelOut = new float[N];
-    float *lastGrowthOut = new float[N];
-    float *lastPmaxOut = new float[N];
-    float *lastMortalityOut = new float[N];
-    float *lastTempOut = new float[N];
-    float *lastDepthOut = new float[N];
-    float *lastFlowSpeedOut = new float[N];
-    float *lastFlowVelocityUOut = new float[N];
-    float *lastFlowVelocityVOut = new float[N];
+    std::vector<int> recruitTimeOut(N);
+    std::vector<int> exitTimeOut(N);
+    std::vector<float> entryForkLengthOut(N);
+    std::vector<float> entryMassOut(N);
+    std::vector<float> forkLengthOut(N);
+    std::vector<float> massOut(N);
+    std::vector<int> statusOut(N);
+    std::vector<int> locationOut(N);
+    std::vector<float> travelOut(N);
+    std::vector<float> lastGrowthOut(N);
+    std::vector<float> lastPmaxOut(N);
+    std::vector<float> lastMortalityOut(N);
+    std::vector<float> lastTempOut(N);
+    std::vector<float> lastDepthOut(N);
+    std::vector<float> lastFlowSpeedOut(N);
+    std::vector<float> lastFlowVelocityUOut(N);
+    std::vector<float> lastFlowVelocityVOut(N);
+    std::vector<float> weightOut(N);
     for (size_t n = 0; n < N; ++n) {
         Fish &f = this->individuals[n];
+        weightOut[n] = f.weight;
         recruitTimeOut[n] = f.spawnTime;
         exitTimeOut[n] = f.exitTime;
         entryForkLengthOut[n] = f.entryForkLength;
@@ -565,52 +1064,57 @@ void Model::saveState(std::string savePath) {
         lastFlowVelocityUOut[n] = f.lastFlowVelocity.u;
         lastFlowVelocityVOut[n] = f.lastFlowVelocity.v;
     }
-    netCDF::NcVar recruitTime = targetFile.addVar("recruitTime", netCDF::ncInt, fishDims);
-    recruitTime.putVar(recruitTimeOut);
-    netCDF::NcVar exitTime = targetFile.addVar("exitTime", netCDF::ncInt, fishDims);
-    exitTime.putVar(exitTimeOut);
-    netCDF::NcVar entryForkLength = targetFile.addVar("entryForkLength", netCDF::ncFloat, fishDims);
-    entryForkLength.putVar(entryForkLengthOut);
-    netCDF::NcVar entryMass = targetFile.addVar("entryMass", netCDF::ncFloat, fishDims);
-    entryMass.putVar(entryMassOut);
-    netCDF::NcVar forkLength = targetFile.addVar("forkLength", netCDF::ncFloat, fishDims);
-    forkLength.putVar(forkLengthOut);
-    netCDF::NcVar mass = targetFile.addVar("mass", netCDF::ncFloat, fishDims);
-    mass.putVar(massOut);
-    netCDF::NcVar status = targetFile.addVar("status", netCDF::ncInt, fishDims);
-    status.putVar(statusOut);
-    netCDF::NcVar location = targetFile.addVar("location", netCDF::ncInt, fishDims);
-    location.putVar(locationOut);
-    netCDF::NcVar travel = targetFile.addVar("travel", netCDF::ncFloat, fishDims);
-    travel.putVar(travelOut);
-    netCDF::NcVar lastGrowth = targetFile.addVar("lastGrowth", netCDF::ncFloat, fishDims);
-    lastGrowth.putVar(lastGrowthOut);
-    netCDF::NcVar lastPmax = targetFile.addVar("lastPmax", netCDF::ncFloat, fishDims);
-    lastPmax.putVar(lastPmaxOut);
-    netCDF::NcVar lastMortality = targetFile.addVar("lastMortality", netCDF::ncFloat, fishDims);
-    lastMortality.putVar(lastMortalityOut);
-    netCDF::NcVar lastTemp = targetFile.addVar("lastTemp", netCDF::ncFloat, fishDims);
-    lastTemp.putVar(lastTempOut);
-    netCDF::NcVar lastDepth = targetFile.addVar("lastDepth", netCDF::ncFloat, fishDims);
-    lastDepth.putVar(lastDepthOut);
-    netCDF::NcVar lastFlowSpeed = targetFile.addVar("lastFlowSpeed", netCDF::ncFloat, fishDims);
-    lastFlowSpeed.putVar(lastFlowSpeedOut);
-    netCDF::NcVar lastVelocityU = targetFile.addVar("lastFlowVelocityU", netCDF::ncFloat, fishDims);
-    lastVelocityU.putVar(lastFlowVelocityUOut);
-    netCDF::NcVar lastVelocityV = targetFile.addVar("lastFlowVelocityV", netCDF::ncFloat, fishDims);
-    lastVelocityV.putVar(lastFlowVelocityVOut);
+    netCDF::NcVar recruitTime = addStoredVar(targetFile, "recruitTime", netCDF::ncInt, fishDims, storage);
+    recruitTime.putVar(recruitTimeOut.data());
+    netCDF::NcVar exitTime = addStoredVar(targetFile, "exitTime", netCDF::ncInt, fishDims, storage);
+    exitTime.putVar(exitTimeOut.data());
+    netCDF::NcVar entryForkLength = addStoredVar(targetFile, "entryForkLength", netCDF::ncFloat, fishDims, storage);
+    entryForkLength.putVar(entryForkLengthOut.data());
+    netCDF::NcVar entryMass = addStoredVar(targetFile, "entryMass", netCDF::ncFloat, fishDims, storage);
+    entryMass.putVar(entryMassOut.data());
+    netCDF::NcVar forkLength = addStoredVar(targetFile, "forkLength", netCDF::ncFloat, fishDims, storage);
+    forkLength.putVar(forkLengthOut.data());
+    netCDF::NcVar mass = addStoredVar(targetFile, "mass", netCDF::ncFloat, fishDims, storage);
+    mass.putVar(massOut.data());
+    netCDF::NcVar status = addStoredVar(targetFile, "status", netCDF::ncInt, fishDims, storage);
+    status.putVar(statusOut.data());
+    netCDF::NcVar location = addStoredVar(targetFile, "location", netCDF::ncInt, fishDims, storage);
+    location.putVar(locationOut.data());
+    netCDF::NcVar travel = addStoredVar(targetFile, "travel", netCDF::ncFloat, fishDims, storage);
+    travel.putVar(travelOut.data());
+    netCDF::NcVar lastGrowth = addStoredVar(targetFile, "lastGrowth", netCDF::ncFloat, fishDims, storage);
+    lastGrowth.putVar(lastGrowthOut.data());
+    netCDF::NcVar lastPmax = addStoredVar(targetFile, "lastPmax", netCDF::ncFloat, fishDims, storage);
+    lastPmax.putVar(lastPmaxOut.data());
+    netCDF::NcVar lastMortality = addStoredVar(targetFile, "lastMortality", netCDF::ncFloat, fishDims, storage);
+    lastMortality.putVar(lastMortalityOut.data());
+    netCDF::NcVar lastTemp = addStoredVar(targetFile, "lastTemp", netCDF::ncFloat, fishDims, storage);
+    lastTemp.putVar(lastTempOut.data());
+    netCDF::NcVar lastDepth = addStoredVar(targetFile, "lastDepth", netCDF::ncFloat, fishDims, storage);
+    lastDepth.putVar(lastDepthOut.data());
+    netCDF::NcVar lastFlowSpeed = addStoredVar(targetFile, "lastFlowSpeed", netCDF::ncFloat, fishDims, storage);
+    lastFlowSpeed.putVar(lastFlowSpeedOut.data());
+    netCDF::NcVar lastVelocityU = addStoredVar(targetFile, "lastFlowVelocityU", netCDF::ncFloat, fishDims, storage);
+    lastVelocityU.putVar(lastFlowVelocityUOut.data());
+    netCDF::NcVar lastVelocityV = addStoredVar(targetFile, "lastFlowVelocityV", netCDF::ncFloat, fishDims, storage);
+    lastVelocityV.putVar(lastFlowVelocityVOut.data());
+    // Weighted-agent runs only, so states from ordinary runs keep the same variables
+    if (this->hasWeightedAgents()) {
+        netCDF::NcVar weight = addStoredVar(targetFile, "weight", netCDF::ncFloat, fishDims, storage);
+        weight.putVar(weightOut.data());
+    }
 
     // Write population history
-    netCDF::NcVar populationHistoryVar = targetFile.addVar("populationHistory", netCDF::ncInt, populationHistoryDims);
+    netCDF::NcVar populationHistoryVar = addStoredVar(targetFile, "populationHistory", netCDF::ncInt, populationHistoryDims, storage);
     populationHistoryVar.putVar(this->populationHistory.data());
 
     // Write sample history
-    int *sampleSiteIDOut = new int[this->sampleHistory.size()];
-    int *sampleTimeOut = new int[this->sampleHistory.size()];
-    int *samplePopOut = new int[this->sampleHistory.size()];
-    float *sampleMeanMassOut = new float[this->sampleHistory.size()];
-    float *sampleMeanLengthOut = new float[this->sampleHistory.size()];
-    float *sampleMeanSpawnTimeOut = new float[this->sampleHistory.size()];
+    std::vector<int> sampleSiteIDOut(this->sampleHistory.size());
+    std::vector<int> sampleTimeOut(this->sampleHistory.size());
+    std::vector<int> samplePopOut(this->sampleHistory.size());
+    std::vector<float> sampleMeanMassOut(this->sampleHistory.size());
+    std::vector<float> sampleMeanLengthOut(this->sampleHistory.size());
+    std::vector<float> sampleMeanSpawnTimeOut(this->sampleHistory.size());
     for (size_t i = 0; i < this->sampleHistory.size(); ++i) {
         sampleSiteIDOut[i] = this->sampleHistory[i].siteID;
         sampleTimeOut[i] = this->sampleHistory[i].time;
@@ -619,49 +1123,32 @@ void Model::saveState(std::string savePath) {
         sampleMeanLengthOut[i] = this->sampleHistory[i].meanLength;
         sampleMeanSpawnTimeOut[i] = this->sampleHistory[i].meanSpawnTime;
     }
-    netCDF::NcVar sampleSiteID = targetFile.addVar("sampleSiteID", netCDF::ncInt, sampleHistoryDims);
-    sampleSiteID.putVar(sampleSiteIDOut);
-    netCDF::NcVar sampleTime = targetFile.addVar("sampleTime", netCDF::ncInt, sampleHistoryDims);
-    sampleTime.putVar(sampleTimeOut);
-    netCDF::NcVar samplePop = targetFile.addVar("samplePop", netCDF::ncInt, sampleHistoryDims);
-    samplePop.putVar(samplePopOut);
-    netCDF::NcVar sampleMeanMass = targetFile.addVar("sampleMeanMass", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanMass.putVar(sampleMeanMassOut);
-    netCDF::NcVar sampleMeanLength = targetFile.addVar("sampleMeanLength", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanLength.putVar(sampleMeanLengthOut);
-    netCDF::NcVar sampleMeanSpawnTime = targetFile.addVar("sampleMeanSpawnTime", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanSpawnTime.putVar(sampleMeanSpawnTimeOut);
-
-    int *monitoringPopulationOut = new int[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringPopulationDensityOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringDepthOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringTempOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    int *monitoringPointsOut = new int[this->monitoringPoints.size()];
+    netCDF::NcVar sampleSiteID = addStoredVar(targetFile, "sampleSiteID", netCDF::ncInt, sampleHistoryDims, storage);
+    sampleSiteID.putVar(sampleSiteIDOut.data());
+    netCDF::NcVar sampleTime = addStoredVar(targetFile, "sampleTime", netCDF::ncInt, sampleHistoryDims, storage);
+    sampleTime.putVar(sampleTimeOut.data());
+    netCDF::NcVar samplePop = addStoredVar(targetFile, "samplePop", netCDF::ncInt, sampleHistoryDims, storage);
+    samplePop.putVar(samplePopOut.data());
+    netCDF::NcVar sampleMeanMass = addStoredVar(targetFile, "sampleMeanMass", netCDF::ncFloat, sampleHistoryDims, storage);
+    sampleMeanMass.putVar(sampleMeanMassOut.data());
+    netCDF::NcVar sampleMeanLength = addStoredVar(targetFile, "sampleMeanLength", netCDF::ncFloat, sampleHistoryDims, storage);
+    sampleMeanLength.putVar(sampleMeanLengthOut.data());
+    netCDF::NcVar sampleMeanSpawnTime = addStoredVar(targetFile, "sampleMeanSpawnTime", netCDF::ncFloat, sampleHistoryDims, storage);
+    sampleMeanSpawnTime.putVar(sampleMeanSpawnTimeOut.data());
+
+    std::vector<int> monitoringPointsOut(this->monitoringPoints.size());
     for (size_t i = 0; i < this->monitoringPoints.size(); ++i) {
         monitoringPointsOut[i] = this->monitoringPoints[i]->id;
-        for (size_t t = 0; t < this->populationHistory.size(); ++t) {
-            monitoringPopulationOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].population;
-            monitoringPopulationDensityOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].populationDensity;
-            monitoringDepthOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].depth;
-            monitoringTempOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].temp;
-        }
     }
-
-    netCDF::NcVar monitoringPopulation = targetFile.addVar("monitoringPopulation", netCDF::ncInt, monitoringDims);
-    monitoringPopulation.putVar(monitoringPopulationOut);
-    netCDF::NcVar monitoringPopulationDensity = targetFile.addVar("monitoringPopulationDensity", netCDF::ncFloat, monitoringDims);
-    monitoringPopulationDensity.putVar(monitoringPopulationDensityOut);
-    netCDF::NcVar monitoringDepth = targetFile.addVar("monitoringDepth", netCDF::ncFloat, monitoringDims);
-    monitoringDepth.putVar(monitoringDepthOut);
-    netCDF::NcVar monitoringTemp = targetFile.addVar("monitoringTemp", netCDF::ncFloat, monitoringDims);
-    monitoringTemp.putVar(monitoringTempOut);
-    netCDF::NcVar monitoringPointIDs = targetFile.addVar("monitoringPointIDs", netCDF::ncInt, monitoringPointsDims);
-    monitoringPointIDs.putVar(monitoringPointsOut);
+    this->monitoringHistory.write(targetFile, monitoringDims, storage);
+    netCDF::NcVar monitoringPointIDs = addStoredVar(targetFile, "monitoringPointIDs", netCDF::ncInt, monitoringPointsDims, storage);
+    monitoringPointIDs.putVar(monitoringPointsOut.data());
 }
 
 // Load model state from a given filename
 // Returns true if the loading was successful, false if something went wrong
 void Model::loadState(std::string loadPath) {
+    this->domains.reset();
     netCDF::NcFile sourceFile(loadPath, netCDF::NcFile::FileMode::read);
     size_t N = sourceFile.getDim("n").getSize();
     long recruitTimeDummy;
@@ -685,6 +1172,8 @@ void Model::loadState(std::string loadPath) {
     netCDF::NcVar lastFlowSpeed = sourceFile.getVar("lastFlowSpeed");
     netCDF::NcVar lastFlowVelocityU = sourceFile.getVar("lastFlowVelocityU");
     netCDF::NcVar lastFlowVelocityV = sourceFile.getVar("lastFlowVelocityV");
+    // Only saved by super-individual runs (all other fish have weight 1)
+    netCDF::NcVar weight = sourceFile.getVar("weight");
     this->individuals.clear();
     std::vector<size_t> idxVec{0U};
     for (size_t id = 0; id < N; ++id) {
@@ -709,6 +1198,9 @@ void Model::loadState(std::string loadPath) {
         lastFlowSpeed.getVar(idxVec, &f.lastFlowSpeed_old);
         lastFlowVelocityU.getVar(idxVec, &f.lastFlowVelocity.u);
         lastFlowVelocityV.getVar(idxVec, &f.lastFlowVelocity.v);
+        if (!weight.isNull()) {
+            weight.getVar(idxVec, &f.weight);
+        }
     }
 
     this->populationHistory.clear();
@@ -742,36 +1234,16 @@ void Model::loadState(std::string loadPath) {
                                          sampleMeanMassDummy, sampleMeanLengthDummy, sampleMeanSpawnTimeDummy);
     }
 
-    this->monitoringHistory.clear();
     this->monitoringPoints.clear();
     size_t numMonitoringPoints = sourceFile.getDim("monitoringPoints").getSize();
-    std::vector<size_t> idxVec2{0U, 0U};
-    netCDF::NcVar monitoringPointIDs = sourceFile.getVar("monitoringPointIDs");
-    netCDF::NcVar monitoringPopulation = sourceFile.getVar("monitoringPopulation");
-    netCDF::NcVar monitoringPopulationDensity = sourceFile.getVar("monitoringPopulationDensity");
-    netCDF::NcVar monitoringDepth = sourceFile.getVar("monitoringDepth");
-    netCDF::NcVar monitoringTemp = sourceFile.getVar("monitoringTemp");
-    int monitoringPointIDDummy;
-    int monitoringPopulationDummy;
-    float monitoringPopulationDensityDummy;
-    float monitoringDepthDummy;
-    float monitoringTempDummy;
-    for (size_t i = 0; i < numMonitoringPoints; ++i) {
-        idxVec2[0] = i;
-        idxVec[0] = i;
-        monitoringPointIDs.getVar(idxVec, &monitoringPointIDDummy);
-        this->monitoringPoints.push_back(this->map[monitoringPointIDDummy]);
-        this->monitoringHistory.emplace_back();
-        for (size_t t = 0; t < populationHistoryLength; ++t) {
-            idxVec2[1] = t;
-            monitoringPopulation.getVar(idxVec2, &monitoringPopulationDummy);
-            monitoringPopulationDensity.getVar(idxVec2, &monitoringPopulationDensityDummy);
-            monitoringDepth.getVar(idxVec2, &monitoringDepthDummy);
-            monitoringTemp.getVar(idxVec2, &monitoringTempDummy);
-            this->monitoringHistory[i].emplace_back((size_t)
-                monitoringPopulationDummy, monitoringPopulationDensityDummy, monitoringDepthDummy, monitoringTempDummy);
-        }
+    std::vector<int> monitoringPointIDsIn(numMonitoringPoints);
+    if (numMonitoringPoints > 0) {
+        sourceFile.getVar("monitoringPointIDs").getVar(monitoringPointIDsIn.data());
+    }
+    for (int id : monitoringPointIDsIn) {
+        this->monitoringPoints.push_back(this->map[id]);
     }
+    this->monitoringHistory.load(sourceFile, numMonitoringPoints, populationHistoryLength);
 
     // Set up the tracker values (density & current recruit plan) that weren't saved
     this->planRecruitment();
@@ -781,17 +1253,27 @@ void Model::loadState(std::string loadPath) {
 
 // Write a summary of all individuals' vital statistics to the provided filename
 void Model::saveSummary(std::string savePath) {
-    netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    // If the monitoring history is being streamed to this file, its rows are already there, so the
+    // stream is closed and the rest of the summary is added to the file instead of replacing it
+    bool appendToStream = savePath == this->monitoringHistory.getStreamPath();
+    if (appendToStream && !this->monitoringHistory.isStreaming()) {
+        throw std::runtime_error("Summary already saved to monitoring stream file " + savePath);
+    }
+    this->monitoringHistory.finishStream();
+    netCDF::NcFile targetFile(savePath, appendToStream ? netCDF::NcFile::FileMode::write : netCDF::NcFile::FileMode::replace);
+    NcStorageOptions storage = NcStorageOptions::parse(this->configMap.getString(ModelParamKey::SummaryStorage));
     size_t N = this->individuals.size();
-    int *recruitTimeOut = new int[N];
-    int *exitTimeOut = new int[N];
-    float *entryForkLengthOut = new float[N];
-    float *entryMassOut = new float[N];
-    float *finalForkLengthOut = new float[N];
-    float *finalMassOut = new float[N];
-    int *finalStatusOut = new int[N];
+    std::vector<int> recruitTimeOut(N);
+    std::vector<int> exitTimeOut(N);
+    std::vector<float> entryForkLengthOut(N);
+    std::vector<float> entryMassOut(N);
+    std::vector<float> finalForkLengthOut(N);
+    std::vector<float> finalMassOut(N);
+    std::vector<int> finalStatusOut(N);
+    std::vector<float> weightOut(N);
     for (size_t n = 0; n < N; ++n) {
         Fish &f = this->individuals[n];
+        weightOut[n] = f.weight;
         recruitTimeOut[n] = f.spawnTime;
         exitTimeOut[n] = f.exitTime;
         entryForkLengthOut[n] = f.entryForkLength;
@@ -803,6 +1285,30 @@ void Model::saveSummary(std::string savePath) {
     netCDF::NcDim nDim = targetFile.addDim("n", N);
     std::vector<netCDF::NcDim> dims;
     dims.push_back(nDim);
+
+    netCDF::NcVar recruitTime = addStoredVar(targetFile, "recruitTime", netCDF::ncInt, dims, storage);
+    recruitTime.putVar(recruitTimeOut.data());
+    netCDF::NcVar exitTime = addStoredVar(targetFile, "exitTime", netCDF::ncInt, dims, storage);
+    exitTime.putVar(exitTimeOut.data());
+    netCDF::NcVar entryForkLength = addStoredVar(targetFile, "entryForkLength", netCDF::ncFloat, dims, storage);
+    entryForkLength.putVar(entryForkLengthOut.data());
+    netCDF::NcVar entryMass = addStoredVar(targetFile, "entryMass", netCDF::ncFloat, dims, storage);
+    entryMass.putVar(entryMassOut.data());
+    netCDF::NcVar finalForkLength = addStoredVar(targetFile, "finalForkLength", netCDF::ncFloat, dims, storage);
+    finalForkLength.putVar(finalForkLengthOut.data());
+    netCDF::NcVar finalMass = addStoredVar(targetFile, "finalMass", netCDF::ncFloat, dims, storage);
+    finalMass.putVar(finalMassOut.data());
+    netCDF::NcVar finalStatus = addStoredVar(targetFile, "finalStatus", netCDF::ncInt, dims, storage);
+    finalStatus.putVar(finalStatusOut.data());
+    // Fish per agent (super-individual runs only)
+    if (this->hasWeightedAgents()) {
+        netCDF::NcVar weight = addStoredVar(targetFile, "weight", netCDF::ncFloat, dims, storage);
+        weight.putVar(weightOut.data());
+    }
+
+    if (appendToStream) {
+        return;
+    }
     std::vector<netCDF::NcDim> monitoringDims;
     netCDF::NcDim monitoringPoints = targetFile.addDim("monitoringPoints", this->monitoringPoints.size());
     netCDF::NcDim historyLength = targetFile.addDim("historyLength", this->populationHistory.size());
@@ -810,51 +1316,75 @@ void Model::saveSummary(std::string savePath) {
     monitoringDims.push_back(historyLength);
     std::vector<netCDF::NcDim> monitoringPointsDims;
     monitoringPointsDims.push_back(monitoringPoints);
-
-    netCDF::NcVar recruitTime = targetFile.addVar("recruitTime", netCDF::ncInt, dims);
-    recruitTime.putVar(recruitTimeOut);
-    netCDF::NcVar exitTime = targetFile.addVar("exitTime", netCDF::ncInt, dims);
-    exitTime.putVar(exitTimeOut);
-    netCDF::NcVar entryForkLength = targetFile.addVar("entryForkLength", netCDF::ncFloat, dims);
-    entryForkLength.putVar(entryForkLengthOut);
-    netCDF::NcVar entryMass = targetFile.addVar("entryMass", netCDF::ncFloat, dims);
-    entryMass.putVar(entryMassOut);
-    netCDF::NcVar finalForkLength = targetFile.addVar("finalForkLength", netCDF::ncFloat, dims);
-    finalForkLength.putVar(finalForkLengthOut);
-    netCDF::NcVar finalMass = targetFile.addVar("finalMass", netCDF::ncFloat, dims);
-    finalMass.putVar(finalMassOut);
-    netCDF::NcVar finalStatus = targetFile.addVar("finalStatus", netCDF::ncInt, dims);
-    finalStatus.putVar(finalStatusOut);
-
-    int *monitoringPopulationOut = new int[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringPopulationDensityOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringDepthOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    float *monitoringTempOut = new float[this->monitoringPoints.size() * this->populationHistory.size()];
-    int *monitoringPointsOut = new int[this->monitoringPoints.size()];
+    std::vector<int> monitoringPointsOut(this->monitoringPoints.size());
     for (size_t i = 0; i < this->monitoringPoints.size(); ++i) {
         monitoringPointsOut[i] = this->monitoringPoints[i]->id;
-        for (size_t t = 0; t < this->populationHistory.size(); ++t) {
-            monitoringPopulationOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].population;
-            monitoringPopulationDensityOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].populationDensity;
-            monitoringDepthOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].depth;
-            monitoringTempOut[i * this->populationHistory.size() + t] = this->monitoringHistory[i][t].temp;
-        }
     }
+    this->monitoringHistory.write(targetFile, monitoringDims, storage);
+    netCDF::NcVar monitoringPointIDs = addStoredVar(targetFile, "monitoringPointIDs", netCDF::ncInt, monitoringPointsDims, storage);
+    monitoringPointIDs.putVar(monitoringPointsOut.data());
+}
 
-    netCDF::NcVar monitoringPopulation = targetFile.addVar("monitoringPopulation", netCDF::ncInt, monitoringDims);
-    monitoringPopulation.putVar(monitoringPopulationOut);
-    netCDF::NcVar monitoringPopulationDensity = targetFile.addVar("monitoringPopulationDensity", netCDF::ncFloat, monitoringDims);
-    monitoringPopulationDensity.putVar(monitoringPopulationDensityOut);
-    netCDF::NcVar monitoringDepth = targetFile.addVar("monitoringDepth", netCDF::ncFloat, monitoringDims);
-    monitoringDepth.putVar(monitoringDepthOut);
-    netCDF::NcVar monitoringTemp = targetFile.addVar("monitoringTemp", netCDF::ncFloat, monitoringDims);
-    monitoringTemp.putVar(monitoringTempOut);
-    netCDF::NcVar monitoringPointIDs = targetFile.addVar("monitoringPointIDs", netCDF::ncInt, monitoringPointsDims);
-    monitoringPointIDs.putVar(monitoringPointsOut);
+void Model::streamMonitoring(const std::string &savePath) {
+    NcStorageOptions storage = NcStorageOptions::parse(this->configMap.getString(ModelParamKey::SummaryStorage));
+    size_t flushInterval = (size_t) this->configMap.getInt(ModelParamKey::MonitoringFlushInterval);
+    this->monitoringHistory.streamTo(savePath, flushInterval, this->monitoringPoints, storage);
 }
 
+void Model::reserveHistory(size_t timesteps) {
+    this->populationHistory.reserve(timesteps);
+    this->monitoringHistory.reserve(timesteps);
+}
+
+// The samples' size distributions as flat row-major arrays ([sample][bin], [sample][quantile] and
+// [sample][centroid], with unused centroids zero-weighted), as written by saveSampleData and
+// saveSampleDataColumnar
+typedef struct SampleSizeColumns {
+    static inline const std::vector<float> QUANTILES = {0.05f, 0.1f, 0.25f, 0.5f, 0.75f, 0.9f, 0.95f};
+    size_t centroids;
+    std::vector<float> lengthBinLow, massBinLow;
+    std::vector<float> lengthHistogram, massHistogram;
+    std::vector<float> lengthQuantiles, massQuantiles;
+    std::vector<float> lengthDigestMean, lengthDigestWeight, massDigestMean, massDigestWeight;
+
+    explicit SampleSizeColumns(const std::vector<Sample> &samples) : centroids(TDigest().capacity()) {
+        for (size_t b = 0; b < SizeSketch::LENGTH_BINS; ++b) {
+            lengthBinLow.push_back(SizeSketch::LENGTH_BIN_LOW + SizeSketch::LENGTH_BIN_WIDTH * (float) b);
+        }
+        for (size_t b = 0; b < SizeSketch::MASS_BINS; ++b) {
+            massBinLow.push_back(SizeSketch::MASS_BIN_LOW + SizeSketch::MASS_BIN_WIDTH * (float) b);
+        }
+        lengthDigestMean.assign(samples.size() * centroids, 0.0f);
+        lengthDigestWeight.assign(samples.size() * centroids, 0.0f);
+        massDigestMean.assign(samples.size() * centroids, 0.0f);
+        massDigestWeight.assign(samples.size() * centroids, 0.0f);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const SizeSketch &sizes = samples[i].sizes;
+            const std::vector<float> &lengthCounts = sizes.lengthHistogram.getCounts();
+            const std::vector<float> &massCounts = sizes.massHistogram.getCounts();
+            lengthHistogram.insert(lengthHistogram.end(), lengthCounts.begin(), lengthCounts.end());
+            massHistogram.insert(massHistogram.end(), massCounts.begin(), massCounts.end());
+            for (float q : QUANTILES) {
+                lengthQuantiles.push_back(sizes.lengthDigest.quantile(q));
+                massQuantiles.push_back(sizes.massDigest.quantile(q));
+            }
+            const std::vector<Centroid> &lengthCentroids = sizes.lengthDigest.getCentroids();
+            for (size_t c = 0; c < lengthCentroids.size() && c < centroids; ++c) {
+                lengthDigestMean[i * centroids + c] = lengthCentroids[c].mean;
+                lengthDigestWeight[i * centroids + c] = lengthCentroids[c].weight;
+            }
+            const std::vector<Centroid> &massCentroids = sizes.massDigest.getCentroids();
+            for (size_t c = 0; c < massCentroids.size() && c < centroids; ++c) {
+                massDigestMean[i * centroids + c] = massCentroids[c].mean;
+                massDigestWeight[i * centroids + c] = massCentroids[c].weight;
+            }
+        }
+    }
+} SampleSizeColumns;
+
 void Model::saveSampleData(std::string savePath) {
     netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    NcStorageOptions storage = NcStorageOptions::parse(this->configMap.getString(ModelParamKey::SampleDataStorage));
     // Add dimensions
     std::vector<netCDF::NcDim> noDims;
     netCDF::NcDim sampleHistoryLength = targetFile.addDim("sampleHistoryLength", this->sampleHistory.size());
@@ -862,12 +1392,12 @@ void Model::saveSampleData(std::string savePath) {
     sampleHistoryDims.push_back(sampleHistoryLength);
 
     // Write sample history
-    int *sampleSiteIDOut = new int[this->sampleHistory.size()];
-    int *sampleTimeOut = new int[this->sampleHistory.size()];
-    int *samplePopOut = new int[this->sampleHistory.size()];
-    float *sampleMeanMassOut = new float[this->sampleHistory.size()];
-    float *sampleMeanLengthOut = new float[this->sampleHistory.size()];
-    float *sampleMeanSpawnTimeOut = new float[this->sampleHistory.size()];
+    std::vector<int> sampleSiteIDOut(this->sampleHistory.size());
+    std::vector<int> sampleTimeOut(this->sampleHistory.size());
+    std::vector<int> samplePopOut(this->sampleHistory.size());
+    std::vector<float> sampleMeanMassOut(this->sampleHistory.size());
+    std::vector<float> sampleMeanLengthOut(this->sampleHistory.size());
+    std::vector<float> sampleMeanSpawnTimeOut(this->sampleHistory.size());
     for (size_t i = 0; i < this->sampleHistory.size(); ++i) {
         sampleSiteIDOut[i] = this->sampleHistory[i].siteID;
         sampleTimeOut[i] = this->sampleHistory[i].time;
@@ -876,18 +1406,113 @@ void Model::saveSampleData(std::string savePath) {
         sampleMeanLengthOut[i] = this->sampleHistory[i].meanLength;
         sampleMeanSpawnTimeOut[i] = this->sampleHistory[i].meanSpawnTime;
     }
-    netCDF::NcVar sampleSiteID = targetFile.addVar("sampleSiteID", netCDF::ncInt, sampleHistoryDims);
-    sampleSiteID.putVar(sampleSiteIDOut);
-    netCDF::NcVar sampleTime = targetFile.addVar("sampleTime", netCDF::ncInt, sampleHistoryDims);
-    sampleTime.putVar(sampleTimeOut);
-    netCDF::NcVar samplePop = targetFile.addVar("samplePop", netCDF::ncInt, sampleHistoryDims);
-    samplePop.putVar(samplePopOut);
-    netCDF::NcVar sampleMeanMass = targetFile.addVar("sampleMeanMass", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanMass.putVar(sampleMeanMassOut);
-    netCDF::NcVar sampleMeanLength = targetFile.addVar("sampleMeanLength", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanLength.putVar(sampleMeanLengthOut);
-    netCDF::NcVar sampleMeanSpawnTime = targetFile.addVar("sampleMeanSpawnTime", netCDF::ncFloat, sampleHistoryDims);
-    sampleMeanSpawnTime.putVar(sampleMeanSpawnTimeOut);
+    netCDF::NcVar sampleSiteID = addStoredVar(targetFile, "sampleSiteID", netCDF::ncInt, sampleHistoryDims, storage);
+    sampleSiteID.putVar(sampleSiteIDOut.data());
+    netCDF::NcVar sampleTime = addStoredVar(targetFile, "sampleTime", netCDF::ncInt, sampleHistoryDims, storage);
+    sampleTime.putVar(sampleTimeOut.data());
+    netCDF::NcVar samplePop = addStoredVar(targetFile, "samplePop", netCDF::ncInt, sampleHistoryDims, storage);
+    samplePop.putVar(samplePopOut.data());
+    netCDF::NcVar sampleMeanMass = addStoredVar(targetFile, "sampleMeanMass", netCDF::ncFloat, sampleHistoryDims, storage);
+    sampleMeanMass.putVar(sampleMeanMassOut.data());
+    netCDF::NcVar sampleMeanLength = addStoredVar(targetFile, "sampleMeanLength", netCDF::ncFloat, sampleHistoryDims, storage);
+    sampleMeanLength.putVar(sampleMeanLengthOut.data());
+    netCDF::NcVar sampleMeanSpawnTime = addStoredVar(targetFile, "sampleMeanSpawnTime", netCDF::ncFloat, sampleHistoryDims, storage);
+    sampleMeanSpawnTime.putVar(sampleMeanSpawnTimeOut.data());
+
+    // Size distributions
+    SampleSizeColumns sizes(this->sampleHistory);
+    netCDF::NcDim lengthBins = targetFile.addDim("lengthBins", SizeSketch::LENGTH_BINS);
+    netCDF::NcDim massBins = targetFile.addDim("massBins", SizeSketch::MASS_BINS);
+    netCDF::NcDim digestCentroids = targetFile.addDim("digestCentroids", sizes.centroids);
+    netCDF::NcDim quantiles = targetFile.addDim("quantiles", SampleSizeColumns::QUANTILES.size());
+    addStoredVar(targetFile, "lengthBinLow", netCDF::ncFloat, {lengthBins}, storage).putVar(sizes.lengthBinLow.data());
+    addStoredVar(targetFile, "massBinLow", netCDF::ncFloat, {massBins}, storage).putVar(sizes.massBinLow.data());
+    addStoredVar(targetFile, "quantileLevels", netCDF::ncFloat, {quantiles}, storage).putVar(SampleSizeColumns::QUANTILES.data());
+    addStoredVar(targetFile, "sampleLengthHistogram", netCDF::ncFloat, {sampleHistoryLength, lengthBins}, storage)
+        .putVar(sizes.lengthHistogram.data());
+    addStoredVar(targetFile, "sampleMassHistogram", netCDF::ncFloat, {sampleHistoryLength, massBins}, storage)
+        .putVar(sizes.massHistogram.data());
+    addStoredVar(targetFile, "sampleLengthQuantiles", netCDF::ncFloat, {sampleHistoryLength, quantiles}, storage)
+        .putVar(sizes.lengthQuantiles.data());
+    addStoredVar(targetFile, "sampleMassQuantiles", netCDF::ncFloat, {sampleHistoryLength, quantiles}, storage)
+        .putVar(sizes.massQuantiles.data());
+    addStoredVar(targetFile, "sampleLengthDigestMean", netCDF::ncFloat, {sampleHistoryLength, digestCentroids}, storage)
+        .putVar(sizes.lengthDigestMean.data());
+    addStoredVar(targetFile, "sampleLengthDigestWeight", netCDF::ncFloat, {sampleHistoryLength, digestCentroids}, storage)
+        .putVar(sizes.lengthDigestWeight.data());
+    addStoredVar(targetFile, "sampleMassDigestMean", netCDF::ncFloat, {sampleHistoryLength, digestCentroids}, storage)
+        .putVar(sizes.massDigestMean.data());
+    addStoredVar(targetFile, "sampleMassDigestWeight", netCDF::ncFloat, {sampleHistoryLength, digestCentroids}, storage)
+        .putVar(sizes.massDigestWeight.data());
+}
+
+// Columns are streamed from the model's own structures, so no per-variable staging arrays are built
+void Model::saveSummaryColumnar(const std::string &savePath) {
+    ColumnarWriter out(savePath);
+    const uint64_t N = this->individuals.size();
+    const uint64_t P = this->monitoringPoints.size();
+    out.writeColumnFrom<int>("recruitTime", {N}, [this](size_t n) { return (int) this->individuals[n].spawnTime; });
+    out.writeColumnFrom<int>("exitTime", {N}, [this](size_t n) { return (int) this->individuals[n].exitTime; });
+    out.writeColumnFrom<float>("entryForkLength", {N}, [this](size_t n) { return this->individuals[n].entryForkLength; });
+    out.writeColumnFrom<float>("entryMass", {N}, [this](size_t n) { return this->individuals[n].entryMass; });
+    out.writeColumnFrom<float>("finalForkLength", {N}, [this](size_t n) { return this->individuals[n].forkLength; });
+    out.writeColumnFrom<float>("finalMass", {N}, [this](size_t n) { return this->individuals[n].mass; });
+    out.writeColumnFrom<int>("finalStatus", {N}, [this](size_t n) { return (int) this->individuals[n].status; });
+    if (this->hasWeightedAgents()) {
+        out.writeColumnFrom<float>("weight", {N}, [this](size_t n) { return this->individuals[n].weight; });
+    }
+
+    // Monitoring columns are time-major ([historyLength][monitoringPoints]), the history's own
+    // layout, so each block of rows is copied straight through
+    const uint64_t H = this->monitoringHistory.getNumTimesteps();
+    out.beginColumn<int>("monitoringPopulation", {H, P});
+    this->monitoringHistory.forEachBlock([&](size_t, size_t count, const int *p, const float *, const float *, const float *) {
+        out.append(p, count * P);
+    });
+    out.endColumn();
+    out.beginColumn<float>("monitoringPopulationDensity", {H, P});
+    this->monitoringHistory.forEachBlock([&](size_t, size_t count, const int *, const float *d, const float *, const float *) {
+        out.append(d, count * P);
+    });
+    out.endColumn();
+    out.beginColumn<float>("monitoringDepth", {H, P});
+    this->monitoringHistory.forEachBlock([&](size_t, size_t count, const int *, const float *, const float *z, const float *) {
+        out.append(z, count * P);
+    });
+    out.endColumn();
+    out.beginColumn<float>("monitoringTemp", {H, P});
+    this->monitoringHistory.forEachBlock([&](size_t, size_t count, const int *, const float *, const float *, const float *c) {
+        out.append(c, count * P);
+    });
+    out.endColumn();
+    out.writeColumnFrom<int>("monitoringPointIDs", {P}, [this](size_t i) { return this->monitoringPoints[i]->id; });
+    out.close();
+}
+
+void Model::saveSampleDataColumnar(const std::string &savePath) {
+    ColumnarWriter out(savePath);
+    const uint64_t S = this->sampleHistory.size();
+    out.writeColumnFrom<int>("sampleSiteID", {S}, [this](size_t i) { return (int) this->sampleHistory[i].siteID; });
+    out.writeColumnFrom<int>("sampleTime", {S}, [this](size_t i) { return (int) this->sampleHistory[i].time; });
+    out.writeColumnFrom<int>("samplePop", {S}, [this](size_t i) { return (int) this->sampleHistory[i].population; });
+    out.writeColumnFrom<float>("sampleMeanMass", {S}, [this](size_t i) { return this->sampleHistory[i].meanMass; });
+    out.writeColumnFrom<float>("sampleMeanLength", {S}, [this](size_t i) { return this->sampleHistory[i].meanLength; });
+    out.writeColumnFrom<float>("sampleMeanSpawnTime", {S}, [this](size_t i) { return this->sampleHistory[i].meanSpawnTime; });
+    SampleSizeColumns sizes(this->sampleHistory);
+    const uint64_t Q = SampleSizeColumns::QUANTILES.size();
+    const uint64_t C = sizes.centroids;
+    out.writeColumn("lengthBinLow", {SizeSketch::LENGTH_BINS}, sizes.lengthBinLow.data());
+    out.writeColumn("massBinLow", {SizeSketch::MASS_BINS}, sizes.massBinLow.data());
+    out.writeColumn("quantileLevels", {Q}, SampleSizeColumns::QUANTILES.data());
+    out.writeColumn("sampleLengthHistogram", {S, SizeSketch::LENGTH_BINS}, sizes.lengthHistogram.data());
+    out.writeColumn("sampleMassHistogram", {S, SizeSketch::MASS_BINS}, sizes.massHistogram.data());
+    out.writeColumn("sampleLengthQuantiles", {S, Q}, sizes.lengthQuantiles.data());
+    out.writeColumn("sampleMassQuantiles", {S, Q}, sizes.massQuantiles.data());
+    out.writeColumn("sampleLengthDigestMean", {S, C}, sizes.lengthDigestMean.data());
+    out.writeColumn("sampleLengthDigestWeight", {S, C}, sizes.lengthDigestWeight.data());
+    out.writeColumn("sampleMassDigestMean", {S, C}, sizes.massDigestMean.data());
+    out.writeColumn("sampleMassDigestWeight", {S, C}, sizes.massDigestWeight.data());
+    out.close();
 }
 
 // void Model::saveNodeIdMapping(const std::string &nodeIdMappingPath) {
@@ -936,6 +1561,25 @@ void Model::saveHydroMapping(const std::string &hydroMappingCsvPath) const {
     hydroMapOutFile.close();
 }
 
+void Model::saveMapCoarsening(const std::string &csvPath) const {
+    std::ofstream out(csvPath);
+    if (!out) {
+        std::cerr << "Error opening file for writing: " << csvPath << std::endl;
+        return;
+    }
+    // Share of its coarse location's area each fine location makes up (for projecting counts back)
+    std::unordered_map<int, double> coarseAreas;
+    for (size_t i = 0; i < this->mapCoarsening.fineIds.size(); ++i) {
+        coarseAreas[this->mapCoarsening.coarseIds[i]] += this->mapCoarsening.fineAreas[i];
+    }
+    out << "fine_node_ID,coarse_node_ID,area_fraction" << std::endl;
+    for (size_t i = 0; i < this->mapCoarsening.fineIds.size(); ++i) {
+        double area = coarseAreas[this->mapCoarsening.coarseIds[i]];
+        out << this->mapCoarsening.fineIds[i] << "," << this->mapCoarsening.coarseIds[i] << ","
+            << (area > 0.0 ? this->mapCoarsening.fineAreas[i] / area : 0.0) << std::endl;
+    }
+}
+
 // Set the proportion of recruits that should be tagged for full life history recording
 void Model::setRecruitTagRate(float rate) { this->recruitTagRate = rate; }
 
@@ -948,6 +1592,7 @@ void Model::saveTaggedHistories(std::string savePath) {
     std::cout << "In saveTaggedHistories" << std::endl;
 
     netCDF::NcFile targetFile(savePath, netCDF::NcFile::FileMode::replace);
+    NcStorageOptions storage = NcStorageOptions::parse(this->configMap.getString(ModelParamKey::TaggedHistoryStorage));
 
     std::vector<size_t> taggedFish;
     for (size_t i = 0; i < this->individuals.size(); ++i) {
@@ -959,23 +1604,23 @@ void Model::saveTaggedHistories(std::string savePath) {
     size_t N = taggedFish.size();
     long T = this->time + 1;
     std::cout << std::endl << "Values for N: " << N << ", and T: " << T << std::endl;
-    int *recruitTimeOut = new int[N];
-    int *taggedTimeOut = new int[N];
-    int *exitTimeOut = new int[N];
-    float *entryForkLengthOut = new float[N];
-    float *entryMassOut = new float[N];
-    float *finalForkLengthOut = new float[N];
-    float *finalMassOut = new float[N];
-    int *finalStatusOut = new int[N];
-    int *locationHistoryOut = new int[N * T];
-    float *growthHistoryOut = new float[N * T];
-    float *pmaxHistoryOut = new float[N * T];
-    float *mortalityHistoryOut = new float[N * T];
-    float *tempHistoryOut = new float[N * T];
-    float *depthHistoryOut = new float[N * T];
-    float *flowSpeedHistoryOut = new float[N * T];
-    float *flowVelocityUHistoryOut = new float[N * T];
-    float *flowVelocityVHistoryOut = new float[N * T];
+    std::vector<int> recruitTimeOut(N);
+    std::vector<int> taggedTimeOut(N);
+    std::vector<int> exitTimeOut(N);
+    std::vector<float> entryForkLengthOut(N);
+    std::vector<float> entryMassOut(N);
+    std::vector<float> finalForkLengthOut(N);
+    std::vector<float> finalMassOut(N);
+    std::vector<int> finalStatusOut(N);
+    std::vector<int> locationHistoryOut(N * T);
+    std::vector<float> growthHistoryOut(N * T);
+    std::vector<float> pmaxHistoryOut(N * T);
+    std::vector<float> mortalityHistoryOut(N * T);
+    std::vector<float> tempHistoryOut(N * T);
+    std::vector<float> depthHistoryOut(N * T);
+    std::vector<float> flowSpeedHistoryOut(N * T);
+    std::vector<float> flowVelocityUHistoryOut(N * T);
+    std::vector<float> flowVelocityVHistoryOut(N * T);
     std::cout << std::endl << "N: " << N << ",   T: " << T << std::endl;
 
     for (size_t n = 0; n < N; ++n) {
@@ -1043,151 +1688,196 @@ void Model::saveTaggedHistories(std::string savePath) {
     dimsNT.push_back(nDim);
     dimsNT.push_back(tDim);
 
-    netCDF::NcVar recruitTime = targetFile.addVar("recruitTime", netCDF::ncInt, dimsN);
-    recruitTime.putVar(recruitTimeOut);
-    netCDF::NcVar taggedTime = targetFile.addVar("taggedTime", netCDF::ncInt, dimsN);
-    taggedTime.putVar(taggedTimeOut);
-    netCDF::NcVar exitTime = targetFile.addVar("exitTime", netCDF::ncInt, dimsN);
-    exitTime.putVar(exitTimeOut);
-    netCDF::NcVar entryForkLength = targetFile.addVar("entryForkLength", netCDF::ncFloat, dimsN);
-    entryForkLength.putVar(entryForkLengthOut);
-    netCDF::NcVar entryMass = targetFile.addVar("entryMass", netCDF::ncFloat, dimsN);
-    entryMass.putVar(entryMassOut);
-    netCDF::NcVar finalForkLength = targetFile.addVar("finalForkLength", netCDF::ncFloat, dimsN);
-    finalForkLength.putVar(finalForkLengthOut);
-    netCDF::NcVar finalMass = targetFile.addVar("finalMass", netCDF::ncFloat, dimsN);
-    finalMass.putVar(finalMassOut);
-    netCDF::NcVar finalStatus = targetFile.addVar("finalStatus", netCDF::ncInt, dimsN);
-    finalStatus.putVar(finalStatusOut);
-    netCDF::NcVar locationHistory = targetFile.addVar("locationHistory", netCDF::ncInt, dimsNT);
-    locationHistory.putVar(locationHistoryOut);
-    netCDF::NcVar growthHistory = targetFile.addVar("growthHistory", netCDF::ncFloat, dimsNT);
-    growthHistory.putVar(growthHistoryOut);
-    netCDF::NcVar pmaxHistory = targetFile.addVar("pmaxHistory", netCDF::ncFloat, dimsNT);
-    pmaxHistory.putVar(pmaxHistoryOut);
-    netCDF::NcVar mortalityHistory = targetFile.addVar("mortalityHistory", netCDF::ncFloat, dimsNT);
-    mortalityHistory.putVar(mortalityHistoryOut);
-    netCDF::NcVar tempHistory = targetFile.addVar("tempHistory", netCDF::ncFloat, dimsNT);
-    tempHistory.putVar(tempHistoryOut);
-    netCDF::NcVar depthHistory = targetFile.addVar("depthHistory", netCDF::ncFloat, dimsNT);
-    depthHistory.putVar(depthHistoryOut);
-    netCDF::NcVar flowSpeedHistory = targetFile.addVar("flowSpeedHistory", netCDF::ncFloat, dimsNT);
-    flowSpeedHistory.putVar(flowSpeedHistoryOut);
-    netCDF::NcVar flowVelocityUHistory = targetFile.addVar("flowVelocityUHistory", netCDF::ncFloat, dimsNT);
-    flowVelocityUHistory.putVar(flowVelocityUHistoryOut);
-    netCDF::NcVar flowVelocityVHistory = targetFile.addVar("flowVelocityVHistory", netCDF::ncFloat, dimsNT);
-    flowVelocityVHistory.putVar(flowVelocityVHistoryOut);
+    netCDF::NcVar recruitTime = addStoredVar(targetFile, "recruitTime", netCDF::ncInt, dimsN, storage);
+    recruitTime.putVar(recruitTimeOut.data());
+    netCDF::NcVar taggedTime = addStoredVar(targetFile, "taggedTime", netCDF::ncInt, dimsN, storage);
+    taggedTime.putVar(taggedTimeOut.data());
+    netCDF::NcVar exitTime = addStoredVar(targetFile, "exitTime", netCDF::ncInt, dimsN, storage);
+    exitTime.putVar(exitTimeOut.data());
+    netCDF::NcVar entryForkLength = addStoredVar(targetFile, "entryForkLength", netCDF::ncFloat, dimsN, storage);
+    entryForkLength.putVar(entryForkLengthOut.data());
+    netCDF::NcVar entryMass = addStoredVar(targetFile, "entryMass", netCDF::ncFloat, dimsN, storage);
+    entryMass.putVar(entryMassOut.data());
+    netCDF::NcVar finalForkLength = addStoredVar(targetFile, "finalForkLength", netCDF::ncFloat, dimsN, storage);
+    finalForkLength.putVar(finalForkLengthOut.data());
+    netCDF::NcVar finalMass = addStoredVar(targetFile, "finalMass", netCDF::ncFloat, dimsN, storage);
+    finalMass.putVar(finalMassOut.data());
+    netCDF::NcVar finalStatus = addStoredVar(targetFile, "finalStatus", netCDF::ncInt, dimsN, storage);
+    finalStatus.putVar(finalStatusOut.data());
+    netCDF::NcVar locationHistory = addStoredVar(targetFile, "locationHistory", netCDF::ncInt, dimsNT, storage);
+    locationHistory.putVar(locationHistoryOut.data());
+    netCDF::NcVar growthHistory = addStoredVar(targetFile, "growthHistory", netCDF::ncFloat, dimsNT, storage);
+    growthHistory.putVar(growthHistoryOut.data());
+    netCDF::NcVar pmaxHistory = addStoredVar(targetFile, "pmaxHistory", netCDF::ncFloat, dimsNT, storage);
+    pmaxHistory.putVar(pmaxHistoryOut.data());
+    netCDF::NcVar mortalityHistory = addStoredVar(targetFile, "mortalityHistory", netCDF::ncFloat, dimsNT, storage);
+    mortalityHistory.putVar(mortalityHistoryOut.data());
+    netCDF::NcVar tempHistory = addStoredVar(targetFile, "tempHistory", netCDF::ncFloat, dimsNT, storage);
+    tempHistory.putVar(tempHistoryOut.data());
+    netCDF::NcVar depthHistory = addStoredVar(targetFile, "depthHistory", netCDF::ncFloat, dimsNT, storage);
+    depthHistory.putVar(depthHistoryOut.data());
+    netCDF::NcVar flowSpeedHistory = addStoredVar(targetFile, "flowSpeedHistory", netCDF::ncFloat, dimsNT, storage);
+    flowSpeedHistory.putVar(flowSpeedHistoryOut.data());
+    netCDF::NcVar flowVelocityUHistory = addStoredVar(targetFile, "flowVelocityUHistory", netCDF::ncFloat, dimsNT, storage);
+    flowVelocityUHistory.putVar(flowVelocityUHistoryOut.data());
+    netCDF::NcVar flowVelocityVHistory = addStoredVar(targetFile, "flowVelocityVHistory", netCDF::ncFloat, dimsNT, storage);
+    flowVelocityVHistory.putVar(flowVelocityVHistoryOut.data());
 }
 
 void Model::loadTaggedHistories(std::string loadPath) {
     this->reset();
-    netCDF::NcFile sourceFile(loadPath, netCDF::NcFile::FileMode::read);
-    size_t N = sourceFile.getDim("n").getSize();
-    long T = sourceFile.getDim("t").getSize();
-    long recruitTimeDummy;
-    float forkLengthDummy;
-    long locationDummy;
-    int statusDummy;
-    float growthDummy;
-    float pmaxDummy;
-    float mortalityDummy;
-    float tempDummy;
-    float depthDummy;
-    float flowSpeedDummy;
-    FlowVelocity flowVelocityDummy;
-    netCDF::NcVar recruitTime = sourceFile.getVar("recruitTime");
-    netCDF::NcVar taggedTime = sourceFile.getVar("taggedTime");
-    netCDF::NcVar exitTime = sourceFile.getVar("exitTime");
-    netCDF::NcVar entryForkLength = sourceFile.getVar("entryForkLength");
-    netCDF::NcVar entryMass = sourceFile.getVar("entryMass");
-    netCDF::NcVar finalForkLength = sourceFile.getVar("finalForkLength");
-    netCDF::NcVar finalMass = sourceFile.getVar("finalMass");
-    netCDF::NcVar finalStatus = sourceFile.getVar("finalStatus");
-    netCDF::NcVar locationHistory = sourceFile.getVar("locationHistory");
-    netCDF::NcVar growthHistory = sourceFile.getVar("growthHistory");
-    netCDF::NcVar pmaxHistory = sourceFile.getVar("pmaxHistory");
-    netCDF::NcVar mortalityHistory = sourceFile.getVar("mortalityHistory");
-    netCDF::NcVar tempHistory = sourceFile.getVar("tempHistory");
-    netCDF::NcVar depthHistory = sourceFile.getVar("depthHistory");
-    netCDF::NcVar flowSpeedHistory = sourceFile.getVar("flowSpeedHistory");
-    netCDF::NcVar flowVelocityUHistory = sourceFile.getVar("flowVelocityUHistory");
-    netCDF::NcVar flowVelocityVHistory = sourceFile.getVar("flowVelocityVHistory");
-    this->individuals.clear();
-    std::vector<size_t> idxVecN{0U};
-    std::vector<size_t> idxVecNT{0U, 0U};
-    for (size_t id = 0; id < N; ++id) {
-        idxVecN[0] = id;
-        idxVecNT[0] = id;
-        idxVecNT[1] = T - 1;
-        recruitTime.getVar(idxVecN, &recruitTimeDummy);
-        finalForkLength.getVar(idxVecN, &forkLengthDummy);
-        finalStatus.getVar(idxVecN, &statusDummy);
-        locationHistory.getVar(idxVecNT, &locationDummy);
-        this->individuals.emplace_back(id, recruitTimeDummy, forkLengthDummy, this->map[locationDummy]);
-        Fish &f = this->individuals[id];
-        taggedTime.getVar(idxVecN, &f.taggedTime);
-        exitTime.getVar(idxVecN, &f.exitTime);
-        entryForkLength.getVar(idxVecN, &f.entryForkLength);
-        entryMass.getVar(idxVecN, &f.entryMass);
-        finalMass.getVar(idxVecN, &f.mass);
-        f.exitStatus = (FishStatus) statusDummy;
-        f.addHistoryBuffers();
-        for (long t = f.taggedTime; t < T; ++t) {
-            idxVecNT[1] = t;
-            locationHistory.getVar(idxVecNT, &locationDummy);
-            if (locationDummy == -1L) {
+    std::string replayPath = loadPath;
+    if (!ReplayStore::isReplayFile(loadPath)) {
+        // Reuse the replay file converted on an earlier load unless the histories have changed since
+        const std::vector<std::string> cachePaths = ReplayStore::cachePaths(loadPath);
+        for (const std::string &cachePath : cachePaths) {
+            std::error_code err;
+            bool upToDate = std::filesystem::exists(cachePath, err)
+                && std::filesystem::last_write_time(cachePath, err) >= std::filesystem::last_write_time(loadPath, err)
+                && !err;
+            if (!upToDate) {
+                continue;
+            }
+            try {
+                this->replayStore = std::make_unique<ReplayStore>(cachePath);
                 break;
+            } catch (std::runtime_error &e) {
+                std::cerr << e.what() << "; rebuilding it" << std::endl;
+            }
+        }
+        if (this->replayStore == nullptr) {
+            TaggedHistoryData data = ReplayStore::readTaggedHistories(loadPath);
+            // Beside the histories if possible, otherwise (e.g. a read-only data directory) in the temp directory,
+            // where the next load looks for it too
+            for (size_t i = 0; i < cachePaths.size(); ++i) {
+                try {
+                    ReplayStore::write(data, cachePaths[i]);
+                    replayPath = cachePaths[i];
+                    break;
+                } catch (std::runtime_error &e) {
+                    if (i + 1 == cachePaths.size()) {
+                        throw;
+                    }
+                    std::cerr << e.what() << "; writing " << cachePaths[i + 1] << " instead" << std::endl;
+                }
             }
-            growthHistory.getVar(idxVecNT, &growthDummy);
-            pmaxHistory.getVar(idxVecNT, &pmaxDummy);
-            mortalityHistory.getVar(idxVecNT, &mortalityDummy);
-            tempHistory.getVar(idxVecNT, &tempDummy);
-            depthHistory.getVar(idxVecNT, &depthDummy);
-            flowSpeedHistory.getVar(idxVecNT, &flowSpeedDummy);
-            flowVelocityUHistory.getVar(idxVecNT, &flowVelocityDummy.u);
-            flowVelocityVHistory.getVar(idxVecNT, &flowVelocityDummy.v);
-            f.locationHistory->push_back(locationDummy);
-            f.growthHistory->push_back(growthDummy);
-            f.pmaxHistory->push_back(pmaxDummy);
-            f.mortalityHistory->push_back(mortalityDummy);
-            f.tempHistory->push_back(tempDummy);
-            f.depthHistory->push_back(depthDummy);
-            f.flowSpeedHistory_old->push_back(flowSpeedDummy);
-            f.flowVelocityHistory->push_back(flowVelocityDummy);
         }
-        f.calculateMassHistory();
     }
+    if (this->replayStore == nullptr) {
+        this->replayStore = std::make_unique<ReplayStore>(replayPath);
+    }
+    const ReplayStore &store = *this->replayStore;
+    this->individuals.clear();
+    this->individuals.reserve(store.getNumFish());
+    for (size_t id = 0; id < store.getNumFish(); ++id) {
+        const ReplayFishInfo &info = store.getFish(id);
+        this->individuals.emplace_back(id, info.recruitTime, info.finalForkLength, this->map[info.finalLocation]);
+        Fish &f = this->individuals[id];
+        f.taggedTime = info.taggedTime;
+        f.exitTime = info.exitTime;
+        f.entryForkLength = info.entryForkLength;
+        f.entryMass = info.entryMass;
+        f.mass = info.finalMass;
+        f.exitStatus = (FishStatus) info.finalStatus;
+    }
+    this->replayTime = -1L;
+    this->setHistoryTimestep(0L);
 }
 
 void Model::setHistoryTimestep(long timestep) {
+    if (this->replayStore == nullptr) {
+        return;
+    }
+    const ReplayStore &store = *this->replayStore;
     this->time = timestep;
-    this->hydroModel.updateTime(timestep);
+    this->hydroModel.updateTime(this->getHour(), this->getHoursPerTimestep());
+
+    // Only fish whose exit time lies between the previously shown timestep and this one change exit status
+    size_t exitFrom = store.countExitedBy(std::min(this->replayTime, timestep));
+    size_t exitTo = store.countExitedBy(std::max(this->replayTime, timestep));
+    for (size_t k = exitFrom; k < exitTo; ++k) {
+        Fish &f = this->individuals[store.getExitOrder()[k]];
+        f.status = timestep >= f.exitTime ? f.exitStatus : FishStatus::Alive;
+    }
+    this->deadCount = store.getDeadCountAt(timestep);
+    this->exitedCount = store.getExitedCountAt(timestep);
+    this->replayTime = timestep;
+
+    // Clear the locations occupied at the previous timestep, then place this timestep's fish
+    std::vector<MapNode *> touchedNodes;
+    for (size_t id : this->livingIndividuals) {
+        MapNode *node = this->individuals[id].location;
+        if (!node->residentIds.empty()) {
+            node->residentIds.clear();
+            node->residentWeight = 0.0f;
+            node->maxMass = 0.0f;
+            touchedNodes.push_back(node);
+        }
+    }
     this->livingIndividuals.clear();
-    for (Fish &f: this->individuals) {
-        if (timestep >= f.taggedTime && timestep < f.taggedTime + (long) f.locationHistory->size()) {
-            f.location = this->map[(*f.locationHistory)[timestep - f.taggedTime]];
-            f.lastGrowth = (*f.growthHistory)[timestep - f.taggedTime];
-            f.lastPmax = (*f.pmaxHistory)[timestep - f.taggedTime];
-            f.lastMortality = (*f.mortalityHistory)[timestep - f.taggedTime];
-            f.lastTemp = (*f.tempHistory)[timestep - f.taggedTime];
-            f.lastDepth = (*f.depthHistory)[timestep - f.taggedTime];
-            f.lastFlowSpeed_old = (*f.flowSpeedHistory_old)[timestep - f.taggedTime];
-            f.lastFlowVelocity = (*f.flowVelocityHistory)[timestep - f.taggedTime];
-            f.status = FishStatus::Alive;
-            f.mass = (*f.massHistory)[timestep - f.taggedTime];
-            f.forkLength = (*f.forkLengthHistory)[timestep - f.taggedTime];
-            this->livingIndividuals.push_back(f.id);
-        } else if (timestep >= f.exitTime) {
-            f.status = f.exitStatus;
+    size_t begin;
+    size_t end;
+    store.getTimestepRange(timestep, begin, end);
+    const uint32_t *fishIds = store.getFishIds();
+    const int32_t *locations = store.getLocations();
+    const float *growth = store.getColumn(ReplayColumn::Growth);
+    const float *pmax = store.getColumn(ReplayColumn::Pmax);
+    const float *mortality = store.getColumn(ReplayColumn::Mortality);
+    const float *temp = store.getColumn(ReplayColumn::Temp);
+    const float *depth = store.getColumn(ReplayColumn::Depth);
+    const float *flowSpeed = store.getColumn(ReplayColumn::FlowSpeed);
+    const float *flowU = store.getColumn(ReplayColumn::FlowVelocityU);
+    const float *flowV = store.getColumn(ReplayColumn::FlowVelocityV);
+    const float *mass = store.getColumn(ReplayColumn::Mass);
+    const float *forkLength = store.getColumn(ReplayColumn::ForkLength);
+    for (size_t r = begin; r < end; ++r) {
+        Fish &f = this->individuals[fishIds[r]];
+        f.location = this->map[locations[r]];
+        f.lastGrowth = growth[r];
+        f.lastPmax = pmax[r];
+        f.lastMortality = mortality[r];
+        f.lastTemp = temp[r];
+        f.lastDepth = depth[r];
+        f.lastFlowSpeed_old = flowSpeed[r];
+        f.lastFlowVelocity.u = flowU[r];
+        f.lastFlowVelocity.v = flowV[r];
+        f.status = FishStatus::Alive;
+        f.mass = mass[r];
+        f.forkLength = forkLength[r];
+        this->livingIndividuals.push_back(f.id);
+        if (f.location->residentIds.empty()) {
+            touchedNodes.push_back(f.location);
         }
+        f.location->residentIds.push_back(f.id);
+        f.location->residentWeight += f.weight;
+        f.location->maxMass = std::max(f.location->maxMass, f.mass);
+    }
+    // A location can be listed twice if it was occupied at both timesteps
+    std::sort(touchedNodes.begin(), touchedNodes.end());
+    touchedNodes.erase(std::unique(touchedNodes.begin(), touchedNodes.end()), touchedNodes.end());
+    std::vector<FishSortDummy> residentMasses;
+    std::vector<FishSortDummy> residentArrivalTimes;
+    for (MapNode *node : touchedNodes) {
+        computeNodeStats(this->individuals, node, residentMasses, residentArrivalTimes);
     }
-    this->countAll(false);
 }
 
 int Model::getInt(ModelParamKey key) const {
     return configMap.getInt(key);
 }
 
+int Model::getHoursPerTimestep() const {
+    return configMap.getInt(ModelParamKey::HoursPerTimestep);
+}
+
+float Model::getSecondsPerTimestep() const {
+    return (float) this->getHoursPerTimestep() * SECONDS_PER_HOUR;
+}
+
+long Model::getHour() const {
+    return this->time * this->getHoursPerTimestep();
+}
+
 float Model::getFloat(ModelParamKey key) const {
     return configMap.getFloat(key);
 }
@@ -1200,6 +1890,63 @@ const ModelConfigMap& Model::getConfigMap() const {
     return configMap;
 }
 
+void Model::setConfigMap(const ModelConfigMap& config) {
+    config.validate();
+    this->configMap = config;
+    // The timestep length may have changed
+    this->hydroModel.updateTime(this->getHour(), this->getHoursPerTimestep());
+}
+
+size_t Model::getMaxThreads() const {
+    return this->maxThreads;
+}
+
+const NumaPlacement *Model::numaPlacement() {
+    const ThreadPinning pinning = parseThreadPinning(this->getString(ModelParamKey::ThreadPinning));
+    const bool interleaveHydro = this->getString(ModelParamKey::HydroPlacement) == "interleave";
+    if (pinning == ThreadPinning::Off && !interleaveHydro) {
+        this->numa.reset();
+        return nullptr;
+    }
+    if (!this->numa || this->numa->getPinning() != pinning) {
+        this->numa = std::make_unique<NumaPlacement>(detectNumaTopology(), pinning);
+        this->numaPlacedFish = nullptr;
+        this->numaHydroInterleaved = false;
+    }
+    if (interleaveHydro && !this->numaHydroInterleaved) {
+        const NumaPlacement &numa = *this->numa;
+        this->hydroModel.forEachArray([&numa](const void *data, size_t bytes) {
+            numa.interleave(data, static_cast<const char *>(data) + bytes);
+        });
+        this->numaHydroInterleaved = true;
+    }
+    return this->numa.get();
+}
+
+void Model::setDistributedStep(DistributedStep *step) {
+    this->distributedStep = step;
+}
+
+void Model::setMaxThreads(size_t threads) {
+    this->maxThreads = std::max((size_t) 1, threads);
+}
+
+bool Model::hasWeightedAgents() const {
+    return this->getInt(ModelParamKey::SuperIndividualSize) > 1 || this->getString(ModelParamKey::MovementEngine) == "density";
+}
+
+bool Model::usesCommonRandomNumbers() const {
+    return this->getInt(ModelParamKey::CommonRandomNumbers) != 0;
+}
+
+const ReachabilityIndex *Model::getReachabilityIndex() const {
+    return this->reachabilityIndex.empty() ? nullptr : &this->reachabilityIndex;
+}
+
+float Model::getMinSplitWeight() const {
+    return std::max(1.0f, (float) this->getInt(ModelParamKey::SuperIndividualSize) / 4.0f);
+}
+
 // Initialize a model instance from a JSON config file
 Model *modelFromConfig(std::string configPath) {
     FILE *fp = fopen(configPath.c_str(), "r");
@@ -1277,14 +2024,17 @@ Model *modelFromConfig(std::string configPath) {
         // Generate map from JSON config params
         std::vector<MapNode *> map;
         std::vector<MapNode *> recPoints;
+        std::unique_ptr<MapArena> mapArena = std::make_unique<MapArena>();
         generateMap(
             map, recPoints,
             d["mapParams"]["m"].GetInt(),
             d["mapParams"]["n"].GetInt(),
             d["mapParams"]["a"].GetFloat(),
             d["mapParams"]["pDist"].GetFloat(),
-            d["mapParams"]["pBlind"].GetFloat()
+            d["mapParams"]["pBlind"].GetFloat(),
+            mapArena->buildMemory()
         );
+        mapArena->compact(map, {&recPoints});
         int simLength = d["simLength"].GetInt();
         std::vector<std::vector<float> > depths;
         std::vector<std::vector<float> > temps;
@@ -1319,6 +2069,7 @@ Model *modelFromConfig(std::string configPath) {
             recCounts, recSizeDists,
             depths, temps, distFlow
         );
+        m->mapArena = std::move(mapArena);
     }
     fclose(fp);
     return m;
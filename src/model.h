@@ -1,21 +1,34 @@
 #ifndef __FISH_MODEL_H
 #define __FISH_MODEL_H
 
+#include <memory>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "fish.h"
 #include "map.h"
+#include "map_arena.h"
+#include "map_coarsen.h"
 #include "hydro.h"
 #include "model_config_map.h"
+#include "density_propagation.h"
+#include "domain_decomposition.h"
+#include "event_scheduler.h"
+#include "monitoring_history.h"
+#include "numa.h"
+#include "reachability_index.h"
+#include "replay_store.h"
+#include "size_sketch.h"
+#include "startup.h"
 
 #ifndef __FISH_FISH_CLS
 class Fish;
 #endif
+class DistributedStep;
 
 
-// This struct represents the results of a single biweekly sampling instance at a given sampling site
+// This struct represents the results of a single sampling instance at a given sampling site
 typedef struct Sample {
     // The site's ID
     size_t siteID;
@@ -30,21 +43,31 @@ typedef struct Sample {
     //float meanLogLength;
     // The mean spawn timestep of sampled fish
     float meanSpawnTime;
+    // Fork length and mass distributions of sampled fish (not kept by saveState / loadState)
+    SizeSketch sizes;
     Sample(size_t siteID, long time, size_t population, float meanMass, float meanLength, float meanSpawnTime)
         : siteID(siteID), time(time), population(population), meanMass(meanMass), meanLength(meanLength), meanSpawnTime(meanSpawnTime) {}
 } Sample;
 
-typedef struct MonitoringRecord {
-    size_t population;
-    float populationDensity;
-    float depth;
-    float temp;
-    MonitoringRecord(size_t population, float populationDensity, float depth, float temp) : population(population), populationDensity(populationDensity), depth(depth), temp(temp) {}
-} MonitoringRecord;
+// Wall-clock seconds spent in each phase of the most recent masterUpdate
+typedef struct PhaseTimings {
+    double recruit;
+    double move;
+    // Both countAll passes
+    double count;
+    double growAndDie;
+    double sampling;
+    // Population history and monitoring point records
+    double record;
+    PhaseTimings() : recruit(0.0), move(0.0), count(0.0), growAndDie(0.0), sampling(0.0), record(0.0) {}
+} PhaseTimings;
 
 class Model {
 public:
-    // List of heap-allocated map locations
+    // Holds the map's locations when they were loaded from files or generated (see map_arena.h); null for maps
+    // built location by location (as in tests), whose locations are heap-allocated
+    std::unique_ptr<MapArena> mapArena;
+    // List of map locations
     std::vector<MapNode *> map;
 
 private:
@@ -60,22 +83,27 @@ public:
     std::vector<std::vector<float>> recSizeDists;
     // Map locations at which recruits are added
     std::vector<MapNode *> recPoints;
-    // A list of per-timestep recruit counts, resampled once per day such that sum(recDayPlan) == recCounts[day]
+    // A list of per-hour recruit counts, resampled once per day such that sum(recDayPlan) == recCounts[day]
     std::vector<size_t> recDayPlan;
-    // The list of SamplingSite structs that determine where and how biweekly sampling is conducted (see SamplingSite in map.h)
+    // The list of SamplingSite structs that determine where sampling is conducted (see SamplingSite in map.h)
     std::vector<SamplingSite *> samplingSites;
+    // When and how the sampling sites are sampled (defaultSamplingSchedule() unless a samplingScheduleFile is given)
+    std::vector<SamplingCampaign> samplingCampaigns;
     // List of locations for which to track population/environmental values per timestep
     std::vector<MapNode *> monitoringPoints;
+    // Which coarse location each location of the full map was merged into (empty unless mapCoarsenTargetNodes is set)
+    MapCoarsening mapCoarsening;
+    // Each location's neighborhood for high-awareness movement (empty unless agentAwareness is "high"; see
+    // reachability_index.h)
+    ReachabilityIndex reachabilityIndex;
     // std::unordered_map<unsigned int, unsigned int> externalCsvIdToInternalId;
 
-    // Timesteps between midnight on Jan 1 and the start of the recruitment data
+    // Hours between midnight on Jan 1 and the start of the recruitment data
     int recTimeIntercept;
-    // Timesteps between midnight on Jan 1 and the timestep considered by the model to be timestep 0
+    // Hours between midnight on Jan 1 and the model's timestep 0
     int globalTimeIntercept;
-    // Whether or not a high tide has already occurred since the start of the current day
-    bool firstHighTide;
 
-    // The current timestep
+    // The current timestep (hours since the start are time * getHoursPerTimestep())
     long time;
     // The list containing all Fish instances, living, dead, and exited
     std::vector<Fish> individuals;
@@ -85,12 +113,23 @@ public:
     int deadCount;
     // The number of fish that have left the model without dying so far
     int exitedCount;
+    // Fish (rather than agents) living, dead and exited, summing Fish::weight; these equal
+    // livingIndividuals.size(), deadCount and exitedCount unless superIndividualSize > 1
+    double livingAbundance;
+    double deadAbundance;
+    double exitedAbundance;
     // The per-timestep record of living population
     std::vector<int> populationHistory;
-    // The list of biweekly sampling results
+    // The list of sampling results
     std::vector<Sample> sampleHistory;
-    // The list of per-timestep populations and environmental values for each monitoring point
-    std::vector<std::vector<MonitoringRecord>> monitoringHistory;
+    // The per-timestep populations and environmental values for each monitoring point (see monitoring_history.h)
+    MonitoringHistory monitoringHistory;
+    // Tagged fish histories being replayed (only present after loadTaggedHistories)
+    std::unique_ptr<ReplayStore> replayStore;
+    // How long each phase of the last timestep took
+    PhaseTimings lastStepTimings;
+    // How long loading the inputs took (all zero unless the model was loaded from data files)
+    StartupTimings startupTimings;
 
     // Mortality constants overridden by ABC
     float mortConstA;
@@ -137,24 +176,30 @@ public:
     // Call to advance the model state by one timestep
     void masterUpdate();
 
-    // Wraps update procedures that happen every timestep
-    void update1h();
+    // Wraps update procedures that happen every timestep (fish movement, growth and counting are skipped
+    // while there are no fish, e.g. before the first recruits)
+    void updateTimestep();
     // Wraps update procedures that happen daily
     void update24h();
-    // Calls Fish::move for every living fish and removes fish that die during this procedure from livingIndividuals
+    // Calls Fish::move for every living fish (or, with movementEngine "density", moves them as densities; see
+    // moveAllDensity) and removes fish that die during this procedure from livingIndividuals
     void moveAll();
     // Computes local population statistics, including density, median and mean mass for each location
     void countAll(bool updateTracking);
     // Calls Fish::grow for every living fish and removes fish that die during this procedure from livingIndividuals
     void growAndDieAll();
-    // Generates and adds new fish according to the current timestep's entry in recDayPlan
+    // Generates and adds new fish according to the recDayPlan entries for the current timestep's hours
     void recruit();
     // Generates and adds a single new fish
     void recruitSingle();
+    // Generates count recruits as super-individuals of up to superIndividualSize fish each
+    void recruitGrouped(size_t count, size_t superIndividualSize);
     // Resamples recDayPlan to determine per-timestep recruit counts for the next day
     void planRecruitment();
     // Computes sampling results and adds new entries to samplingHistory
     void sampling();
+    // Same, for the given sites only (positions in samplingSites; empty = every site)
+    void sampling(const std::vector<size_t> &siteIds);
     // Resets the model state
     void reset();
     // Saves model state to the provided filename
@@ -165,26 +210,58 @@ public:
     void saveSummary(std::string savePath);
     // Write all sampling results to the provided filename
     void saveSampleData(std::string savePath);
+    // Write the monitoring history to the provided filename as the run goes, every monitoringFlushInterval
+    // timesteps, instead of holding it all in memory; saveSummary to the same filename completes the file
+    void streamMonitoring(const std::string &savePath);
+    // Preallocate the per-timestep histories for a run of the given number of timesteps
+    void reserveHistory(size_t timesteps);
+    // Same contents as saveSummary / saveSampleData, written as memory-mappable columnar files (see columnar_file.h)
+    void saveSummaryColumnar(const std::string &savePath);
+    void saveSampleDataColumnar(const std::string &savePath);
     // Set the proportion of recruits that should be tagged for full life history recording
     void setRecruitTagRate(float rate);
     // Tag an individual so that its full life history is recorded
     void tagIndividual(size_t id);
     // Write the full life histories for tagged individuals to the provided filename
     void saveTaggedHistories(std::string savePath);
-    // Read individuals' life histories saved by saveTaggedHistories into the "individuals" list
-    // so that their histories can be replayed in the GUI
+    // Open life histories saved by saveTaggedHistories (or a replay file converted from them) for replay
+    // in the GUI; one fish is added to the "individuals" list per tagged fish. A NetCDF history file is
+    // converted to a replay file alongside it on first load, which later loads reuse.
     void loadTaggedHistories(std::string loadPath);
     // Set the model's timestep and update fish to reflect the data
-    // in the currently loaded life histories
+    // in the currently loaded life histories (only fish active at the old or new timestep are touched)
     void setHistoryTimestep(long timestep);
 
     // void saveNodeIdMapping(const std::string &nodeIdMappingPath);
     void saveHydroMapping(const std::string & hydroMappingCsvPath) const;
+    // Write the fine-to-coarse location mapping (only meaningful if the map was coarsened)
+    void saveMapCoarsening(const std::string &csvPath) const;
 
     int getInt(ModelParamKey key) const;
     float getFloat(ModelParamKey key) const;
+    // Length of a timestep (the hoursPerTimestep config parameter)
+    int getHoursPerTimestep() const;
+    float getSecondsPerTimestep() const;
+    // Hours from timestep 0 to the start of the current timestep
+    long getHour() const;
     std::string getString(ModelParamKey key) const;
     const ModelConfigMap& getConfigMap() const;
+    // Replace the model's parameters, e.g. before reset() for a new run on the same inputs. Only parameters
+    // read while the model runs take effect; the ones used to load the inputs were consumed at construction.
+    void setConfigMap(const ModelConfigMap& config);
+    size_t getMaxThreads() const;
+    // The smallest weight a super-individual may split into (a quarter of superIndividualSize, which
+    // bounds the number of agents per recruit group)
+    float getMinSplitWeight() const;
+    // Whether agents may stand for other than one fish (superIndividualSize > 1 or movementEngine "density")
+    bool hasWeightedAgents() const;
+    // Whether random draws are keyed by fish and step (commonRandomNumbers = 1)
+    bool usesCommonRandomNumbers() const;
+    // The map's reachability index, or null if it has none
+    const ReachabilityIndex *getReachabilityIndex() const;
+    void setMaxThreads(size_t threads);
+    // Run each step as one process of a distributed run (see distributed.h; null = a whole run)
+    void setDistributedStep(DistributedStep *step);
 
     // add addhistory from fish???
     // void addHistoryBuffers();
@@ -192,10 +269,62 @@ public:
 
 
 private:
+    // Takes over the inputs loaded for the file constructor
+    Model(
+        StartupInputs &&inputs,
+        int globalTimeIntercept,
+        int recTimeIntercept,
+        size_t maxThreads,
+        float habitatTypeExitConditionHours,
+        const ModelConfigMap &config
+    );
+
     ModelConfigMap configMap;
     unsigned long nextFishID;
     size_t maxThreads;
     float recruitTagRate;
+    // Timestep last shown by setHistoryTimestep (-1 right after loading histories)
+    long replayTime;
+    // Upcoming recruitment planning and sampling events (rebuilt whenever time moves other than by masterUpdate)
+    EventScheduler scheduler;
+    // Whether the last countAll found no living fish (so node statistics are already clear)
+    bool countedEmpty;
+    // Carry out one scheduled event in the current step
+    void handleEvent(const ScheduledEvent &event);
+    // Transition matrices for movementEngine "density" (created on first use)
+    std::unique_ptr<DensityPropagation> densityPropagation;
+    // Regions and the fish each owns for domainRegions > 0 (created on first use)
+    std::unique_ptr<DomainDecomposition> domains;
+    // The regions, if domainRegions > 0 and moveAll has handed the living fish out to them
+    DomainDecomposition *activeDomains() const;
+    // moveAll with each region's fish moved by one worker, handing fish that leave to their new region
+    void moveAllDomains();
+    // After movement, drop the fish that died or exited from the living list and add the agents split off
+    // by super-individuals (splits, in thread or region order)
+    void collectMoved(std::vector<std::vector<Fish>> &splits);
+    // After growth and mortality, drop the fish that died from the living list and total the abundances
+    void collectGrown();
+    // This process's part in a distributed run, if it's one of several (see runDistributed)
+    DistributedStep *distributedStep;
+    // Worker pinning and memory placement for threadPinning / hydroPlacement (created on first use; see numa.h)
+    std::unique_ptr<NumaPlacement> numa;
+    // The fish storage and day the workers' fish were last moved to their nodes for, and whether the
+    // hydrology has been interleaved
+    const Fish *numaPlacedFish;
+    long numaPlacedDay;
+    bool numaHydroInterleaved;
+    // The placement for the configured threadPinning and hydroPlacement, or null if neither is set
+    const NumaPlacement *numaPlacement();
+
+    /*
+    * Density movement engine: untagged fish of the same fork length class and exit habitat hours are
+    * pushed through that class's transition matrix together, and the fish arriving at each location
+    * are pooled into one agent carrying their total weight and weighted mean size, spawn time and
+    * entry size. Pooled agents reuse the IDs of the agents they came from (extra ones get new IDs; the
+    * rest are marked Merged), and pools of less than one fish are kept as one fish with probability
+    * equal to their weight. Tagged fish keep their identity and draw a destination from their row.
+    */
+    void moveAllDensity();
 };
 #define __FISH_MODEL_CLS
 
@@ -1,4 +1,5 @@
 #include "model_config_map.h"
+#include "output_storage.h"
 
 #include <iostream>
 #include <ostream>
@@ -19,6 +20,57 @@ std::unordered_map<ModelParamKey, ConfigDefinition> ModelConfigMap::createDefaul
         {ModelParamKey::PmaxLowerLimit, {"pmaxLowerLimit", 0.2f}},
         {ModelParamKey::AgentAwareness, {"agentAwareness", "medium"}}, // options are "low", "medium", and "high"
         {ModelParamKey::MortalityInflectionPoint, {"mortalityInflectionPoint", 500.0f}},
+        {ModelParamKey::OutputFormat, {"outputFormat", "netcdf"}}, // options are "netcdf", "columnar", and "both"
+        // NetCDF chunking/compression per output file (see output_storage.h for the format)
+        {ModelParamKey::StateStorage, {"stateStorage", "deflate:1,shuffle:1,chunk:4x4096"}},
+        {ModelParamKey::SummaryStorage, {"summaryStorage", "deflate:4,shuffle:1,chunk:4x4096"}},
+        {ModelParamKey::SampleDataStorage, {"sampleDataStorage", "deflate:4,shuffle:1,chunk:4x4096"}},
+        {ModelParamKey::TaggedHistoryStorage, {"taggedHistoryStorage", "deflate:4,shuffle:1,chunk:32x720"}},
+        // Timesteps of monitoring history held in memory between writes to the summary file (0 = keep it all)
+        {ModelParamKey::MonitoringFlushInterval, {"monitoringFlushInterval", 720}},
+        // Unix socket on which headless publishes per-step telemetry ("" = none; "{runID}" is replaced with the run ID)
+        {ModelParamKey::TelemetrySocket, {"telemetrySocket", ""}},
+        // Recruits represented by each agent (1 = one Fish per recruit; see Model::recruit)
+        {ModelParamKey::SuperIndividualSize, {"superIndividualSize", 1}},
+        // "agent" walks each fish; "density" propagates fish densities (low agent awareness only; see density_propagation.h)
+        {ModelParamKey::MovementEngine, {"movementEngine", "agent"}},
+        // Fork length class width (mm) for the density movement engine's transition matrices
+        {ModelParamKey::DensitySizeClassWidth, {"densitySizeClassWidth", 5.0f}},
+        // Merge map locations down to this many after loading (0 = use the full map; see map_coarsen.h)
+        {ModelParamKey::MapCoarsenTargetNodes, {"mapCoarsenTargetNodes", 0}},
+        // Largest elevation (m) and pathDist (m) differences between locations that coarsening may merge
+        {ModelParamKey::MapCoarsenMaxElevationDifference, {"mapCoarsenMaxElevationDifference", 0.5f}},
+        {ModelParamKey::MapCoarsenMaxPathDistDifference, {"mapCoarsenMaxPathDistDifference", 250.0f}},
+        // Directory for prepared map caches ("" = always build the map from the CSVs; see map_cache.h)
+        {ModelParamKey::MapCacheDir, {"mapCacheDir", ""}},
+        // Hours covered by each timestep: 1, 2, 3 or 6 (hydrology is aggregated over each step's hours)
+        {ModelParamKey::HoursPerTimestep, {"hoursPerTimestep", 1}},
+        // CSV file of sampling campaigns ("" = every site at noon every 14th day; see loadSamplingSchedule in load.h)
+        {ModelParamKey::SamplingScheduleFile, {"samplingScheduleFile", ""}},
+        // 1 = draw each fish's random numbers from streams keyed by its ID and the step, so runs with the
+        // same seed are paired draw-for-draw (see KeyedRandScope in util.h)
+        {ModelParamKey::CommonRandomNumbers, {"commonRandomNumbers", 0}},
+        // MB of distributary hydrology held in memory, streamed from a converted file in blocks (0 = load it all;
+        // see hydro_stream.h)
+        {ModelParamKey::HydroMemoryBudgetMB, {"hydroMemoryBudgetMB", 0}},
+        // Most locations in each location's neighborhood in the reachability index used by high-awareness
+        // movement (0 = no index; see reachability_index.h)
+        {ModelParamKey::ReachabilityNeighborhoodSize, {"reachabilityNeighborhoodSize", 256}},
+        // Regions the map is partitioned into, each owning its fish and locations (0 = off; see
+        // domain_decomposition.h)
+        {ModelParamKey::DomainRegions, {"domainRegions", 0}},
+        // Processes a headless run is spread over, each owning a part of the map and its fish (1 = one process;
+        // see distributed.h), and how they talk: "socket" (Unix domain sockets) or "shm" (shared memory)
+        {ModelParamKey::Processes, {"processes", 1}},
+        {ModelParamKey::ProcessTransport, {"processTransport", "socket"}},
+        // Pin movement and growth workers to CPUs: "off", "compact" (fill one NUMA node first) or "spread"
+        // (share them between the nodes), and move each worker's fish to its node (see numa.h)
+        {ModelParamKey::ThreadPinning, {"threadPinning", "off"}},
+        // Where the hydrology's pages go: "default" (wherever they were loaded) or "interleave" (across the NUMA nodes)
+        {ModelParamKey::HydroPlacement, {"hydroPlacement", "default"}},
+        // Fish ahead of the one being moved at which each movement worker's prefetch pipeline runs (0 = off;
+        // see movement_prefetch.h)
+        {ModelParamKey::MovementPrefetchDistance, {"movementPrefetchDistance", 8}},
     };
 }
 
@@ -55,11 +107,19 @@ std::string ModelConfigMap::getString(ModelParamKey key) const {
     throw std::runtime_error("Config key not found");
 }
 
+const ConfigValue& ModelConfigMap::get(ModelParamKey key) const {
+    auto it = paramValues_.find(key);
+    if (it != paramValues_.end()) {
+        return it->second;
+    }
+    throw std::runtime_error("Config key not found");
+}
+
 void ModelConfigMap::set(ModelParamKey key, const ConfigValue& value) {
     paramValues_[key] = value;
 }
 
-void ModelConfigMap::loadFromJson(const rapidjson::Document& d) {
+void ModelConfigMap::loadFromJson(const rapidjson::Value& d) {
     for (const auto& [configKey, fileKey] : fileKeyMap_) {
         if (d.HasMember(fileKey.c_str())) {
             const auto& jsonValue = d[fileKey.c_str()];
@@ -82,10 +142,153 @@ std::string ModelConfigMap::getFileKey(ModelParamKey key) const {
     return (it != fileKeyMap_.end()) ? it->second : "unknown";
 }
 
+bool ModelConfigMap::findFileKey(const std::string& fileKey, ModelParamKey& key) const {
+    for (const auto& [configKey, name] : fileKeyMap_) {
+        if (name == fileKey) {
+            key = configKey;
+            return true;
+        }
+    }
+    return false;
+}
+
 void ModelConfigMap::validate() const {
     std::string agentAwareness = getString(ModelParamKey::AgentAwareness);
     if (agentAwareness != "low" && agentAwareness != "medium" && agentAwareness != "high") {
         std::cerr << "Invalid value for AgentAwareness: " << agentAwareness << std::endl;
         throw std::runtime_error("Invalid value for AgentAwareness");
     }
-}
\ No newline at end of file
+    std::string outputFormat = getString(ModelParamKey::OutputFormat);
+    if (outputFormat != "netcdf" && outputFormat != "columnar" && outputFormat != "both") {
+        std::cerr << "Invalid value for OutputFormat: " << outputFormat << std::endl;
+        throw std::runtime_error("Invalid value for OutputFormat");
+    }
+    for (ModelParamKey key : {ModelParamKey::StateStorage, ModelParamKey::SummaryStorage,
+                              ModelParamKey::SampleDataStorage, ModelParamKey::TaggedHistoryStorage}) {
+        NcStorageOptions::parse(getString(key));
+    }
+    int monitoringFlushInterval = getInt(ModelParamKey::MonitoringFlushInterval);
+    if (monitoringFlushInterval < 0) {
+        std::cerr << "Invalid value for MonitoringFlushInterval: " << monitoringFlushInterval << std::endl;
+        throw std::runtime_error("Invalid value for MonitoringFlushInterval");
+    }
+    int superIndividualSize = getInt(ModelParamKey::SuperIndividualSize);
+    if (superIndividualSize < 1) {
+        std::cerr << "Invalid value for SuperIndividualSize: " << superIndividualSize << std::endl;
+        throw std::runtime_error("Invalid value for SuperIndividualSize");
+    }
+    std::string movementEngine = getString(ModelParamKey::MovementEngine);
+    if (movementEngine != "agent" && (movementEngine != "density" || agentAwareness != "low")) {
+        std::cerr << "Invalid value for MovementEngine: " << movementEngine
+                  << " (\"density\" requires agentAwareness \"low\")" << std::endl;
+        throw std::runtime_error("Invalid value for MovementEngine");
+    }
+    float densitySizeClassWidth = getFloat(ModelParamKey::DensitySizeClassWidth);
+    if (!(densitySizeClassWidth > 0.0f)) {
+        std::cerr << "Invalid value for DensitySizeClassWidth: " << densitySizeClassWidth << std::endl;
+        throw std::runtime_error("Invalid value for DensitySizeClassWidth");
+    }
+    int hoursPerTimestep = getInt(ModelParamKey::HoursPerTimestep);
+    if (hoursPerTimestep != 1 && hoursPerTimestep != 2 && hoursPerTimestep != 3 && hoursPerTimestep != 6) {
+        std::cerr << "Invalid value for HoursPerTimestep: " << hoursPerTimestep << " (must be 1, 2, 3 or 6)" << std::endl;
+        throw std::runtime_error("Invalid value for HoursPerTimestep");
+    }
+    int mapCoarsenTargetNodes = getInt(ModelParamKey::MapCoarsenTargetNodes);
+    if (mapCoarsenTargetNodes < 0) {
+        std::cerr << "Invalid value for MapCoarsenTargetNodes: " << mapCoarsenTargetNodes << std::endl;
+        throw std::runtime_error("Invalid value for MapCoarsenTargetNodes");
+    }
+    for (ModelParamKey key : {ModelParamKey::MapCoarsenMaxElevationDifference,
+                              ModelParamKey::MapCoarsenMaxPathDistDifference}) {
+        float difference = getFloat(key);
+        if (!(difference >= 0.0f)) {
+            std::cerr << "Invalid value for " << getFileKey(key) << ": " << difference << std::endl;
+            throw std::runtime_error("Invalid value for " + getFileKey(key));
+        }
+    }
+    int commonRandomNumbers = getInt(ModelParamKey::CommonRandomNumbers);
+    if (commonRandomNumbers != 0 && commonRandomNumbers != 1) {
+        std::cerr << "Invalid value for CommonRandomNumbers: " << commonRandomNumbers << std::endl;
+        throw std::runtime_error("Invalid value for CommonRandomNumbers");
+    }
+    int hydroMemoryBudgetMB = getInt(ModelParamKey::HydroMemoryBudgetMB);
+    if (hydroMemoryBudgetMB < 0) {
+        std::cerr << "Invalid value for HydroMemoryBudgetMB: " << hydroMemoryBudgetMB << std::endl;
+        throw std::runtime_error("Invalid value for HydroMemoryBudgetMB");
+    }
+    int reachabilityNeighborhoodSize = getInt(ModelParamKey::ReachabilityNeighborhoodSize);
+    if (reachabilityNeighborhoodSize < 0) {
+        std::cerr << "Invalid value for ReachabilityNeighborhoodSize: " << reachabilityNeighborhoodSize << std::endl;
+        throw std::runtime_error("Invalid value for ReachabilityNeighborhoodSize");
+    }
+    int domainRegions = getInt(ModelParamKey::DomainRegions);
+    if (domainRegions < 0) {
+        std::cerr << "Invalid value for DomainRegions: " << domainRegions << std::endl;
+        throw std::runtime_error("Invalid value for DomainRegions");
+    }
+    if (domainRegions > 0 && movementEngine != "agent") {
+        std::cerr << "Invalid value for DomainRegions: " << domainRegions
+                  << " (regions require movementEngine \"agent\")" << std::endl;
+        throw std::runtime_error("Invalid value for DomainRegions");
+    }
+    int processes = getInt(ModelParamKey::Processes);
+    if (processes < 1) {
+        std::cerr << "Invalid value for Processes: " << processes << std::endl;
+        throw std::runtime_error("Invalid value for Processes");
+    }
+    if (processes > 1 && (commonRandomNumbers != 1 || superIndividualSize != 1 || movementEngine != "agent"
+                          || domainRegions != 0 || hydroMemoryBudgetMB != 0)) {
+        std::cerr << "Invalid value for Processes: " << processes << " (more than one process requires "
+                  << "commonRandomNumbers 1, superIndividualSize 1, movementEngine \"agent\", domainRegions 0 "
+                  << "and hydroMemoryBudgetMB 0)" << std::endl;
+        throw std::runtime_error("Invalid value for Processes");
+    }
+    std::string processTransport = getString(ModelParamKey::ProcessTransport);
+    if (processTransport != "socket" && processTransport != "shm") {
+        std::cerr << "Invalid value for ProcessTransport: " << processTransport << std::endl;
+        throw std::runtime_error("Invalid value for ProcessTransport");
+    }
+    std::string threadPinning = getString(ModelParamKey::ThreadPinning);
+    if (threadPinning != "off" && threadPinning != "compact" && threadPinning != "spread") {
+        std::cerr << "Invalid value for ThreadPinning: " << threadPinning << std::endl;
+        throw std::runtime_error("Invalid value for ThreadPinning");
+    }
+    std::string hydroPlacement = getString(ModelParamKey::HydroPlacement);
+    if (hydroPlacement != "default" && hydroPlacement != "interleave") {
+        std::cerr << "Invalid value for HydroPlacement: " << hydroPlacement << std::endl;
+        throw std::runtime_error("Invalid value for HydroPlacement");
+    }
+    int movementPrefetchDistance = getInt(ModelParamKey::MovementPrefetchDistance);
+    if (movementPrefetchDistance < 0) {
+        std::cerr << "Invalid value for MovementPrefetchDistance: " << movementPrefetchDistance << std::endl;
+        throw std::runtime_error("Invalid value for MovementPrefetchDistance");
+    }
+}
+
+bool ModelConfigMap::isRunTimeParameter(ModelParamKey key) {
+    switch (key) {
+        case ModelParamKey::HabitatMortalityMultiplier:
+        case ModelParamKey::MortMin:
+        case ModelParamKey::MortMax:
+        case ModelParamKey::GrowthSlope:
+        case ModelParamKey::GrowthSlopeNearshore:
+        case ModelParamKey::PmaxUpperLimit:
+        case ModelParamKey::PmaxUpperLimitNearshore:
+        case ModelParamKey::PmaxLowerLimit:
+        case ModelParamKey::AgentAwareness:
+        case ModelParamKey::MortalityInflectionPoint:
+        case ModelParamKey::SummaryStorage:
+        case ModelParamKey::SampleDataStorage:
+        case ModelParamKey::SuperIndividualSize:
+        case ModelParamKey::MovementEngine:
+        case ModelParamKey::DensitySizeClassWidth:
+        case ModelParamKey::CommonRandomNumbers:
+        case ModelParamKey::DomainRegions:
+        case ModelParamKey::ThreadPinning:
+        case ModelParamKey::HydroPlacement:
+        case ModelParamKey::MovementPrefetchDistance:
+            return true;
+        default:
+            return false;
+    }
+}
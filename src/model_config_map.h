@@ -25,7 +25,32 @@ enum class ModelParamKey {
     PmaxUpperLimitNearshore,
     PmaxLowerLimit,
     AgentAwareness,
-    MortalityInflectionPoint
+    MortalityInflectionPoint,
+    OutputFormat,
+    StateStorage,
+    SummaryStorage,
+    SampleDataStorage,
+    TaggedHistoryStorage,
+    MonitoringFlushInterval,
+    TelemetrySocket,
+    SuperIndividualSize,
+    MovementEngine,
+    DensitySizeClassWidth,
+    MapCoarsenTargetNodes,
+    MapCoarsenMaxElevationDifference,
+    MapCoarsenMaxPathDistDifference,
+    MapCacheDir,
+    HoursPerTimestep,
+    SamplingScheduleFile,
+    CommonRandomNumbers,
+    HydroMemoryBudgetMB,
+    ReachabilityNeighborhoodSize,
+    DomainRegions,
+    Processes,
+    ProcessTransport,
+    ThreadPinning,
+    HydroPlacement,
+    MovementPrefetchDistance
 };
 
 class ModelConfigMap {
@@ -41,9 +66,16 @@ public:
     int getInt(ModelParamKey key) const;
     float getFloat(ModelParamKey key) const;
     std::string getString(ModelParamKey key) const;
+    const ConfigValue& get(ModelParamKey key) const;
 
     void set(ModelParamKey key, const ConfigValue& value);
-    void loadFromJson(const rapidjson::Document& d);
+    // Set every parameter named in a JSON object (a config file or any object within one), then validate
+    void loadFromJson(const rapidjson::Value& d);
     std::string getFileKey(ModelParamKey key) const;
+    // Look up a parameter by its config file name; returns false if there is no such parameter
+    bool findFileKey(const std::string& fileKey, ModelParamKey& key) const;
     void validate() const;
+    // Whether a parameter is read while the model runs (and so can be changed between runs on the same inputs),
+    // rather than only when the map, hydrology and recruit inputs are loaded
+    static bool isRunTimeParameter(ModelParamKey key);
 };
\ No newline at end of file
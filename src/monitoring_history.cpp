@@ -0,0 +1,237 @@
+#include "monitoring_history.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+// Each recording thread handles at least this many points (as with movement threads and fish)
+constexpr size_t POINTS_PER_THREAD = 4096;
+
+static const char *const MONITORING_VARS[4] = {
+    "monitoringPopulation", "monitoringPopulationDensity", "monitoringDepth", "monitoringTemp"
+};
+
+MonitoringHistory::MonitoringHistory()
+    : numPoints(0), numTimesteps(0), flushedTimesteps(0), flushInterval(0) {}
+
+MonitoringHistory::~MonitoringHistory() {}
+
+void MonitoringHistory::reset(size_t numPoints) {
+    this->numPoints = numPoints;
+    this->numTimesteps = 0;
+    this->flushedTimesteps = 0;
+    this->flushInterval = 0;
+    this->population.clear();
+    this->populationDensity.clear();
+    this->depth.clear();
+    this->temp.clear();
+    this->streamFile.reset();
+    this->streamPath.clear();
+}
+
+void MonitoringHistory::reserve(size_t timesteps) {
+    size_t rows = this->flushInterval > 0 ? std::min(timesteps, this->flushInterval) : timesteps;
+    this->population.reserve(rows * this->numPoints);
+    this->populationDensity.reserve(rows * this->numPoints);
+    this->depth.reserve(rows * this->numPoints);
+    this->temp.reserve(rows * this->numPoints);
+}
+
+void MonitoringHistory::record(const std::vector<MapNode *> &points, HydroModel &hydroModel, size_t maxThreads) {
+    const size_t rowStart = this->population.size();
+    this->population.resize(rowStart + this->numPoints);
+    this->populationDensity.resize(rowStart + this->numPoints);
+    this->depth.resize(rowStart + this->numPoints);
+    this->temp.resize(rowStart + this->numPoints);
+    auto fill = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            MapNode *n = points[i];
+            this->population[rowStart + i] = (int) std::lround(n->residentWeight);
+            this->populationDensity[rowStart + i] = n->popDensity;
+            this->depth[rowStart + i] = hydroModel.getDepth(*n);
+            this->temp[rowStart + i] = hydroModel.getTemp(*n);
+        }
+    };
+    size_t numThreads = std::max((size_t) 1, std::min(maxThreads, this->numPoints / POINTS_PER_THREAD));
+    if (numThreads == 1) {
+        fill(0, this->numPoints);
+    } else {
+        std::vector<std::thread> threads;
+        size_t perThread = (this->numPoints + numThreads - 1) / numThreads;
+        for (size_t begin = 0; begin < this->numPoints; begin += perThread) {
+            threads.emplace_back(fill, begin, std::min(this->numPoints, begin + perThread));
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+    ++this->numTimesteps;
+    if (this->streamFile && this->numTimesteps - this->flushedTimesteps >= this->flushInterval) {
+        this->flush();
+    }
+}
+
+void MonitoringHistory::appendRow(const std::vector<MonitoringRecord> &row) {
+    if (row.size() != this->numPoints) {
+        throw std::runtime_error("Monitoring row has the wrong number of points");
+    }
+    for (const MonitoringRecord &r : row) {
+        this->population.push_back((int) r.population);
+        this->populationDensity.push_back(r.populationDensity);
+        this->depth.push_back(r.depth);
+        this->temp.push_back(r.temp);
+    }
+    ++this->numTimesteps;
+    if (this->streamFile && this->numTimesteps - this->flushedTimesteps >= this->flushInterval) {
+        this->flush();
+    }
+}
+
+MonitoringRecord MonitoringHistory::get(size_t t, size_t point) const {
+    if (t >= this->flushedTimesteps) {
+        size_t i = (t - this->flushedTimesteps) * this->numPoints + point;
+        return MonitoringRecord((size_t) this->population[i], this->populationDensity[i], this->depth[i], this->temp[i]);
+    }
+    std::vector<int> p(this->numPoints);
+    std::vector<float> d(this->numPoints), z(this->numPoints), c(this->numPoints);
+    this->readFlushed(t, 1, p.data(), d.data(), z.data(), c.data());
+    return MonitoringRecord((size_t) p[point], d[point], z[point], c[point]);
+}
+
+void MonitoringHistory::readFlushed(size_t t0, size_t count, int *population, float *populationDensity, float *depth, float *temp) const {
+    std::unique_ptr<netCDF::NcFile> reopened;
+    const netCDF::NcFile *file = this->streamFile.get();
+    if (file == nullptr) {
+        reopened = std::make_unique<netCDF::NcFile>(this->streamPath, netCDF::NcFile::FileMode::read);
+        file = reopened.get();
+    }
+    std::vector<size_t> start{0, t0};
+    std::vector<size_t> counts{this->numPoints, count};
+    std::vector<ptrdiff_t> stride{1, 1};
+    // Element (point, t) of the variable lands at t * numPoints + point
+    std::vector<ptrdiff_t> imap{1, (ptrdiff_t) this->numPoints};
+    file->getVar(MONITORING_VARS[0]).getVar(start, counts, stride, imap, population);
+    file->getVar(MONITORING_VARS[1]).getVar(start, counts, stride, imap, populationDensity);
+    file->getVar(MONITORING_VARS[2]).getVar(start, counts, stride, imap, depth);
+    file->getVar(MONITORING_VARS[3]).getVar(start, counts, stride, imap, temp);
+}
+
+void MonitoringHistory::forEachBlock(const BlockVisitor &visit) const {
+    if (this->numPoints == 0) {
+        return;
+    }
+    if (this->flushedTimesteps > 0) {
+        size_t blockSize = std::min(this->flushedTimesteps, READ_BLOCK_TIMESTEPS);
+        std::vector<int> p(blockSize * this->numPoints);
+        std::vector<float> d(p.size()), z(p.size()), c(p.size());
+        for (size_t t0 = 0; t0 < this->flushedTimesteps; t0 += blockSize) {
+            size_t count = std::min(blockSize, this->flushedTimesteps - t0);
+            this->readFlushed(t0, count, p.data(), d.data(), z.data(), c.data());
+            visit(t0, count, p.data(), d.data(), z.data(), c.data());
+        }
+    }
+    if (this->numTimesteps > this->flushedTimesteps) {
+        visit(this->flushedTimesteps, this->numTimesteps - this->flushedTimesteps, this->population.data(),
+              this->populationDensity.data(), this->depth.data(), this->temp.data());
+    }
+}
+
+void MonitoringHistory::streamTo(const std::string &path, size_t flushInterval, const std::vector<MapNode *> &points, const NcStorageOptions &storage) {
+    if (this->streamFile || this->flushedTimesteps > 0) {
+        throw std::runtime_error("Monitoring history is already streamed to " + this->streamPath);
+    }
+    if (this->numPoints == 0 || flushInterval == 0) {
+        return;
+    }
+    this->streamFile = std::make_unique<netCDF::NcFile>(path, netCDF::NcFile::FileMode::replace);
+    this->streamPath = path;
+    this->flushInterval = flushInterval;
+    netCDF::NcDim pointsDim = this->streamFile->addDim("monitoringPoints", this->numPoints);
+    // Unlimited, so every flush can extend it
+    netCDF::NcDim historyDim = this->streamFile->addDim("historyLength");
+    std::vector<netCDF::NcDim> dims{pointsDim, historyDim};
+    addStoredVar(*this->streamFile, MONITORING_VARS[0], netCDF::ncInt, dims, storage);
+    for (int v = 1; v < 4; ++v) {
+        addStoredVar(*this->streamFile, MONITORING_VARS[v], netCDF::ncFloat, dims, storage);
+    }
+    std::vector<int> pointIds;
+    for (MapNode *n : points) {
+        pointIds.push_back(n->id);
+    }
+    addStoredVar(*this->streamFile, "monitoringPointIDs", netCDF::ncInt, {pointsDim}, storage).putVar(pointIds.data());
+    if (this->numTimesteps >= this->flushInterval) {
+        this->flush();
+    }
+}
+
+void MonitoringHistory::flush() {
+    if (!this->streamFile || this->numTimesteps == this->flushedTimesteps) {
+        return;
+    }
+    size_t count = this->numTimesteps - this->flushedTimesteps;
+    std::vector<size_t> start{0, this->flushedTimesteps};
+    std::vector<size_t> counts{this->numPoints, count};
+    std::vector<ptrdiff_t> stride{1, 1};
+    std::vector<ptrdiff_t> imap{1, (ptrdiff_t) this->numPoints};
+    this->streamFile->getVar(MONITORING_VARS[0]).putVar(start, counts, stride, imap, this->population.data());
+    this->streamFile->getVar(MONITORING_VARS[1]).putVar(start, counts, stride, imap, this->populationDensity.data());
+    this->streamFile->getVar(MONITORING_VARS[2]).putVar(start, counts, stride, imap, this->depth.data());
+    this->streamFile->getVar(MONITORING_VARS[3]).putVar(start, counts, stride, imap, this->temp.data());
+    this->streamFile->sync();
+    this->flushedTimesteps = this->numTimesteps;
+    // clear() keeps the capacity, so the next interval's rows don't reallocate
+    this->population.clear();
+    this->populationDensity.clear();
+    this->depth.clear();
+    this->temp.clear();
+}
+
+void MonitoringHistory::finishStream() {
+    if (!this->streamFile) {
+        return;
+    }
+    this->flush();
+    // Closes the file
+    this->streamFile.reset();
+    this->flushInterval = 0;
+}
+
+void MonitoringHistory::write(const netCDF::NcFile &file, const std::vector<netCDF::NcDim> &dims, const NcStorageOptions &storage) const {
+    netCDF::NcVar vars[4];
+    vars[0] = addStoredVar(file, MONITORING_VARS[0], netCDF::ncInt, dims, storage);
+    for (int v = 1; v < 4; ++v) {
+        vars[v] = addStoredVar(file, MONITORING_VARS[v], netCDF::ncFloat, dims, storage);
+    }
+    std::vector<ptrdiff_t> stride{1, 1};
+    std::vector<ptrdiff_t> imap{1, (ptrdiff_t) this->numPoints};
+    this->forEachBlock([&](size_t t0, size_t count, const int *p, const float *d, const float *z, const float *c) {
+        std::vector<size_t> start{0, t0};
+        std::vector<size_t> counts{this->numPoints, count};
+        vars[0].putVar(start, counts, stride, imap, p);
+        vars[1].putVar(start, counts, stride, imap, d);
+        vars[2].putVar(start, counts, stride, imap, z);
+        vars[3].putVar(start, counts, stride, imap, c);
+    });
+}
+
+void MonitoringHistory::load(const netCDF::NcFile &file, size_t numPoints, size_t historyLength) {
+    this->reset(numPoints);
+    if (numPoints == 0 || historyLength == 0) {
+        this->numTimesteps = historyLength;
+        return;
+    }
+    this->population.resize(numPoints * historyLength);
+    this->populationDensity.resize(numPoints * historyLength);
+    this->depth.resize(numPoints * historyLength);
+    this->temp.resize(numPoints * historyLength);
+    std::vector<size_t> start{0, 0};
+    std::vector<size_t> counts{numPoints, historyLength};
+    std::vector<ptrdiff_t> stride{1, 1};
+    std::vector<ptrdiff_t> imap{1, (ptrdiff_t) numPoints};
+    file.getVar(MONITORING_VARS[0]).getVar(start, counts, stride, imap, this->population.data());
+    file.getVar(MONITORING_VARS[1]).getVar(start, counts, stride, imap, this->populationDensity.data());
+    file.getVar(MONITORING_VARS[2]).getVar(start, counts, stride, imap, this->depth.data());
+    file.getVar(MONITORING_VARS[3]).getVar(start, counts, stride, imap, this->temp.data());
+    this->numTimesteps = historyLength;
+}
@@ -0,0 +1,100 @@
+#ifndef __FISH_MONITORING_HISTORY_H
+#define __FISH_MONITORING_HISTORY_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <netcdf>
+#include "map.h"
+#include "hydro.h"
+#include "output_storage.h"
+
+typedef struct MonitoringRecord {
+    size_t population;
+    float populationDensity;
+    float depth;
+    float temp;
+    MonitoringRecord(size_t population, float populationDensity, float depth, float temp) : population(population), populationDensity(populationDensity), depth(depth), temp(temp) {}
+} MonitoringRecord;
+
+/*
+* Per-timestep populations and environmental values at the monitoring points, held as four
+* time-major columns (row t holds every point's value at timestep t), so recording a timestep
+* appends one contiguous row per column.
+*
+* Optionally the rows are streamed to a NetCDF file every flushInterval timesteps and dropped
+* from memory, so memory use doesn't grow with run length. Files are written with the
+* [monitoringPoints][historyLength] layout of the model's outputs; NetCDF's mapped writes
+* (imap) do the transposition, so rows never have to be rearranged in memory.
+*/
+class MonitoringHistory {
+public:
+    // Rows from the stream file are read back this many timesteps at a time
+    static constexpr size_t READ_BLOCK_TIMESTEPS = 720;
+
+    // Visitor for forEachBlock: first timestep, number of timesteps, then the block's time-major
+    // (timesteps x points) population, population density, depth and temperature values
+    typedef std::function<void(size_t, size_t, const int *, const float *, const float *, const float *)> BlockVisitor;
+
+    MonitoringHistory();
+    ~MonitoringHistory();
+    MonitoringHistory(const MonitoringHistory &) = delete;
+    MonitoringHistory &operator=(const MonitoringHistory &) = delete;
+
+    // Drop every row (and stop streaming) and start over with the given number of points
+    void reset(size_t numPoints);
+    // Preallocate room for a run of this many timesteps (one flush interval's worth while streaming)
+    void reserve(size_t timesteps);
+    // Append the current timestep's row, filled in parallel over the points when there are many
+    void record(const std::vector<MapNode *> &points, HydroModel &hydroModel, size_t maxThreads);
+    // Append a row of precomputed values (one record per point)
+    void appendRow(const std::vector<MonitoringRecord> &row);
+
+    size_t getNumPoints() const { return numPoints; }
+    size_t getNumTimesteps() const { return numTimesteps; }
+    // One point's values at timestep t (flushed rows are read back from the stream file)
+    MonitoringRecord get(size_t t, size_t point) const;
+    // Visit every row in timestep order, in blocks of consecutive timesteps
+    void forEachBlock(const BlockVisitor &visit) const;
+
+    /*
+    * Start streaming rows to a new NetCDF file at path (replacing it), flushing every flushInterval
+    * timesteps. The file gets the monitoringPoints/historyLength dimensions, the four monitoring
+    * variables and monitoringPointIDs, under the same names saveSummary uses, so it can become
+    * the summary file. Rows recorded so far are written at the first flush.
+    */
+    void streamTo(const std::string &path, size_t flushInterval, const std::vector<MapNode *> &points, const NcStorageOptions &storage);
+    // Write buffered rows to the stream file now
+    void flush();
+    // Flush and close the stream file, which then holds the complete monitoring variables; later rows stay in memory
+    void finishStream();
+    bool isStreaming() const { return streamFile != nullptr; }
+    // Path of the current or finished stream file ("" if rows have never been streamed)
+    const std::string &getStreamPath() const { return streamPath; }
+
+    // Add the four monitoring variables over dims ([monitoringPoints][historyLength]) to a file and write every row
+    void write(const netCDF::NcFile &file, const std::vector<netCDF::NcDim> &dims, const NcStorageOptions &storage) const;
+    // Replace the contents with the monitoring variables of a file written by write() or streamTo()
+    void load(const netCDF::NcFile &file, size_t numPoints, size_t historyLength);
+
+private:
+    // Read flushed timesteps [t0, t0 + count) into the given buffers
+    void readFlushed(size_t t0, size_t count, int *population, float *populationDensity, float *depth, float *temp) const;
+
+    size_t numPoints;
+    size_t numTimesteps;
+    // Timesteps [0, flushedTimesteps) are only in the stream file
+    size_t flushedTimesteps;
+    size_t flushInterval;
+    // Time-major values for timesteps [flushedTimesteps, numTimesteps)
+    std::vector<int> population;
+    std::vector<float> populationDensity;
+    std::vector<float> depth;
+    std::vector<float> temp;
+    std::string streamPath;
+    std::unique_ptr<netCDF::NcFile> streamFile;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "fish.h"
+#include "model.h"
+#include "util.h"
+
+/*
+* Benchmark of interleaved movement prefetching (movementPrefetchDistance; see movement_prefetch.h).
+*
+* Usage: movement_benchmark <config> [--fish n] [--steps n] [--seed s] [--distances "d,d,..."]
+*
+* Loads the model once, scatters n fish (default 2000000) over the wet locations of its map, and then for
+* each prefetch distance (default 0,2,4,8,16; 0 is the unprefetched baseline) starts again from those fish
+* and times n steps (default 10) of agent movement alone, with commonRandomNumbers = 1. Reports the time
+* per fish, the speedup over the first distance, and the survivors and a checksum of their locations,
+* which are the same for every distance. Fish scattered over the whole map, unlike recruits that are still
+* near the entry points, miss the cache at every link of their walk; use enough of them that their storage
+* (printed at the start) is well beyond the last-level cache.
+*/
+
+static const char *DEFAULT_DISTANCES = "0,2,4,8,16";
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The last-level cache's size as the kernel reports it ("" if it doesn't)
+static std::string lastLevelCacheSize() {
+    std::string size;
+    for (int index = 0; index < 8; ++index) {
+        std::ifstream file("/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/size");
+        std::string line;
+        if (file && std::getline(file, line)) {
+            size = line;
+        }
+    }
+    return size;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: movement_benchmark <config> [--fish n] [--steps n] [--seed s] [--distances \"d,d,...\"]"
+                  << std::endl;
+        return 1;
+    }
+    std::string configPath(argv[1]);
+    size_t numFish = 2000000;
+    long steps = 10;
+    unsigned seed = 1U;
+    std::string distanceList(DEFAULT_DISTANCES);
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg(argv[i]);
+        if (arg == "--fish") {
+            numFish = std::stoul(argv[i + 1]);
+        } else if (arg == "--steps") {
+            steps = std::stol(argv[i + 1]);
+        } else if (arg == "--seed") {
+            seed = (unsigned) std::stoul(argv[i + 1]);
+        } else if (arg == "--distances") {
+            distanceList = argv[i + 1];
+        } else {
+            std::cerr << "Unrecognized option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    Model *model = modelFromConfig(configPath);
+    ModelConfigMap config = model->getConfigMap();
+    config.set(ModelParamKey::CommonRandomNumbers, 1);
+    model->setConfigMap(config);
+    std::vector<MapNode *> wet;
+    for (MapNode *node : model->map) {
+        if (model->hydroModel.getDepth(*node) > 0.0f) {
+            wet.push_back(node);
+        }
+    }
+    if (wet.empty()) {
+        std::cerr << "No wet locations at the start of the run" << std::endl;
+        return 1;
+    }
+    GlobalRand::reseed(seed);
+    model->individuals.clear();
+    model->livingIndividuals.clear();
+    for (size_t id = 0; id < numFish; ++id) {
+        MapNode *location = wet[(size_t) GlobalRand::int_rand(0, (int) wet.size() - 1)];
+        model->individuals.emplace_back(id, model->time, 45.0f + 30.0f * unit_rand(), location);
+        model->livingIndividuals.push_back(id);
+    }
+    const std::vector<Fish> startFish = model->individuals;
+    const std::vector<size_t> startLiving = model->livingIndividuals;
+    std::string llc = lastLevelCacheSize();
+    std::cout << model->map.size() << " locations; " << numFish << " fish in "
+              << (double) (numFish * sizeof(Fish)) / 1048576.0 << " MB"
+              << (llc.empty() ? "" : " (last-level cache " + llc + ")") << std::endl << std::endl;
+    std::cout << std::left << std::setw(12) << "distance" << std::right << std::setw(14) << "ns/fish/step"
+        << std::setw(12) << "speedup" << std::setw(12) << "living" << std::setw(22) << "location checksum"
+        << std::endl;
+
+    std::istringstream distances(distanceList);
+    std::string distance;
+    double baseline = 0.0;
+    while (std::getline(distances, distance, ',')) {
+        config.set(ModelParamKey::MovementPrefetchDistance, std::stoi(distance));
+        model->setConfigMap(config);
+        model->individuals = startFish;
+        model->livingIndividuals = startLiving;
+        double seconds = 0.0;
+        size_t moved = 0;
+        for (long step = 0; step < steps; ++step) {
+            moved += model->livingIndividuals.size();
+            auto start = std::chrono::steady_clock::now();
+            model->moveAll();
+            seconds += secondsSince(start);
+        }
+        uint64_t checksum = 0;
+        for (size_t id : model->livingIndividuals) {
+            checksum = checksum * 1000003ULL + (uint64_t) model->individuals[id].location->id;
+        }
+        const double nsPerFish = moved > 0 ? seconds * 1e9 / (double) moved : 0.0;
+        if (baseline == 0.0) {
+            baseline = nsPerFish;
+        }
+        std::cout << std::left << std::setw(12) << distance << std::right << std::fixed << std::setprecision(1)
+            << std::setw(14) << nsPerFish << std::setprecision(2) << std::setw(12)
+            << (nsPerFish > 0.0 ? baseline / nsPerFish : 0.0) << std::setw(12) << model->livingIndividuals.size()
+            << std::setw(22) << checksum << std::endl;
+    }
+    delete model;
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "movement_prefetch.h"
+
+#include "model.h"
+#include "util.h"
+
+MovementPrefetch::MovementPrefetch(const Model &model, std::vector<size_t>::const_iterator first,
+                                   std::vector<size_t>::const_iterator last, size_t distance)
+    : model(model), first(first), count((size_t) (last - first)), distance(distance) {}
+
+void MovementPrefetch::advance(size_t i) const {
+    if (this->distance == 0) {
+        return;
+    }
+    for (size_t stage = 0; stage < STAGES; ++stage) {
+        const size_t ahead = i + (STAGES - stage) * this->distance;
+        if (ahead < this->count) {
+            this->prefetchStage(stage, this->model.individuals[*(this->first + ahead)]);
+        }
+    }
+}
+
+void MovementPrefetch::prefetchStage(size_t stage, const Fish &fish) const {
+    if (stage == 0) {
+        prefetchRead(&fish);
+        return;
+    }
+    const MapNode *location = fish.location;
+    if (location == nullptr) {
+        return;
+    }
+    const HydroModel &hydroModel = this->model.hydroModel;
+    switch (stage) {
+        case 1:
+            prefetchRead(location);
+            prefetchRead(&location->edgesOut);
+            break;
+        case 2:
+            prefetchRead(location->edgesIn.data());
+            prefetchRead(location->edgesOut.data());
+            hydroModel.prefetchHydroNode(*location);
+            break;
+        case 3:
+            for (const Edge &edge : location->edgesIn) {
+                prefetchRead(edge.source);
+            }
+            for (const Edge &edge : location->edgesOut) {
+                prefetchRead(edge.target);
+            }
+            hydroModel.prefetchConditions(*location);
+            break;
+        case 4:
+            for (const Edge &edge : location->edgesIn) {
+                hydroModel.prefetchHydroNode(*edge.source);
+            }
+            for (const Edge &edge : location->edgesOut) {
+                hydroModel.prefetchHydroNode(*edge.target);
+            }
+            break;
+        default:
+            for (const Edge &edge : location->edgesIn) {
+                hydroModel.prefetchConditions(*edge.source);
+            }
+            for (const Edge &edge : location->edgesOut) {
+                hydroModel.prefetchConditions(*edge.target);
+            }
+            break;
+    }
+}
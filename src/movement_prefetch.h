@@ -0,0 +1,45 @@
+#ifndef __FISH_MOVEMENT_PREFETCH_H
+#define __FISH_MOVEMENT_PREFETCH_H
+
+#include <cstddef>
+#include <vector>
+#include "fish.h"
+
+class Model;
+
+/*
+* Interleaved prefetching for the agent movement workers (the movementPrefetchDistance parameter).
+*
+* Moving a fish follows a chain of dependent loads: the fish, its location, the location's edge lists, each
+* neighbor, the hydro nodes of the location and its neighbors, and the current step's values in their
+* series. Walking one fish at a time, the worker waits out a cache miss at each link. Instead, the worker
+* runs the chains of the fish ahead of it in its batch as a pipeline: before moving the fish at position i,
+* it issues one link for each of several later fish, the first link for the fish STAGES x distance ahead,
+* the second for the fish (STAGES - 1) x distance ahead and so on, the last (the neighbors' hydro values)
+* for the fish distance ahead. Each link reads only what the previous one fetched a distance of fish
+* earlier, so by the time a fish is moved its whole chain is in cache and the misses of many fish overlap.
+*
+* Only loads move ahead; the fish are still moved one after another in the same order, so results (random
+* draws included, with or without commonRandomNumbers) are the same at any distance.
+*/
+class MovementPrefetch {
+public:
+    static constexpr size_t STAGES = 6;
+
+    // For a worker's batch [first, last) of fish IDs (in model.individuals); distance 0 turns it off
+    MovementPrefetch(const Model &model, std::vector<size_t>::const_iterator first,
+                     std::vector<size_t>::const_iterator last, size_t distance);
+    // Issue the prefetches due before moving the fish at position i of the batch
+    void advance(size_t i) const;
+
+private:
+    const Model &model;
+    std::vector<size_t>::const_iterator first;
+    size_t count;
+    size_t distance;
+
+    // Link stage of fish's chain (everything it reads was fetched by stage - 1)
+    void prefetchStage(size_t stage, const Fish &fish) const;
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include "numa.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+// "0-3,8" from a sorted list of CPUs
+static std::string formatCpuList(const std::vector<int> &cpus) {
+    std::ostringstream out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        out << (i > 0 ? "," : "") << cpus[i];
+        if (j > i) {
+            out << "-" << cpus[j];
+        }
+        i = j + 1;
+    }
+    return out.str();
+}
+
+size_t NumaTopology::numCpus() const {
+    size_t count = 0;
+    for (const std::vector<int> &cpus : this->nodeCpus) {
+        count += cpus.size();
+    }
+    return count;
+}
+
+std::string NumaTopology::describe() const {
+    std::ostringstream out;
+    out << this->numNodes() << (this->numNodes() == 1 ? " NUMA node: " : " NUMA nodes: ");
+    for (size_t i = 0; i < this->numNodes(); ++i) {
+        out << (i > 0 ? ", " : "") << this->nodeIds[i] << " (CPUs " << formatCpuList(this->nodeCpus[i]) << ")";
+    }
+    return out.str();
+}
+
+std::vector<int> parseCpuList(const std::string &list) {
+    std::vector<int> cpus;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        try {
+            size_t used = 0;
+            int first = std::stoi(range.substr(0, dash), &used);
+            int last = first;
+            if (used != (dash == std::string::npos ? range.size() : dash)) {
+                throw std::invalid_argument(range);
+            }
+            if (dash != std::string::npos) {
+                last = std::stoi(range.substr(dash + 1), &used);
+                if (used != range.size() - dash - 1) {
+                    throw std::invalid_argument(range);
+                }
+            }
+            if (first < 0 || last < first) {
+                throw std::invalid_argument(range);
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::logic_error &) {
+            throw std::runtime_error("Invalid CPU list: " + list);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+NumaTopology readNumaTopology(const std::string &nodeDir) {
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(nodeDir, error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+            || !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            continue;
+        }
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list)) {
+            continue;
+        }
+        std::vector<int> cpus = parseCpuList(list);
+        if (!cpus.empty()) {
+            nodes.emplace_back(std::stoi(name.substr(4)), cpus);
+        }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    NumaTopology topology;
+    for (auto &node : nodes) {
+        topology.nodeIds.push_back(node.first);
+        topology.nodeCpus.push_back(std::move(node.second));
+    }
+    return topology;
+}
+
+NumaTopology detectNumaTopology() {
+    std::vector<int> allowed;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (allowed.empty()) {
+        for (int cpu = 0; cpu < (int) std::max(1U, std::thread::hardware_concurrency()); ++cpu) {
+            allowed.push_back(cpu);
+        }
+    }
+    NumaTopology machine = readNumaTopology("/sys/devices/system/node");
+    NumaTopology topology;
+    for (size_t i = 0; i < machine.numNodes(); ++i) {
+        std::vector<int> cpus;
+        std::set_intersection(machine.nodeCpus[i].begin(), machine.nodeCpus[i].end(), allowed.begin(), allowed.end(),
+                              std::back_inserter(cpus));
+        if (!cpus.empty()) {
+            topology.nodeIds.push_back(machine.nodeIds[i]);
+            topology.nodeCpus.push_back(cpus);
+        }
+    }
+    if (topology.numNodes() == 0) {
+        topology.nodeIds = {0};
+        topology.nodeCpus = {allowed};
+    }
+    return topology;
+}
+
+ThreadPinning parseThreadPinning(const std::string &name) {
+    if (name == "off") {
+        return ThreadPinning::Off;
+    }
+    if (name == "compact") {
+        return ThreadPinning::Compact;
+    }
+    if (name == "spread") {
+        return ThreadPinning::Spread;
+    }
+    throw std::runtime_error("Unknown thread pinning: " + name);
+}
+
+NumaPlacement::NumaPlacement(NumaTopology topology, ThreadPinning pinning)
+    : topology(std::move(topology)), pinning(pinning) {
+    for (size_t node = 0; node < this->topology.numNodes(); ++node) {
+        for (int cpu : this->topology.nodeCpus[node]) {
+            this->cpus.push_back(cpu);
+            this->cpuNodes.push_back(node);
+        }
+    }
+    if (this->cpus.empty()) {
+        throw std::runtime_error("No CPUs to place workers on");
+    }
+}
+
+size_t NumaPlacement::nodeForWorker(size_t worker, size_t numWorkers) const {
+    if (this->pinning == ThreadPinning::Compact) {
+        return this->cpuNodes[worker % this->cpus.size()];
+    }
+    // Consecutive workers (so consecutive batches of fish) share a node
+    return worker * this->topology.numNodes() / std::max(numWorkers, (size_t) 1);
+}
+
+int NumaPlacement::cpuForWorker(size_t worker, size_t numWorkers) const {
+    if (this->pinning == ThreadPinning::Compact) {
+        return this->cpus[worker % this->cpus.size()];
+    }
+    const size_t numNodes = this->topology.numNodes();
+    const size_t node = this->nodeForWorker(worker, numWorkers);
+    const size_t firstWorker = (node * numWorkers + numNodes - 1) / numNodes;
+    const std::vector<int> &nodeCpus = this->topology.nodeCpus[node];
+    return nodeCpus[(worker - firstWorker) % nodeCpus.size()];
+}
+
+bool NumaPlacement::pinWorker(size_t worker, size_t numWorkers) const {
+    if (this->pinning == ThreadPinning::Off) {
+        return true;
+    }
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(this->cpuForWorker(worker, numWorkers), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// Prefer the node (or interleave over the nodes, kernel numbers) for the whole pages in [begin, end), moving
+// pages already placed elsewhere
+static bool bindPages(const void *begin, const void *end, bool interleave, const std::vector<int> &nodes) {
+#ifdef __linux__
+    const uintptr_t pageSize = (uintptr_t) sysconf(_SC_PAGESIZE);
+    const uintptr_t first = ((uintptr_t) begin + pageSize - 1) / pageSize * pageSize;
+    const uintptr_t last = (uintptr_t) end / pageSize * pageSize;
+    if (last <= first) {
+        return true;
+    }
+    constexpr size_t BITS = sizeof(unsigned long) * CHAR_BIT;
+    std::vector<unsigned long> mask((size_t) *std::max_element(nodes.begin(), nodes.end()) / BITS + 1, 0UL);
+    for (int node : nodes) {
+        mask[(size_t) node / BITS] |= 1UL << ((size_t) node % BITS);
+    }
+    const int mode = interleave ? MPOL_INTERLEAVE : MPOL_PREFERRED;
+    return syscall(SYS_mbind, (void *) first, (unsigned long) (last - first), mode, mask.data(),
+                   (unsigned long) (mask.size() * BITS + 1), MPOL_MF_MOVE) == 0;
+#else
+    (void) begin;
+    (void) end;
+    (void) interleave;
+    (void) nodes;
+    return false;
+#endif
+}
+
+bool NumaPlacement::moveToNode(const void *begin, const void *end, size_t node) const {
+    if (this->topology.numNodes() <= 1) {
+        return true;
+    }
+    return bindPages(begin, end, false, {this->topology.nodeIds[node]});
+}
+
+bool NumaPlacement::interleave(const void *begin, const void *end) const {
+    if (this->topology.numNodes() <= 1) {
+        return true;
+    }
+    return bindPages(begin, end, true, this->topology.nodeIds);
+}
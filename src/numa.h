@@ -0,0 +1,77 @@
+#ifndef __FISH_NUMA_H
+#define __FISH_NUMA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+* NUMA placement (the threadPinning and hydroPlacement parameters).
+*
+* Movement and growth workers each take a contiguous batch of the living fish, which (the list being in ID
+* order) is a contiguous stretch of Model::individuals. With pinning, each worker runs on a CPU of one node,
+* and at the start of each day (or when recruits have moved the fish storage) the pages holding its batch are
+* moved to that node, so from then on its fish are local rather than wherever the loading or recruiting
+* thread first touched them. The hydrology and the per-step environment aggregates are read by every worker
+* for any location, so they have no owner; instead they can be interleaved page by page across the nodes,
+* spreading their traffic over every memory controller.
+*
+* Placement is advice: where the kernel refuses it (or off Linux) the run carries on unplaced, and the
+* results are the same either way.
+*/
+
+// The machine's memory nodes and the CPUs on each
+typedef struct NumaTopology {
+    // Kernel node numbers, ascending
+    std::vector<int> nodeIds;
+    // CPUs of each node
+    std::vector<std::vector<int>> nodeCpus;
+    size_t numNodes() const { return this->nodeIds.size(); }
+    size_t numCpus() const;
+    // e.g. "2 NUMA nodes: 0 (CPUs 0-15), 1 (CPUs 16-31)"
+    std::string describe() const;
+} NumaTopology;
+
+// Parse a kernel CPU list ("0-3,8,10-11"); throws on anything else
+std::vector<int> parseCpuList(const std::string &list);
+// Read the nodes (nodeN/cpulist) under a sysfs node directory; nodes without CPUs are left out, and an empty
+// topology is returned if there are none
+NumaTopology readNumaTopology(const std::string &nodeDir);
+// This machine's topology, limited to the CPUs this process may run on (so a run under numactl --cpunodebind
+// sees only those nodes); a single node of every allowed CPU if the kernel doesn't report nodes
+NumaTopology detectNumaTopology();
+
+enum class ThreadPinning {
+    Off,
+    // Fill one node's CPUs before using the next
+    Compact,
+    // Share the workers evenly between the nodes
+    Spread
+};
+ThreadPinning parseThreadPinning(const std::string &name);
+
+class NumaPlacement {
+public:
+    NumaPlacement(NumaTopology topology, ThreadPinning pinning);
+
+    const NumaTopology &getTopology() const { return this->topology; }
+    ThreadPinning getPinning() const { return this->pinning; }
+    // The position in getTopology() of the node, and the CPU, that worker w of numWorkers runs on
+    size_t nodeForWorker(size_t worker, size_t numWorkers) const;
+    int cpuForWorker(size_t worker, size_t numWorkers) const;
+    // Pin the calling thread to its worker's CPU (nothing if pinning is off); false if the kernel refused
+    bool pinWorker(size_t worker, size_t numWorkers) const;
+    // Move the pages lying wholly within [begin, end) to a node (a position in getTopology()), or interleave
+    // them across every node; false if the kernel refused
+    bool moveToNode(const void *begin, const void *end, size_t node) const;
+    bool interleave(const void *begin, const void *end) const;
+
+private:
+    NumaTopology topology;
+    ThreadPinning pinning;
+    // Every node's CPUs in node order, and the node of each
+    std::vector<int> cpus;
+    std::vector<size_t> cpuNodes;
+};
+
+#endif
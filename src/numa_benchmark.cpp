@@ -0,0 +1,89 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "model.h"
+#include "util.h"
+
+/*
+* Benchmark of NUMA placement settings (threadPinning / hydroPlacement; see numa.h).
+*
+* Usage: numa_benchmark <config> [--steps n] [--seed s] [--settings "pinning/placement;..."]
+*
+* Loads the model afresh for each setting (so every run starts from memory placed by the loading thread,
+* as a real run does), runs it for n steps (default 720) with commonRandomNumbers = 1, and reports the
+* time spent moving and growing fish (the phases whose workers are pinned), the whole step time, and the
+* living fish at the end, which is the same for every setting. The first setting is the baseline for the
+* speedups. Without a multi-socket machine, a kernel booted with numa=fake=2 splits one into two nodes
+* (same memory latency, so only the placement itself is exercised).
+*/
+
+static const char *DEFAULT_SETTINGS = "off/default;spread/default;spread/interleave;compact/default;compact/interleave";
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: numa_benchmark <config> [--steps n] [--seed s] [--settings \"pinning/placement;...\"]" << std::endl;
+        return 1;
+    }
+    std::string configPath(argv[1]);
+    long steps = 720;
+    unsigned seed = 1U;
+    std::string settingList(DEFAULT_SETTINGS);
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg(argv[i]);
+        if (arg == "--steps") {
+            steps = std::stol(argv[i + 1]);
+        } else if (arg == "--seed") {
+            seed = (unsigned) std::stoul(argv[i + 1]);
+        } else if (arg == "--settings") {
+            settingList = argv[i + 1];
+        } else {
+            std::cerr << "Unrecognized option " << arg << std::endl;
+            return 1;
+        }
+    }
+    std::cout << detectNumaTopology().describe() << std::endl << std::endl;
+    std::cout << std::left << std::setw(24) << "pinning/placement" << std::right << std::setw(12) << "move s"
+        << std::setw(12) << "grow s" << std::setw(12) << "step s" << std::setw(12) << "speedup" << std::setw(12)
+        << "living" << std::endl;
+
+    std::istringstream settings(settingList);
+    std::string setting;
+    double baseline = 0.0;
+    while (std::getline(settings, setting, ';')) {
+        const size_t slash = setting.find('/');
+        Model *model = modelFromConfig(configPath);
+        ModelConfigMap config = model->getConfigMap();
+        config.set(ModelParamKey::CommonRandomNumbers, 1);
+        config.set(ModelParamKey::ThreadPinning, setting.substr(0, slash));
+        config.set(ModelParamKey::HydroPlacement, slash == std::string::npos ? "default" : setting.substr(slash + 1));
+        model->setConfigMap(config);
+        GlobalRand::reseed(seed);
+        model->reserveHistory((size_t) steps);
+
+        double moveSeconds = 0.0;
+        double growSeconds = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        while (model->time < steps) {
+            model->masterUpdate();
+            moveSeconds += model->lastStepTimings.move;
+            growSeconds += model->lastStepTimings.growAndDie;
+        }
+        double stepSeconds = secondsSince(start);
+        if (baseline == 0.0) {
+            baseline = moveSeconds + growSeconds;
+        }
+        std::cout << std::left << std::setw(24) << setting << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << moveSeconds << std::setw(12) << growSeconds << std::setw(12) << stepSeconds
+            << std::setprecision(2) << std::setw(12) << baseline / (moveSeconds + growSeconds) << std::setw(12)
+            << model->livingIndividuals.size() << std::endl;
+        delete model;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <filesystem>
+#include <netcdf>
+#include "output_storage.h"
+
+/*
+* Benchmark of NetCDF storage settings for tagged-history-shaped output.
+*
+* Usage: output_benchmark <scratch directory> [--fish n] [--timesteps t] [--specs "spec;spec;..."]
+*
+* Writes synthetic tagged histories (n fish x t timesteps; each fish is only active for part of the run,
+* so most entries are -1/0 padding as in real output) once per storage spec, then reports write time,
+* file size, and the time to read back one fish's track (fish-major access) and one timestep across all
+* fish (time-major access). Specs use the stateStorage/summaryStorage/... config syntax.
+*/
+
+static const char *DEFAULT_SPECS =
+    "contiguous;deflate:0,shuffle:0,chunk:32x720;deflate:1,shuffle:1,chunk:32x720;"
+    "deflate:4,shuffle:1,chunk:32x720;deflate:9,shuffle:1,chunk:32x720;deflate:4,shuffle:0,chunk:32x720;"
+    "deflate:4,shuffle:1,chunk:1x3984;deflate:4,shuffle:1,chunk:1024x24";
+
+typedef struct SyntheticHistories {
+    size_t numFish;
+    size_t numTimesteps;
+    std::vector<int> location;
+    std::vector<float> growth;
+    std::vector<float> temp;
+} SyntheticHistories;
+
+static SyntheticHistories makeHistories(size_t numFish, size_t numTimesteps) {
+    SyntheticHistories h{numFish, numTimesteps, {}, {}, {}};
+    h.location.assign(numFish * numTimesteps, -1);
+    h.growth.assign(numFish * numTimesteps, 0.0f);
+    h.temp.assign(numFish * numTimesteps, 0.0f);
+    std::mt19937 rng(12345U);
+    std::uniform_int_distribution<size_t> start(0, numTimesteps - 1);
+    std::uniform_int_distribution<size_t> duration(24, 40 * 24);
+    std::uniform_int_distribution<int> step(-2, 2);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    for (size_t n = 0; n < numFish; ++n) {
+        size_t t0 = start(rng);
+        size_t t1 = std::min(numTimesteps, t0 + duration(rng));
+        int loc = (int) (rng() % 20000U);
+        for (size_t t = t0; t < t1; ++t) {
+            loc = std::max(0, loc + step(rng));
+            h.location[n * numTimesteps + t] = loc;
+            h.growth[n * numTimesteps + t] = 0.002f + 0.0005f * noise(rng);
+            h.temp[n * numTimesteps + t] = 11.0f + 2.0f * std::sin((float) t / 24.0f * 6.2832f) + 0.1f * noise(rng);
+        }
+    }
+    return h;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: output_benchmark <scratch directory> [--fish n] [--timesteps t] [--specs \"spec;spec;...\"]" << std::endl;
+        return 1;
+    }
+    std::string scratch(argv[1]);
+    size_t numFish = 5000;
+    size_t numTimesteps = 166 * 24;
+    std::string specList(DEFAULT_SPECS);
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg(argv[i]);
+        if (arg == "--fish") {
+            numFish = std::stoul(argv[i + 1]);
+        } else if (arg == "--timesteps") {
+            numTimesteps = std::stoul(argv[i + 1]);
+        } else if (arg == "--specs") {
+            specList = argv[i + 1];
+        } else {
+            std::cerr << "Unrecognized option " << arg << std::endl;
+            return 1;
+        }
+    }
+    std::filesystem::create_directories(scratch);
+
+    std::cout << "Generating " << numFish << " x " << numTimesteps << " tagged histories..." << std::endl;
+    SyntheticHistories h = makeHistories(numFish, numTimesteps);
+    double rawMB = (double) (h.location.size() * 3 * 4) / (1024.0 * 1024.0);
+    std::cout << "Raw data: " << std::fixed << std::setprecision(1) << rawMB << " MB" << std::endl << std::endl;
+    std::cout << std::left << std::setw(40) << "storage" << std::right << std::setw(10) << "write s" << std::setw(10)
+        << "MB" << std::setw(10) << "ratio" << std::setw(12) << "fish ms" << std::setw(12) << "step ms" << std::endl;
+
+    std::istringstream specs(specList);
+    std::string spec;
+    int index = 0;
+    while (std::getline(specs, spec, ';')) {
+        NcStorageOptions storage = NcStorageOptions::parse(spec);
+        std::string path = scratch + "/output_benchmark_" + std::to_string(index++) + ".nc";
+
+        auto writeStart = std::chrono::steady_clock::now();
+        {
+            netCDF::NcFile file(path, netCDF::NcFile::FileMode::replace);
+            std::vector<netCDF::NcDim> dims{file.addDim("n", numFish), file.addDim("t", numTimesteps)};
+            addStoredVar(file, "locationHistory", netCDF::ncInt, dims, storage).putVar(h.location.data());
+            addStoredVar(file, "growthHistory", netCDF::ncFloat, dims, storage).putVar(h.growth.data());
+            addStoredVar(file, "tempHistory", netCDF::ncFloat, dims, storage).putVar(h.temp.data());
+        }
+        double writeSeconds = secondsSince(writeStart);
+        double sizeMB = (double) std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+        // Read patterns: one fish's whole track, and one timestep across every fish (fresh file handle each)
+        std::vector<float> fishTrack(numTimesteps);
+        std::vector<float> timestepSlice(numFish);
+        auto fishStart = std::chrono::steady_clock::now();
+        {
+            netCDF::NcFile file(path, netCDF::NcFile::FileMode::read);
+            file.getVar("growthHistory").getVar({numFish / 2, 0}, {1, numTimesteps}, fishTrack.data());
+        }
+        double fishMs = secondsSince(fishStart) * 1000.0;
+        auto stepStart = std::chrono::steady_clock::now();
+        {
+            netCDF::NcFile file(path, netCDF::NcFile::FileMode::read);
+            file.getVar("growthHistory").getVar({0, numTimesteps / 2}, {numFish, 1}, timestepSlice.data());
+        }
+        double stepMs = secondsSince(stepStart) * 1000.0;
+
+        std::cout << std::left << std::setw(40) << spec << std::right << std::setprecision(3) << std::setw(10)
+            << writeSeconds << std::setprecision(1) << std::setw(10) << sizeMB << std::setw(10) << rawMB / sizeMB
+            << std::setprecision(2) << std::setw(12) << fishMs << std::setw(12) << stepMs << std::endl;
+        std::filesystem::remove(path);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "output_storage.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+NcStorageOptions NcStorageOptions::parse(const std::string &spec) {
+    NcStorageOptions storage{false, 4, true, 32, 720};
+    if (spec == "contiguous") {
+        storage.contiguous = true;
+        storage.deflateLevel = 0;
+        storage.shuffle = false;
+        return storage;
+    }
+    std::istringstream settings(spec);
+    std::string setting;
+    while (std::getline(settings, setting, ',')) {
+        size_t colon = setting.find(':');
+        std::string key = setting.substr(0, colon);
+        std::string value = colon == std::string::npos ? "" : setting.substr(colon + 1);
+        try {
+            size_t used = 0;
+            if (key == "deflate") {
+                storage.deflateLevel = std::stoi(value, &used);
+                if (storage.deflateLevel < 0 || storage.deflateLevel > 9) {
+                    used = 0;
+                }
+            } else if (key == "shuffle") {
+                int shuffle = std::stoi(value, &used);
+                storage.shuffle = shuffle != 0;
+            } else if (key == "chunk") {
+                size_t x = value.find('x');
+                long rows = std::stol(value.substr(0, x), &used);
+                long columns = x == std::string::npos ? 0 : std::stol(value.substr(x + 1));
+                if (rows <= 0 || columns <= 0) {
+                    used = 0;
+                }
+                storage.chunkRows = (size_t) rows;
+                storage.chunkColumns = (size_t) columns;
+            }
+            if (used == 0) {
+                throw std::invalid_argument(setting);
+            }
+        } catch (const std::logic_error &e) {
+            throw std::runtime_error("Invalid NetCDF storage setting \"" + setting + "\" in \"" + spec + "\"");
+        }
+    }
+    return storage;
+}
+
+std::vector<size_t> getChunkSizes(const std::vector<size_t> &dimSizes, const NcStorageOptions &storage) {
+    std::vector<size_t> chunks;
+    // Zero-length variables and scalars have nothing to chunk
+    if (storage.contiguous || dimSizes.empty()
+        || std::find(dimSizes.begin(), dimSizes.end(), (size_t) 0) != dimSizes.end()) {
+        return chunks;
+    }
+    if (dimSizes.size() == 1) {
+        chunks.push_back(std::min(dimSizes[0], storage.chunkRows * storage.chunkColumns));
+    } else {
+        chunks.push_back(std::min(dimSizes[0], storage.chunkRows));
+        chunks.push_back(std::min(dimSizes[1], storage.chunkColumns));
+        for (size_t d = 2; d < dimSizes.size(); ++d) {
+            chunks.push_back(dimSizes[d]);
+        }
+    }
+    return chunks;
+}
+
+netCDF::NcVar addStoredVar(
+    const netCDF::NcFile &file,
+    const std::string &name,
+    const netCDF::NcType &type,
+    const std::vector<netCDF::NcDim> &dims,
+    const NcStorageOptions &storage
+) {
+    netCDF::NcVar var = file.addVar(name, type, dims);
+    std::vector<size_t> dimSizes;
+    for (const netCDF::NcDim &dim : dims) {
+        // An unlimited dimension is chunked as though it were arbitrarily long
+        dimSizes.push_back(dim.isUnlimited() ? std::numeric_limits<size_t>::max() : dim.getSize());
+    }
+    std::vector<size_t> chunks = getChunkSizes(dimSizes, storage);
+    if (chunks.empty()) {
+        return var;
+    }
+    // Filters need chunked storage, and both must be set before any data is written
+    var.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+    if (storage.deflateLevel > 0 || storage.shuffle) {
+        var.setCompression(storage.shuffle, storage.deflateLevel > 0, storage.deflateLevel);
+    }
+    return var;
+}
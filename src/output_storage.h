@@ -0,0 +1,41 @@
+#ifndef __FISH_OUTPUT_STORAGE_H
+#define __FISH_OUTPUT_STORAGE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <netcdf>
+
+/*
+* How a NetCDF output file's variables are stored on disk, parsed from a config string:
+*   "contiguous"                          uncompressed, unchunked (the old behaviour)
+*   "deflate:<0-9>,shuffle:<0|1>,chunk:<rows>x<columns>"
+* Any of the three comma-separated settings may be left out (defaults: deflate 4, shuffle on, chunk 32x720).
+* 2-D variables, which are all (fish or monitoring point) x timestep, are chunked rows x columns;
+* 1-D variables are chunked rows*columns elements at a time. Chunks are trimmed to the variable's size.
+*/
+typedef struct NcStorageOptions {
+    bool contiguous;
+    // 0 disables the deflate filter
+    int deflateLevel;
+    bool shuffle;
+    size_t chunkRows;
+    size_t chunkColumns;
+
+    // Throws std::runtime_error if the spec is malformed
+    static NcStorageOptions parse(const std::string &spec);
+} NcStorageOptions;
+
+// Chunk sizes for a variable with the given dimension lengths (empty if it should stay contiguous)
+std::vector<size_t> getChunkSizes(const std::vector<size_t> &dimSizes, const NcStorageOptions &storage);
+
+// Add a variable to the file, chunked and compressed according to the storage options
+netCDF::NcVar addStoredVar(
+    const netCDF::NcFile &file,
+    const std::string &name,
+    const netCDF::NcType &type,
+    const std::vector<netCDF::NcDim> &dims,
+    const NcStorageOptions &storage
+);
+
+#endif
@@ -0,0 +1,140 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "model.h"
+#include "util.h"
+
+/*
+* Paired ensemble comparison of two scenarios using common random numbers.
+*
+* Usage: paired_ensemble <config A> <config B> [--seeds n] [--steps n]
+*
+* Runs both configurations for each seed 1..n (default 8) with commonRandomNumbers = 1, so a fish makes
+* the same draws in both scenarios wherever their states coincide, and reports per metric the mean of
+* each scenario, the mean and standard deviation of the paired differences with a 95% confidence
+* interval, and the variance reduction (var A + var B) / var(A - B): the factor by which pairing cuts
+* the number of replicates an unpaired comparison would need for the same precision.
+*/
+
+typedef struct PairedRun {
+    // Metric name -> value; samples are keyed by site and hour, so only ones present in every run compare
+    std::map<std::string, double> metrics;
+} PairedRun;
+
+static std::vector<PairedRun> runScenario(const std::string &configPath, unsigned int seeds, long steps) {
+    Model *model = modelFromConfig(configPath);
+    ModelConfigMap config = model->getConfigMap();
+    config.set(ModelParamKey::CommonRandomNumbers, 1);
+    model->setConfigMap(config);
+    std::vector<PairedRun> runs;
+    for (unsigned int seed = 1; seed <= seeds; ++seed) {
+        GlobalRand::reseed(seed);
+        model->reset();
+        model->reserveHistory((size_t) steps);
+        while (model->time < steps) {
+            model->masterUpdate();
+        }
+        PairedRun run;
+        run.metrics["living"] = model->livingAbundance;
+        run.metrics["dead"] = model->deadAbundance;
+        run.metrics["exited"] = model->exitedAbundance;
+        double weight = 0.0, length = 0.0, mass = 0.0;
+        for (size_t id : model->livingIndividuals) {
+            const Fish &f = model->individuals[id];
+            weight += f.weight;
+            length += f.weight * f.forkLength;
+            mass += f.weight * f.mass;
+        }
+        run.metrics["final mean length"] = weight > 0.0 ? length / weight : 0.0;
+        run.metrics["final mean mass"] = weight > 0.0 ? mass / weight : 0.0;
+        for (const Sample &s : model->sampleHistory) {
+            std::string prefix = "site " + std::to_string(s.siteID) + " h" + std::to_string(s.time * model->getHoursPerTimestep());
+            run.metrics[prefix + " population"] = (double) s.population;
+            run.metrics[prefix + " mean length"] = s.meanLength;
+        }
+        runs.push_back(run);
+        std::cout << configPath << " seed " << seed << " done" << std::endl;
+    }
+    delete model;
+    return runs;
+}
+
+static void meanVariance(const std::vector<double> &values, double &mean, double &variance) {
+    mean = 0.0;
+    for (double v : values) mean += v;
+    mean /= (double) values.size();
+    double ss = 0.0;
+    for (double v : values) ss += (v - mean) * (v - mean);
+    variance = values.size() > 1 ? ss / (double) (values.size() - 1) : 0.0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: paired_ensemble <config A> <config B> [--seeds n] [--steps n]" << std::endl;
+        return 1;
+    }
+    std::string configA(argv[1]);
+    std::string configB(argv[2]);
+    unsigned int seeds = 8;
+    long steps = 30 * 24;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string arg(argv[i]);
+        if (arg == "--seeds") {
+            seeds = (unsigned int) std::stoul(argv[i + 1]);
+        } else if (arg == "--steps") {
+            steps = std::stol(argv[i + 1]);
+        } else {
+            std::cerr << "Unrecognized option " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (seeds < 2 || steps <= 0) {
+        std::cerr << "Need --seeds >= 2 and --steps > 0" << std::endl;
+        return 1;
+    }
+
+    // One scenario at a time, so only one set of inputs is in memory
+    std::vector<PairedRun> runsA = runScenario(configA, seeds, steps);
+    std::vector<PairedRun> runsB = runScenario(configB, seeds, steps);
+
+    std::cout << std::endl << std::left << std::setw(34) << "metric" << std::right
+              << std::setw(12) << "mean A" << std::setw(12) << "mean B" << std::setw(12) << "diff"
+              << std::setw(12) << "sd diff" << std::setw(26) << "95% CI" << std::setw(12) << "var. red." << std::endl;
+    for (const auto &entry : runsA[0].metrics) {
+        const std::string &name = entry.first;
+        std::vector<double> a, b, diff;
+        bool everywhere = true;
+        for (unsigned int i = 0; i < seeds && everywhere; ++i) {
+            everywhere = runsA[i].metrics.count(name) && runsB[i].metrics.count(name);
+            if (everywhere) {
+                a.push_back(runsA[i].metrics.at(name));
+                b.push_back(runsB[i].metrics.at(name));
+                diff.push_back(b.back() - a.back());
+            }
+        }
+        if (!everywhere) {
+            continue;
+        }
+        double meanA, varA, meanB, varB, meanDiff, varDiff;
+        meanVariance(a, meanA, varA);
+        meanVariance(b, meanB, varB);
+        meanVariance(diff, meanDiff, varDiff);
+        // Normal approximation to the t interval
+        double halfWidth = 1.96 * std::sqrt(varDiff / (double) seeds);
+        std::string interval = "[" + std::to_string(meanDiff - halfWidth) + ", " + std::to_string(meanDiff + halfWidth) + "]";
+        std::cout << std::left << std::setw(34) << name << std::right << std::setprecision(4)
+                  << std::setw(12) << meanA << std::setw(12) << meanB << std::setw(12) << meanDiff
+                  << std::setw(12) << std::sqrt(varDiff) << std::setw(26) << interval << std::setw(12);
+        if (varDiff > 0.0) {
+            std::cout << (varA + varB) / varDiff;
+        } else {
+            std::cout << (varA + varB > 0.0 ? "inf" : "-");
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
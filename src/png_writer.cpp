@@ -0,0 +1,109 @@
+#include "png_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+// Largest payload of a single stored deflate block
+constexpr size_t MAX_STORED_BLOCK = 65535;
+
+static const std::array<unsigned long, 256> &crcTable() {
+    static const std::array<unsigned long, 256> table = []() {
+        std::array<unsigned long, 256> t{};
+        for (unsigned long n = 0; n < 256; ++n) {
+            unsigned long c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1UL) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+unsigned long pngCrc32(const unsigned char *data, size_t length, unsigned long crc) {
+    const std::array<unsigned long, 256> &table = crcTable();
+    crc ^= 0xFFFFFFFFUL;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFFUL] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+static void putUint32(std::vector<unsigned char> &out, unsigned long v) {
+    out.push_back((unsigned char) ((v >> 24) & 0xFFUL));
+    out.push_back((unsigned char) ((v >> 16) & 0xFFUL));
+    out.push_back((unsigned char) ((v >> 8) & 0xFFUL));
+    out.push_back((unsigned char) (v & 0xFFUL));
+}
+
+static void putChunk(std::vector<unsigned char> &out, const char *type, const std::vector<unsigned char> &data) {
+    putUint32(out, data.size());
+    size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    // The CRC covers the chunk type and data
+    putUint32(out, pngCrc32(out.data() + typeStart, out.size() - typeStart));
+}
+
+std::vector<unsigned char> encodePng(int width, int height, const std::vector<unsigned char> &rgb) {
+    if (width <= 0 || height <= 0 || rgb.size() != (size_t) width * height * 3) {
+        throw std::runtime_error("encodePng: pixel buffer doesn't match the image size");
+    }
+    std::vector<unsigned char> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::vector<unsigned char> header;
+    putUint32(header, (unsigned long) width);
+    putUint32(header, (unsigned long) height);
+    // 8 bits per channel, RGB, deflate, adaptive filtering, no interlace
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    putChunk(png, "IHDR", header);
+
+    // Scanlines, each prefixed with filter type 0 (none)
+    const size_t rowBytes = (size_t) width * 3;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + y * rowBytes, rgb.begin() + (y + 1) * rowBytes);
+    }
+
+    // zlib stream of stored blocks
+    std::vector<unsigned char> zlib;
+    zlib.reserve(raw.size() + raw.size() / MAX_STORED_BLOCK * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    size_t pos = 0;
+    do {
+        size_t len = std::min(MAX_STORED_BLOCK, raw.size() - pos);
+        bool last = pos + len == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back((unsigned char) (len & 0xFF));
+        zlib.push_back((unsigned char) (len >> 8));
+        zlib.push_back((unsigned char) (~len & 0xFF));
+        zlib.push_back((unsigned char) ((~len >> 8) & 0xFF));
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+    } while (pos < raw.size());
+    unsigned long a = 1UL;
+    unsigned long b = 0UL;
+    for (unsigned char c : raw) {
+        a = (a + c) % 65521UL;
+        b = (b + a) % 65521UL;
+    }
+    putUint32(zlib, (b << 16) | a);
+    putChunk(png, "IDAT", zlib);
+    putChunk(png, "IEND", {});
+    return png;
+}
+
+void writePng(const std::string &path, int width, int height, const std::vector<unsigned char> &rgb) {
+    std::vector<unsigned char> png = encodePng(width, height, rgb);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(png.data()), png.size());
+    if (!out) {
+        throw std::runtime_error("Unable to write " + path);
+    }
+}
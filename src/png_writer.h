@@ -0,0 +1,20 @@
+#ifndef __FISH_PNG_WRITER_H
+#define __FISH_PNG_WRITER_H
+
+#include <string>
+#include <vector>
+
+/*
+* Minimal PNG encoder for 8-bit RGB images (rows top to bottom, 3 bytes per pixel).
+* There's no zlib dependency: image data goes into stored (uncompressed) deflate blocks,
+* which every PNG reader accepts. Files are larger than compressed PNGs but encoding is
+* just a copy plus checksums.
+*/
+std::vector<unsigned char> encodePng(int width, int height, const std::vector<unsigned char> &rgb);
+// Encode and write to path; throws std::runtime_error if the file can't be written
+void writePng(const std::string &path, int width, int height, const std::vector<unsigned char> &rgb);
+
+// CRC-32 as used by PNG chunks (exposed for tests)
+unsigned long pngCrc32(const unsigned char *data, size_t length, unsigned long crc = 0UL);
+
+#endif
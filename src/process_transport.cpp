@@ -0,0 +1,272 @@
+#include "process_transport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+class SocketTransport : public ProcessTransport {
+public:
+    explicit SocketTransport(size_t numProcesses)
+        : ProcessTransport(numProcesses), fds(numProcesses * numProcesses, -1) {
+        // fds[a * n + b] is a's end of the socket pair it shares with b
+        for (size_t a = 0; a < numProcesses; ++a) {
+            for (size_t b = a + 1; b < numProcesses; ++b) {
+                int pair[2];
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                    this->closeAll();
+                    throw std::runtime_error("Couldn't create a socket pair for a distributed run");
+                }
+                this->fds[a * numProcesses + b] = pair[0];
+                this->fds[b * numProcesses + a] = pair[1];
+            }
+        }
+    }
+
+    ~SocketTransport() override {
+        this->closeAll();
+    }
+
+    void attach(size_t rank) override {
+        this->rank = rank;
+        for (size_t a = 0; a < this->numProcesses; ++a) {
+            for (size_t b = 0; b < this->numProcesses; ++b) {
+                int &fd = this->fds[a * this->numProcesses + b];
+                if (a != rank && fd >= 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+        }
+    }
+
+    void send(size_t peer, const void *data, size_t length) override {
+        const char *bytes = static_cast<const char *>(data);
+        while (length > 0) {
+            ssize_t sent = ::send(this->fd(peer), bytes, length, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                throw std::runtime_error("Lost the connection to process " + std::to_string(peer));
+            }
+            bytes += sent;
+            length -= (size_t) sent;
+        }
+    }
+
+    void receive(size_t peer, void *data, size_t length) override {
+        char *bytes = static_cast<char *>(data);
+        while (length > 0) {
+            ssize_t received = read(this->fd(peer), bytes, length);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                throw std::runtime_error("Lost the connection to process " + std::to_string(peer));
+            }
+            bytes += received;
+            length -= (size_t) received;
+        }
+    }
+
+    void abort() override {
+        for (size_t b = 0; b < this->numProcesses; ++b) {
+            int fd = this->fds[this->rank * this->numProcesses + b];
+            if (fd >= 0) {
+                shutdown(fd, SHUT_RDWR);
+            }
+        }
+    }
+
+private:
+    std::vector<int> fds;
+
+    int fd(size_t peer) const {
+        return this->fds[this->rank * this->numProcesses + peer];
+    }
+
+    void closeAll() {
+        for (int &fd : this->fds) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+};
+
+// One direction between two processes: bytes [consumed, written) of the stream are in the buffer
+typedef struct ShmChannel {
+    alignas(64) std::atomic<uint64_t> written;
+    alignas(64) std::atomic<uint64_t> consumed;
+} ShmChannel;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory channels need lock-free atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory channels need lock-free atomics");
+
+class SharedMemoryTransport : public ProcessTransport {
+public:
+    SharedMemoryTransport(size_t numProcesses, size_t bufferBytes)
+        : ProcessTransport(numProcesses), bufferBytes(bufferBytes),
+          channelBytes(sizeof(ShmChannel) + bufferBytes),
+          regionBytes(HEADER_BYTES + numProcesses * numProcesses * (sizeof(ShmChannel) + bufferBytes)) {
+        this->region = static_cast<char *>(mmap(nullptr, this->regionBytes, PROT_READ | PROT_WRITE,
+                                                MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+        if (this->region == MAP_FAILED) {
+            throw std::runtime_error("Couldn't map shared memory for a distributed run");
+        }
+        new (this->region) std::atomic<uint32_t>(0);
+        for (size_t i = 0; i < numProcesses * numProcesses; ++i) {
+            ShmChannel *channel = new (this->region + HEADER_BYTES + i * this->channelBytes) ShmChannel;
+            channel->written.store(0);
+            channel->consumed.store(0);
+        }
+    }
+
+    ~SharedMemoryTransport() override {
+        munmap(this->region, this->regionBytes);
+    }
+
+    void attach(size_t rank) override {
+        this->rank = rank;
+    }
+
+    void send(size_t peer, const void *data, size_t length) override {
+        ShmChannel &channel = this->channel(this->rank, peer);
+        char *buffer = reinterpret_cast<char *>(&channel + 1);
+        const char *bytes = static_cast<const char *>(data);
+        int waits = 0;
+        while (length > 0) {
+            const uint64_t written = channel.written.load(std::memory_order_relaxed);
+            const uint64_t free = this->bufferBytes - (written - channel.consumed.load(std::memory_order_acquire));
+            if (free == 0) {
+                this->wait(waits++);
+                continue;
+            }
+            const size_t start = (size_t) (written % this->bufferBytes);
+            const size_t count = std::min({(size_t) free, length, this->bufferBytes - start});
+            std::memcpy(buffer + start, bytes, count);
+            channel.written.store(written + count, std::memory_order_release);
+            bytes += count;
+            length -= count;
+            waits = 0;
+        }
+    }
+
+    void receive(size_t peer, void *data, size_t length) override {
+        ShmChannel &channel = this->channel(peer, this->rank);
+        const char *buffer = reinterpret_cast<const char *>(&channel + 1);
+        char *bytes = static_cast<char *>(data);
+        int waits = 0;
+        while (length > 0) {
+            const uint64_t consumed = channel.consumed.load(std::memory_order_relaxed);
+            const uint64_t available = channel.written.load(std::memory_order_acquire) - consumed;
+            if (available == 0) {
+                this->wait(waits++);
+                continue;
+            }
+            const size_t start = (size_t) (consumed % this->bufferBytes);
+            const size_t count = std::min({(size_t) available, length, this->bufferBytes - start});
+            std::memcpy(bytes, buffer + start, count);
+            channel.consumed.store(consumed + count, std::memory_order_release);
+            bytes += count;
+            length -= count;
+            waits = 0;
+        }
+    }
+
+    void abort() override {
+        this->aborted().store(1, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t HEADER_BYTES = 64;
+    size_t bufferBytes;
+    size_t channelBytes;
+    size_t regionBytes;
+    char *region;
+
+    std::atomic<uint32_t> &aborted() {
+        return *reinterpret_cast<std::atomic<uint32_t> *>(this->region);
+    }
+
+    ShmChannel &channel(size_t from, size_t to) {
+        return *reinterpret_cast<ShmChannel *>(this->region + HEADER_BYTES
+                                               + (from * this->numProcesses + to) * this->channelBytes);
+    }
+
+    // Spin briefly, then back off to short sleeps
+    void wait(int waits) {
+        if (this->aborted().load(std::memory_order_acquire) != 0) {
+            throw std::runtime_error("Another process of the distributed run failed");
+        }
+        if (waits < 1000) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+};
+
+} // namespace
+
+std::unique_ptr<ProcessTransport> makeSocketTransport(size_t numProcesses) {
+    return std::make_unique<SocketTransport>(numProcesses);
+}
+
+std::unique_ptr<ProcessTransport> makeSharedMemoryTransport(size_t numProcesses, size_t bufferBytes) {
+    return std::make_unique<SharedMemoryTransport>(numProcesses, bufferBytes);
+}
+
+std::unique_ptr<ProcessTransport> makeProcessTransport(const std::string &name, size_t numProcesses) {
+    if (name == "socket") {
+        return makeSocketTransport(numProcesses);
+    }
+    if (name == "shm") {
+        return makeSharedMemoryTransport(numProcesses);
+    }
+    throw std::runtime_error("Unknown process transport: " + name);
+}
+
+void sendMessage(ProcessTransport &transport, size_t peer, const std::vector<char> &message) {
+    const uint64_t length = message.size();
+    transport.send(peer, &length, sizeof(length));
+    transport.send(peer, message.data(), message.size());
+}
+
+std::vector<char> receiveMessage(ProcessTransport &transport, size_t peer) {
+    uint64_t length = 0;
+    transport.receive(peer, &length, sizeof(length));
+    std::vector<char> message((size_t) length);
+    transport.receive(peer, message.data(), message.size());
+    return message;
+}
+
+std::vector<std::vector<char>> exchangeMessages(ProcessTransport &transport,
+                                                const std::vector<std::vector<char>> &outgoing) {
+    const size_t rank = transport.getRank();
+    std::vector<std::vector<char>> incoming(transport.getNumProcesses());
+    // Every process handles its pairs in the same global order (by lower rank, then higher), and the lower
+    // rank of each pair sends first
+    for (size_t peer = 0; peer < transport.getNumProcesses(); ++peer) {
+        if (peer == rank) {
+            continue;
+        }
+        if (rank < peer) {
+            sendMessage(transport, peer, outgoing[peer]);
+            incoming[peer] = receiveMessage(transport, peer);
+        } else {
+            incoming[peer] = receiveMessage(transport, peer);
+            sendMessage(transport, peer, outgoing[peer]);
+        }
+    }
+    return incoming;
+}
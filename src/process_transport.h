@@ -0,0 +1,92 @@
+#ifndef __FISH_PROCESS_TRANSPORT_H
+#define __FISH_PROCESS_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+* Byte streams between the processes of a distributed run (see distributed.h), one each way between every
+* pair. A transport is created before the processes are forked, and each process then attaches to it with
+* its rank. send blocks until the peer has taken (or buffered) the bytes, and receive until they've all
+* arrived, so peers must agree on the order of their messages; exchangeMessages does that for the usual
+* everyone-to-everyone step.
+*/
+class ProcessTransport {
+public:
+    virtual ~ProcessTransport() = default;
+    size_t getNumProcesses() const { return this->numProcesses; }
+    size_t getRank() const { return this->rank; }
+    // Called once in each process after forking
+    virtual void attach(size_t rank) = 0;
+    virtual void send(size_t peer, const void *data, size_t length) = 0;
+    virtual void receive(size_t peer, void *data, size_t length) = 0;
+    // Make every peer's waits fail (e.g. when this process can't go on). Sockets also fail their peers' waits
+    // when a process dies outright; shared memory can't tell.
+    virtual void abort() = 0;
+
+protected:
+    explicit ProcessTransport(size_t numProcesses) : numProcesses(numProcesses), rank(0) {}
+    size_t numProcesses;
+    size_t rank;
+};
+
+// Unix domain socket pairs
+std::unique_ptr<ProcessTransport> makeSocketTransport(size_t numProcesses);
+// Ring buffers of bufferBytes each in anonymous shared memory
+std::unique_ptr<ProcessTransport> makeSharedMemoryTransport(size_t numProcesses, size_t bufferBytes = 1 << 18);
+// By name: "socket" or "shm"; throws for anything else
+std::unique_ptr<ProcessTransport> makeProcessTransport(const std::string &name, size_t numProcesses);
+
+// Send outgoing[peer] to every other process and return what each sent this one (indexed by rank; this
+// process's own entry is empty). Peers are visited in an order (pairs by lower rank, then higher) that
+// can't deadlock however large the messages.
+std::vector<std::vector<char>> exchangeMessages(ProcessTransport &transport,
+                                                const std::vector<std::vector<char>> &outgoing);
+// A single length-prefixed message each way
+void sendMessage(ProcessTransport &transport, size_t peer, const std::vector<char> &message);
+std::vector<char> receiveMessage(ProcessTransport &transport, size_t peer);
+
+// Appends plain values to a message
+class MessageWriter {
+public:
+    explicit MessageWriter(std::vector<char> &out) : out(out) {}
+    template <typename T>
+    void put(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "messages hold plain values");
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        this->out.insert(this->out.end(), bytes, bytes + sizeof(T));
+    }
+
+private:
+    std::vector<char> &out;
+};
+
+// Reads the values a MessageWriter wrote, in the same order; throws if the message runs out
+class MessageReader {
+public:
+    explicit MessageReader(const std::vector<char> &in) : in(in), offset(0) {}
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "messages hold plain values");
+        if (this->offset + sizeof(T) > this->in.size()) {
+            throw std::runtime_error("Truncated message between processes");
+        }
+        T value;
+        std::memcpy(&value, this->in.data() + this->offset, sizeof(T));
+        this->offset += sizeof(T);
+        return value;
+    }
+    bool done() const { return this->offset == this->in.size(); }
+
+private:
+    const std::vector<char> &in;
+    size_t offset;
+};
+
+#endif
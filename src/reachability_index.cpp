@@ -0,0 +1,124 @@
+#include "reachability_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+
+ReachabilityIndex::ReachabilityIndex() : neighborhoodSize(0), offsets(1, 0) {}
+
+ReachabilityIndex::ReachabilityIndex(size_t neighborhoodSize, std::vector<uint64_t> offsets, std::vector<float> radii,
+                                     std::vector<uint32_t> ids, std::vector<float> lengths)
+    : neighborhoodSize(neighborhoodSize), offsets(std::move(offsets)), radii(std::move(radii)), ids(std::move(ids)),
+      lengths(std::move(lengths)) {}
+
+// The largest float no greater than value, so stored lower bounds and radii never overstate
+static float floatAtMost(double value) {
+    float rounded = (float) value;
+    return (double) rounded > value ? std::nextafter(rounded, 0.0f) : rounded;
+}
+
+// The neighborhoods of locations [first, last), appended to ids and lengths with their sizes in counts
+typedef struct NeighborhoodRange {
+    std::vector<uint32_t> counts;
+    std::vector<float> radii;
+    std::vector<uint32_t> ids;
+    std::vector<float> lengths;
+} NeighborhoodRange;
+
+static void buildRange(const std::vector<MapNode *> &map, size_t first, size_t last, size_t neighborhoodSize,
+                       NeighborhoodRange &out) {
+    typedef std::pair<double, uint32_t> QueueEntry;
+    std::vector<double> pathLengths(map.size());
+    // Per-source generation stamps, so the arrays aren't cleared for every source
+    std::vector<uint32_t> seen(map.size(), 0);
+    std::vector<uint32_t> settled(map.size(), 0);
+    uint32_t generation = 0;
+    for (size_t source = first; source < last; ++source) {
+        ++generation;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+        pathLengths[source] = 0.0;
+        seen[source] = generation;
+        queue.emplace(0.0, (uint32_t) source);
+        size_t count = 0;
+        double radius = std::numeric_limits<double>::infinity();
+        while (!queue.empty()) {
+            const auto [pathLength, id] = queue.top();
+            if (settled[id] == generation || pathLength > pathLengths[id]) {
+                queue.pop();
+                continue;
+            }
+            if (count == neighborhoodSize) {
+                // Everything closer than the next location to settle is in the neighborhood
+                radius = pathLength;
+                break;
+            }
+            queue.pop();
+            settled[id] = generation;
+            out.ids.push_back(id);
+            out.lengths.push_back(floatAtMost(pathLength));
+            ++count;
+            const MapNode *node = map[id];
+            auto relax = [&](const Edge &edge) {
+                const MapNode *other = edge.source == node ? edge.target : edge.source;
+                // Movement caps the cost of the first hop into a distributary, so it's a free step
+                const double length = (id == source && isDistributary(other->type)) ? 0.0 : (double) edge.length;
+                const uint32_t otherId = (uint32_t) other->id;
+                if (seen[otherId] != generation || pathLength + length < pathLengths[otherId]) {
+                    seen[otherId] = generation;
+                    pathLengths[otherId] = pathLength + length;
+                    queue.emplace(pathLength + length, otherId);
+                }
+            };
+            for (const Edge &edge : node->edgesIn) {
+                relax(edge);
+            }
+            for (const Edge &edge : node->edgesOut) {
+                relax(edge);
+            }
+        }
+        out.counts.push_back((uint32_t) count);
+        out.radii.push_back(std::isinf(radius) ? std::numeric_limits<float>::infinity() : floatAtMost(radius));
+    }
+}
+
+ReachabilityIndex ReachabilityIndex::build(const std::vector<MapNode *> &map, size_t neighborhoodSize,
+                                           size_t maxThreads) {
+    if (neighborhoodSize == 0 || map.empty()) {
+        return ReachabilityIndex();
+    }
+    for (size_t i = 0; i < map.size(); ++i) {
+        if (map[i]->id != (int) i) {
+            return ReachabilityIndex();
+        }
+    }
+    const size_t numThreads = std::max((size_t) 1, std::min(maxThreads, map.size() / 256 + 1));
+    std::vector<NeighborhoodRange> ranges(numThreads);
+    std::vector<std::thread> threads;
+    const size_t perThread = (map.size() + numThreads - 1) / numThreads;
+    for (size_t t = 0; t < numThreads; ++t) {
+        const size_t first = std::min(map.size(), t * perThread);
+        const size_t last = std::min(map.size(), first + perThread);
+        threads.emplace_back(buildRange, std::cref(map), first, last, neighborhoodSize, std::ref(ranges[t]));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    ReachabilityIndex index;
+    index.neighborhoodSize = neighborhoodSize;
+    index.offsets.reserve(map.size() + 1);
+    for (NeighborhoodRange &range : ranges) {
+        for (uint32_t count : range.counts) {
+            index.offsets.push_back(index.offsets.back() + count);
+        }
+        index.radii.insert(index.radii.end(), range.radii.begin(), range.radii.end());
+        index.ids.insert(index.ids.end(), range.ids.begin(), range.ids.end());
+        index.lengths.insert(index.lengths.end(), range.lengths.begin(), range.lengths.end());
+        range = NeighborhoodRange();
+    }
+    return index;
+}
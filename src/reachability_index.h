@@ -0,0 +1,56 @@
+#ifndef __FISH_REACHABILITY_INDEX_H
+#define __FISH_REACHABILITY_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "map.h"
+
+/*
+* Static neighborhoods for high-awareness movement (see FishMovementHighAwareness). A move along an edge
+* costs length * swimSpeed / transitSpeed, and the transit speed is at most swimSpeed plus the fastest flow,
+* so a location at path length L can only be reached within a timestep if L <= swimRange * (swimSpeed +
+* maxFlowSpeed) / swimSpeed. (The first hop into a distributary is capped at the swim range, so it counts as
+* length 0.) Path lengths don't change during a run, so each location's nearest locations by path length
+* are found once after the map is loaded and cached with the map; a fish's search then only visits the part
+* of its neighborhood within that bound. Each neighborhood holds at most neighborhoodSize locations and
+* records the path length it's complete up to; a search reaching past that uses the whole map.
+*/
+class ReachabilityIndex {
+public:
+    ReachabilityIndex();
+    // From the parts written to the map cache (see the accessors below)
+    ReachabilityIndex(size_t neighborhoodSize, std::vector<uint64_t> offsets, std::vector<float> radii,
+                      std::vector<uint32_t> ids, std::vector<float> lengths);
+
+    // Index every location of a map whose MapNode::ids are their positions, using up to maxThreads threads.
+    // Returns an empty index if neighborhoodSize is 0 or the ids aren't positions.
+    static ReachabilityIndex build(const std::vector<MapNode *> &map, size_t neighborhoodSize, size_t maxThreads);
+
+    bool empty() const { return this->radii.empty(); }
+    size_t getNeighborhoodSize() const { return this->neighborhoodSize; }
+    size_t getNumNodes() const { return this->radii.size(); }
+    // Whether the neighborhood of location id holds every location within pathLength of it
+    bool covers(size_t id, double pathLength) const { return pathLength < (double) this->radii[id]; }
+    // The neighborhood of location id (itself first), nearest first, with each location's path length lower
+    // bound
+    size_t neighborCount(size_t id) const { return (size_t) (this->offsets[id + 1] - this->offsets[id]); }
+    const uint32_t *neighborIds(size_t id) const { return this->ids.data() + this->offsets[id]; }
+    const float *neighborLengths(size_t id) const { return this->lengths.data() + this->offsets[id]; }
+
+    const std::vector<uint64_t> &getOffsets() const { return this->offsets; }
+    const std::vector<float> &getRadii() const { return this->radii; }
+    const std::vector<uint32_t> &getIds() const { return this->ids; }
+    const std::vector<float> &getLengths() const { return this->lengths; }
+
+private:
+    size_t neighborhoodSize;
+    // Location id's neighborhood is entries [offsets[id], offsets[id + 1]) of ids and lengths
+    std::vector<uint64_t> offsets;
+    // Path length each neighborhood is complete below (infinity if it holds everything reachable)
+    std::vector<float> radii;
+    std::vector<uint32_t> ids;
+    std::vector<float> lengths;
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <sys/stat.h>
+#include "model.h"
+#include "render_snapshot.h"
+#include "frame_renderer.h"
+#include "png_writer.h"
+
+/*
+* Batch animation frame export without a GUI.
+*
+* Usage: render <output directory> [options]
+*   --config <file>           model config (default: default_config_env_from_file.json)
+*   --replay <file>           render a tag replay (NetCDF history or .replay file) instead of running the model
+*   --steps <n>               timesteps to run or replay (default: 166 days, or the whole replay)
+*   --stride <n>              render every n-th timestep (default: 1)
+*   --size <w>x<h>            frame size in pixels (default: 1280x960)
+*   --viewport <minX,minY,maxX,maxY>  map area to show, in map coordinates (default: whole map)
+*   --threads <n>             rasterizing/encoding threads (default: hardware concurrency)
+*
+* Frames are written as <output directory>/frame_<timestep>.png. The model (or replay) is
+* stepped on the main thread; snapshots are handed to worker threads that rasterize and encode them.
+*/
+
+typedef struct RenderOptions {
+    std::string outputPath;
+    std::string configPath;
+    std::string replayPath;
+    long steps;
+    long stride;
+    int width;
+    int height;
+    bool hasViewport;
+    FrameViewport viewport;
+    unsigned threads;
+} RenderOptions;
+
+void printUsage() {
+    std::cerr << "Usage: render <output directory> [--config file] [--replay file] [--steps n] [--stride n]"
+        << " [--size WxH] [--viewport minX,minY,maxX,maxY] [--threads n]" << std::endl;
+}
+
+bool parseOptions(int argc, char **argv, RenderOptions &opts) {
+    if (argc < 2) {
+        return false;
+    }
+    opts.outputPath = argv[1];
+    opts.configPath = "default_config_env_from_file.json";
+    opts.steps = -1;
+    opts.stride = 1;
+    opts.width = 1280;
+    opts.height = 960;
+    opts.hasViewport = false;
+    opts.threads = std::max(1U, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value(argv[++i]);
+        try {
+            if (arg == "--config") {
+                opts.configPath = value;
+            } else if (arg == "--replay") {
+                opts.replayPath = value;
+            } else if (arg == "--steps") {
+                opts.steps = std::stol(value);
+            } else if (arg == "--stride") {
+                opts.stride = std::max(1L, std::stol(value));
+            } else if (arg == "--size") {
+                size_t x = value.find('x');
+                if (x == std::string::npos) {
+                    return false;
+                }
+                opts.width = std::stoi(value.substr(0, x));
+                opts.height = std::stoi(value.substr(x + 1));
+            } else if (arg == "--viewport") {
+                char sep;
+                std::istringstream is(value);
+                if (!(is >> opts.viewport.minX >> sep >> opts.viewport.minY >> sep >> opts.viewport.maxX >> sep >> opts.viewport.maxY)) {
+                    return false;
+                }
+                opts.hasViewport = true;
+            } else if (arg == "--threads") {
+                opts.threads = (unsigned) std::max(1, std::stoi(value));
+            } else {
+                std::cerr << "Unrecognized option " << arg << std::endl;
+                return false;
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return false;
+        }
+    }
+    return opts.width > 0 && opts.height > 0;
+}
+
+// Bounded hand-off from the stepping thread to the frame workers
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+    void push(std::unique_ptr<RenderSnapshot> snapshot) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->notFull.wait(lock, [this]() { return this->frames.size() < this->capacity; });
+        this->frames.push_back(std::move(snapshot));
+        this->notEmpty.notify_one();
+    }
+
+    // Returns nullptr once the queue is closed and drained
+    std::unique_ptr<RenderSnapshot> pop() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->notEmpty.wait(lock, [this]() { return !this->frames.empty() || this->closed; });
+        if (this->frames.empty()) {
+            return nullptr;
+        }
+        std::unique_ptr<RenderSnapshot> snapshot = std::move(this->frames.front());
+        this->frames.pop_front();
+        this->notFull.notify_one();
+        return snapshot;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closed = true;
+        this->notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    bool closed;
+    std::deque<std::unique_ptr<RenderSnapshot>> frames;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+int main(int argc, char **argv) {
+    RenderOptions opts;
+    if (!parseOptions(argc, argv, opts)) {
+        printUsage();
+        return 1;
+    }
+
+    struct stat sb;
+    if (stat(opts.outputPath.c_str(), &sb) != 0 || !S_ISDIR(sb.st_mode)) {
+        mkdir(opts.outputPath.c_str(), S_IRWXU | S_IRWXG | S_IRWXO);
+    }
+
+    std::cout << "Configuring model..." << std::endl;
+    Model *m = modelFromConfig(opts.configPath);
+    bool replay = !opts.replayPath.empty();
+    long totalSteps = opts.steps >= 0 ? opts.steps : 166*24 / m->getHoursPerTimestep();
+    if (replay) {
+        m->loadTaggedHistories(opts.replayPath);
+        long replaySteps = (long) m->replayStore->getNumTimesteps();
+        totalSteps = opts.steps >= 0 ? std::min(opts.steps, replaySteps) : replaySteps;
+    }
+
+    FrameRenderer renderer(m->map, m->samplingSites, opts.width, opts.height,
+        opts.hasViewport ? opts.viewport : FrameRenderer::fitMap(m->map));
+    FrameQueue queue(2 * opts.threads);
+    std::atomic<long> framesWritten(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < opts.threads; ++i) {
+        workers.emplace_back([&]() {
+            std::vector<unsigned char> rgb;
+            while (std::unique_ptr<RenderSnapshot> snapshot = queue.pop()) {
+                renderer.render(*snapshot, rgb);
+                std::ostringstream path;
+                path << opts.outputPath << "/frame_" << std::setw(6) << std::setfill('0') << snapshot->time << ".png";
+                try {
+                    writePng(path.str(), opts.width, opts.height, rgb);
+                    ++framesWritten;
+                } catch (const std::runtime_error &e) {
+                    std::cerr << e.what() << std::endl;
+                    failed = true;
+                }
+            }
+        });
+    }
+
+    // Running the model yields frames for timesteps 0..steps; a replay holds timesteps 0..steps-1
+    long lastTimestep = replay ? totalSteps - 1 : totalSteps;
+    auto start = std::chrono::steady_clock::now();
+    for (long t = 0; t <= lastTimestep && !failed; ++t) {
+        if (replay) {
+            m->setHistoryTimestep(t);
+        } else if (t > 0) {
+            m->masterUpdate();
+        }
+        if (t % opts.stride == 0) {
+            queue.push(captureRenderSnapshot(*m, -1, -1L));
+        }
+    }
+    queue.close();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << framesWritten.load() << " frames written to " << opts.outputPath << " in " << elapsed << "s" << std::endl;
+    delete m;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+#include "render_snapshot.h"
+
+#include <unordered_map>
+
+#include "fish.h"
+
+FishRenderState::FishRenderState()
+    : id(0UL), status(FishStatus::Alive), spawnTime(0L), forkLength(0.0f), mass(0.0f), lastPmax(0.0f),
+      lastGrowth(0.0f), lastMortality(0.0f), lastTemp(0.0f), lastDepth(0.0f), lastFlowSpeed_old(0.0f),
+      lastFlowVelocity(), taggedTime(-1L), locationId(-1) {}
+
+FishRenderState::FishRenderState(const Fish &fish)
+    : id(fish.id), status(fish.status), spawnTime(fish.spawnTime), forkLength(fish.forkLength), mass(fish.mass),
+      lastPmax(fish.lastPmax), lastGrowth(fish.lastGrowth), lastMortality(fish.lastMortality),
+      lastTemp(fish.lastTemp), lastDepth(fish.lastDepth), lastFlowSpeed_old(fish.lastFlowSpeed_old),
+      lastFlowVelocity(fish.lastFlowVelocity), taggedTime(fish.taggedTime),
+      locationId(fish.location == nullptr ? -1 : fish.location->id) {}
+
+std::unique_ptr<RenderSnapshot> captureRenderSnapshot(Model &model, int selectedNodeId, long selectedFishId) {
+    std::unique_ptr<RenderSnapshot> snapshot = std::make_unique<RenderSnapshot>();
+    snapshot->time = model.time;
+    snapshot->livingCount = model.livingIndividuals.size();
+    snapshot->deadCount = model.deadCount;
+    snapshot->exitedCount = model.exitedCount;
+    snapshot->occupancy.resize(model.map.size(), 0U);
+    snapshot->popDensity.resize(model.map.size(), 0.0f);
+    for (MapNode *node : model.map) {
+        snapshot->occupancy[node->id] = (unsigned) node->residentIds.size();
+        snapshot->popDensity[node->id] = node->popDensity;
+    }
+
+    snapshot->selectedFishId = -1L;
+    if (selectedFishId >= 0 && (size_t) selectedFishId < model.individuals.size()) {
+        Fish &fish = model.individuals[selectedFishId];
+        snapshot->selectedFishId = selectedFishId;
+        snapshot->selectedFish = FishRenderState(fish);
+        // The selection follows the fish as it moves
+        selectedNodeId = snapshot->selectedFish.locationId;
+        if (fish.status == FishStatus::Alive) {
+            std::unordered_map<MapNode *, float> reachable;
+            fish.getReachableNodes(model, reachable);
+            for (auto it = reachable.begin(); it != reachable.end(); ++it) {
+                snapshot->selectedFishRange.push_back(it->first->id);
+            }
+        }
+    }
+
+    snapshot->selectedNodeId = -1;
+    if (selectedNodeId >= 0 && (size_t) selectedNodeId < model.map.size()) {
+        MapNode &node = *model.map[selectedNodeId];
+        snapshot->selectedNodeId = selectedNodeId;
+        snapshot->selectedNode.depth = model.hydroModel.getDepth(node);
+        snapshot->selectedNode.temp = model.hydroModel.getTemp(node);
+        snapshot->selectedNode.flowSpeed = model.hydroModel.getUnsignedFlowSpeedAt(node);
+        snapshot->selectedNode.flowVelocity = FlowVelocity(model.hydroModel.getCurrentU(node), model.hydroModel.getCurrentV(node));
+        for (size_t i = 0; i < node.residentIds.size() && i < RenderSnapshot::MAX_LISTED_RESIDENTS; ++i) {
+            snapshot->selectedNodeResidents.push_back(node.residentIds[i]);
+        }
+    }
+    return snapshot;
+}
+
+RenderSnapshotSlot::RenderSnapshotSlot() : latest(nullptr) {}
+
+RenderSnapshotSlot::~RenderSnapshotSlot() {
+    delete this->latest.exchange(nullptr);
+}
+
+void RenderSnapshotSlot::publish(std::unique_ptr<RenderSnapshot> snapshot) {
+    // acq_rel: the consumer must see the fully-built snapshot, and we must see the
+    // consumer's release of the previous one before freeing it
+    RenderSnapshot *stale = this->latest.exchange(snapshot.release(), std::memory_order_acq_rel);
+    delete stale;
+}
+
+std::unique_ptr<RenderSnapshot> RenderSnapshotSlot::take() {
+    return std::unique_ptr<RenderSnapshot>(this->latest.exchange(nullptr, std::memory_order_acq_rel));
+}
@@ -0,0 +1,98 @@
+#ifndef __FISH_RENDER_SNAPSHOT_H
+#define __FISH_RENDER_SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "model.h"
+
+// Environmental values at the selected map location, captured alongside the occupancy
+typedef struct NodeRenderState {
+    float depth;
+    float temp;
+    float flowSpeed;
+    FlowVelocity flowVelocity;
+    NodeRenderState() : depth(0.0f), temp(0.0f), flowSpeed(0.0f), flowVelocity() {}
+} NodeRenderState;
+
+// Copy of the Fish fields shown in the GUI info panel
+typedef struct FishRenderState {
+    unsigned long id;
+    FishStatus status;
+    long spawnTime;
+    float forkLength;
+    float mass;
+    float lastPmax;
+    float lastGrowth;
+    float lastMortality;
+    float lastTemp;
+    float lastDepth;
+    float lastFlowSpeed_old;
+    FlowVelocity lastFlowVelocity;
+    long taggedTime;
+    // MapNode::id of the fish's current location
+    int locationId;
+    FishRenderState();
+    explicit FishRenderState(const Fish &fish);
+} FishRenderState;
+
+/*
+* An immutable copy of everything the GUI needs to draw one frame of the model.
+* Snapshots are captured by whichever thread is stepping the model, so the GUI
+* never has to read Model fields while a step is in progress.
+* Per-node vectors are indexed by MapNode::id (the node's index in Model::map).
+*/
+typedef struct RenderSnapshot {
+    // The model timestep at which this snapshot was captured
+    long time;
+    size_t livingCount;
+    int deadCount;
+    int exitedCount;
+    // Number of living fish at each location
+    std::vector<unsigned> occupancy;
+    // Population density at each location (individuals/m^2)
+    std::vector<float> popDensity;
+    // MapNode::id of the selected location (-1 if no location is selected)
+    int selectedNodeId;
+    NodeRenderState selectedNode;
+    // Up to MAX_LISTED_RESIDENTS Fish::id values of fish at the selected location
+    std::vector<long> selectedNodeResidents;
+    // Fish::id of the selected fish (-1 if no fish is selected)
+    long selectedFishId;
+    FishRenderState selectedFish;
+    // MapNode::id values of the locations the selected fish can reach this timestep
+    std::vector<int> selectedFishRange;
+
+    static constexpr size_t MAX_LISTED_RESIDENTS = 25;
+} RenderSnapshot;
+
+/*
+* Copy the current model state into a new snapshot.
+* Must be called from the thread that owns the model (no step may be running concurrently).
+* selectedNodeId and selectedFishId may be -1 to skip the per-selection details.
+*/
+std::unique_ptr<RenderSnapshot> captureRenderSnapshot(Model &model, int selectedNodeId, long selectedFishId);
+
+/*
+* Lock-free single-producer/single-consumer mailbox holding the most recent snapshot.
+* The producer overwrites any snapshot the consumer has not picked up yet, so a slow
+* consumer only ever sees the latest frame and the producer never blocks.
+*/
+class RenderSnapshotSlot {
+public:
+    RenderSnapshotSlot();
+    ~RenderSnapshotSlot();
+    RenderSnapshotSlot(const RenderSnapshotSlot &) = delete;
+    RenderSnapshotSlot &operator=(const RenderSnapshotSlot &) = delete;
+
+    // Producer side: hand over a snapshot, discarding an unconsumed older one
+    void publish(std::unique_ptr<RenderSnapshot> snapshot);
+    // Consumer side: take the latest snapshot, or nullptr if nothing new was published
+    std::unique_ptr<RenderSnapshot> take();
+
+private:
+    std::atomic<RenderSnapshot *> latest;
+};
+
+#endif
@@ -0,0 +1,318 @@
+#include "replay_store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include <netcdf>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fish.h"
+
+constexpr char REPLAY_MAGIC[8] = {'W', 'B', 'R', 'E', 'P', 'L', 'A', 'Y'};
+constexpr uint32_t REPLAY_VERSION = 1;
+constexpr size_t REPLAY_HEADER_SIZE = 64;
+
+/*
+* File layout (native byte order; every section starts on an 8-byte boundary):
+*   header (64 bytes): magic, version, numFish, numTimesteps, numRecords
+*   ReplayFishInfo[numFish]
+*   uint64 timestep offsets[numTimesteps + 1] (records of timestep t are [offsets[t], offsets[t+1]))
+*   uint32 fish ID[numRecords], int32 location[numRecords], then one float[numRecords] per ReplayColumn
+*/
+typedef struct ReplayHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t numFish;
+    uint64_t numTimesteps;
+    uint64_t numRecords;
+} ReplayHeader;
+
+static size_t align8(size_t offset) {
+    return (offset + 7) & ~((size_t) 7);
+}
+
+template <typename T>
+static void writeSection(std::ofstream &out, const std::vector<T> &values) {
+    out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    size_t padding = align8(values.size() * sizeof(T)) - values.size() * sizeof(T);
+    const char zeros[8] = {0};
+    out.write(zeros, padding);
+}
+
+void ReplayStore::write(const TaggedHistoryData &data, const std::string &path) {
+    const size_t N = data.numFish;
+    const size_t T = data.numTimesteps;
+    // A fish's history runs from its tagging time up to its first missing location
+    std::vector<size_t> historyEnd(N, 0);
+    std::vector<uint64_t> offsets(T + 1, 0);
+    for (size_t n = 0; n < N; ++n) {
+        long start = data.fish[n].taggedTime;
+        if (start < 0) {
+            continue;
+        }
+        size_t t = (size_t) start;
+        while (t < T && data.locationHistory[n * T + t] != -1) {
+            ++offsets[t + 1];
+            ++t;
+        }
+        historyEnd[n] = t;
+    }
+    for (size_t t = 0; t < T; ++t) {
+        offsets[t + 1] += offsets[t];
+    }
+    const size_t R = offsets[T];
+
+    std::vector<ReplayFishInfo> fish = data.fish;
+    std::vector<uint32_t> fishIds(R);
+    std::vector<int32_t> locations(R);
+    std::vector<std::vector<float>> columns((size_t) ReplayColumn::Count, std::vector<float>(R));
+    const std::vector<float> *sources[] = {
+        &data.growthHistory, &data.pmaxHistory, &data.mortalityHistory, &data.tempHistory, &data.depthHistory,
+        &data.flowSpeedHistory, &data.flowVelocityUHistory, &data.flowVelocityVHistory
+    };
+    std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+    std::vector<size_t> recordAt(T);
+    for (size_t n = 0; n < N; ++n) {
+        long start = data.fish[n].taggedTime;
+        if (start < 0 || historyEnd[n] <= (size_t) start) {
+            fish[n].finalLocation = 0;
+            continue;
+        }
+        for (size_t t = (size_t) start; t < historyEnd[n]; ++t) {
+            size_t r = fill[t]++;
+            recordAt[t] = r;
+            fishIds[r] = (uint32_t) n;
+            locations[r] = data.locationHistory[n * T + t];
+            for (size_t c = 0; c < (size_t) ReplayColumn::Mass; ++c) {
+                columns[c][r] = (*sources[c])[n * T + t];
+            }
+        }
+        fish[n].finalLocation = data.locationHistory[n * T + historyEnd[n] - 1];
+        // Back-calculate mass and fork length from the final mass, latest timestep first
+        // (same order as Fish::calculateMassHistory, so fork length draws match)
+        float mass = data.fish[n].finalMass;
+        for (size_t t = historyEnd[n]; t-- > (size_t) start;) {
+            size_t r = recordAt[t];
+            columns[(size_t) ReplayColumn::Mass][r] = mass;
+            columns[(size_t) ReplayColumn::ForkLength][r] = forkLengthFromMass(mass);
+            mass -= columns[(size_t) ReplayColumn::Growth][r];
+        }
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Unable to write replay file " + path);
+    }
+    ReplayHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    header.version = REPLAY_VERSION;
+    header.numFish = N;
+    header.numTimesteps = T;
+    header.numRecords = R;
+    char headerBytes[REPLAY_HEADER_SIZE] = {0};
+    std::memcpy(headerBytes, &header, sizeof(header));
+    out.write(headerBytes, REPLAY_HEADER_SIZE);
+    writeSection(out, fish);
+    writeSection(out, offsets);
+    writeSection(out, fishIds);
+    writeSection(out, locations);
+    for (const std::vector<float> &column : columns) {
+        writeSection(out, column);
+    }
+    if (!out) {
+        throw std::runtime_error("Unable to write replay file " + path);
+    }
+}
+
+TaggedHistoryData ReplayStore::readTaggedHistories(const std::string &netCDFPath) {
+    netCDF::NcFile sourceFile(netCDFPath, netCDF::NcFile::FileMode::read);
+    TaggedHistoryData data;
+    data.numFish = sourceFile.getDim("n").getSize();
+    data.numTimesteps = sourceFile.getDim("t").getSize();
+    const size_t N = data.numFish;
+    const size_t NT = data.numFish * data.numTimesteps;
+
+    std::vector<int> recruitTime(N), taggedTime(N), exitTime(N), finalStatus(N);
+    std::vector<float> entryForkLength(N), entryMass(N), finalForkLength(N), finalMass(N);
+    std::pair<const char *, std::vector<int> *> intVars[] = {
+        {"recruitTime", &recruitTime}, {"taggedTime", &taggedTime}, {"exitTime", &exitTime}, {"finalStatus", &finalStatus}
+    };
+    std::pair<const char *, std::vector<float> *> floatVars[] = {
+        {"entryForkLength", &entryForkLength}, {"entryMass", &entryMass},
+        {"finalForkLength", &finalForkLength}, {"finalMass", &finalMass}
+    };
+    data.locationHistory.resize(NT);
+    std::pair<const char *, std::vector<float> *> historyVars[] = {
+        {"growthHistory", &data.growthHistory}, {"pmaxHistory", &data.pmaxHistory},
+        {"mortalityHistory", &data.mortalityHistory}, {"tempHistory", &data.tempHistory},
+        {"depthHistory", &data.depthHistory}, {"flowSpeedHistory", &data.flowSpeedHistory},
+        {"flowVelocityUHistory", &data.flowVelocityUHistory}, {"flowVelocityVHistory", &data.flowVelocityVHistory}
+    };
+    if (NT > 0) {
+        sourceFile.getVar("locationHistory").getVar(data.locationHistory.data());
+    }
+    for (auto &var : historyVars) {
+        var.second->resize(NT);
+        if (NT > 0) {
+            sourceFile.getVar(var.first).getVar(var.second->data());
+        }
+    }
+    if (N > 0) {
+        for (auto &var : intVars) {
+            sourceFile.getVar(var.first).getVar(var.second->data());
+        }
+        for (auto &var : floatVars) {
+            sourceFile.getVar(var.first).getVar(var.second->data());
+        }
+    }
+    data.fish.resize(N);
+    for (size_t n = 0; n < N; ++n) {
+        ReplayFishInfo &info = data.fish[n];
+        info.recruitTime = recruitTime[n];
+        info.taggedTime = taggedTime[n];
+        info.exitTime = exitTime[n];
+        info.entryForkLength = entryForkLength[n];
+        info.entryMass = entryMass[n];
+        info.finalForkLength = finalForkLength[n];
+        info.finalMass = finalMass[n];
+        info.finalStatus = finalStatus[n];
+        info.finalLocation = 0;
+    }
+    return data;
+}
+
+bool ReplayStore::isReplayFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(REPLAY_MAGIC)];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) == 0;
+}
+
+std::vector<std::string> ReplayStore::cachePaths(const std::string &netCDFPath) {
+    std::error_code err;
+    std::filesystem::path source = std::filesystem::absolute(netCDFPath, err);
+    if (err) {
+        source = netCDFPath;
+    }
+    auto modified = std::filesystem::last_write_time(source, err);
+    std::ostringstream key;
+    key << source.string() << ':' << (err ? 0 : modified.time_since_epoch().count());
+    std::ostringstream name;
+    name << source.stem().string() << '-' << std::hex << std::hash<std::string>()(key.str()) << ".replay";
+    return {netCDFPath + ".replay", (std::filesystem::temp_directory_path() / name.str()).string()};
+}
+
+ReplayStore::ReplayStore(const std::string &path)
+    : fd(-1), mapping(nullptr), mappingSize(0), numFish(0), numTimesteps(0), numRecords(0)
+{
+    this->fd = open(path.c_str(), O_RDONLY);
+    if (this->fd == -1) {
+        throw std::runtime_error("Unable to open replay file " + path);
+    }
+    struct stat info;
+    if (fstat(this->fd, &info) != 0 || (size_t) info.st_size < REPLAY_HEADER_SIZE) {
+        close(this->fd);
+        throw std::runtime_error("Invalid replay file " + path);
+    }
+    this->mappingSize = (size_t) info.st_size;
+    this->mapping = mmap(nullptr, this->mappingSize, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (this->mapping == MAP_FAILED) {
+        close(this->fd);
+        throw std::runtime_error("Unable to map replay file " + path);
+    }
+    const char *base = static_cast<const char *>(this->mapping);
+    ReplayHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || header.version != REPLAY_VERSION) {
+        munmap(this->mapping, this->mappingSize);
+        close(this->fd);
+        throw std::runtime_error("Invalid replay file " + path);
+    }
+    this->numFish = header.numFish;
+    this->numTimesteps = header.numTimesteps;
+    this->numRecords = header.numRecords;
+
+    size_t offset = REPLAY_HEADER_SIZE;
+    size_t fishOffset = offset;
+    offset = align8(offset + this->numFish * sizeof(ReplayFishInfo));
+    size_t timestepOffset = offset;
+    offset = align8(offset + (this->numTimesteps + 1) * sizeof(uint64_t));
+    size_t idOffset = offset;
+    offset = align8(offset + this->numRecords * sizeof(uint32_t));
+    size_t locationOffset = offset;
+    offset = align8(offset + this->numRecords * sizeof(int32_t));
+    size_t columnOffsets[(size_t) ReplayColumn::Count];
+    for (size_t c = 0; c < (size_t) ReplayColumn::Count; ++c) {
+        columnOffsets[c] = offset;
+        offset = align8(offset + this->numRecords * sizeof(float));
+    }
+    if (offset > this->mappingSize) {
+        munmap(this->mapping, this->mappingSize);
+        close(this->fd);
+        throw std::runtime_error("Truncated replay file " + path);
+    }
+    this->fishInfo = reinterpret_cast<const ReplayFishInfo *>(base + fishOffset);
+    this->timestepOffsets = reinterpret_cast<const uint64_t *>(base + timestepOffset);
+    this->fishIds = reinterpret_cast<const uint32_t *>(base + idOffset);
+    this->locations = reinterpret_cast<const int32_t *>(base + locationOffset);
+    for (size_t c = 0; c < (size_t) ReplayColumn::Count; ++c) {
+        this->columns[c] = reinterpret_cast<const float *>(base + columnOffsets[c]);
+    }
+
+    // Exit bookkeeping is small (one entry per fish), so it's built in memory
+    for (size_t id = 0; id < this->numFish; ++id) {
+        if (this->fishInfo[id].exitTime >= 0) {
+            this->exitOrder.push_back((uint32_t) id);
+        }
+    }
+    std::stable_sort(this->exitOrder.begin(), this->exitOrder.end(), [this](uint32_t a, uint32_t b) {
+        return this->fishInfo[a].exitTime < this->fishInfo[b].exitTime;
+    });
+    this->deadBefore.assign(this->exitOrder.size() + 1, 0);
+    this->exitedBefore.assign(this->exitOrder.size() + 1, 0);
+    for (size_t k = 0; k < this->exitOrder.size(); ++k) {
+        bool exited = (FishStatus) this->fishInfo[this->exitOrder[k]].finalStatus == FishStatus::Exited;
+        this->deadBefore[k + 1] = this->deadBefore[k] + (exited ? 0 : 1);
+        this->exitedBefore[k + 1] = this->exitedBefore[k] + (exited ? 1 : 0);
+    }
+}
+
+ReplayStore::~ReplayStore() {
+    munmap(this->mapping, this->mappingSize);
+    close(this->fd);
+}
+
+void ReplayStore::getTimestepRange(long t, size_t &begin, size_t &end) const {
+    if (t < 0 || (size_t) t >= this->numTimesteps) {
+        begin = end = 0;
+        return;
+    }
+    begin = this->timestepOffsets[t];
+    end = this->timestepOffsets[t + 1];
+}
+
+size_t ReplayStore::countExitedBy(long t) const {
+    auto it = std::upper_bound(this->exitOrder.begin(), this->exitOrder.end(), t, [this](long time, uint32_t id) {
+        return time < this->fishInfo[id].exitTime;
+    });
+    return (size_t) (it - this->exitOrder.begin());
+}
+
+int ReplayStore::getDeadCountAt(long t) const {
+    return this->deadBefore[this->countExitedBy(t)];
+}
+
+int ReplayStore::getExitedCountAt(long t) const {
+    return this->exitedBefore[this->countExitedBy(t)];
+}
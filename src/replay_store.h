@@ -0,0 +1,120 @@
+#ifndef __FISH_REPLAY_STORE_H
+#define __FISH_REPLAY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-fish values from a tagged history file that don't change over time
+typedef struct ReplayFishInfo {
+    int64_t recruitTime;
+    int64_t taggedTime;
+    // -1 if the fish was still in the model when the histories were saved
+    int64_t exitTime;
+    float entryForkLength;
+    float entryMass;
+    float finalForkLength;
+    float finalMass;
+    int32_t finalStatus;
+    // Last location with recorded history (0 if the fish has none)
+    int32_t finalLocation;
+} ReplayFishInfo;
+
+// Per-timestep float fields stored for each active tagged fish
+enum class ReplayColumn {
+    Growth,
+    Pmax,
+    Mortality,
+    Temp,
+    Depth,
+    FlowSpeed,
+    FlowVelocityU,
+    FlowVelocityV,
+    Mass,
+    ForkLength,
+    Count
+};
+
+/*
+* Tagged fish histories as read from a saveTaggedHistories file: per-fish values plus
+* fish-major (n, t) arrays, with -1 locations outside a fish's tagged lifetime
+*/
+typedef struct TaggedHistoryData {
+    size_t numFish;
+    size_t numTimesteps;
+    std::vector<ReplayFishInfo> fish;
+    std::vector<int> locationHistory;
+    std::vector<float> growthHistory;
+    std::vector<float> pmaxHistory;
+    std::vector<float> mortalityHistory;
+    std::vector<float> tempHistory;
+    std::vector<float> depthHistory;
+    std::vector<float> flowSpeedHistory;
+    std::vector<float> flowVelocityUHistory;
+    std::vector<float> flowVelocityVHistory;
+} TaggedHistoryData;
+
+/*
+* Read-only, memory-mapped replay file indexing tagged fish histories by timestep.
+* Records are grouped by timestep (one record per fish active at that timestep) and stored
+* column by column, so seeking to a timestep only touches that timestep's records; pages
+* are read in by the OS as they are first visited rather than all at load time.
+*/
+class ReplayStore {
+public:
+    // Convert tagged histories to a replay file at the given path
+    // (mass and fork length histories are back-calculated from final mass and growth)
+    static void write(const TaggedHistoryData &data, const std::string &path);
+    // Read every history variable of a saveTaggedHistories NetCDF file with one bulk read each
+    static TaggedHistoryData readTaggedHistories(const std::string &netCDFPath);
+    // Whether path names a file in this replay format (as opposed to a NetCDF history file)
+    static bool isReplayFile(const std::string &path);
+    // Where the replay file converted from a NetCDF history file is kept, in order of preference: beside the
+    // history file, then (for read-only data directories) in the temp directory under a name keyed on the
+    // history file's absolute path and modification time
+    static std::vector<std::string> cachePaths(const std::string &netCDFPath);
+
+    // Memory-map an existing replay file; throws std::runtime_error if it's missing or malformed
+    explicit ReplayStore(const std::string &path);
+    ~ReplayStore();
+    ReplayStore(const ReplayStore &) = delete;
+    ReplayStore &operator=(const ReplayStore &) = delete;
+
+    size_t getNumFish() const { return numFish; }
+    size_t getNumTimesteps() const { return numTimesteps; }
+    const ReplayFishInfo &getFish(size_t id) const { return fishInfo[id]; }
+
+    // Record index range [begin, end) of the fish active at timestep t (empty outside the recorded timesteps)
+    void getTimestepRange(long t, size_t &begin, size_t &end) const;
+    const uint32_t *getFishIds() const { return fishIds; }
+    const int32_t *getLocations() const { return locations; }
+    const float *getColumn(ReplayColumn column) const { return columns[(size_t) column]; }
+
+    // Fish IDs that left the model, in order of exit time
+    const std::vector<uint32_t> &getExitOrder() const { return exitOrder; }
+    // Position in getExitOrder() of the first fish that exits after timestep t
+    size_t countExitedBy(long t) const;
+    // Number of fish that died / exited without dying at or before timestep t
+    int getDeadCountAt(long t) const;
+    int getExitedCountAt(long t) const;
+
+private:
+    int fd;
+    void *mapping;
+    size_t mappingSize;
+    size_t numFish;
+    size_t numTimesteps;
+    size_t numRecords;
+    const ReplayFishInfo *fishInfo;
+    const uint64_t *timestepOffsets;
+    const uint32_t *fishIds;
+    const int32_t *locations;
+    const float *columns[(size_t) ReplayColumn::Count];
+    std::vector<uint32_t> exitOrder;
+    // Running dead/exited counts along exitOrder (element k counts the first k exits)
+    std::vector<int> deadBefore;
+    std::vector<int> exitedBefore;
+};
+
+#endif
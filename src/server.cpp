@@ -0,0 +1,281 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "model.h"
+#include "simulation_server.h"
+
+/*
+* Long-lived simulation server for calibration frameworks.
+*
+* Usage: server <config file> <socket path> [--queue n] [--steps n]
+*
+* Loads the model inputs once, then accepts connections on a Unix domain socket. Each line a
+* client sends is a JSON request (see simulation_server.h); the server answers every request
+* right away ("queued", "busy" when the queue is full, "cancelling", "status", or "error") and
+* sends a result line for each job when it finishes. Jobs run one at a time in submission order.
+*/
+
+// Requests are one line of job parameters; a client sending a longer line is answered with an error and dropped
+// rather than buffered without limit
+const size_t MAX_REQUEST_LENGTH = 65536;
+
+sig_atomic_t stopRequested = 0;
+
+void handleStop(int) {
+    stopRequested = 1;
+}
+
+typedef struct ServerConnection {
+    int fd;
+    std::string in;
+    // Guarded by the outbox mutex, since job results are queued from the worker thread
+    std::string out;
+    // IDs of this client's jobs that haven't reported a result yet, cancelled if it disconnects
+    std::set<std::string> jobIds;
+    // Set once the connection is being dropped: nothing more is read, and it closes when out is sent
+    bool closing;
+} ServerConnection;
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: server <config file> <socket path> [--queue n] [--steps n]" << std::endl;
+        return 1;
+    }
+    std::string configPath(argv[1]);
+    std::string socketPath(argv[2]);
+    size_t queueCapacity = 16;
+    long defaultSteps = -1;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string arg(argv[i]);
+        if (arg == "--queue") {
+            queueCapacity = std::stoul(argv[i + 1]);
+        } else if (arg == "--steps") {
+            defaultSteps = std::stol(argv[i + 1]);
+        } else {
+            std::cerr << "Unrecognized option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Configuring model..." << std::endl;
+    Model *m = modelFromConfig(configPath);
+    SimulationJob defaults;
+    defaults.seed = (unsigned int) m->getInt(ModelParamKey::rng_seed);
+    // Default to 166 days at the configured timestep length
+    defaults.steps = defaultSteps > 0 ? defaultSteps : 166*24 / m->getHoursPerTimestep();
+    defaults.mortConstA = m->mortConstA;
+    defaults.mortConstC = m->mortConstC;
+    defaults.config = m->getConfigMap();
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return 1;
+    }
+    socketPath.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socketPath.c_str());
+    if (listenFd == -1 || bind(listenFd, (sockaddr *) &addr, sizeof(addr)) == -1 || listen(listenFd, 16) == -1) {
+        std::cerr << "Couldn't listen on " << socketPath << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    // Written by the worker thread when a result is ready, to wake the poll loop
+    int wakeFds[2];
+    if (pipe2(wakeFds, O_NONBLOCK | O_CLOEXEC) == -1) {
+        std::cerr << "Couldn't create wake pipe: " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // Connections outlive the job server, whose shutdown reports abandoned jobs
+    std::mutex outboxMutex;
+    std::map<int, ServerConnection> connections;
+    int nextConnectionId = 0;
+    auto send = [&](int connectionId, const std::string &line) {
+        {
+            std::lock_guard<std::mutex> lock(outboxMutex);
+            auto it = connections.find(connectionId);
+            if (it == connections.end()) {
+                return;
+            }
+            it->second.out += line + "\n";
+        }
+        char c = 0;
+        ssize_t ignored = write(wakeFds[1], &c, 1);
+        (void) ignored;
+    };
+    auto jobFinished = [&](int connectionId, const SimulationResult &result) {
+        {
+            std::lock_guard<std::mutex> lock(outboxMutex);
+            auto it = connections.find(connectionId);
+            if (it != connections.end()) {
+                it->second.jobIds.erase(result.id);
+            }
+        }
+        send(connectionId, formatSimulationResult(result));
+    };
+
+    {
+        SimulationServer jobs(*m, queueCapacity);
+        signal(SIGINT, handleStop);
+        signal(SIGTERM, handleStop);
+        signal(SIGPIPE, SIG_IGN);
+        std::cout << "Listening on " << socketPath << " (queue capacity " << queueCapacity << ")" << std::endl;
+
+        std::vector<pollfd> fds;
+        std::vector<int> ids;
+        while (!stopRequested) {
+            fds.clear();
+            ids.clear();
+            fds.push_back({listenFd, POLLIN, 0});
+            fds.push_back({wakeFds[0], POLLIN, 0});
+            {
+                std::lock_guard<std::mutex> lock(outboxMutex);
+                for (auto &[id, c] : connections) {
+                    short events = c.closing ? 0 : POLLIN;
+                    if (!c.out.empty()) {
+                        events |= POLLOUT;
+                    }
+                    fds.push_back({c.fd, events, 0});
+                    ids.push_back(id);
+                }
+            }
+            if (poll(fds.data(), fds.size(), 500) <= 0) {
+                continue;
+            }
+            if (fds[1].revents & POLLIN) {
+                char drain[256];
+                while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+            }
+
+            for (size_t i = 0; i < ids.size(); ++i) {
+                const int id = ids[i];
+                const short revents = fds[i + 2].revents;
+                bool open = !(revents & (POLLERR | POLLNVAL));
+                std::vector<std::string> lines;
+                bool tooLong = false;
+                bool closing;
+                {
+                    std::lock_guard<std::mutex> lock(outboxMutex);
+                    closing = connections[id].closing;
+                }
+                if (open && !closing && (revents & (POLLIN | POLLHUP))) {
+                    char buf[4096];
+                    ssize_t n = recv(fds[i + 2].fd, buf, sizeof(buf), MSG_DONTWAIT);
+                    if (n > 0) {
+                        std::lock_guard<std::mutex> lock(outboxMutex);
+                        std::string &in = connections[id].in;
+                        in.append(buf, (size_t) n);
+                        size_t newline;
+                        while ((newline = in.find('\n')) != std::string::npos && newline <= MAX_REQUEST_LENGTH) {
+                            lines.push_back(in.substr(0, newline));
+                            in.erase(0, newline + 1);
+                        }
+                        if (in.size() > MAX_REQUEST_LENGTH) {
+                            tooLong = true;
+                            in.clear();
+                        }
+                    } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        open = false;
+                    }
+                }
+                for (const std::string &line : lines) {
+                    ServerRequest request;
+                    std::string error;
+                    if (!parseServerRequest(line, defaults, request, error)) {
+                        send(id, formatServerReply(request.job.id, "error", error));
+                    } else if (request.command == "status") {
+                        send(id, formatServerReply(request.job.id, "status", std::to_string(jobs.getQueueLength())
+                            + " of " + std::to_string(jobs.getQueueCapacity()) + " queue slots in use"));
+                    } else if (request.command == "cancel") {
+                        bool found = jobs.cancel(request.job.id);
+                        send(id, formatServerReply(request.job.id, found ? "cancelling" : "error", found ? "" : "no such job"));
+                    } else {
+                        // Recorded before submitting, since a short job can report its result right away
+                        bool recorded;
+                        {
+                            std::lock_guard<std::mutex> lock(outboxMutex);
+                            recorded = connections[id].jobIds.insert(request.job.id).second;
+                        }
+                        if (jobs.submit(request.job, [&jobFinished, id](const SimulationResult &result) {
+                                jobFinished(id, result);
+                            })) {
+                            send(id, formatServerReply(request.job.id, "queued", ""));
+                        } else {
+                            if (recorded) {
+                                std::lock_guard<std::mutex> lock(outboxMutex);
+                                connections[id].jobIds.erase(request.job.id);
+                            }
+                            // The client should retry later (or the ID is already in use)
+                            send(id, formatServerReply(request.job.id, "busy", "queue full or job ID already queued"));
+                        }
+                    }
+                }
+                if (tooLong) {
+                    send(id, formatServerReply("", "error", "request too long"));
+                    std::lock_guard<std::mutex> lock(outboxMutex);
+                    connections[id].closing = true;
+                }
+                if (open && (revents & POLLOUT)) {
+                    std::lock_guard<std::mutex> lock(outboxMutex);
+                    std::string &out = connections[id].out;
+                    ssize_t n = ::send(fds[i + 2].fd, out.data(), out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+                    if (n > 0) {
+                        out.erase(0, (size_t) n);
+                    } else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                        open = false;
+                    }
+                }
+                if (open) {
+                    std::lock_guard<std::mutex> lock(outboxMutex);
+                    const ServerConnection &c = connections[id];
+                    open = !(c.closing && c.out.empty());
+                }
+                if (!open) {
+                    // Nobody is left to read the results of the client's jobs, so don't spend time running them
+                    std::set<std::string> abandoned;
+                    {
+                        std::lock_guard<std::mutex> lock(outboxMutex);
+                        close(fds[i + 2].fd);
+                        abandoned = std::move(connections[id].jobIds);
+                        connections.erase(id);
+                    }
+                    // Outside the lock, since cancelling a queued job reports its result right away
+                    for (const std::string &jobId : abandoned) {
+                        jobs.cancel(jobId);
+                    }
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                int fd;
+                while ((fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                    std::lock_guard<std::mutex> lock(outboxMutex);
+                    connections[nextConnectionId++] = {fd, "", "", {}, false};
+                }
+            }
+        }
+        std::cout << "Shutting down" << std::endl;
+    }
+
+    for (auto &[id, c] : connections) {
+        close(c.fd);
+    }
+    close(listenFd);
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    unlink(socketPath.c_str());
+    delete m;
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "simulation_runner.h"
+
+#include <algorithm>
+#include <chrono>
+
+SimulationRunner::SimulationRunner(Model *model, std::function<void()> onPublish)
+    : model(model), onPublish(onPublish), running(false), cancelRequested(false),
+      targetStepsPerSec(UNTHROTTLED), selectedNodeId(-1), selectedFishId(-1L) {}
+
+SimulationRunner::~SimulationRunner() {
+    this->cancel();
+}
+
+bool SimulationRunner::start(long steps, double targetStepsPerSec) {
+    if (this->running.load()) {
+        return false;
+    }
+    // Reap the previous (finished) worker before launching a new one
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+    this->cancelRequested = false;
+    this->targetStepsPerSec = targetStepsPerSec;
+    this->running = true;
+    this->worker = std::thread(&SimulationRunner::run, this, steps);
+    return true;
+}
+
+void SimulationRunner::cancel() {
+    this->cancelRequested = true;
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+    this->running = false;
+}
+
+bool SimulationRunner::isRunning() const {
+    return this->running.load();
+}
+
+void SimulationRunner::setTargetStepsPerSec(double stepsPerSec) {
+    this->targetStepsPerSec = stepsPerSec;
+}
+
+void SimulationRunner::setSelection(int nodeId, long fishId) {
+    this->selectedNodeId = nodeId;
+    this->selectedFishId = fishId;
+}
+
+void SimulationRunner::publishNow() {
+    if (this->running.load()) {
+        // The worker publishes after every step anyway
+        return;
+    }
+    this->publish();
+}
+
+std::unique_ptr<RenderSnapshot> SimulationRunner::takeLatest() {
+    return this->slot.take();
+}
+
+void SimulationRunner::publish() {
+    this->slot.publish(captureRenderSnapshot(*this->model, this->selectedNodeId.load(), this->selectedFishId.load()));
+    if (this->onPublish) {
+        this->onPublish();
+    }
+}
+
+// Worker thread body: step, publish, then sleep off whatever is left of the step's time budget
+void SimulationRunner::run(long steps) {
+    auto nextStepTime = std::chrono::steady_clock::now();
+    for (long i = 0; steps == RUN_UNTIL_CANCELLED || i < steps; ++i) {
+        if (this->cancelRequested.load()) {
+            break;
+        }
+        this->model->masterUpdate();
+        this->publish();
+        double rate = this->targetStepsPerSec.load();
+        if (rate > 0.0) {
+            nextStepTime += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / rate));
+            auto now = std::chrono::steady_clock::now();
+            if (nextStepTime < now) {
+                // Running behind (slow steps): don't try to catch up with a burst
+                nextStepTime = now;
+            }
+            // Sleep in short slices so cancellation stays prompt at low rates
+            while (std::chrono::steady_clock::now() < nextStepTime && !this->cancelRequested.load()) {
+                std::this_thread::sleep_until(std::min(nextStepTime, std::chrono::steady_clock::now() + std::chrono::milliseconds(50)));
+            }
+        } else {
+            nextStepTime = std::chrono::steady_clock::now();
+        }
+    }
+    this->running = false;
+    if (this->onPublish) {
+        // Let the front end know the run has ended (e.g. to re-enable controls)
+        this->onPublish();
+    }
+}
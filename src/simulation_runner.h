@@ -0,0 +1,62 @@
+#ifndef __FISH_SIMULATION_RUNNER_H
+#define __FISH_SIMULATION_RUNNER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "model.h"
+#include "render_snapshot.h"
+
+/*
+* Steps a model on a background thread so that an interactive front end stays responsive.
+* After every step the runner captures a RenderSnapshot and hands it to the front end through
+* a RenderSnapshotSlot; the front end never reads the model while a run is in progress.
+*
+* Only one run may be active at a time. Anything else that touches the model (loading,
+* saving, tagging, replay) must call cancel() first.
+*/
+class SimulationRunner {
+public:
+    // Pass as the step count to keep running until cancelled
+    static constexpr long RUN_UNTIL_CANCELLED = -1L;
+    // Pass as the step rate to run as fast as possible
+    static constexpr double UNTHROTTLED = 0.0;
+
+    // onPublish is called from the worker thread after each new snapshot is published;
+    // it should only schedule a redraw (e.g. post an event), never touch the model
+    SimulationRunner(Model *model, std::function<void()> onPublish);
+    ~SimulationRunner();
+
+    // Start stepping the model. Returns false if a run is already active.
+    bool start(long steps, double targetStepsPerSec);
+    // Ask the active run to stop after its current step, then wait for it to finish
+    void cancel();
+    // True while a run is active
+    bool isRunning() const;
+    // Change the target rate of the active (or next) run
+    void setTargetStepsPerSec(double stepsPerSec);
+    // Which location/fish the captured snapshots should describe in detail (-1 for none)
+    void setSelection(int nodeId, long fishId);
+    // Capture and publish a snapshot on the calling thread; ignored while a run is active
+    void publishNow();
+    // Consumer side of the snapshot slot
+    std::unique_ptr<RenderSnapshot> takeLatest();
+
+private:
+    void run(long steps);
+    void publish();
+
+    Model *model;
+    std::function<void()> onPublish;
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<bool> cancelRequested;
+    std::atomic<double> targetStepsPerSec;
+    std::atomic<int> selectedNodeId;
+    std::atomic<long> selectedFishId;
+    RenderSnapshotSlot slot;
+};
+
+#endif
@@ -0,0 +1,277 @@
+#include "simulation_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <sstream>
+#include <rapidjson/document.h>
+#include "telemetry.h"
+#include "util.h"
+
+SimulationResult runSimulationJob(Model &model, const SimulationJob &job, const std::atomic<bool> &cancelled) {
+    SimulationResult result;
+    result.id = job.id;
+    auto start = std::chrono::steady_clock::now();
+    const size_t maxThreads = model.getMaxThreads();
+    try {
+        model.setConfigMap(job.config);
+        model.mortConstA = job.mortConstA;
+        model.mortConstC = job.mortConstC;
+        GlobalRand::reseed(job.seed);
+        // Movement threads draw from the shared generator in whatever order they run, so (as in
+        // headless) a seeded run only reproduces on one thread
+        if (job.seed != GlobalRand::USE_RANDOM_SEED) {
+            model.setMaxThreads(1);
+        }
+        model.reset();
+        while (model.time < job.steps && !cancelled) {
+            model.masterUpdate();
+        }
+        model.setMaxThreads(maxThreads);
+        result.status = cancelled ? "cancelled" : "done";
+        if (!cancelled && !job.outputPath.empty()) {
+            std::string summaryPath = job.outputPath + "/summary_" + job.id + ".nc";
+            std::string samplePath = job.outputPath + "/output_" + job.id + ".nc";
+            model.saveSummary(summaryPath);
+            model.saveSampleData(samplePath);
+            result.files = {summaryPath, samplePath};
+        }
+    } catch (const std::exception &e) {
+        model.setMaxThreads(maxThreads);
+        result.status = "error";
+        result.message = e.what();
+    }
+    result.time = model.time;
+    result.living = model.livingIndividuals.size();
+    result.exited = model.exitedCount;
+    result.dead = model.deadCount;
+    result.samples = model.sampleHistory;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+SimulationServer::SimulationServer(Model &model, size_t queueCapacity)
+    : SimulationServer([&model](const SimulationJob &job, const std::atomic<bool> &cancelled) {
+          return runSimulationJob(model, job, cancelled);
+      }, queueCapacity) {}
+
+SimulationServer::SimulationServer(JobRunner runner, size_t queueCapacity)
+    : runner(runner), queueCapacity(queueCapacity), cancelRunning(false), stopping(false)
+{
+    this->worker = std::thread(&SimulationServer::work, this);
+}
+
+SimulationServer::~SimulationServer() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        this->cancelRunning = true;
+    }
+    this->jobAvailable.notify_all();
+    this->worker.join();
+}
+
+bool SimulationServer::submit(const SimulationJob &job, ResultCallback onResult) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->stopping || this->queue.size() >= this->queueCapacity || job.id == this->runningId
+            || std::any_of(this->queue.begin(), this->queue.end(), [&](const QueuedJob &q) { return q.job.id == job.id; })) {
+            return false;
+        }
+        this->queue.push_back({job, onResult});
+    }
+    this->jobAvailable.notify_one();
+    return true;
+}
+
+bool SimulationServer::cancel(const std::string &id) {
+    ResultCallback onResult;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->runningId.empty() && id == this->runningId) {
+            this->cancelRunning = true;
+            return true;
+        }
+        auto it = std::find_if(this->queue.begin(), this->queue.end(), [&](const QueuedJob &q) { return q.job.id == id; });
+        if (it == this->queue.end()) {
+            return false;
+        }
+        onResult = it->onResult;
+        this->queue.erase(it);
+    }
+    SimulationResult result;
+    result.id = id;
+    result.status = "cancelled";
+    onResult(result);
+    return true;
+}
+
+size_t SimulationServer::getQueueLength() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->queue.size();
+}
+
+void SimulationServer::work() {
+    while (true) {
+        QueuedJob next;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->jobAvailable.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+            if (this->stopping) {
+                break;
+            }
+            next = std::move(this->queue.front());
+            this->queue.pop_front();
+            this->runningId = next.job.id;
+            this->cancelRunning = false;
+        }
+        SimulationResult result = this->runner(next.job, this->cancelRunning);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->runningId.clear();
+        }
+        next.onResult(result);
+    }
+    // Anything still queued at shutdown is reported as cancelled
+    std::deque<QueuedJob> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        abandoned.swap(this->queue);
+    }
+    for (QueuedJob &q : abandoned) {
+        SimulationResult result;
+        result.id = q.job.id;
+        result.status = "cancelled";
+        q.onResult(result);
+    }
+}
+
+static std::string jsonString(const std::string &s) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if ((unsigned char) c < 0x20) {
+            const char *hex = "0123456789abcdef";
+            out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+static bool validJobId(const std::string &id) {
+    return !id.empty() && std::all_of(id.begin(), id.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+    });
+}
+
+bool parseServerRequest(const std::string &line, const SimulationJob &defaults, ServerRequest &request, std::string &error) {
+    rapidjson::Document d;
+    d.Parse(line.c_str(), line.size());
+    if (d.HasParseError() || !d.IsObject()) {
+        error = "request is not a JSON object";
+        return false;
+    }
+    request.command = d.HasMember("command") && d["command"].IsString() ? d["command"].GetString() : "run";
+    request.job = defaults;
+    if (d.HasMember("id")) {
+        if (!d["id"].IsString() || !validJobId(d["id"].GetString())) {
+            error = "id must be a non-empty string of letters, digits, '_' and '-'";
+            return false;
+        }
+        request.job.id = d["id"].GetString();
+    }
+    if (request.command == "status") {
+        return true;
+    }
+    if (request.command != "run" && request.command != "cancel") {
+        error = "unknown command \"" + request.command + "\"";
+        return false;
+    }
+    if (request.job.id.empty()) {
+        error = "missing id";
+        return false;
+    }
+    if (request.command == "cancel") {
+        return true;
+    }
+    if (d.HasMember("seed")) {
+        if (!d["seed"].IsUint()) {
+            error = "seed must be a non-negative integer";
+            return false;
+        }
+        request.job.seed = d["seed"].GetUint();
+    }
+    if (d.HasMember("steps")) {
+        if (!d["steps"].IsInt() || d["steps"].GetInt() <= 0) {
+            error = "steps must be a positive integer";
+            return false;
+        }
+        request.job.steps = d["steps"].GetInt();
+    }
+    if (d.HasMember("mortConstA") && d["mortConstA"].IsNumber()) {
+        request.job.mortConstA = d["mortConstA"].GetFloat();
+    }
+    if (d.HasMember("mortConstC") && d["mortConstC"].IsNumber()) {
+        request.job.mortConstC = d["mortConstC"].GetFloat();
+    }
+    if (d.HasMember("outputPath") && d["outputPath"].IsString()) {
+        request.job.outputPath = d["outputPath"].GetString();
+    }
+    if (d.HasMember("overrides")) {
+        const rapidjson::Value &overrides = d["overrides"];
+        if (!overrides.IsObject()) {
+            error = "overrides must be an object";
+            return false;
+        }
+        for (auto it = overrides.MemberBegin(); it != overrides.MemberEnd(); ++it) {
+            ModelParamKey key;
+            std::string name = it->name.GetString();
+            if (!request.job.config.findFileKey(name, key)
+                || !ModelConfigMap::isRunTimeParameter(key)) {
+                error = "parameter \"" + name + "\" can't be overridden per run";
+                return false;
+            }
+        }
+        try {
+            request.job.config.loadFromJson(overrides);
+        } catch (const std::exception &e) {
+            error = e.what();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string formatSimulationResult(const SimulationResult &result) {
+    std::ostringstream out;
+    out << "{\"id\":" << jsonString(result.id) << ",\"status\":" << jsonString(result.status);
+    if (!result.message.empty()) {
+        out << ",\"message\":" << jsonString(result.message);
+    }
+    out << ",\"time\":" << result.time << ",\"living\":" << result.living << ",\"exited\":" << result.exited
+        << ",\"dead\":" << result.dead << ",\"seconds\":" << result.seconds << ",\"samples\":[";
+    for (size_t i = 0; i < result.samples.size(); ++i) {
+        out << (i > 0 ? "," : "") << formatSampleJson(result.samples[i]);
+    }
+    out << "],\"files\":[";
+    for (size_t i = 0; i < result.files.size(); ++i) {
+        out << (i > 0 ? "," : "") << jsonString(result.files[i]);
+    }
+    out << "]}";
+    return out.str();
+}
+
+std::string formatServerReply(const std::string &id, const std::string &status, const std::string &message) {
+    std::ostringstream out;
+    out << "{\"id\":" << jsonString(id) << ",\"status\":" << jsonString(status);
+    if (!message.empty()) {
+        out << ",\"message\":" << jsonString(message);
+    }
+    out << "}";
+    return out.str();
+}
@@ -0,0 +1,119 @@
+#ifndef __FISH_SIMULATION_SERVER_H
+#define __FISH_SIMULATION_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+#include "model_config_map.h"
+
+// One run requested of a SimulationServer
+typedef struct SimulationJob {
+    // Client-chosen name, echoed in the result (also used in output filenames, so [A-Za-z0-9_-] only)
+    std::string id;
+    // GlobalRand seed (GlobalRand::USE_RANDOM_SEED for a random one)
+    unsigned int seed;
+    // Timesteps to run from the start of the inputs
+    long steps;
+    float mortConstA;
+    float mortConstC;
+    // Parameters for the run (the server's config plus the request's overrides)
+    ModelConfigMap config;
+    // If not empty, the summary and sample data files are saved in this directory
+    std::string outputPath;
+} SimulationJob;
+
+typedef struct SimulationResult {
+    std::string id;
+    // "done", "cancelled" or "error"
+    std::string status;
+    std::string message;
+    long time;
+    size_t living;
+    int exited;
+    int dead;
+    double seconds;
+    std::vector<Sample> samples;
+    // Output files written (if the job had an outputPath)
+    std::vector<std::string> files;
+    SimulationResult() : time(0), living(0), exited(0), dead(0), seconds(0.0) {}
+} SimulationResult;
+
+// Reset the model and run one job on it, stopping early if cancelled becomes true
+SimulationResult runSimulationJob(Model &model, const SimulationJob &job, const std::atomic<bool> &cancelled);
+
+/*
+* Runs jobs one at a time on a model whose inputs were loaded once.
+*
+* Jobs share the model (and the global RNG), so they run in submission order on a single worker
+* thread; each job's timesteps are still spread over the model's movement threads. At most
+* queueCapacity jobs wait behind the running one; submit() refuses more, so clients back off
+* rather than queueing unbounded work.
+*/
+class SimulationServer {
+public:
+    typedef std::function<void(const SimulationResult &)> ResultCallback;
+    // Runs one job; runSimulationJob on the server's model unless a test substitutes something else
+    typedef std::function<SimulationResult(const SimulationJob &, const std::atomic<bool> &)> JobRunner;
+
+    SimulationServer(Model &model, size_t queueCapacity);
+    SimulationServer(JobRunner runner, size_t queueCapacity);
+    // Cancels the running job and reports queued jobs as cancelled
+    ~SimulationServer();
+    SimulationServer(const SimulationServer &) = delete;
+    SimulationServer &operator=(const SimulationServer &) = delete;
+
+    // Queue a job; onResult is called from the worker thread when it finishes (or is cancelled).
+    // Returns false without queueing if the queue is full or the ID is already queued or running.
+    bool submit(const SimulationJob &job, ResultCallback onResult);
+    // Cancel a queued or running job; returns false if there's no such job
+    bool cancel(const std::string &id);
+    // Jobs waiting to run (not counting the running one)
+    size_t getQueueLength();
+    size_t getQueueCapacity() const { return queueCapacity; }
+
+private:
+    typedef struct QueuedJob {
+        SimulationJob job;
+        ResultCallback onResult;
+    } QueuedJob;
+
+    void work();
+
+    JobRunner runner;
+    size_t queueCapacity;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<QueuedJob> queue;
+    std::string runningId;
+    std::atomic<bool> cancelRunning;
+    bool stopping;
+    std::thread worker;
+};
+
+/*
+* Wire format used by the server executable: one JSON object per line in each direction.
+*
+* Requests: {"command": "run", "id": ..., "seed": ..., "steps": ..., "mortConstA": ..., "mortConstC": ...,
+* "overrides": {<config parameter>: <value>, ...}, "outputPath": ...} (everything but id optional),
+* {"command": "cancel", "id": ...} and {"command": "status"}.
+*/
+typedef struct ServerRequest {
+    std::string command;
+    SimulationJob job;
+} ServerRequest;
+
+// Parse a request line, filling unset job fields from the defaults. Returns false with a message on bad requests.
+bool parseServerRequest(const std::string &line, const SimulationJob &defaults, ServerRequest &request, std::string &error);
+// Response lines (without the trailing newline)
+std::string formatSimulationResult(const SimulationResult &result);
+std::string formatServerReply(const std::string &id, const std::string &status, const std::string &message);
+
+#endif
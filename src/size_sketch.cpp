@@ -0,0 +1,154 @@
+#include "size_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+FixedHistogram::FixedHistogram(float low, float width, size_t bins) : low(low), width(width), counts(bins, 0.0f) {}
+
+void FixedHistogram::add(float value, float weight) {
+    float bin = std::floor((value - this->low) / this->width);
+    size_t index = bin <= 0.0f ? 0 : std::min((size_t) bin, this->counts.size() - 1);
+    this->counts[index] += weight;
+}
+
+void FixedHistogram::merge(const FixedHistogram &other) {
+    if (other.low != this->low || other.width != this->width || other.counts.size() != this->counts.size()) {
+        throw std::runtime_error("Can't merge histograms with different bins");
+    }
+    for (size_t i = 0; i < this->counts.size(); ++i) {
+        this->counts[i] += other.counts[i];
+    }
+}
+
+// Values added between compressions, as a multiple of the compression
+constexpr size_t PENDING_FACTOR = 8;
+
+TDigest::TDigest(float compression)
+    : compression(compression),
+      totalWeight(0.0),
+      min(std::numeric_limits<float>::infinity()),
+      max(-std::numeric_limits<float>::infinity()) {}
+
+void TDigest::add(float value, float weight) {
+    if (weight <= 0.0f) {
+        return;
+    }
+    this->pending.push_back({value, weight});
+    this->totalWeight += weight;
+    this->min = std::min(this->min, value);
+    this->max = std::max(this->max, value);
+    if (this->pending.size() >= PENDING_FACTOR * (size_t) this->compression) {
+        this->compress();
+    }
+}
+
+void TDigest::merge(const TDigest &other) {
+    this->pending.insert(this->pending.end(), other.centroids.begin(), other.centroids.end());
+    this->pending.insert(this->pending.end(), other.pending.begin(), other.pending.end());
+    this->totalWeight += other.totalWeight;
+    this->min = std::min(this->min, other.min);
+    this->max = std::max(this->max, other.max);
+    this->compress();
+}
+
+// Scale function k1: centroids near the tails (q near 0 or 1) cover less of the weight
+static double scale(double q, double compression) {
+    return compression / (2.0 * M_PI) * std::asin(2.0 * std::min(1.0, std::max(0.0, q)) - 1.0);
+}
+
+void TDigest::compress() {
+    if (this->pending.empty()) {
+        return;
+    }
+    std::vector<Centroid> all;
+    all.reserve(this->centroids.size() + this->pending.size());
+    all.insert(all.end(), this->centroids.begin(), this->centroids.end());
+    all.insert(all.end(), this->pending.begin(), this->pending.end());
+    this->pending.clear();
+    std::stable_sort(all.begin(), all.end(), [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+    double total = 0.0;
+    for (const Centroid &c : all) {
+        total += c.weight;
+    }
+    // Greedily merge neighbors while a centroid spans at most one unit of k. Any two consecutive results
+    // together span more than one unit, and k spans compression / 2 units in all, so there are at most
+    // compression + 2 centroids.
+    this->centroids.clear();
+    Centroid current = all[0];
+    double before = 0.0;
+    double kLeft = scale(0.0, this->compression);
+    for (size_t i = 1; i < all.size(); ++i) {
+        double proposed = current.weight + all[i].weight;
+        if (scale((before + proposed) / total, this->compression) - kLeft <= 1.0) {
+            current.mean += (all[i].mean - current.mean) * (all[i].weight / (float) proposed);
+            current.weight = (float) proposed;
+        } else {
+            this->centroids.push_back(current);
+            before += current.weight;
+            kLeft = scale(before / total, this->compression);
+            current = all[i];
+        }
+    }
+    this->centroids.push_back(current);
+    this->totalWeight = total;
+}
+
+float TDigest::quantile(float q) const {
+    if (!this->pending.empty()) {
+        TDigest compressed = *this;
+        compressed.compress();
+        return compressed.quantile(q);
+    }
+    if (this->centroids.empty()) {
+        return 0.0f;
+    }
+    if (this->centroids.size() == 1) {
+        return this->centroids[0].mean;
+    }
+    const double target = std::min(1.0, std::max(0.0, (double) q)) * this->totalWeight;
+    // Each centroid's weight is taken to be centred on its mean, with min and max at the ends
+    double centre = this->centroids[0].weight / 2.0;
+    if (target <= centre) {
+        return (float) (this->min + (this->centroids[0].mean - this->min) * (target / centre));
+    }
+    for (size_t i = 1; i < this->centroids.size(); ++i) {
+        double next = centre + (this->centroids[i - 1].weight + this->centroids[i].weight) / 2.0;
+        if (target <= next) {
+            double t = (target - centre) / (next - centre);
+            return (float) (this->centroids[i - 1].mean + (this->centroids[i].mean - this->centroids[i - 1].mean) * t);
+        }
+        centre = next;
+    }
+    const double rest = this->totalWeight - centre;
+    const float last = this->centroids.back().mean;
+    return (float) (last + (this->max - last) * (rest > 0.0 ? (target - centre) / rest : 1.0));
+}
+
+size_t TDigest::capacity() const {
+    return (size_t) std::ceil(this->compression) + 2;
+}
+
+SizeSketch::SizeSketch()
+    : lengthHistogram(LENGTH_BIN_LOW, LENGTH_BIN_WIDTH, LENGTH_BINS),
+      massHistogram(MASS_BIN_LOW, MASS_BIN_WIDTH, MASS_BINS) {}
+
+void SizeSketch::add(float forkLength, float mass, float weight) {
+    this->lengthHistogram.add(forkLength, weight);
+    this->massHistogram.add(mass, weight);
+    this->lengthDigest.add(forkLength, weight);
+    this->massDigest.add(mass, weight);
+}
+
+void SizeSketch::merge(const SizeSketch &other) {
+    this->lengthHistogram.merge(other.lengthHistogram);
+    this->massHistogram.merge(other.massHistogram);
+    this->lengthDigest.merge(other.lengthDigest);
+    this->massDigest.merge(other.massDigest);
+}
+
+void SizeSketch::compress() {
+    this->lengthDigest.compress();
+    this->massDigest.compress();
+}
@@ -0,0 +1,89 @@
+#ifndef __FISH_SIZE_SKETCH_H
+#define __FISH_SIZE_SKETCH_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+* Fixed-memory summaries of the fork lengths and masses of sampled fish: equal-width histograms and
+* t-digest quantile sketches (Dunning & Ertl's merging digest). Both are weighted, so super-individuals
+* count as the fish they stand for, and both merge, so sketches built separately (by different threads,
+* or in different ensemble members) combine into the sketch of all their fish together.
+*/
+
+// Weighted counts in equal-width bins over [low, low + width * bins); values outside go in the end bins
+class FixedHistogram {
+public:
+    FixedHistogram(float low, float width, size_t bins);
+
+    void add(float value, float weight);
+    // Add other's counts; throws std::runtime_error if its bins differ
+    void merge(const FixedHistogram &other);
+    float getLow() const { return low; }
+    float getWidth() const { return width; }
+    const std::vector<float> &getCounts() const { return counts; }
+
+private:
+    float low;
+    float width;
+    std::vector<float> counts;
+};
+
+typedef struct Centroid {
+    float mean;
+    float weight;
+} Centroid;
+
+class TDigest {
+public:
+    static constexpr float DEFAULT_COMPRESSION = 64.0f;
+
+    explicit TDigest(float compression = DEFAULT_COMPRESSION);
+
+    void add(float value, float weight);
+    void merge(const TDigest &other);
+    // Fold pending values into the centroids (done automatically as values are added)
+    void compress();
+    // Value with a fraction q of the weight below it, interpolated between centroids (0 if empty)
+    float quantile(float q) const;
+    // The most centroids a compressed digest can hold, for fixed-width serialization
+    size_t capacity() const;
+    // Compressed centroids in increasing order of mean (call compress() first to include pending values)
+    const std::vector<Centroid> &getCentroids() const { return centroids; }
+    double getTotalWeight() const { return totalWeight; }
+
+private:
+    float compression;
+    std::vector<Centroid> centroids;
+    // Values added since the last compress()
+    std::vector<Centroid> pending;
+    double totalWeight;
+    float min;
+    float max;
+};
+
+// The histograms and digests of one sample's fork lengths (mm) and masses (g)
+class SizeSketch {
+public:
+    // Fork lengths in 5mm bins from 30mm (matching the 5mm recruit size classes from 35mm), masses in 0.25g bins
+    static constexpr float LENGTH_BIN_LOW = 30.0f;
+    static constexpr float LENGTH_BIN_WIDTH = 5.0f;
+    static constexpr size_t LENGTH_BINS = 24;
+    static constexpr float MASS_BIN_LOW = 0.0f;
+    static constexpr float MASS_BIN_WIDTH = 0.25f;
+    static constexpr size_t MASS_BINS = 60;
+
+    SizeSketch();
+
+    void add(float forkLength, float mass, float weight);
+    void merge(const SizeSketch &other);
+    // Compress both digests (before reading their centroids)
+    void compress();
+
+    FixedHistogram lengthHistogram;
+    FixedHistogram massHistogram;
+    TDigest lengthDigest;
+    TDigest massDigest;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// Target average number of nodes per cell when the cell size is picked automatically
+constexpr float NODES_PER_CELL = 4.0f;
+
+SpatialGrid::SpatialGrid(const std::vector<MapNode *> &map, float cellSize)
+    : minX(0.0f), minY(0.0f), maxX(0.0f), maxY(0.0f), cellSize(cellSize), cellsX(1), cellsY(1)
+{
+    std::unordered_map<const MapNode *, int> indexOf;
+    indexOf.reserve(map.size());
+    for (size_t i = 0; i < map.size(); ++i) {
+        MapNode *n = map[i];
+        indexOf[n] = (int) i;
+        this->xs.push_back(n->x);
+        this->ys.push_back(n->y);
+        if (i == 0) {
+            this->minX = this->maxX = n->x;
+            this->minY = this->maxY = n->y;
+        } else {
+            this->minX = std::min(this->minX, n->x);
+            this->minY = std::min(this->minY, n->y);
+            this->maxX = std::max(this->maxX, n->x);
+            this->maxY = std::max(this->maxY, n->y);
+        }
+    }
+
+    // Collect each connected pair once; distributary edge-to-edge links get their own colour
+    for (size_t i = 0; i < map.size(); ++i) {
+        MapNode *n = map[i];
+        bool dangling = false;
+        for (Edge &e : n->edgesOut) {
+            auto it = indexOf.find(e.target);
+            if (it == indexOf.end()) {
+                dangling = true;
+                continue;
+            }
+            HabitatType type = n->type;
+            if (n->type == HabitatType::DistributaryEdge && e.target->type == HabitatType::DistributaryEdge) {
+                type = HabitatType::DistributaryEdge;
+            }
+            this->segments.emplace_back((int) i, it->second, type);
+        }
+        for (Edge &e : n->edgesIn) {
+            if (!indexOf.count(e.source)) {
+                dangling = true;
+            }
+        }
+        if (dangling) {
+            this->danglingNodes.push_back((int) i);
+        }
+    }
+
+    float spanX = this->maxX - this->minX;
+    float spanY = this->maxY - this->minY;
+    if (this->cellSize <= 0.0f) {
+        float area = std::max(spanX, 1.0f) * std::max(spanY, 1.0f);
+        this->cellSize = std::sqrt(area * NODES_PER_CELL / (float) std::max<size_t>(map.size(), 1));
+        this->cellSize = std::max(this->cellSize, 1.0f);
+    }
+    this->cellsX = std::max(1, (int) std::floor(spanX / this->cellSize) + 1);
+    this->cellsY = std::max(1, (int) std::floor(spanY / this->cellSize) + 1);
+    size_t numCells = (size_t) this->cellsX * (size_t) this->cellsY;
+
+    // Bucket nodes by cell (counting sort into a flattened per-cell list)
+    this->nodeStarts.assign(numCells + 1, 0);
+    for (size_t i = 0; i < this->xs.size(); ++i) {
+        ++this->nodeStarts[(size_t) cellY(this->ys[i]) * this->cellsX + cellX(this->xs[i]) + 1];
+    }
+    for (size_t c = 0; c < numCells; ++c) {
+        this->nodeStarts[c + 1] += this->nodeStarts[c];
+    }
+    this->nodeCells.resize(this->xs.size());
+    std::vector<size_t> fill(this->nodeStarts.begin(), this->nodeStarts.end() - 1);
+    for (size_t i = 0; i < this->xs.size(); ++i) {
+        size_t c = (size_t) cellY(this->ys[i]) * this->cellsX + cellX(this->xs[i]);
+        this->nodeCells[fill[c]++] = (int) i;
+    }
+
+    // Segments go in every cell their bounding box covers
+    this->segmentStarts.assign(numCells + 1, 0);
+    auto segmentBounds = [this](const MapSegment &s, float &x0, float &y0, float &x1, float &y1) {
+        x0 = std::min(this->xs[s.sourceIndex], this->xs[s.targetIndex]);
+        x1 = std::max(this->xs[s.sourceIndex], this->xs[s.targetIndex]);
+        y0 = std::min(this->ys[s.sourceIndex], this->ys[s.targetIndex]);
+        y1 = std::max(this->ys[s.sourceIndex], this->ys[s.targetIndex]);
+    };
+    float x0, y0, x1, y1;
+    for (const MapSegment &s : this->segments) {
+        segmentBounds(s, x0, y0, x1, y1);
+        this->forEachCell(x0, y0, x1, y1, [this](size_t c) { ++this->segmentStarts[c + 1]; });
+    }
+    for (size_t c = 0; c < numCells; ++c) {
+        this->segmentStarts[c + 1] += this->segmentStarts[c];
+    }
+    this->segmentCells.resize(this->segmentStarts[numCells]);
+    fill.assign(this->segmentStarts.begin(), this->segmentStarts.end() - 1);
+    for (size_t si = 0; si < this->segments.size(); ++si) {
+        segmentBounds(this->segments[si], x0, y0, x1, y1);
+        this->forEachCell(x0, y0, x1, y1, [this, &fill, si](size_t c) { this->segmentCells[fill[c]++] = si; });
+    }
+}
+
+int SpatialGrid::cellX(float x) const {
+    return std::min(this->cellsX - 1, std::max(0, (int) std::floor((x - this->minX) / this->cellSize)));
+}
+
+int SpatialGrid::cellY(float y) const {
+    return std::min(this->cellsY - 1, std::max(0, (int) std::floor((y - this->minY) / this->cellSize)));
+}
+
+template <typename F>
+void SpatialGrid::forEachCell(float minX, float minY, float maxX, float maxY, F fn) const {
+    if (maxX < this->minX || maxY < this->minY || minX > this->maxX || minY > this->maxY) {
+        return;
+    }
+    int cx0 = cellX(minX);
+    int cx1 = cellX(maxX);
+    int cy0 = cellY(minY);
+    int cy1 = cellY(maxY);
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            fn((size_t) cy * this->cellsX + cx);
+        }
+    }
+}
+
+void SpatialGrid::queryNodes(float minX, float minY, float maxX, float maxY, std::vector<int> &out) const {
+    this->forEachCell(minX, minY, maxX, maxY, [&](size_t c) {
+        for (size_t k = this->nodeStarts[c]; k < this->nodeStarts[c + 1]; ++k) {
+            int i = this->nodeCells[k];
+            if (this->xs[i] >= minX && this->xs[i] <= maxX && this->ys[i] >= minY && this->ys[i] <= maxY) {
+                out.push_back(i);
+            }
+        }
+    });
+}
+
+void SpatialGrid::querySegments(float minX, float minY, float maxX, float maxY, std::vector<size_t> &out) const {
+    size_t first = out.size();
+    this->forEachCell(minX, minY, maxX, maxY, [&](size_t c) {
+        out.insert(out.end(), this->segmentCells.begin() + this->segmentStarts[c], this->segmentCells.begin() + this->segmentStarts[c + 1]);
+    });
+    // A segment spanning several cells is listed in each of them
+    std::sort(out.begin() + first, out.end());
+    out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
+
+// Search rings of cells outward from the query point until no unsearched cell can hold a closer node
+int SpatialGrid::nearestNode(float x, float y) const {
+    if (this->xs.empty()) {
+        return -1;
+    }
+    int best = -1;
+    float bestDist2 = std::numeric_limits<float>::max();
+    int cx = cellX(x);
+    int cy = cellY(y);
+    int maxRing = std::max(this->cellsX, this->cellsY);
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        for (int gy = cy - ring; gy <= cy + ring; ++gy) {
+            if (gy < 0 || gy >= this->cellsY) {
+                continue;
+            }
+            for (int gx = cx - ring; gx <= cx + ring; ++gx) {
+                if (gx < 0 || gx >= this->cellsX) {
+                    continue;
+                }
+                // Only the ring's border cells are new
+                if (gy != cy - ring && gy != cy + ring && gx != cx - ring && gx != cx + ring) {
+                    continue;
+                }
+                size_t c = (size_t) gy * this->cellsX + gx;
+                for (size_t k = this->nodeStarts[c]; k < this->nodeStarts[c + 1]; ++k) {
+                    int i = this->nodeCells[k];
+                    float dx = this->xs[i] - x;
+                    float dy = this->ys[i] - y;
+                    float d2 = dx*dx + dy*dy;
+                    if (d2 < bestDist2) {
+                        bestDist2 = d2;
+                        best = i;
+                    }
+                }
+            }
+        }
+        // Every point outside the searched square is at least ring*cellSize away
+        // (the query point may itself lie outside the grid, hence the clamped-cell offset)
+        float outsideX = std::max(0.0f, std::max(this->minX - x, x - this->maxX));
+        float outsideY = std::max(0.0f, std::max(this->minY - y, y - this->maxY));
+        float searched = ring * this->cellSize - std::max(outsideX, outsideY);
+        if (best != -1 && searched > 0.0f && searched * searched >= bestDist2) {
+            break;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,71 @@
+#ifndef __FISH_SPATIAL_INDEX_H
+#define __FISH_SPATIAL_INDEX_H
+
+#include <vector>
+#include "map.h"
+
+// A drawable map edge between two locations (each connected pair appears once)
+typedef struct MapSegment {
+    // Indices into the map node list
+    int sourceIndex;
+    int targetIndex;
+    // Habitat type whose colour the segment is drawn with
+    HabitatType type;
+    MapSegment(int sourceIndex, int targetIndex, HabitatType type)
+        : sourceIndex(sourceIndex), targetIndex(targetIndex), type(type) {}
+} MapSegment;
+
+/*
+* Uniform-grid spatial index over map locations and the segments between them.
+* Built once from a map; lets the renderer and hit-testing touch only the part of
+* the map inside a rectangle instead of walking every node and edge.
+* Coordinates are map coordinates (UTM meters); indices are positions in the map list.
+*/
+class SpatialGrid {
+public:
+    // cellSize <= 0 picks a size giving a few nodes per cell on average
+    explicit SpatialGrid(const std::vector<MapNode *> &map, float cellSize = 0.0f);
+
+    // Append the indices of nodes inside the rectangle to out
+    void queryNodes(float minX, float minY, float maxX, float maxY, std::vector<int> &out) const;
+    // Append the indices (into getSegments()) of segments whose bounding box overlaps the rectangle to out, without duplicates
+    void querySegments(float minX, float minY, float maxX, float maxY, std::vector<size_t> &out) const;
+    // Index of the node closest to (x, y), or -1 if the map is empty
+    int nearestNode(float x, float y) const;
+
+    const std::vector<MapSegment> &getSegments() const { return segments; }
+    // Indices of nodes with an edge leading to a node that isn't part of the map
+    const std::vector<int> &getDanglingNodes() const { return danglingNodes; }
+
+    float getMinX() const { return minX; }
+    float getMinY() const { return minY; }
+    float getMaxX() const { return maxX; }
+    float getMaxY() const { return maxY; }
+    float getCellSize() const { return cellSize; }
+
+private:
+    int cellX(float x) const;
+    int cellY(float y) const;
+    // Visit each cell index covered by the rectangle (clamped to the grid)
+    template <typename F> void forEachCell(float minX, float minY, float maxX, float maxY, F fn) const;
+
+    // Node coordinates, by map index
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<MapSegment> segments;
+    std::vector<int> danglingNodes;
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+    float cellSize;
+    int cellsX;
+    int cellsY;
+    // Per-cell contents, flattened: cell c owns [nodeStarts[c], nodeStarts[c+1]) of nodeCells
+    std::vector<size_t> nodeStarts;
+    std::vector<int> nodeCells;
+    std::vector<size_t> segmentStarts;
+    std::vector<size_t> segmentCells;
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "startup.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "hydro_stream.h"
+#include "load.h"
+#include "map_cache.h"
+#include "model_config_map.h"
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Path of the prepared map cache for these inputs and settings ("" if mapCacheDir isn't set)
+static std::string mapCachePath(const StartupFiles &files, const ModelConfigMap &config) {
+    if (config.getString(ModelParamKey::MapCacheDir).empty()) {
+        return "";
+    }
+    std::ostringstream settings;
+    settings << files.blindChannelSimplificationRadius << ',' << config.getInt(ModelParamKey::VirtualNodes) << ','
+             << config.getInt(ModelParamKey::MapCoarsenTargetNodes) << ','
+             << config.getFloat(ModelParamKey::MapCoarsenMaxElevationDifference) << ','
+             << config.getFloat(ModelParamKey::MapCoarsenMaxPathDistDifference);
+    std::string key = mapCacheKey({files.mapLocationFilename, files.mapEdgeFilename, files.mapGeometryFilename,
+                                   files.flowSpeedFilename, files.distribWseTempFilename}, files.recPointIds,
+                                  settings.str());
+    return (std::filesystem::path(config.getString(ModelParamKey::MapCacheDir)) / ("map_" + key + ".bin")).string();
+}
+
+// Path of the converted hydro stream file for these inputs, in mapCacheDir if it's set and the temporary
+// directory otherwise (reused by later runs until an input changes)
+static std::string hydroStreamPath(const StartupFiles &files, const ModelConfigMap &config) {
+    std::filesystem::path dir = config.getString(ModelParamKey::MapCacheDir).empty()
+        ? std::filesystem::temp_directory_path()
+        : std::filesystem::path(config.getString(ModelParamKey::MapCacheDir));
+    std::string key = mapCacheKey({files.flowSpeedFilename, files.distribWseTempFilename}, {}, "hydro stream");
+    return (dir / ("hydro_" + key + ".bin")).string();
+}
+
+// Open the hydro stream for these inputs, converting them first if there's no usable stream file
+static std::unique_ptr<HydroStream> openHydroStream(const StartupFiles &files, const ModelConfigMap &config) {
+    const std::string path = hydroStreamPath(files, config);
+    const size_t budgetBytes = (size_t) config.getInt(ModelParamKey::HydroMemoryBudgetMB) << 20;
+    try {
+        auto stream = std::make_unique<HydroStream>(path, budgetBytes);
+        std::cout << "Streaming distributary hydrology from " << path << std::endl;
+        return stream;
+    } catch (const std::runtime_error &e) {
+        if (std::filesystem::exists(path)) {
+            std::cerr << e.what() << "; converting it again" << std::endl;
+        }
+    }
+    std::string flowSpeed = files.flowSpeedFilename, wseTemp = files.distribWseTempFilename;
+    std::error_code err;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), err);
+    convertDistribHydro(flowSpeed, wseTemp, path, budgetBytes);
+    return std::make_unique<HydroStream>(path, budgetBytes);
+}
+
+// The distributary hydrology: every node's series, or with hydroMemoryBudgetMB set, a stream and nodes
+// holding only their positions
+typedef struct HydroGrid {
+    std::vector<DistribHydroNode> nodes;
+    std::unique_ptr<HydroStream> stream;
+} HydroGrid;
+
+typedef struct HydroTables {
+    std::vector<float> cresTide;
+    std::vector<float> flowVol;
+    std::vector<float> airTemp;
+} HydroTables;
+
+// Wait for a task, keeping the first exception any task throws
+template <typename T>
+static void join(std::future<T> &task, T &out, std::exception_ptr &error) {
+    try {
+        out = task.get();
+    } catch (...) {
+        if (!error) {
+            error = std::current_exception();
+        }
+    }
+}
+
+StartupInputs loadStartupInputs(const StartupFiles &files, const ModelConfigMap &config) {
+    const auto start = std::chrono::steady_clock::now();
+    StartupInputs inputs;
+    inputs.mapArena = std::make_unique<MapArena>();
+    const std::string cachePath = mapCachePath(files, config);
+
+    std::future<HydroTables> hydroTablesTask = std::async(std::launch::async, [&files, &inputs]() {
+        auto taskStart = std::chrono::steady_clock::now();
+        std::string cresTide = files.cresTideFilename, flowVol = files.flowVolFilename, airTemp = files.airTempFilename;
+        HydroTables tables;
+        // The hourly values are every 4th column
+        tables.cresTide = loadFloatListInterleaved(cresTide, 4);
+        tables.flowVol = loadFloatListInterleaved(flowVol, 4);
+        tables.airTemp = loadFloatListInterleaved(airTemp, 4);
+        inputs.timings.hydroTables = secondsSince(taskStart);
+        return tables;
+    });
+    std::future<HydroGrid> hydroGridTask = std::async(std::launch::async, [&files, &config, &inputs]() {
+        auto taskStart = std::chrono::steady_clock::now();
+        HydroGrid grid;
+        if (config.getInt(ModelParamKey::HydroMemoryBudgetMB) > 0) {
+            grid.stream = openHydroStream(files, config);
+            for (size_t i = 0; i < grid.stream->getNumNodes(); ++i) {
+                grid.nodes.emplace_back(i);
+                grid.nodes.back().x = grid.stream->getXs()[i];
+                grid.nodes.back().y = grid.stream->getYs()[i];
+            }
+        } else {
+            std::string flowSpeed = files.flowSpeedFilename, wseTemp = files.distribWseTempFilename;
+            loadDistribHydro(flowSpeed, wseTemp, grid.nodes);
+        }
+        inputs.timings.hydroGrid = secondsSince(taskStart);
+        return grid;
+    });
+    // Whether the map came from the cache (already linked to the hydrology)
+    std::future<bool> mapTask = std::async(std::launch::async, [&files, &config, &inputs, &cachePath]() {
+        auto taskStart = std::chrono::steady_clock::now();
+        bool cached = !cachePath.empty() && readMapCache(cachePath, inputs.map, inputs.recPoints,
+                                                         inputs.monitoringPoints, inputs.samplingSites,
+                                                         inputs.mapCoarsening, &inputs.reachability);
+        if (cached) {
+            std::cout << "Loaded " << inputs.map.size() << " map locations from " << cachePath << std::endl;
+        } else {
+            std::string location = files.mapLocationFilename, edge = files.mapEdgeFilename;
+            std::string geometry = files.mapGeometryFilename;
+            std::vector<unsigned> recPointIds = files.recPointIds;
+            parseMap(inputs.map, location, edge, geometry, recPointIds, inputs.recPoints, inputs.monitoringPoints,
+                     inputs.samplingSites, files.blindChannelSimplificationRadius, config, inputs.mapCoarsening,
+                     inputs.mapArena->buildMemory());
+        }
+        std::vector<std::vector<MapNode *> *> locationLists = {&inputs.recPoints, &inputs.monitoringPoints};
+        for (SamplingSite *site : inputs.samplingSites) {
+            locationLists.push_back(&site->points);
+        }
+        inputs.mapArena->compact(inputs.map, locationLists);
+        inputs.timings.map = secondsSince(taskStart);
+        return cached;
+    });
+    std::future<bool> recruitmentTask = std::async(std::launch::async, [&files, &inputs]() {
+        auto taskStart = std::chrono::steady_clock::now();
+        std::string counts = files.recCountFilename, sizes = files.recSizeDistsFilename;
+        loadIntList(counts, inputs.recCounts);
+        loadRecSizeDists(sizes, inputs.recSizeDists);
+        inputs.timings.recruitment = secondsSince(taskStart);
+        return true;
+    });
+
+    std::exception_ptr error;
+    HydroTables tables;
+    HydroGrid grid;
+    bool mapCached = false, recruitmentLoaded = false;
+    join(hydroTablesTask, tables, error);
+    join(hydroGridTask, grid, error);
+    join(mapTask, mapCached, error);
+    join(recruitmentTask, recruitmentLoaded, error);
+    if (error) {
+        for (MapNode *node : inputs.map) {
+            if (!inputs.mapArena->owns(node)) {
+                delete node;
+            }
+        }
+        for (SamplingSite *site : inputs.samplingSites) {
+            delete site;
+        }
+        std::rethrow_exception(error);
+    }
+
+    auto joinStart = std::chrono::steady_clock::now();
+    bool writeCache = !mapCached;
+    if (!mapCached) {
+        if (grid.stream) {
+            assignMapHydro(inputs.map, grid.nodes, grid.stream->getMinWses());
+        } else {
+            assignMapHydro(inputs.map, grid.nodes);
+        }
+    }
+    // Only high-awareness movement searches neighborhoods; an index cached with other settings is rebuilt
+    const size_t neighborhoodSize = (size_t) config.getInt(ModelParamKey::ReachabilityNeighborhoodSize);
+    if (config.getString(ModelParamKey::AgentAwareness) == "high" && neighborhoodSize > 0) {
+        if (inputs.reachability.empty() || inputs.reachability.getNeighborhoodSize() != neighborhoodSize ||
+            inputs.reachability.getNumNodes() != inputs.map.size()) {
+            inputs.reachability = ReachabilityIndex::build(inputs.map, neighborhoodSize,
+                                                           std::max(1U, std::thread::hardware_concurrency()));
+            writeCache = true;
+        }
+    } else {
+        inputs.reachability = ReachabilityIndex();
+    }
+    if (writeCache && !cachePath.empty()) {
+        // The cache only saves time, so a run goes ahead without it
+        try {
+            std::error_code err;
+            std::filesystem::create_directories(config.getString(ModelParamKey::MapCacheDir), err);
+            writeMapCache(cachePath, inputs.map, inputs.recPoints, inputs.monitoringPoints, inputs.samplingSites,
+                          inputs.mapCoarsening, inputs.reachability);
+        } catch (const std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    inputs.hydroModel = std::make_unique<HydroModel>(std::move(tables.cresTide), std::move(tables.flowVol),
+                                                     std::move(tables.airTemp), std::move(grid.nodes),
+                                                     files.hydroTimeIntercept, std::move(grid.stream));
+    inputs.timings.hydroAssignment = secondsSince(joinStart);
+    inputs.timings.total = secondsSince(start);
+    return inputs;
+}
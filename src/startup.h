@@ -0,0 +1,81 @@
+#ifndef __FISH_STARTUP_H
+#define __FISH_STARTUP_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "hydro.h"
+#include "map.h"
+#include "map_arena.h"
+#include "map_coarsen.h"
+#include "reachability_index.h"
+
+class ModelConfigMap;
+
+/*
+* Loading a model's inputs as a small task graph. The hydrology tables (tide, flow volume and air
+* temperature CSVs), the distributary hydrology (NetCDF), the map (CSVs, cleanup and coarsening, or the
+* prepared map cache) and the recruitment CSVs are independent, so they load concurrently; the only join is
+* linking the map to the hydrology (assignMapHydro in load.h), after which the reachability index is built
+* for high-awareness movement (see reachability_index.h) and the prepared map is cached along with it.
+* All NetCDF reading stays on the one hydrology task, as the NetCDF library isn't thread-safe. With
+* hydroMemoryBudgetMB set, that task converts the distributary hydrology to a stream file (once per set of
+* inputs) and opens it instead of loading it (see hydro_stream.h).
+*/
+
+// Wall-clock seconds spent in each phase of loading a model's inputs (the first four overlap)
+typedef struct StartupTimings {
+    // Tide, flow volume and air temperature CSVs
+    double hydroTables;
+    // Distributary hydrology NetCDF files (or opening the hydro stream, converting them first if needed)
+    double hydroGrid;
+    // Map CSVs, cleanup and coarsening (or reading the prepared map cache)
+    double map;
+    // Recruit count and size distribution CSVs
+    double recruitment;
+    // Linking the map to the hydrology, building the reachability index and writing the prepared map cache
+    double hydroAssignment;
+    // From the start of loading to the last task finishing
+    double total;
+    StartupTimings() : hydroTables(0.0), hydroGrid(0.0), map(0.0), recruitment(0.0), hydroAssignment(0.0), total(0.0) {}
+} StartupTimings;
+
+// Input files and load-time settings for a model run from data files (see the file Model constructor)
+typedef struct StartupFiles {
+    std::string recCountFilename;
+    std::string recSizeDistsFilename;
+    std::vector<unsigned> recPointIds;
+    std::string mapLocationFilename;
+    std::string mapEdgeFilename;
+    std::string mapGeometryFilename;
+    float blindChannelSimplificationRadius;
+    std::string cresTideFilename;
+    std::string flowVolFilename;
+    std::string airTempFilename;
+    std::string flowSpeedFilename;
+    std::string distribWseTempFilename;
+    int hydroTimeIntercept;
+} StartupFiles;
+
+// Everything the file Model constructor loads
+typedef struct StartupInputs {
+    std::unique_ptr<HydroModel> hydroModel;
+    // Holds the map's locations once it's loaded (see map_arena.h)
+    std::unique_ptr<MapArena> mapArena;
+    std::vector<MapNode *> map;
+    std::vector<MapNode *> recPoints;
+    std::vector<MapNode *> monitoringPoints;
+    std::vector<SamplingSite *> samplingSites;
+    MapCoarsening mapCoarsening;
+    // Empty unless agentAwareness is "high" (see reachability_index.h)
+    ReachabilityIndex reachability;
+    std::vector<int> recCounts;
+    std::vector<std::vector<float>> recSizeDists;
+    StartupTimings timings;
+} StartupInputs;
+
+// Load a model's inputs, running independent loads concurrently. Exceptions from any task are rethrown
+// once every task has finished.
+StartupInputs loadStartupInputs(const StartupFiles &files, const ModelConfigMap &config);
+
+#endif
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "model.h"
+#include "mode_validation.h"
+#include "util.h"
+
+/*
+* Compares super-individual runs against the individual model.
+*
+* Usage: super_individual_validation <config file> [--size n] [--steps n] [--seeds n]
+*
+* Loads the inputs once, then for each seed runs the model with one Fish per recruit and with
+* superIndividualSize = n (default 100). Reports, per mode, the mean and standard deviation across
+* seeds of the final abundances, each sampling result and the population trajectory, with the
+* difference in standard errors (|z| much above 2 means the super-individual model is biased), plus
+* the Kolmogorov-Smirnov distance between the pooled, abundance-weighted size distributions of the
+* surviving fish (the report is compareModes in mode_validation.h). Intended for small (short or
+* low-recruitment) years, since the individual model has to run them too.
+*/
+
+static ValidationRun runOnce(Model &model, int superIndividualSize, unsigned int seed, long steps) {
+    ModelConfigMap config = model.getConfigMap();
+    config.set(ModelParamKey::SuperIndividualSize, superIndividualSize);
+    model.setConfigMap(config);
+    GlobalRand::reseed(seed);
+    model.reset();
+    model.reserveHistory((size_t) steps);
+    auto start = std::chrono::steady_clock::now();
+    while (model.time < steps) {
+        model.masterUpdate();
+    }
+    ValidationRun run;
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.agents = model.individuals.size();
+    run.living = model.livingAbundance;
+    run.dead = model.deadAbundance;
+    run.exited = model.exitedAbundance;
+    run.trajectory.assign(model.populationHistory.begin(), model.populationHistory.end());
+    for (const Sample &s : model.sampleHistory) {
+        run.samples[{s.siteID, s.time}] = {(double) s.population, s.meanLength, s.meanMass};
+    }
+    for (size_t id : model.livingIndividuals) {
+        const Fish &f = model.individuals[id];
+        run.forkLengths.emplace_back(f.forkLength, f.weight);
+        run.masses.emplace_back(f.mass, f.weight);
+    }
+    return run;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: super_individual_validation <config file> [--size n] [--steps n] [--seeds n]" << std::endl;
+        return 1;
+    }
+    std::string configPath(argv[1]);
+    int superIndividualSize = 100;
+    long steps = 60 * 24;
+    unsigned int seeds = 8;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg(argv[i]);
+        if (arg == "--size") {
+            superIndividualSize = std::stoi(argv[i + 1]);
+        } else if (arg == "--steps") {
+            steps = std::stol(argv[i + 1]);
+        } else if (arg == "--seeds") {
+            seeds = (unsigned int) std::stoul(argv[i + 1]);
+        } else {
+            std::cerr << "Unrecognized option " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (superIndividualSize < 2 || steps <= 0 || seeds < 2) {
+        std::cerr << "Need --size >= 2, --steps > 0 and --seeds >= 2" << std::endl;
+        return 1;
+    }
+
+    Model *m = modelFromConfig(configPath);
+    std::vector<ValidationRun> individualRuns;
+    std::vector<ValidationRun> superRuns;
+    for (unsigned int seed = 1; seed <= seeds; ++seed) {
+        individualRuns.push_back(runOnce(*m, 1, seed, steps));
+        superRuns.push_back(runOnce(*m, superIndividualSize, seed, steps));
+        std::cout << "seed " << seed << ": individual " << individualRuns.back().agents << " agents, "
+                  << individualRuns.back().seconds << "s; super " << superRuns.back().agents << " agents, "
+                  << superRuns.back().seconds << "s" << std::endl;
+    }
+
+    compareModes("individual", individualRuns, "super", superRuns, "t", "population trajectory");
+
+    delete m;
+    return 0;
+}
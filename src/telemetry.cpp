@@ -0,0 +1,207 @@
+#include "telemetry.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+#include "model.h"
+
+// Records are batched into a reader's send buffer up to about this many bytes
+constexpr size_t MAX_PENDING_BYTES = 64 * 1024;
+// The server thread wakes at least this often to notice shutdown
+constexpr int POLL_TIMEOUT_MS = 200;
+
+static std::runtime_error socketError(const std::string &what, const std::string &path) {
+    return std::runtime_error("Telemetry socket " + path + ": " + what + " failed: " + std::strerror(errno));
+}
+
+TelemetryServer::TelemetryServer(const std::string &socketPath, size_t capacity)
+    : socketPath(socketPath), capacity(capacity > 0 ? capacity : 1), listenFd(-1), wakeFds{-1, -1},
+      firstSeq(0), stopping(false), numReaders(0), numDropped(0)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Telemetry socket path is empty or too long: " + socketPath);
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    this->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (this->listenFd == -1) {
+        throw socketError("socket", socketPath);
+    }
+    // A socket file left behind by a crashed run would make bind fail
+    unlink(socketPath.c_str());
+    if (bind(this->listenFd, (sockaddr *) &addr, sizeof(addr)) == -1 || listen(this->listenFd, 16) == -1) {
+        std::runtime_error error = socketError("bind/listen", socketPath);
+        close(this->listenFd);
+        throw error;
+    }
+    if (pipe2(this->wakeFds, O_NONBLOCK | O_CLOEXEC) == -1) {
+        std::runtime_error error = socketError("pipe", socketPath);
+        close(this->listenFd);
+        unlink(socketPath.c_str());
+        throw error;
+    }
+    this->thread = std::thread(&TelemetryServer::serve, this);
+}
+
+TelemetryServer::~TelemetryServer() {
+    this->stopping = true;
+    this->wake();
+    this->thread.join();
+    close(this->listenFd);
+    close(this->wakeFds[0]);
+    close(this->wakeFds[1]);
+    unlink(this->socketPath.c_str());
+}
+
+void TelemetryServer::publish(const std::string &record) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->ring.push_back(record + "\n");
+        if (this->ring.size() > this->capacity) {
+            this->ring.pop_front();
+            ++this->firstSeq;
+        }
+    }
+    this->wake();
+}
+
+void TelemetryServer::wake() {
+    char c = 0;
+    // If the pipe is full the server thread has wakeups pending anyway
+    ssize_t ignored = write(this->wakeFds[1], &c, 1);
+    (void) ignored;
+}
+
+typedef struct TelemetryReader {
+    int fd;
+    // Sequence number of the next record to queue for this reader
+    uint64_t nextSeq;
+    std::string pending;
+    size_t sent;
+} TelemetryReader;
+
+void TelemetryServer::serve() {
+    std::vector<TelemetryReader> readers;
+    std::vector<pollfd> fds;
+    while (!this->stopping) {
+        // Refill the send buffers of readers that have caught up on what was queued for them
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            const uint64_t endSeq = this->firstSeq + this->ring.size();
+            for (TelemetryReader &r : readers) {
+                if (r.sent < r.pending.size()) {
+                    continue;
+                }
+                r.pending.clear();
+                r.sent = 0;
+                if (r.nextSeq < this->firstSeq) {
+                    this->numDropped += this->firstSeq - r.nextSeq;
+                    r.nextSeq = this->firstSeq;
+                }
+                while (r.nextSeq < endSeq && r.pending.size() < MAX_PENDING_BYTES) {
+                    r.pending += this->ring[r.nextSeq - this->firstSeq];
+                    ++r.nextSeq;
+                }
+            }
+        }
+
+        fds.clear();
+        fds.push_back({this->listenFd, POLLIN, 0});
+        fds.push_back({this->wakeFds[0], POLLIN, 0});
+        for (TelemetryReader &r : readers) {
+            // Readers aren't expected to send anything, but POLLIN reports when they hang up
+            fds.push_back({r.fd, (short) (r.sent < r.pending.size() ? POLLIN | POLLOUT : POLLIN), 0});
+        }
+        if (poll(fds.data(), fds.size(), POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char drain[256];
+            while (read(this->wakeFds[0], drain, sizeof(drain)) > 0) {}
+        }
+        std::vector<TelemetryReader> remaining;
+        for (size_t i = 0; i < readers.size(); ++i) {
+            TelemetryReader &r = readers[i];
+            short revents = fds[i + 2].revents;
+            bool open = !(revents & (POLLERR | POLLNVAL));
+            if (open && (revents & (POLLIN | POLLHUP))) {
+                char discard[256];
+                ssize_t n = recv(r.fd, discard, sizeof(discard), MSG_DONTWAIT);
+                open = n > 0 || (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK));
+            }
+            if (open && (revents & POLLOUT)) {
+                ssize_t n = send(r.fd, r.pending.data() + r.sent, r.pending.size() - r.sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (n > 0) {
+                    r.sent += (size_t) n;
+                } else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    open = false;
+                }
+            }
+            if (open) {
+                remaining.push_back(std::move(r));
+            } else {
+                close(r.fd);
+            }
+        }
+        readers.swap(remaining);
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept4(this->listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                readers.push_back({fd, this->firstSeq + this->ring.size(), "", 0});
+            }
+        }
+        this->numReaders = readers.size();
+    }
+    for (TelemetryReader &r : readers) {
+        close(r.fd);
+    }
+    this->numReaders = 0;
+}
+
+std::string formatStepRecord(const Model &model, unsigned long runID, double stepSeconds, size_t firstNewSample) {
+    const PhaseTimings &t = model.lastStepTimings;
+    std::ostringstream out;
+    out << "{\"run\":" << runID
+        << ",\"time\":" << model.time
+        << ",\"living\":" << model.livingIndividuals.size()
+        << ",\"exited\":" << model.exitedCount
+        << ",\"dead\":" << model.deadCount
+        << ",\"stepSeconds\":" << stepSeconds
+        << ",\"phases\":{\"recruit\":" << t.recruit << ",\"move\":" << t.move << ",\"count\":" << t.count
+        << ",\"growAndDie\":" << t.growAndDie << ",\"sampling\":" << t.sampling << ",\"record\":" << t.record << "}"
+        << ",\"samples\":[";
+    for (size_t i = firstNewSample; i < model.sampleHistory.size(); ++i) {
+        out << (i > firstNewSample ? "," : "") << formatSampleJson(model.sampleHistory[i]);
+    }
+    out << "]}";
+    return out.str();
+}
+
+std::string formatStartupRecord(const Model &model, unsigned long runID) {
+    const StartupTimings &t = model.startupTimings;
+    std::ostringstream out;
+    out << "{\"run\":" << runID
+        << ",\"startup\":{\"hydroTables\":" << t.hydroTables << ",\"hydroGrid\":" << t.hydroGrid
+        << ",\"map\":" << t.map << ",\"recruitment\":" << t.recruitment
+        << ",\"hydroAssignment\":" << t.hydroAssignment << ",\"total\":" << t.total << "}}";
+    return out.str();
+}
+
+std::string formatSampleJson(const Sample &s) {
+    std::ostringstream out;
+    out << "{\"site\":" << s.siteID << ",\"time\":" << s.time << ",\"population\":" << s.population
+        << ",\"meanMass\":" << s.meanMass << ",\"meanLength\":" << s.meanLength
+        << ",\"meanSpawnTime\":" << s.meanSpawnTime << "}";
+    return out.str();
+}
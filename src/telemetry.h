@@ -0,0 +1,71 @@
+#ifndef __FISH_TELEMETRY_H
+#define __FISH_TELEMETRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Model;
+struct Sample;
+
+/*
+* Publishes one-line records to any number of readers attached to a Unix domain socket.
+*
+* Readers can connect and disconnect at any time; a new reader gets records published after it
+* attaches. Records wait in a ring buffer of the last `capacity` records, and a background thread
+* sends each reader whatever it hasn't seen yet. A reader that falls more than `capacity` records
+* behind skips the oldest ones, so publish() never waits on a reader.
+*/
+class TelemetryServer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    // Listens on socketPath (replacing any stale socket there); throws std::runtime_error on failure
+    TelemetryServer(const std::string &socketPath, size_t capacity = DEFAULT_CAPACITY);
+    ~TelemetryServer();
+    TelemetryServer(const TelemetryServer &) = delete;
+    TelemetryServer &operator=(const TelemetryServer &) = delete;
+
+    // Queue a record (without its trailing newline) for every attached reader
+    void publish(const std::string &record);
+
+    const std::string &getSocketPath() const { return socketPath; }
+    size_t getNumReaders() const { return numReaders; }
+    // Records that readers have missed by falling behind (counted once per reader)
+    uint64_t getNumDropped() const { return numDropped; }
+
+private:
+    void serve();
+    void wake();
+
+    std::string socketPath;
+    size_t capacity;
+    int listenFd;
+    // Pipe that publish() and the destructor write to, to interrupt the server thread's poll()
+    int wakeFds[2];
+
+    std::mutex mutex;
+    // Newline-terminated records firstSeq ... firstSeq + ring.size() - 1
+    std::deque<std::string> ring;
+    uint64_t firstSeq;
+
+    std::atomic<bool> stopping;
+    std::atomic<size_t> numReaders;
+    std::atomic<uint64_t> numDropped;
+    std::thread thread;
+};
+
+// The JSON line published after each timestep: time, fish counts, the step's wall time and
+// phase timings (seconds), and any samples taken from sampleHistory[firstNewSample] onwards
+std::string formatStepRecord(const Model &model, unsigned long runID, double stepSeconds, size_t firstNewSample);
+// The JSON line published once before the first timestep: the seconds spent in each phase of loading the
+// inputs (see StartupTimings in startup.h)
+std::string formatStartupRecord(const Model &model, unsigned long runID);
+// One sampling result as a JSON object
+std::string formatSampleJson(const Sample &sample);
+
+#endif
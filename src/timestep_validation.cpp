@@ -0,0 +1,98 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "model.h"
+#include "mode_validation.h"
+#include "util.h"
+
+/*
+* Compares multi-hour timestep runs against the hourly model.
+*
+* Usage: timestep_validation <config file> [--hours h] [--days n] [--seeds n]
+*
+* Loads the inputs once, then for each seed runs the first n days (default 30) with hoursPerTimestep = 1
+* and with hoursPerTimestep = h (default 3). Reports, per mode, the mean and standard deviation across
+* seeds of the run time, the final abundances and each sampling result (matched by site and hour), with
+* the difference in standard errors, plus the largest divergence of the daily population trajectory and
+* the Kolmogorov-Smirnov distance between the pooled, abundance-weighted final size distributions and the
+* speedup (the report is compareModes in mode_validation.h).
+*/
+
+static ValidationRun runOnce(Model &model, int hoursPerTimestep, unsigned int seed, long days) {
+    ModelConfigMap config = model.getConfigMap();
+    config.set(ModelParamKey::HoursPerTimestep, hoursPerTimestep);
+    model.setConfigMap(config);
+    GlobalRand::reseed(seed);
+    model.reset();
+    const long steps = days * 24 / hoursPerTimestep;
+    model.reserveHistory((size_t) steps);
+    auto start = std::chrono::steady_clock::now();
+    while (model.time < steps) {
+        model.masterUpdate();
+    }
+    ValidationRun run;
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.agents = model.individuals.size();
+    run.living = model.livingAbundance;
+    run.dead = model.deadAbundance;
+    run.exited = model.exitedAbundance;
+    // Living abundance at the end of each day, which both modes have
+    const long stepsPerDay = 24 / hoursPerTimestep;
+    for (long day = 1; day <= days; ++day) {
+        run.trajectory.push_back((double) model.populationHistory[day * stepsPerDay - 1]);
+    }
+    // Keyed by hour, to match samples across step lengths
+    for (const Sample &s : model.sampleHistory) {
+        run.samples[{s.siteID, s.time * hoursPerTimestep}] = {(double) s.population, s.meanLength, s.meanMass};
+    }
+    for (size_t id : model.livingIndividuals) {
+        const Fish &f = model.individuals[id];
+        run.forkLengths.emplace_back(f.forkLength, f.weight);
+        run.masses.emplace_back(f.mass, f.weight);
+    }
+    return run;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: timestep_validation <config file> [--hours h] [--days n] [--seeds n]" << std::endl;
+        return 1;
+    }
+    std::string configPath(argv[1]);
+    int hours = 3;
+    long days = 30;
+    unsigned int seeds = 8;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg(argv[i]);
+        if (arg == "--hours") {
+            hours = std::stoi(argv[i + 1]);
+        } else if (arg == "--days") {
+            days = std::stol(argv[i + 1]);
+        } else if (arg == "--seeds") {
+            seeds = (unsigned int) std::stoul(argv[i + 1]);
+        } else {
+            std::cerr << "Unrecognized option " << arg << std::endl;
+            return 1;
+        }
+    }
+    if ((hours != 2 && hours != 3 && hours != 6) || days <= 0 || seeds < 2) {
+        std::cerr << "Need --hours 2, 3 or 6, --days > 0 and --seeds >= 2" << std::endl;
+        return 1;
+    }
+
+    Model *m = modelFromConfig(configPath);
+    std::vector<ValidationRun> hourlyRuns;
+    std::vector<ValidationRun> coarseRuns;
+    for (unsigned int seed = 1; seed <= seeds; ++seed) {
+        hourlyRuns.push_back(runOnce(*m, 1, seed, days));
+        coarseRuns.push_back(runOnce(*m, hours, seed, days));
+        std::cout << "seed " << seed << ": hourly " << hourlyRuns.back().seconds << "s; "
+                  << hours << "-hour " << coarseRuns.back().seconds << "s" << std::endl;
+    }
+
+    compareModes("hourly", hourlyRuns, std::to_string(hours) + "-hour", coarseRuns, "h", "daily population");
+
+    delete m;
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "util.h"
+#include <algorithm>
 #include <random>
 #include <cmath>
 
@@ -7,17 +8,32 @@ std::default_random_engine GlobalRand::generator(initial_rd());
 std::uniform_real_distribution<float> GlobalRand::unit_dist;
 std::normal_distribution<float> GlobalRand::normal_dist;
 std::uniform_int_distribution<int> GlobalRand::int_dist;
+uint64_t GlobalRand::keySeed = initial_rd();
+thread_local KeyedRandScope *KeyedRandScope::current = nullptr;
 
 
 float GlobalRand::unit_rand() {
+    float u;
+    if (KeyedRandScope::next(u)) {
+        return u;
+    }
     return GlobalRand::unit_dist(GlobalRand::generator);
 }
 
 float GlobalRand::unit_normal_rand() {
+    float u1, u2;
+    if (KeyedRandScope::next(u1) && KeyedRandScope::next(u2)) {
+        // Box-Muller
+        return std::sqrt(-2.0f * std::log(1.0f - u1)) * std::cos(2.0f * (float) M_PI * u2);
+    }
     return GlobalRand::normal_dist(GlobalRand::generator);
 }
 
 int GlobalRand::int_rand(int min, int max) {
+    float u;
+    if (KeyedRandScope::next(u)) {
+        return min + std::min((int) (u * (float) (max - min + 1)), max - min);
+    }
     GlobalRand::int_dist = std::uniform_int_distribution<int>(min, max);
     return GlobalRand::int_dist(GlobalRand::generator);
 }
@@ -28,10 +44,52 @@ void GlobalRand::reseed(const unsigned int seed) {
         return;
     }
     GlobalRand::generator = std::default_random_engine(seed);
+    GlobalRand::keySeed = seed;
+    // The normal distribution caches a value between calls, which would carry over from the old sequence
+    GlobalRand::normal_dist.reset();
 }
 
 void GlobalRand::reseed_random() {
     GlobalRand::generator = std::default_random_engine(std::random_device{}());
+    GlobalRand::keySeed = std::random_device{}();
+    GlobalRand::normal_dist.reset();
+}
+
+uint64_t GlobalRand::getKeySeed() {
+    return GlobalRand::keySeed;
+}
+
+// splitmix64 finalizer
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+KeyedRandScope::KeyedRandScope(bool enabled, RandPurpose purpose, uint64_t id, uint64_t step, uint64_t sub)
+    : enabled(enabled), key(0), counter(0), outer(nullptr) {
+    if (!enabled) {
+        return;
+    }
+    this->key = mix(mix(mix(mix(GlobalRand::getKeySeed() ^ (uint64_t) purpose) ^ id) ^ step) ^ sub);
+    this->outer = current;
+    current = this;
+}
+
+KeyedRandScope::~KeyedRandScope() {
+    if (this->enabled) {
+        current = this->outer;
+    }
+}
+
+bool KeyedRandScope::next(float &out) {
+    if (current == nullptr) {
+        return false;
+    }
+    // The top 24 bits, so the result is exactly representable and below 1
+    out = (float) (mix(current->key ^ current->counter++) >> 40) * (1.0f / 16777216.0f);
+    return true;
 }
 
 float unit_rand() {
@@ -1,6 +1,7 @@
 #ifndef __FISH_UTIL_H
 #define __FISH_UTIL_H
 
+#include <cstdint>
 #include <random>
 
 class GlobalRand {
@@ -12,9 +13,12 @@ public:
     static constexpr unsigned int USE_RANDOM_SEED = 0;
     static void reseed(unsigned int seed);
     static void reseed_random();
+    // Seed of the keyed streams (see KeyedRandScope), set along with the generator's
+    static uint64_t getKeySeed();
 
 private:
     static std::default_random_engine generator;
+    static uint64_t keySeed;
     static std::uniform_real_distribution<float> unit_dist;
     static std::normal_distribution<float> normal_dist;
     static std::uniform_int_distribution<int> int_dist;
@@ -23,6 +27,47 @@ private:
 float unit_rand();
 float unit_normal_rand();
 
+// What a keyed draw is for (see KeyedRandScope)
+enum class RandPurpose : uint32_t {
+    // Which hour each of a day's recruits enters (id = recruitment data day)
+    RecruitPlan = 1,
+    // A recruit's entry point and size (id = fish ID; or, for super-individuals, the hour)
+    Recruit,
+    // A fish's movement (id = fish ID)
+    Movement,
+    // A fish's mortality draw and length update (id = fish ID)
+    GrowthAndMortality,
+    // Whether a density-engine pool of less than one fish survives (id = map position)
+    DensityPool
+};
+
+/*
+* Common random numbers: while a KeyedRandScope is active on a thread, the GlobalRand draws made on that
+* thread come from a stream keyed by the scope's (purpose, id, step, sub), the key seed and the draw's
+* position within the scope, instead of from the shared generator. Two runs with the same seed then make
+* the same draws for the same fish and purpose wherever their states coincide, however differently
+* their other draws went, so paired comparisons between scenarios carry far less Monte Carlo noise.
+* Keyed draws are also independent of thread scheduling. A scope created with enabled = false does
+* nothing, so call sites can pass the commonRandomNumbers setting straight through.
+*/
+class KeyedRandScope {
+public:
+    KeyedRandScope(bool enabled, RandPurpose purpose, uint64_t id, uint64_t step, uint64_t sub = 0);
+    ~KeyedRandScope();
+    KeyedRandScope(const KeyedRandScope &) = delete;
+    KeyedRandScope &operator=(const KeyedRandScope &) = delete;
+
+    // Set out to the next uniform [0, 1) draw of this thread's innermost active scope; false if there's none
+    static bool next(float &out);
+
+private:
+    bool enabled;
+    uint64_t key;
+    uint64_t counter;
+    KeyedRandScope *outer;
+    static thread_local KeyedRandScope *current;
+};
+
 // Hook to allow tests to override the sampling behavior.
 // In production code, this should be left as nullptr.
 using SampleFunction = unsigned(*)(float *weights, unsigned weightsLen);
@@ -34,4 +79,13 @@ int poisson(double lambda);
 
 double normal_pdf(double x, double mu, double sigma);
 
+// Hint that the memory at address will be read soon (only a hint: it never changes a result)
+inline void prefetchRead(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#else
+    (void) address;
+#endif
+}
+
 #endif
\ No newline at end of file
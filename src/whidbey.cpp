@@ -0,0 +1,252 @@
+#include "whidbey.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <variant>
+#include "model.h"
+#include "util.h"
+
+struct wb_model {
+    std::unique_ptr<Model> model;
+    // Movement threads for unseeded runs (seeded runs use one, as in headless)
+    size_t maxThreads;
+};
+
+static thread_local std::string lastError;
+
+static wb_status fail(wb_status status, const std::string &message) {
+    lastError = message;
+    return status;
+}
+
+// Run f, turning any exception into WB_ERROR_MODEL
+template <typename F>
+static wb_status guarded(F f) {
+    try {
+        return f();
+    } catch (const std::exception &e) {
+        return fail(WB_ERROR_MODEL, e.what());
+    } catch (...) {
+        return fail(WB_ERROR_MODEL, "unknown error");
+    }
+}
+
+#define WB_REQUIRE(cond, message) \
+    if (!(cond)) { return fail(WB_ERROR_INVALID_ARGUMENT, message); }
+
+// Find a parameter by its config file name, holding the given type
+template <typename T>
+static wb_status findParam(const wb_model *model, const char *name, bool forWriting, ModelParamKey &key) {
+    WB_REQUIRE(model != nullptr && name != nullptr, "null model or parameter name");
+    const ModelConfigMap &config = model->model->getConfigMap();
+    WB_REQUIRE(config.findFileKey(name, key), std::string("unknown parameter ") + name);
+    WB_REQUIRE(std::holds_alternative<T>(config.get(key)), std::string("parameter ") + name + " has a different type");
+    WB_REQUIRE(!forWriting || ModelConfigMap::isRunTimeParameter(key),
+               std::string("parameter ") + name + " is only read when the inputs are loaded");
+    return WB_OK;
+}
+
+template <typename T>
+static wb_status setParam(wb_model *model, const char *name, const T &value) {
+    ModelParamKey key;
+    wb_status status = findParam<T>(model, name, true, key);
+    if (status != WB_OK) {
+        return status;
+    }
+    return guarded([&]() {
+        ModelConfigMap config = model->model->getConfigMap();
+        config.set(key, value);
+        model->model->setConfigMap(config);
+        return WB_OK;
+    });
+}
+
+int wb_api_version(void) {
+    return WB_API_VERSION;
+}
+
+const char *wb_last_error(void) {
+    return lastError.c_str();
+}
+
+wb_model *wb_model_adopt(Model *model) {
+    if (model == nullptr) {
+        return nullptr;
+    }
+    return new wb_model{std::unique_ptr<Model>(model), model->getMaxThreads()};
+}
+
+wb_status wb_model_create(const char *config_path, wb_model **out) {
+    WB_REQUIRE(config_path != nullptr && out != nullptr, "null config path or output handle");
+    *out = nullptr;
+    return guarded([&]() {
+        *out = wb_model_adopt(modelFromConfig(config_path));
+        return WB_OK;
+    });
+}
+
+void wb_model_destroy(wb_model *model) {
+    delete model;
+}
+
+wb_status wb_model_reset(wb_model *model, unsigned int seed) {
+    WB_REQUIRE(model != nullptr, "null model");
+    return guarded([&]() {
+        GlobalRand::reseed(seed);
+        model->model->setMaxThreads(seed == GlobalRand::USE_RANDOM_SEED ? model->maxThreads : 1);
+        model->model->reset();
+        return WB_OK;
+    });
+}
+
+wb_status wb_model_step(wb_model *model, long steps) {
+    WB_REQUIRE(model != nullptr, "null model");
+    WB_REQUIRE(steps >= 0, "negative step count");
+    return guarded([&]() {
+        for (long i = 0; i < steps; ++i) {
+            model->model->masterUpdate();
+        }
+        return WB_OK;
+    });
+}
+
+wb_status wb_model_time(const wb_model *model, long *time) {
+    WB_REQUIRE(model != nullptr && time != nullptr, "null model or output");
+    *time = model->model->time;
+    return WB_OK;
+}
+
+wb_status wb_model_counts(const wb_model *model, size_t *living, size_t *exited, size_t *dead) {
+    WB_REQUIRE(model != nullptr, "null model");
+    const Model &m = *model->model;
+    if (living != nullptr) *living = m.livingIndividuals.size();
+    if (exited != nullptr) *exited = (size_t) m.exitedCount;
+    if (dead != nullptr) *dead = (size_t) m.deadCount;
+    return WB_OK;
+}
+
+wb_status wb_model_fish_columns(const wb_model *model, wb_fish_columns *out) {
+    WB_REQUIRE(model != nullptr && out != nullptr, "null model or output");
+    const Model &m = *model->model;
+    *out = wb_fish_columns{};
+    out->count = m.livingIndividuals.size();
+    out->living = m.livingIndividuals.data();
+    out->num_individuals = m.individuals.size();
+    out->stride = sizeof(Fish);
+    if (!m.individuals.empty()) {
+        const Fish &first = m.individuals.front();
+        out->spawn_time = &first.spawnTime;
+        out->fork_length = &first.forkLength;
+        out->mass = &first.mass;
+        out->travel = &first.travel;
+        out->last_growth = &first.lastGrowth;
+        out->last_pmax = &first.lastPmax;
+        out->last_mortality = &first.lastMortality;
+    }
+    return WB_OK;
+}
+
+wb_status wb_model_fish_locations(const wb_model *model, int *out, size_t capacity, size_t *written) {
+    WB_REQUIRE(model != nullptr && (out != nullptr || capacity == 0), "null model or output");
+    const Model &m = *model->model;
+    size_t n = std::min(capacity, m.livingIndividuals.size());
+    for (size_t i = 0; i < n; ++i) {
+        const MapNode *location = m.individuals[m.livingIndividuals[i]].location;
+        out[i] = location == nullptr ? -1 : location->id;
+    }
+    if (written != nullptr) *written = n;
+    return WB_OK;
+}
+
+wb_status wb_model_num_samples(const wb_model *model, size_t *count) {
+    WB_REQUIRE(model != nullptr && count != nullptr, "null model or output");
+    *count = model->model->sampleHistory.size();
+    return WB_OK;
+}
+
+wb_status wb_model_get_sample(const wb_model *model, size_t index, wb_sample *out) {
+    WB_REQUIRE(model != nullptr && out != nullptr, "null model or output");
+    WB_REQUIRE(index < model->model->sampleHistory.size(), "sample index out of range");
+    const Sample &s = model->model->sampleHistory[index];
+    *out = wb_sample{s.siteID, s.time, s.population, s.meanMass, s.meanLength, s.meanSpawnTime};
+    return WB_OK;
+}
+
+wb_status wb_model_set_int(wb_model *model, const char *name, int value) {
+    return setParam<int>(model, name, value);
+}
+
+wb_status wb_model_set_float(wb_model *model, const char *name, float value) {
+    return setParam<float>(model, name, value);
+}
+
+wb_status wb_model_set_string(wb_model *model, const char *name, const char *value) {
+    WB_REQUIRE(value != nullptr, "null value");
+    return setParam<std::string>(model, name, std::string(value));
+}
+
+wb_status wb_model_get_int(const wb_model *model, const char *name, int *value) {
+    ModelParamKey key;
+    wb_status status = findParam<int>(model, name, false, key);
+    if (status == WB_OK) {
+        WB_REQUIRE(value != nullptr, "null output");
+        *value = model->model->getInt(key);
+    }
+    return status;
+}
+
+wb_status wb_model_get_float(const wb_model *model, const char *name, float *value) {
+    ModelParamKey key;
+    wb_status status = findParam<float>(model, name, false, key);
+    if (status == WB_OK) {
+        WB_REQUIRE(value != nullptr, "null output");
+        *value = model->model->getFloat(key);
+    }
+    return status;
+}
+
+wb_status wb_model_get_string(const wb_model *model, const char *name, char *out, size_t capacity, size_t *length) {
+    ModelParamKey key;
+    wb_status status = findParam<std::string>(model, name, false, key);
+    if (status == WB_OK) {
+        WB_REQUIRE(out != nullptr || capacity == 0, "null output");
+        std::string value = model->model->getString(key);
+        if (capacity > 0) {
+            size_t n = std::min(capacity - 1, value.size());
+            std::memcpy(out, value.data(), n);
+            out[n] = '\0';
+        }
+        if (length != nullptr) *length = value.size();
+    }
+    return status;
+}
+
+wb_status wb_model_set_mortality_constants(wb_model *model, float a, float c) {
+    WB_REQUIRE(model != nullptr, "null model");
+    model->model->mortConstA = a;
+    model->model->mortConstC = c;
+    return WB_OK;
+}
+
+wb_status wb_model_save_summary(wb_model *model, const char *path) {
+    WB_REQUIRE(model != nullptr && path != nullptr, "null model or path");
+    return guarded([&]() { model->model->saveSummary(path); return WB_OK; });
+}
+
+wb_status wb_model_save_sample_data(wb_model *model, const char *path) {
+    WB_REQUIRE(model != nullptr && path != nullptr, "null model or path");
+    return guarded([&]() { model->model->saveSampleData(path); return WB_OK; });
+}
+
+wb_status wb_model_save_state(wb_model *model, const char *path) {
+    WB_REQUIRE(model != nullptr && path != nullptr, "null model or path");
+    return guarded([&]() { model->model->saveState(path); return WB_OK; });
+}
+
+wb_status wb_model_load_state(wb_model *model, const char *path) {
+    WB_REQUIRE(model != nullptr && path != nullptr, "null model or path");
+    return guarded([&]() { model->model->loadState(path); return WB_OK; });
+}
@@ -0,0 +1,127 @@
+#ifndef __FISH_WHIDBEY_H
+#define __FISH_WHIDBEY_H
+
+/*
+* C API for embedding the model (libwhidbey).
+*
+* A wb_model is a model whose map, hydrology and recruit inputs have been loaded. It can be run,
+* reset with a new seed and new run-time parameters, and run again without reloading anything, so
+* calibration code in another language can drive many runs in-process.
+*
+* Every function that can fail returns a wb_status; on failure wb_last_error() describes what went
+* wrong. No C++ exception crosses this API. Models share the global random number generator, so
+* step models from one thread at a time; a seeded model also runs its movement on a single thread.
+*/
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WB_API_VERSION 1
+
+typedef struct wb_model wb_model;
+
+typedef enum wb_status {
+    WB_OK = 0,
+    // A null handle or pointer, an unknown parameter name, a value of the wrong type or a parameter
+    // that can't be changed after loading
+    WB_ERROR_INVALID_ARGUMENT = 1,
+    // The model reported an error (e.g. an input file couldn't be read or a value failed validation)
+    WB_ERROR_MODEL = 2
+} wb_status;
+
+// One sampling result (see Sample in model.h)
+typedef struct wb_sample {
+    size_t site_id;
+    long time;
+    size_t population;
+    float mean_mass;
+    float mean_fork_length;
+    float mean_spawn_time;
+} wb_sample;
+
+/*
+* Views of per-fish values, read in place from the model.
+*
+* The value columns hold one entry per fish ever recruited (num_individuals, indexed by fish ID),
+* `stride` bytes apart; `living` lists the IDs of the count living fish. Use WB_FISH_VALUE to read
+* an entry. The pointers stay valid until the model is stepped, reset, destroyed or loads state.
+*/
+typedef struct wb_fish_columns {
+    size_t count;
+    const size_t *living;
+    size_t num_individuals;
+    size_t stride;
+    const long *spawn_time;
+    // mm
+    const float *fork_length;
+    // g
+    const float *mass;
+    // m travelled last timestep
+    const float *travel;
+    const float *last_growth;
+    const float *last_pmax;
+    const float *last_mortality;
+} wb_fish_columns;
+
+// The value of `column` (a wb_fish_columns member) for fish `id`
+#define WB_FISH_VALUE(columns, column, id) \
+    (*(const __typeof__(*(columns).column) *) ((const char *) (columns).column + (size_t) (id) * (columns).stride))
+
+// WB_API_VERSION of the library (may differ from the header's if linked against another build)
+int wb_api_version(void);
+// Message for the last failed call on this thread ("" if none)
+const char *wb_last_error(void);
+
+// Load a model from a JSON config file (as used by headless)
+wb_status wb_model_create(const char *config_path, wb_model **out);
+void wb_model_destroy(wb_model *model);
+
+// Return to timestep 0 with no fish, reseeding the random number generator first (0 = random seed)
+wb_status wb_model_reset(wb_model *model, unsigned int seed);
+// Advance the model by the given number of timesteps
+wb_status wb_model_step(wb_model *model, long steps);
+
+wb_status wb_model_time(const wb_model *model, long *time);
+wb_status wb_model_counts(const wb_model *model, size_t *living, size_t *exited, size_t *dead);
+wb_status wb_model_fish_columns(const wb_model *model, wb_fish_columns *out);
+// Copy the map location ID of each living fish (in wb_fish_columns::living order) into out, which
+// must have room for capacity entries; *written is set to the number copied
+wb_status wb_model_fish_locations(const wb_model *model, int *out, size_t capacity, size_t *written);
+wb_status wb_model_num_samples(const wb_model *model, size_t *count);
+wb_status wb_model_get_sample(const wb_model *model, size_t index, wb_sample *out);
+
+/*
+* Parameters are named as in the config file (see CONFIG_README.md). Only parameters read while the
+* model runs can be set; new values are validated, and take effect immediately (call
+* wb_model_reset to start a fresh run with them).
+*/
+wb_status wb_model_set_int(wb_model *model, const char *name, int value);
+wb_status wb_model_set_float(wb_model *model, const char *name, float value);
+wb_status wb_model_set_string(wb_model *model, const char *name, const char *value);
+wb_status wb_model_get_int(const wb_model *model, const char *name, int *value);
+wb_status wb_model_get_float(const wb_model *model, const char *name, float *value);
+// Copy a string parameter, NUL-terminated and truncated to fit, into out; *length (if not null) is
+// set to the full length without the terminator
+wb_status wb_model_get_string(const wb_model *model, const char *name, char *out, size_t capacity, size_t *length);
+// The mortality constants normally set by ABC
+wb_status wb_model_set_mortality_constants(wb_model *model, float a, float c);
+
+wb_status wb_model_save_summary(wb_model *model, const char *path);
+wb_status wb_model_save_sample_data(wb_model *model, const char *path);
+wb_status wb_model_save_state(wb_model *model, const char *path);
+wb_status wb_model_load_state(wb_model *model, const char *path);
+
+#ifdef __cplusplus
+}
+
+class Model;
+
+// Take ownership of a model that has already been constructed (e.g. from preloaded inputs in C++
+// code), so it can be driven through the C API; wb_model_destroy deletes it
+wb_model *wb_model_adopt(Model *model);
+#endif
+
+#endif
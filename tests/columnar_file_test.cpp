@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "columnar_file.h"
+#include "model.h"
+#include "test_utilities.h"
+
+static std::string tempPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+TEST_CASE("ColumnarWriter columns round-trip through a memory-mapped ColumnarReader", "[columnar_file]") {
+    std::string path = tempPath("whidbey_columnar_test.wbc");
+    std::vector<float> mass{1.5f, 2.25f, 3.0f};
+    std::vector<int> grid(2 * 5);
+    for (size_t i = 0; i < grid.size(); ++i) {
+        grid[i] = (int) i * 10;
+    }
+    const size_t streamedCount = ColumnarWriter::CHUNK_ELEMENTS * 2 + 7;
+    {
+        ColumnarWriter out(path);
+        out.writeColumn<float>("mass", {3}, mass.data());
+        out.writeColumn<int>("grid", {2, 5}, grid.data());
+        // Spans several staging chunks
+        out.writeColumnFrom<int64_t>("streamed", {streamedCount}, [](size_t i) { return (int64_t) i * 3; });
+        out.writeColumnFrom<double>("empty", {0}, [](size_t) { return 0.0; });
+        // Pieces of one column can come from separate appends
+        out.beginColumn<uint32_t>("pieces", {4});
+        uint32_t first[1] = {7U};
+        uint32_t rest[3] = {8U, 9U, 10U};
+        out.append(first, 1);
+        out.append(rest, 3);
+        out.endColumn();
+        out.close();
+    }
+    REQUIRE(ColumnarReader::isColumnarFile(path));
+
+    ColumnarReader in(path);
+    REQUIRE(in.getColumns().size() == 5);
+    for (const ColumnInfo &column : in.getColumns()) {
+        REQUIRE(column.offset % 64 == 0);
+    }
+    const ColumnInfo *gridInfo = in.findColumn("grid");
+    REQUIRE(gridInfo != nullptr);
+    REQUIRE(gridInfo->dtype == "<i4");
+    REQUIRE(gridInfo->shape == std::vector<uint64_t>{2, 5});
+    REQUIRE(gridInfo->byteLength == grid.size() * sizeof(int));
+    REQUIRE(in.findColumn("missing") == nullptr);
+
+    const float *massIn = in.getColumn<float>("mass");
+    REQUIRE(std::vector<float>(massIn, massIn + 3) == mass);
+    const int *gridIn = in.getColumn<int>("grid");
+    REQUIRE(std::vector<int>(gridIn, gridIn + grid.size()) == grid);
+    const int64_t *streamedIn = in.getColumn<int64_t>("streamed");
+    bool streamedMatches = true;
+    for (size_t i = 0; i < streamedCount; ++i) {
+        streamedMatches = streamedMatches && streamedIn[i] == (int64_t) i * 3;
+    }
+    REQUIRE(streamedMatches);
+    REQUIRE(in.findColumn("empty")->byteLength == 0);
+    const uint32_t *piecesIn = in.getColumn<uint32_t>("pieces");
+    REQUIRE(std::vector<uint32_t>(piecesIn, piecesIn + 4) == std::vector<uint32_t>{7U, 8U, 9U, 10U});
+
+    REQUIRE_THROWS_AS(in.getColumn<int>("mass"), std::runtime_error);
+    REQUIRE_THROWS_AS(in.getColumn<float>("missing"), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("ColumnarWriter rejects columns that don't match their shape", "[columnar_file]") {
+    std::string path = tempPath("whidbey_columnar_bad_test.wbc");
+    ColumnarWriter out(path);
+    std::vector<float> values(4, 1.0f);
+    out.beginColumn<float>("short", {5});
+    out.append(values.data(), 4);
+    REQUIRE_THROWS_AS(out.endColumn(), std::runtime_error);
+
+    out.beginColumn<float>("long", {3});
+    REQUIRE_THROWS_AS(out.append(values.data(), 4), std::runtime_error);
+    out.append(values.data(), 3);
+    std::vector<int> ints(1, 0);
+    REQUIRE_THROWS_AS(out.append(ints.data(), 1), std::runtime_error);
+    out.endColumn();
+    out.close();
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(ColumnarReader(path), std::runtime_error);
+}
+
+TEST_CASE("Model writes its summary and sample data as columnar files", "[columnar_file][model]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    // The model owns (and deletes) its map nodes
+    MapNode *a = createMapNode(0.0f, 0.0f, HabitatType::Distributary).release();
+    MapNode *b = createMapNode(1.0f, 0.0f, HabitatType::Distributary).release();
+    a->id = 0;
+    b->id = 1;
+    model.map = {a, b};
+    model.individuals.emplace_back(0, 5L, 40.0f, a);
+    model.individuals.emplace_back(1, 9L, 45.0f, b);
+    model.individuals[1].status = FishStatus::Exited;
+    model.individuals[1].exitTime = 30L;
+    model.monitoringPoints = {b};
+    model.populationHistory = {1, 2, 1};
+    model.monitoringHistory.reset(1);
+    for (int t = 0; t < 3; ++t) {
+        model.monitoringHistory.appendRow({MonitoringRecord((size_t) t, 0.5f * t, 1.0f + t, 10.0f)});
+    }
+    model.sampleHistory.emplace_back(3, 24L, 2, 1.25f, 42.0f, 7.0f);
+    model.sampleHistory.back().sizes.add(42.0f, 1.25f, 2.0f);
+    model.sampleHistory.back().sizes.compress();
+
+    std::string summaryPath = tempPath("whidbey_columnar_summary_test.wbc");
+    std::string samplePath = tempPath("whidbey_columnar_sample_test.wbc");
+    model.saveSummaryColumnar(summaryPath);
+    model.saveSampleDataColumnar(samplePath);
+
+    {
+        ColumnarReader summary(summaryPath);
+        REQUIRE(summary.findColumn("recruitTime")->shape == std::vector<uint64_t>{2});
+        REQUIRE(summary.getColumn<int>("recruitTime")[1] == 9);
+        REQUIRE(summary.getColumn<int>("exitTime")[1] == 30);
+        REQUIRE(summary.getColumn<float>("finalForkLength")[0] == model.individuals[0].forkLength);
+        REQUIRE(summary.getColumn<int>("finalStatus")[1] == (int) FishStatus::Exited);
+        REQUIRE(summary.findColumn("monitoringDepth")->shape == std::vector<uint64_t>{3, 1});
+        REQUIRE(summary.getColumn<float>("monitoringDepth")[2] == 3.0f);
+        REQUIRE(summary.getColumn<int>("monitoringPopulation")[1] == 1);
+        REQUIRE(summary.getColumn<int>("monitoringPointIDs")[0] == 1);
+
+        ColumnarReader samples(samplePath);
+        REQUIRE(samples.getColumn<int>("sampleSiteID")[0] == 3);
+        REQUIRE(samples.getColumn<int>("sampleTime")[0] == 24);
+        REQUIRE(samples.getColumn<float>("sampleMeanLength")[0] == 42.0f);
+        REQUIRE(samples.findColumn("sampleLengthHistogram")->shape == std::vector<uint64_t>{1, SizeSketch::LENGTH_BINS});
+        // 42mm is in the 40-45mm bin
+        REQUIRE(samples.getColumn<float>("sampleLengthHistogram")[2] == 2.0f);
+        REQUIRE(samples.getColumn<float>("lengthBinLow")[2] == 40.0f);
+        REQUIRE(samples.getColumn<float>("sampleMassQuantiles")[3] == 1.25f);
+        REQUIRE(samples.getColumn<float>("sampleLengthDigestWeight")[0] == 2.0f);
+        REQUIRE(samples.getColumn<float>("sampleLengthDigestWeight")[1] == 0.0f);
+    }
+    std::filesystem::remove(summaryPath);
+    std::filesystem::remove(samplePath);
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+#include "test_utilities.h"
+#include "util.h"
+
+// Two connected Distributary locations recruiting on the first day
+struct PairedFixture : RecruitingModel {
+    explicit PairedFixture(float mortMax) : RecruitingModel(pairedMap(), {0, 1}) {
+        model->recCounts[0] = 50;
+        configure(ModelParamKey::CommonRandomNumbers, 1);
+        configure(ModelParamKey::MortMax, mortMax);
+    }
+};
+
+static std::vector<float> keyedDraws(RandPurpose purpose, uint64_t id, uint64_t step, size_t count) {
+    KeyedRandScope keyed(true, purpose, id, step);
+    std::vector<float> draws;
+    for (size_t i = 0; i < count; ++i) {
+        draws.push_back(unit_rand());
+    }
+    return draws;
+}
+
+TEST_CASE("Keyed draws depend only on the seed and key", "[common_random_numbers]") {
+    GlobalRand::reseed(3U);
+    std::vector<float> first = keyedDraws(RandPurpose::Movement, 7, 2, 100);
+    for (float u : first) {
+        REQUIRE(u >= 0.0f);
+        REQUIRE(u < 1.0f);
+    }
+    // Draws from the shared generator and from other keys in between change nothing
+    unit_rand();
+    unit_normal_rand();
+    keyedDraws(RandPurpose::Movement, 8, 2, 10);
+    REQUIRE(keyedDraws(RandPurpose::Movement, 7, 2, 100) == first);
+    REQUIRE(keyedDraws(RandPurpose::Movement, 7, 3, 100) != first);
+    REQUIRE(keyedDraws(RandPurpose::GrowthAndMortality, 7, 2, 100) != first);
+
+    // Nor does the thread
+    std::vector<float> threaded;
+    std::thread t([&threaded]() { threaded = keyedDraws(RandPurpose::Movement, 7, 2, 100); });
+    t.join();
+    REQUIRE(threaded == first);
+
+    // A different seed gives different streams
+    GlobalRand::reseed(4U);
+    REQUIRE(keyedDraws(RandPurpose::Movement, 7, 2, 100) != first);
+
+    // Keyed normal and integer draws are in range
+    KeyedRandScope keyed(true, RandPurpose::Recruit, 1, 0);
+    double sum = 0.0;
+    for (int i = 0; i < 10000; ++i) {
+        sum += unit_normal_rand();
+        int k = GlobalRand::int_rand(0, 23);
+        REQUIRE(k >= 0);
+        REQUIRE(k <= 23);
+    }
+    REQUIRE(sum / 10000.0 < 0.05);
+    REQUIRE(sum / 10000.0 > -0.05);
+}
+
+TEST_CASE("Inert and finished scopes leave the shared generator in charge", "[common_random_numbers]") {
+    GlobalRand::reseed(3U);
+    float expected = unit_rand();
+    GlobalRand::reseed(3U);
+    {
+        KeyedRandScope inert(false, RandPurpose::Movement, 7, 2);
+        REQUIRE(unit_rand() == expected);
+    }
+    GlobalRand::reseed(3U);
+    {
+        KeyedRandScope keyed(true, RandPurpose::Movement, 7, 2);
+        unit_rand();
+    }
+    REQUIRE(unit_rand() == expected);
+    float unused;
+    REQUIRE_FALSE(KeyedRandScope::next(unused));
+}
+
+TEST_CASE("Paired scenarios share each fish's draws", "[common_random_numbers]") {
+    PairedFixture a(0.0f);
+    PairedFixture b(0.5f);
+    GlobalRand::reseed(11U);
+    a.runHours(24);
+    GlobalRand::reseed(11U);
+    // Extra draws from the shared generator don't unpair the runs
+    for (int i = 0; i < 17; ++i) {
+        unit_rand();
+    }
+    b.runHours(24);
+
+    REQUIRE(a.model->individuals.size() == 50);
+    REQUIRE(b.model->individuals.size() == 50);
+    for (size_t id = 0; id < 50; ++id) {
+        const Fish &fa = a.model->individuals[id];
+        const Fish &fb = b.model->individuals[id];
+        REQUIRE(fa.spawnTime == fb.spawnTime);
+        REQUIRE(fa.entryForkLength == fb.entryForkLength);
+        REQUIRE(fa.entryMass == fb.entryMass);
+    }
+    REQUIRE(b.model->deadAbundance > a.model->deadAbundance);
+}
+
+TEST_CASE("commonRandomNumbers must be 0 or 1", "[common_random_numbers]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::CommonRandomNumbers) == 0);
+    config.set(ModelParamKey::CommonRandomNumbers, 2);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,151 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <map>
+#include <memory>
+
+#include "density_propagation.h"
+#include "fish_movement_downstream.h"
+#include "model.h"
+#include "test_utilities.h"
+
+// A branching channel flowing east: A -> B -> C, with a side branch A -> D
+struct BranchingChannelFixture : RecruitingModel {
+    BranchingChannelFixture() : RecruitingModel(branchingChannel(), {}) {
+        hydroModel->uValue = 0.05f;
+        GlobalRand::reseed(5U);
+    }
+
+    static std::vector<MapNode *> branchingChannel() {
+        const float xs[] = {0.0f, 100.0f, 200.0f, 100.0f};
+        const float ys[] = {0.0f, 0.0f, 0.0f, 60.0f};
+        std::vector<MapNode *> map;
+        for (int i = 0; i < 4; ++i) {
+            MapNode *node = new MapNode(HabitatType::Distributary, 1000.0f, 0.0f, 0.0f);
+            node->id = i;
+            node->x = xs[i];
+            node->y = ys[i];
+            map.push_back(node);
+        }
+        connectNodes(map[0], map[1], 100.0f);
+        connectNodes(map[1], map[2], 100.0f);
+        connectNodes(map[0], map[3], 120.0f);
+        return map;
+    }
+};
+
+TEST_CASE("Low-awareness destination distribution matches sampled walks", "[density_propagation]") {
+    BranchingChannelFixture fixture;
+    const float swimSpeed = swimSpeedFromForkLength(50.0f);
+    FishMovementDownstream movement(*fixture.model, swimSpeed, swimSpeed * SECONDS_PER_HOUR);
+    MapNode *origin = fixture.model->map[0];
+
+    std::vector<Destination> destinations = movement.getDestinationDistribution(origin, DENSITY_COST_BINS);
+    double total = 0.0;
+    std::map<int, double> expected;
+    for (const Destination &d : destinations) {
+        REQUIRE(d.probability > 0.0);
+        total += d.probability;
+        expected[d.node->id] += d.probability;
+    }
+    REQUIRE(total == Catch::Approx(1.0));
+    // A stays with 1/3 (stay, B or D); D then stays
+    REQUIRE(expected[0] == Catch::Approx(1.0 / 3.0));
+    REQUIRE(expected.count(2) == 1);
+
+    const int draws = 30000;
+    std::map<int, int> counts;
+    for (int i = 0; i < draws; ++i) {
+        ++counts[movement.determineNextLocation(origin).first->id];
+    }
+    for (const auto &[id, probability] : expected) {
+        REQUIRE((double) counts[id] / draws == Catch::Approx(probability).margin(0.015));
+    }
+}
+
+TEST_CASE("Density propagation multiplies per-origin values through a transition matrix", "[density_propagation]") {
+    BranchingChannelFixture fixture;
+    std::vector<MapNode *> &map = fixture.model->map;
+    TransitionMatrix matrix;
+    matrix.origins = {map[0], map[1]};
+    matrix.rowStart = {0, 2, 3};
+    matrix.destinations = {map[0], map[1], map[2]};
+    matrix.destinationIndices = {0, 1, 2};
+    matrix.probabilities = {0.25, 0.75, 1.0};
+    matrix.costs = {10.0f, 50.0f, 80.0f};
+    REQUIRE(matrix.findRow(map[1]) == 1);
+    REQUIRE(matrix.findRow(map[3]) == 2);
+
+    // Two channels: fish and fish-weighted mass
+    std::vector<double> density = {8.0, 16.0, 2.0, 10.0};
+    std::vector<double> out(map.size() * 3, 0.0);
+    std::vector<size_t> touched;
+    DensityPropagation::propagate(matrix, density, 2, out, touched);
+    REQUIRE(touched == std::vector<size_t>{0, 1, 2});
+    REQUIRE(out[0 * 3 + 0] == Catch::Approx(2.0));
+    REQUIRE(out[1 * 3 + 0] == Catch::Approx(6.0));
+    REQUIRE(out[1 * 3 + 1] == Catch::Approx(12.0));
+    REQUIRE(out[1 * 3 + 2] == Catch::Approx(6.0 * 50.0));
+    REQUIRE(out[2 * 3 + 0] == Catch::Approx(2.0));
+    REQUIRE(out[2 * 3 + 1] == Catch::Approx(10.0));
+    REQUIRE(out[3 * 3 + 0] == 0.0);
+}
+
+TEST_CASE("Density movement engine pools untagged fish per location and size class", "[density_propagation]") {
+    BranchingChannelFixture fixture;
+    Model &model = *fixture.model;
+    ModelConfigMap config = model.getConfigMap();
+    config.set(ModelParamKey::AgentAwareness, std::string("low"));
+    config.set(ModelParamKey::MovementEngine, std::string("density"));
+    model.setConfigMap(config);
+    for (unsigned long id = 0; id < 40; ++id) {
+        model.individuals.emplace_back(id, 0L, id % 2 == 0 ? 42.0f : 51.0f, model.map[0]);
+        model.livingIndividuals.push_back(id);
+    }
+    // Fish 0 is tagged, so it moves alone
+    model.individuals[0].taggedTime = 0L;
+
+    model.moveAll();
+    model.countAll(false);
+    float living = 0.0f;
+    std::map<std::pair<int, size_t>, int> agentsPerCell;
+    size_t merged = 0;
+    for (const Fish &f : model.individuals) {
+        if (f.status == FishStatus::Merged) {
+            ++merged;
+            REQUIRE(f.weight == 0.0f);
+        }
+    }
+    for (size_t id : model.livingIndividuals) {
+        const Fish &f = model.individuals[id];
+        living += f.weight;
+        REQUIRE(f.weight >= 1.0f);
+        if (id != 0) {
+            ++agentsPerCell[{f.location->id, (size_t) (f.forkLength / 5.0f)}];
+        }
+    }
+    REQUIRE(model.individuals[0].weight == 1.0f);
+    REQUIRE(model.individuals[0].status == FishStatus::Alive);
+    for (const auto &[cell, agents] : agentsPerCell) {
+        REQUIRE(agents == 1);
+    }
+    REQUIRE(merged > 0);
+    REQUIRE(model.livingIndividuals.size() + merged == model.individuals.size());
+    // Pools of under one fish are kept or dropped at random, so the total is only close
+    REQUIRE(living == Catch::Approx(40.0f).margin(4.0f));
+    float resident = 0.0f;
+    for (MapNode *node : model.map) {
+        resident += node->residentWeight;
+    }
+    REQUIRE(resident == Catch::Approx(living));
+}
+
+TEST_CASE("Density movement engine needs low agent awareness", "[density_propagation]") {
+    ModelConfigMap config;
+    REQUIRE(config.getString(ModelParamKey::MovementEngine) == "agent");
+    config.set(ModelParamKey::MovementEngine, std::string("density"));
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::AgentAwareness, std::string("low"));
+    REQUIRE_NOTHROW(config.validate());
+    config.set(ModelParamKey::DensitySizeClassWidth, 0.0f);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "distributed.h"
+#include "model.h"
+#include "process_transport.h"
+#include "test_utilities.h"
+#include "util.h"
+
+TEST_CASE("Process transports carry messages between forked processes", "[distributed]") {
+    for (const std::string name : {"socket", "shm"}) {
+        // A small ring buffer, so the large messages wrap around it many times
+        std::unique_ptr<ProcessTransport> transport = name == "shm" ? makeSharedMemoryTransport(3, 64)
+                                                                    : makeProcessTransport(name, 3);
+        auto messageFrom = [](size_t from, size_t to) {
+            std::vector<char> message;
+            MessageWriter writer(message);
+            for (size_t i = 0; i < 1000 * (from + 1); ++i) {
+                writer.put<uint64_t>(from * 100 + to + i);
+            }
+            return message;
+        };
+        auto exchange = [&transport, &messageFrom](size_t rank) {
+            transport->attach(rank);
+            std::vector<std::vector<char>> outgoing(3);
+            for (size_t peer = 0; peer < 3; ++peer) {
+                if (peer != rank) {
+                    outgoing[peer] = messageFrom(rank, peer);
+                }
+            }
+            std::vector<std::vector<char>> incoming = exchangeMessages(*transport, outgoing);
+            for (size_t peer = 0; peer < 3; ++peer) {
+                if (peer != rank && incoming[peer] != messageFrom(peer, rank)) {
+                    return false;
+                }
+            }
+            return incoming[rank].empty();
+        };
+        std::vector<pid_t> children;
+        for (size_t rank = 1; rank < 3; ++rank) {
+            pid_t child = fork();
+            REQUIRE(child >= 0);
+            if (child == 0) {
+                _exit(exchange(rank) ? 0 : 1);
+            }
+            children.push_back(child);
+        }
+        REQUIRE(exchange(0));
+        for (pid_t child : children) {
+            int status = 0;
+            REQUIRE(waitpid(child, &status, 0) == child);
+            REQUIRE(WIFEXITED(status));
+            REQUIRE(WEXITSTATUS(status) == 0);
+        }
+    }
+
+    SECTION("a truncated message is an error") {
+        std::vector<char> message;
+        MessageWriter writer(message);
+        writer.put<int>(7);
+        MessageReader reader(message);
+        REQUIRE(reader.get<int>() == 7);
+        REQUIRE(reader.done());
+        REQUIRE_THROWS_AS(reader.get<int>(), std::runtime_error);
+    }
+}
+
+// A grid of Distributary locations with recruits entering at one corner on the first day, sampled and
+// monitored across the map
+struct DistributedFixture : RecruitingModel {
+    DistributedFixture(int processes, const std::string &transport) : RecruitingModel(gridMap(10), {0, 1}) {
+        model->recCounts[0] = 300;
+        SamplingSite *near = new SamplingSite("near", 0);
+        near->points = {model->map[11], model->map[12]};
+        SamplingSite *far = new SamplingSite("far", 1);
+        far->points = {model->map[45], model->map[99]};
+        model->samplingSites = {near, far};
+        model->samplingCampaigns = {{{}, 6L, 6L, SamplingMethod::BeachSeine}};
+        model->monitoringPoints = {model->map[0], model->map[55], model->map[99]};
+        model->monitoringHistory.reset(model->monitoringPoints.size());
+        configure(ModelParamKey::CommonRandomNumbers, 1);
+        configure(ModelParamKey::Processes, processes);
+        configure(ModelParamKey::ProcessTransport, transport);
+    }
+};
+
+TEST_CASE("Distributed runs match single-process runs", "[distributed]") {
+    DistributedFixture single(1, "socket");
+    GlobalRand::reseed(5U);
+    runDistributed(*single.model, 48);
+    const Model &a = *single.model;
+
+    for (const std::string transport : {"socket", "shm"}) {
+        DistributedFixture distributed(3, transport);
+        GlobalRand::reseed(5U);
+        runDistributed(*distributed.model, 48);
+        const Model &b = *distributed.model;
+
+        REQUIRE(b.time == a.time);
+        REQUIRE(b.individuals.size() == a.individuals.size());
+        REQUIRE(b.livingIndividuals == a.livingIndividuals);
+        REQUIRE(b.populationHistory == a.populationHistory);
+        REQUIRE(b.deadCount == a.deadCount);
+        REQUIRE(b.exitedCount == a.exitedCount);
+        for (size_t id = 0; id < a.individuals.size(); ++id) {
+            REQUIRE(b.individuals[id].status == a.individuals[id].status);
+            REQUIRE(b.individuals[id].location->id == a.individuals[id].location->id);
+            REQUIRE(b.individuals[id].mass == a.individuals[id].mass);
+            REQUIRE(b.individuals[id].forkLength == a.individuals[id].forkLength);
+            REQUIRE(b.individuals[id].exitTime == a.individuals[id].exitTime);
+        }
+        for (size_t i = 0; i < a.map.size(); ++i) {
+            REQUIRE(b.map[i]->residentIds == a.map[i]->residentIds);
+            REQUIRE(b.map[i]->popDensity == a.map[i]->popDensity);
+        }
+        REQUIRE(b.sampleHistory.size() == a.sampleHistory.size());
+        for (size_t i = 0; i < a.sampleHistory.size(); ++i) {
+            REQUIRE(b.sampleHistory[i].population == a.sampleHistory[i].population);
+            REQUIRE(b.sampleHistory[i].meanMass == a.sampleHistory[i].meanMass);
+            REQUIRE(b.sampleHistory[i].meanLength == a.sampleHistory[i].meanLength);
+        }
+        for (size_t t = 0; t < a.monitoringHistory.getNumTimesteps(); ++t) {
+            for (size_t point = 0; point < a.monitoringPoints.size(); ++point) {
+                REQUIRE(b.monitoringHistory.get(t, point).population == a.monitoringHistory.get(t, point).population);
+                REQUIRE(b.monitoringHistory.get(t, point).populationDensity
+                        == a.monitoringHistory.get(t, point).populationDensity);
+            }
+        }
+        REQUIRE(b.monitoringHistory.getNumTimesteps() == a.monitoringHistory.getNumTimesteps());
+    }
+    // Somebody was sampled at the far site, which the recruits' process doesn't own
+    size_t farPopulation = 0;
+    for (const Sample &sample : a.sampleHistory) {
+        if (sample.siteID == 1) {
+            farPopulation += sample.population;
+        }
+    }
+    REQUIRE(farPopulation > 0);
+}
+
+TEST_CASE("More than one process needs the deterministic single-agent mode", "[distributed]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::Processes) == 1);
+    REQUIRE(config.getString(ModelParamKey::ProcessTransport) == "socket");
+    config.set(ModelParamKey::Processes, 0);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::Processes, 4);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::CommonRandomNumbers, 1);
+    config.validate();
+    config.set(ModelParamKey::ProcessTransport, "mpi");
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::ProcessTransport, "shm");
+    config.set(ModelParamKey::DomainRegions, 2);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::DomainRegions, 0);
+    config.set(ModelParamKey::SuperIndividualSize, 10);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    // Only headless forks; the server and the C API step in one process, so they can't take these per run
+    REQUIRE_FALSE(ModelConfigMap::isRunTimeParameter(ModelParamKey::Processes));
+    REQUIRE_FALSE(ModelConfigMap::isRunTimeParameter(ModelParamKey::ProcessTransport));
+}
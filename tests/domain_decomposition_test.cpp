@@ -0,0 +1,159 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "domain_decomposition.h"
+#include "map_partition.h"
+#include "model.h"
+#include "test_utilities.h"
+#include "util.h"
+
+TEST_CASE("partitionMap splits a grid into balanced regions with a short boundary", "[domain_decomposition]") {
+    std::vector<MapNode *> map = gridMap(24);
+    std::vector<double> weights(map.size(), 1.0);
+
+    for (size_t numRegions : {2, 4, 7}) {
+        MapPartition partition = partitionMap(map, weights, numRegions);
+        REQUIRE(partition.numRegions == numRegions);
+        REQUIRE(partition.regions.size() == map.size());
+        const double mean = (double) map.size() / (double) numRegions;
+        double total = 0.0;
+        for (double weight : partition.regionWeights) {
+            REQUIRE(weight > 0.0);
+            REQUIRE(weight <= (1.0 + PARTITION_IMBALANCE) * mean + 1.0);
+            total += weight;
+        }
+        REQUIRE(total == (double) map.size());
+        // Straight cuts across the grid would cut 24 edges each
+        REQUIRE(partition.edgeCut <= 24 * 2 * (numRegions - 1));
+        // Deterministic
+        REQUIRE(partitionMap(map, weights, numRegions).regions == partition.regions);
+    }
+
+    SECTION("weights pull regions towards heavy locations") {
+        std::vector<double> skewed(map.size(), 1.0);
+        for (size_t i = 0; i < 24; ++i) {
+            skewed[i] = 20.0;
+        }
+        MapPartition partition = partitionMap(map, skewed, 4);
+        std::set<uint32_t> firstRowRegions(partition.regions.begin(), partition.regions.begin() + 24);
+        REQUIRE(firstRowRegions.size() >= 2);
+    }
+
+    SECTION("a map with no more locations than regions gets one location per region") {
+        std::vector<MapNode *> small(map.begin(), map.begin() + 3);
+        MapPartition partition = partitionMap(small, {1.0, 2.0, 3.0}, 5);
+        REQUIRE(partition.regions == std::vector<uint32_t>{0, 1, 2});
+        REQUIRE(partition.regionWeights[4] == 0.0);
+    }
+    for (MapNode *node : map) {
+        delete node;
+    }
+}
+
+TEST_CASE("DomainDecomposition hands fish that leave a region to their new region", "[domain_decomposition]") {
+    std::vector<MapNode *> map = gridMap(8);
+    DomainDecomposition domains(map, 4);
+    // Three fish per location, by ID
+    std::vector<MapNode *> locations;
+    std::vector<size_t> living;
+    for (size_t id = 0; id < 3 * map.size(); ++id) {
+        locations.push_back(map[id % map.size()]);
+        living.push_back(id);
+    }
+    auto locationOf = [&locations](size_t id) { return locations[id]; };
+    domains.sync(living, locationOf);
+    domains.markSynced(living.size());
+    REQUIRE(domains.getNumFish() == living.size());
+
+    // Everyone moves one location along, and fish 5 dies
+    for (size_t id = 0; id < locations.size(); ++id) {
+        locations[id] = map[(id + 1) % map.size()];
+    }
+    locations[5] = nullptr;
+    for (size_t region = 0; region < domains.getNumRegions(); ++region) {
+        domains.post(region, locationOf);
+    }
+    domains.forEachRegion(4, [&domains](size_t region) { domains.deliver(region); });
+    REQUIRE(domains.getNumFish() == living.size() - 1);
+    for (size_t region = 0; region < domains.getNumRegions(); ++region) {
+        const std::vector<size_t> &fish = domains.getRegionFish(region);
+        REQUIRE(std::is_sorted(fish.begin(), fish.end()));
+        for (size_t id : fish) {
+            REQUIRE(domains.regionOf(locations[id]) == region);
+        }
+    }
+
+    // New fish are adopted by the region of their location; a mismatch reassigns everyone
+    living.erase(living.begin() + 5);
+    living.push_back(locations.size());
+    locations.push_back(map[0]);
+    domains.sync(living, locationOf);
+    REQUIRE(domains.getNumFish() == living.size());
+    domains.markSynced(0);
+    domains.sync(living, locationOf);
+    REQUIRE(domains.getNumFish() == living.size());
+    for (MapNode *node : map) {
+        delete node;
+    }
+}
+
+// A grid of Distributary locations with recruits entering at one corner on the first day
+struct DomainFixture : RecruitingModel {
+    explicit DomainFixture(int domainRegions) : RecruitingModel(gridMap(10), {0, 1}) {
+        model->recCounts[0] = 300;
+        model->setMaxThreads(4);
+        configure(ModelParamKey::CommonRandomNumbers, 1);
+        configure(ModelParamKey::DomainRegions, domainRegions);
+    }
+};
+
+TEST_CASE("Domain-decomposed runs match runs without regions", "[domain_decomposition]") {
+    DomainFixture plain(0);
+    DomainFixture regions(4);
+    GlobalRand::reseed(5U);
+    while (plain.model->getHour() < 48) {
+        plain.model->masterUpdate();
+    }
+    GlobalRand::reseed(5U);
+    while (regions.model->getHour() < 48) {
+        regions.model->masterUpdate();
+    }
+
+    REQUIRE(regions.model->individuals.size() == plain.model->individuals.size());
+    REQUIRE(regions.model->livingIndividuals == plain.model->livingIndividuals);
+    REQUIRE(regions.model->populationHistory == plain.model->populationHistory);
+    std::set<int> visited;
+    for (size_t id = 0; id < plain.model->individuals.size(); ++id) {
+        const Fish &a = plain.model->individuals[id];
+        const Fish &b = regions.model->individuals[id];
+        REQUIRE(b.status == a.status);
+        REQUIRE(b.location->id == a.location->id);
+        REQUIRE(b.mass == a.mass);
+        REQUIRE(b.forkLength == a.forkLength);
+        visited.insert(b.location->id);
+    }
+    for (size_t i = 0; i < plain.model->map.size(); ++i) {
+        REQUIRE(regions.model->map[i]->residentIds == plain.model->map[i]->residentIds);
+    }
+    // The fish spread beyond the recruit points' region
+    DomainDecomposition domains(regions.model->map, 4);
+    std::set<size_t> regionsVisited;
+    for (int id : visited) {
+        regionsVisited.insert(domains.regionOf(regions.model->map[id]));
+    }
+    REQUIRE(regionsVisited.size() > 1);
+}
+
+TEST_CASE("domainRegions can't be negative or used with the density engine", "[domain_decomposition]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::DomainRegions) == 0);
+    config.set(ModelParamKey::DomainRegions, -1);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::DomainRegions, 4);
+    config.validate();
+    config.set(ModelParamKey::AgentAwareness, "low");
+    config.set(ModelParamKey::MovementEngine, "density");
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,153 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#include "event_scheduler.h"
+#include "load.h"
+#include "model.h"
+#include "test_utilities.h"
+
+// Two connected Distributary locations with a sampling site on each
+struct ScheduleFixture : RecruitingModel {
+    ScheduleFixture() : RecruitingModel(pairedMap(), {0}) {
+        for (int i = 0; i < 2; ++i) {
+            SamplingSite *site = new SamplingSite(i == 0 ? "North" : "South", i);
+            site->points = {model->map[i]};
+            model->samplingSites.push_back(site);
+        }
+        GlobalRand::reseed(5U);
+    }
+};
+
+TEST_CASE("Events come out in hour order and repeat", "[event_scheduler]") {
+    EventScheduler scheduler;
+    REQUIRE(scheduler.getHour() == -1);
+    std::vector<SamplingCampaign> campaigns = {
+        {{}, 12L, 48L, SamplingMethod::BeachSeine},
+        {{1}, 0L, 0L, SamplingMethod::Fyke},
+        {{0}, 30L, 0L, SamplingMethod::BeachSeine},
+    };
+    scheduler.reset(0L, campaigns);
+    REQUIRE(scheduler.nextEventHour() == 0);
+
+    std::vector<ScheduledEvent> due = scheduler.advance(6L);
+    REQUIRE(due.size() == 2);
+    REQUIRE(due[0].type == EventType::PlanRecruitment);
+    REQUIRE(due[1].type == EventType::Sampling);
+    REQUIRE(due[1].campaign == 1);
+    REQUIRE(scheduler.getHour() == 6);
+    REQUIRE(scheduler.advance(12L).empty());
+
+    due = scheduler.advance(72L);
+    std::vector<long> hours;
+    for (const ScheduledEvent &event : due) {
+        hours.push_back(event.hour);
+    }
+    REQUIRE(hours == std::vector<long>{12, 24, 30, 48, 60});
+    REQUIRE(scheduler.nextEventHour() == 72);
+
+    // Starting part-way through, repeating campaigns pick up at their next occurrence and one-off ones
+    // already past are dropped
+    scheduler.reset(50L, campaigns);
+    due = scheduler.advance(200L);
+    hours.clear();
+    for (const ScheduledEvent &event : due) {
+        if (event.type == EventType::Sampling) {
+            hours.push_back(event.hour);
+        }
+    }
+    REQUIRE(hours == std::vector<long>{60, 108, 156});
+}
+
+TEST_CASE("The default schedule samples every site at noon every 14th day", "[event_scheduler]") {
+    ScheduleFixture fixture;
+    fixture.runHours(30 * 24);
+    REQUIRE(fixture.model->sampleHistory.size() == 6);
+    for (size_t i = 0; i < 6; ++i) {
+        const Sample &s = fixture.model->sampleHistory[i];
+        REQUIRE(s.siteID == i % 2);
+        REQUIRE(s.time == (long) (i / 2) * 14 * 24 + 12);
+    }
+    // Nothing was ever alive, so every step skipped the fish phases
+    REQUIRE(fixture.model->populationHistory.size() == 30 * 24);
+    REQUIRE(fixture.model->lastStepTimings.move == 0.0);
+}
+
+TEST_CASE("Campaigns sample their own sites, fyke campaigns at high tide", "[event_scheduler]") {
+    ScheduleFixture fixture;
+    Model &model = *fixture.model;
+    model.samplingCampaigns = {
+        {{1}, 24L + 6L, 0L, SamplingMethod::BeachSeine},
+        // High tide on day 2 comes at hour 57; on day 3 there's none
+        {{0}, 48L, 24L, SamplingMethod::Fyke},
+    };
+    fixture.hydroModel->highTideHours = {40L, 57L, 100L};
+    fixture.runHours(4 * 24);
+    REQUIRE(model.sampleHistory.size() == 2);
+    REQUIRE(model.sampleHistory[0].siteID == 1);
+    REQUIRE(model.sampleHistory[0].time == 30);
+    REQUIRE(model.sampleHistory[1].siteID == 0);
+    REQUIRE(model.sampleHistory[1].time == 57);
+
+    // reset rebuilds the calendar
+    model.reset();
+    fixture.runHours(4 * 24);
+    REQUIRE(model.sampleHistory.size() == 2);
+}
+
+TEST_CASE("Empty steps are skipped until the first recruits", "[event_scheduler]") {
+    ScheduleFixture fixture;
+    Model &model = *fixture.model;
+    model.recCounts[1] = 24;
+    fixture.runHours(24);
+    REQUIRE(model.individuals.empty());
+    REQUIRE(model.lastStepTimings.move == 0.0);
+    fixture.runHours(48);
+    REQUIRE(model.individuals.size() == 24);
+    REQUIRE(model.populationHistory.size() == 48);
+    REQUIRE(model.populationHistory[23] == 0);
+    REQUIRE(model.populationHistory[47] > 0);
+    size_t residents = model.map[0]->residentIds.size() + model.map[1]->residentIds.size();
+    REQUIRE(residents == model.livingIndividuals.size());
+}
+
+TEST_CASE("Sampling schedules load from CSV", "[event_scheduler]") {
+    SamplingSite north("North", 0);
+    SamplingSite south("South", 1);
+    std::vector<SamplingSite *> sites = {&north, &south};
+    std::string path = (std::filesystem::temp_directory_path() / "event_scheduler_test_schedule.csv").string();
+    {
+        std::ofstream f(path);
+        f << "site,day,hour,method,repeatDays\r\n"
+          << "all,0,12,beach seine,14\r\n"
+          << "South,3,0,fyke\r\n";
+    }
+    std::vector<SamplingCampaign> campaigns;
+    loadSamplingSchedule(path, sites, campaigns);
+    REQUIRE(campaigns.size() == 2);
+    REQUIRE(campaigns[0].siteIds.empty());
+    REQUIRE(campaigns[0].firstHour == 12);
+    REQUIRE(campaigns[0].repeatHours == 14 * 24);
+    REQUIRE(campaigns[0].method == SamplingMethod::BeachSeine);
+    REQUIRE(campaigns[1].siteIds == std::vector<size_t>{1});
+    REQUIRE(campaigns[1].firstHour == 72);
+    REQUIRE(campaigns[1].repeatHours == 0);
+    REQUIRE(campaigns[1].method == SamplingMethod::Fyke);
+
+    {
+        std::ofstream f(path);
+        f << "site,day,hour,method,repeatDays\n"
+          << "East,0,12,beach seine,14\n";
+    }
+    campaigns.clear();
+    REQUIRE_THROWS_AS(loadSamplingSchedule(path, sites, campaigns), std::runtime_error);
+    {
+        std::ofstream f(path);
+        f << "site,day,hour,method,repeatDays\n"
+          << "North,0,24,beach seine,14\n";
+    }
+    REQUIRE_THROWS_AS(loadSamplingSchedule(path, sites, campaigns), std::runtime_error);
+    std::remove(path.c_str());
+}
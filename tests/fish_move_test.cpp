@@ -173,7 +173,7 @@ TEST_CASE("Fish::move terminates when remaining time is exhausted", "[fish][move
 
     // Compute swimRange exactly as Fish::move does, but locally for the test.
     float swimSpeed = swimSpeedFromForkLength(forkLength);
-    float swimRange = swimSpeed * SECONDS_PER_TIMESTEP;
+    float swimRange = swimSpeed * SECONDS_PER_HOUR;
 
     // Connect A -> B with an edge whose cost will be equal to swimRange
     // when transitSpeed == swimSpeed.
@@ -467,7 +467,7 @@ TEST_CASE("FishMovement getReachableNeighbors respects agentAwareness", "[fish_m
     // Create a fish at node B with sufficient swim range
     Fish fish(1, 0, 100.0f, nodeB);
     float swimSpeed = swimSpeedFromForkLength(fish.forkLength);
-    float swimRange = swimSpeed * SECONDS_PER_TIMESTEP;
+    float swimRange = swimSpeed * SECONDS_PER_HOUR;
     auto fitnessCalc = [](Model &, MapNode &, float) { return 1.0f; };
 
     SECTION("agentAwareness set to medium") {
@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_renderer.h"
+#include "map_colors.h"
+#include "png_writer.h"
+#include "test_utilities.h"
+
+static unsigned long readUint32(const std::vector<unsigned char> &data, size_t pos) {
+    return ((unsigned long) data[pos] << 24) | ((unsigned long) data[pos + 1] << 16)
+        | ((unsigned long) data[pos + 2] << 8) | (unsigned long) data[pos + 3];
+}
+
+TEST_CASE("encodePng writes a valid PNG with stored deflate blocks", "[png_writer]") {
+    // Large enough that the image data spans several stored blocks
+    const int w = 200;
+    const int h = 150;
+    std::vector<unsigned char> rgb((size_t) w * h * 3);
+    for (size_t i = 0; i < rgb.size(); ++i) {
+        rgb[i] = (unsigned char) (i * 7 % 251);
+    }
+    std::vector<unsigned char> png = encodePng(w, h, rgb);
+    const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    REQUIRE(std::memcmp(png.data(), signature, 8) == 0);
+
+    // Walk the chunks, checking each CRC and collecting the IDAT payload
+    std::vector<std::string> chunkTypes;
+    std::vector<unsigned char> idat;
+    size_t pos = 8;
+    while (pos < png.size()) {
+        unsigned long length = readUint32(png, pos);
+        std::string type(png.begin() + pos + 4, png.begin() + pos + 8);
+        chunkTypes.push_back(type);
+        REQUIRE(readUint32(png, pos + 8 + length) == pngCrc32(png.data() + pos + 4, length + 4));
+        if (type == "IHDR") {
+            REQUIRE(readUint32(png, pos + 8) == (unsigned long) w);
+            REQUIRE(readUint32(png, pos + 12) == (unsigned long) h);
+        } else if (type == "IDAT") {
+            idat.insert(idat.end(), png.begin() + pos + 8, png.begin() + pos + 8 + length);
+        }
+        pos += 12 + length;
+    }
+    REQUIRE(pos == png.size());
+    REQUIRE(chunkTypes == std::vector<std::string>{"IHDR", "IDAT", "IEND"});
+
+    // Unpack the stored blocks and compare with the filtered scanlines
+    std::vector<unsigned char> raw;
+    size_t z = 2;
+    bool last = false;
+    int blocks = 0;
+    while (!last) {
+        last = (idat[z] & 1) != 0;
+        REQUIRE((idat[z] & 6) == 0);
+        size_t len = idat[z + 1] | (idat[z + 2] << 8);
+        size_t nlen = idat[z + 3] | (idat[z + 4] << 8);
+        REQUIRE(len == (~nlen & 0xFFFF));
+        raw.insert(raw.end(), idat.begin() + z + 5, idat.begin() + z + 5 + len);
+        z += 5 + len;
+        ++blocks;
+    }
+    REQUIRE(blocks > 1);
+    REQUIRE(raw.size() == (size_t) h * (w * 3 + 1));
+    for (int y = 0; y < h; ++y) {
+        REQUIRE(raw[(size_t) y * (w * 3 + 1)] == 0);
+        REQUIRE(std::memcmp(&raw[(size_t) y * (w * 3 + 1) + 1], &rgb[(size_t) y * w * 3], w * 3) == 0);
+    }
+    unsigned long a = 1UL, b = 0UL;
+    for (unsigned char c : raw) {
+        a = (a + c) % 65521UL;
+        b = (b + a) % 65521UL;
+    }
+    REQUIRE(readUint32(idat, z) == ((b << 16) | a));
+}
+
+TEST_CASE("encodePng rejects a buffer of the wrong size", "[png_writer]") {
+    std::vector<unsigned char> rgb(10);
+    REQUIRE_THROWS_AS(encodePng(4, 4, rgb), std::runtime_error);
+}
+
+TEST_CASE("FrameRenderer draws map edges in habitat colours and marks occupied locations", "[frame_renderer]") {
+    auto a = createMapNode(0.0f, 0.0f, HabitatType::Distributary);
+    auto b = createMapNode(50.0f, 0.0f, HabitatType::Distributary);
+    auto c = createMapNode(100.0f, 0.0f, HabitatType::BlindChannel);
+    a->id = 0;
+    b->id = 1;
+    c->id = 2;
+    connectNodes(a.get(), b.get(), 50.0f);
+    connectNodes(c.get(), b.get(), 50.0f);
+    std::vector<MapNode *> map{a.get(), b.get(), c.get()};
+    std::vector<SamplingSite *> sites;
+
+    const int w = 101;
+    const int h = 41;
+    FrameRenderer renderer(map, sites, w, h, FrameViewport{0.0f, -20.0f, 100.0f, 20.0f});
+    auto pixel = [&](const std::vector<unsigned char> &rgb, int x, int y) {
+        size_t i = ((size_t) y * w + x) * 3;
+        return RgbColor{rgb[i], rgb[i + 1], rgb[i + 2]};
+    };
+    auto same = [](RgbColor p, RgbColor q) { return p.r == q.r && p.g == q.g && p.b == q.b; };
+
+    RenderSnapshot snapshot;
+    snapshot.occupancy = {0U, 0U, 0U};
+    std::vector<unsigned char> rgb;
+    renderer.render(snapshot, rgb);
+    REQUIRE(rgb.size() == (size_t) w * h * 3);
+    int lineY = renderer.toPixelY(0.0f);
+    REQUIRE(same(pixel(rgb, renderer.toPixelX(25.0f), lineY), DISTRIBUTARY_RGB));
+    REQUIRE(same(pixel(rgb, renderer.toPixelX(75.0f), lineY), BLIND_CHANNEL_RGB));
+    REQUIRE(same(pixel(rgb, 50, 0), RgbColor{255U, 255U, 255U}));
+
+    SECTION("Occupied locations get a marker; the map layer is unchanged between frames") {
+        snapshot.occupancy[1] = 4U;
+        std::vector<unsigned char> occupied;
+        renderer.render(snapshot, occupied);
+        RgbColor marker = pixel(occupied, renderer.toPixelX(50.0f), lineY);
+        REQUIRE_FALSE(same(marker, DISTRIBUTARY_RGB));
+        REQUIRE_FALSE(same(marker, RgbColor{255U, 255U, 255U}));
+
+        snapshot.occupancy[1] = 0U;
+        std::vector<unsigned char> cleared;
+        renderer.render(snapshot, cleared);
+        REQUIRE(cleared == rgb);
+    }
+}
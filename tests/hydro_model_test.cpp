@@ -1,6 +1,9 @@
 #include <complex>
+#include <cmath>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 #include "hydro.h"
+#include "hydro_stream.h"
 #include "catch2/matchers/catch_matchers.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 
@@ -117,3 +120,76 @@ TEST_CASE("HydroModel::calculateFlowSpeedScalar tests", "[hydro]") {
         REQUIRE_THAT(scalar, Catch::Matchers::WithinRel(1.0, 0.0001));
     }
 }
+
+TEST_CASE("Multi-hour steps aggregate hydrology over the step's hours", "[hydro]") {
+    MapNode node(HabitatType::BlindChannel, 25.0f, 0.0f, 0.0f);
+    node.nearestHydroNodeID = 0;
+    std::vector<MapNode *> map = {&node};
+    std::vector<std::vector<float> > depths = {{1.0f, 0.5f, 2.0f, -0.1f, 3.0f, 3.0f}};
+    std::vector<std::vector<float> > temps = {{9.0f, 10.0f, 14.0f, 20.0f, 20.0f, 20.0f}};
+    HydroModel hydro_model(map, depths, temps, 1.0f);
+    hydro_model.hydroNodes.emplace_back(0);
+    hydro_model.hydroNodes[0].us = {1.0f, 2.0f, 6.0f, 0.0f, 0.0f, 0.0f};
+    hydro_model.hydroNodes[0].vs = {0.0f, -3.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+    hydro_model.hydroNodes[0].wses = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    hydro_model.hydroNodes[0].temps = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+    hydro_model.updateTime(0, 3);
+    REQUIRE_THAT(hydro_model.getCurrentU(node), Catch::Matchers::WithinRel(3.0f, 0.0001f));
+    REQUIRE_THAT(hydro_model.getCurrentV(node), Catch::Matchers::WithinRel(-1.0f, 0.0001f));
+    // Shallowest depth, mean temperature
+    REQUIRE(hydro_model.getDepth(node) == 0.5f);
+    REQUIRE_THAT(hydro_model.getTemp(node), Catch::Matchers::WithinRel(11.0f, 0.0001f));
+
+    hydro_model.updateTime(3, 3);
+    REQUIRE(hydro_model.getDepth(node) == -0.1f);
+    REQUIRE_THAT(hydro_model.getCurrentU(node), Catch::Matchers::WithinAbs(0.0f, 0.0001f));
+
+    // One-hour steps read the hour itself
+    hydro_model.updateTime(2);
+    REQUIRE(hydro_model.getCurrentU(node) == 6.0f);
+    REQUIRE(hydro_model.getDepth(node) == 2.0f);
+    REQUIRE(hydro_model.getTemp(node) == 14.0f);
+}
+
+TEST_CASE("Multi-hour steps read each location's own hydro node after skipped ones", "[hydro]") {
+    // File nodes 0, 2 and 3, as loaded when node 1 couldn't be used: positions no longer match ids
+    std::vector<DistribHydroNode> hydroNodes;
+    for (unsigned id : {0U, 2U, 3U}) {
+        hydroNodes.emplace_back(id);
+        const float k = (float) (id + 1);
+        hydroNodes.back().us = std::vector<float>(6, 0.5f * k);
+        hydroNodes.back().vs = std::vector<float>(6, -0.25f * k);
+        hydroNodes.back().wses = std::vector<float>(6, 10.0f * k);
+        hydroNodes.back().temps = std::vector<float>(6, 8.0f + k);
+    }
+    HydroModel hydro_model(std::vector<float>(6, 0.0f), std::vector<float>(6, 0.0f), std::vector<float>(6, 10.0f),
+                           std::move(hydroNodes), 0);
+    hydro_model.updateTime(0, 3);
+    for (unsigned position = 0; position < 3; ++position) {
+        MapNode node(HabitatType::Distributary, 1000.0f, 0.0f, 0.0f);
+        node.nearestHydroNodeID = position;
+        const float k = (float) (hydro_model.hydroNodes[position].id + 1);
+        REQUIRE_THAT(hydro_model.getCurrentU(node), Catch::Matchers::WithinRel(0.5f * k, 0.0001f));
+        REQUIRE_THAT(hydro_model.getCurrentV(node), Catch::Matchers::WithinRel(-0.25f * k, 0.0001f));
+        REQUIRE(hydro_model.getDepth(node) == 10.0f * k);
+        REQUIRE_THAT(hydro_model.getTemp(node), Catch::Matchers::WithinRel(8.0f + k, 0.0001f));
+    }
+    // The fastest node is file node 3, at position 2
+    REQUIRE_THAT(hydro_model.getMaxFlowSpeed(), Catch::Matchers::WithinRel(std::sqrt(2.0f * 2.0f + 1.0f), 0.0001f));
+}
+
+TEST_CASE("A multi-hour step is at high tide if any of its hours is", "[hydro]") {
+    std::vector<float> tide = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f};
+    HydroModel hydro_model(tide, std::vector<float>(9, 0.0f), std::vector<float>(9, 10.0f), {}, 0);
+    hydro_model.updateTime(3);
+    REQUIRE_FALSE(hydro_model.isHighTide());
+    hydro_model.updateTime(4);
+    REQUIRE(hydro_model.isHighTide());
+    hydro_model.updateTime(3, 3);
+    REQUIRE(hydro_model.isHighTide());
+    hydro_model.updateTime(0, 3);
+    REQUIRE_FALSE(hydro_model.isHighTide());
+    hydro_model.updateTime(6, 3);
+    REQUIRE_FALSE(hydro_model.isHighTide());
+}
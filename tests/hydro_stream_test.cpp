@@ -0,0 +1,173 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "hydro.h"
+#include "hydro_stream.h"
+#include "load.h"
+#include "model_config_map.h"
+
+static constexpr size_t NODES = 3;
+static constexpr size_t HOURS = 50;
+
+// Distinct values for each node, hour and variable (var 0-3: u, v, wse, temp)
+static float hydroValue(size_t node, size_t hour, size_t var) {
+    return (float) (var * 1000 + node * 100) + (float) ((hour * 7 + node * 3) % 11) * 0.5f;
+}
+
+static std::string writeTestStream(const std::string &name) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    HydroStreamWriter writer(path, {1.0f, 2.0f, 3.0f}, {10.0f, 20.0f, 30.0f});
+    float values[4][NODES];
+    for (size_t t = 0; t < HOURS; ++t) {
+        for (size_t var = 0; var < 4; ++var) {
+            for (size_t i = 0; i < NODES; ++i) {
+                values[var][i] = hydroValue(i, t, var);
+            }
+        }
+        writer.addHour(values[0], values[1], values[2], values[3]);
+    }
+    writer.finish();
+    return path;
+}
+
+// Room for three blocks of 8 hours
+static constexpr size_t BUDGET = 3 * 8 * 4 * NODES * sizeof(float);
+
+TEST_CASE("HydroStream reads every hour through a sliding window of blocks", "[hydro_stream]") {
+    const std::string path = writeTestStream("whidbey_hydro_stream_test.bin");
+    HydroStream stream(path, BUDGET);
+    REQUIRE(stream.getNumNodes() == NODES);
+    REQUIRE(stream.getNumHours() == HOURS);
+    REQUIRE(stream.getBlockHours() == 8);
+    REQUIRE(stream.getXs()[2] == 3.0f);
+    REQUIRE(stream.getYs()[1] == 20.0f);
+    for (size_t i = 0; i < NODES; ++i) {
+        float minWse = hydroValue(i, 0, 2);
+        for (size_t t = 0; t < HOURS; ++t) {
+            minWse = std::min(minWse, hydroValue(i, t, 2));
+        }
+        REQUIRE(stream.getMinWses()[i] == minWse);
+    }
+
+    SECTION("hour by hour and in steps crossing block boundaries") {
+        for (size_t stepHours : {1, 3, 6}) {
+            for (size_t first = 0; first < HOURS; first += stepHours) {
+                stream.seek(first, stepHours);
+                for (size_t t = first; t < std::min(first + stepHours, HOURS); ++t) {
+                    const float *slab = stream.hour(t);
+                    for (size_t var = 0; var < 4; ++var) {
+                        for (size_t i = 0; i < NODES; ++i) {
+                            REQUIRE(slab[var * NODES + i] == hydroValue(i, t, var));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("seeking backwards reloads evicted blocks") {
+        stream.seek(45, 1);
+        stream.seek(2, 6);
+        REQUIRE(stream.hour(7)[NODES + 1] == hydroValue(1, 7, 1));
+    }
+
+    SECTION("seeking past the end of the data throws") {
+        REQUIRE_THROWS_AS(stream.seek(HOURS, 1), std::runtime_error);
+    }
+
+    SECTION("a budget without room for three blocks of the longest step is rejected") {
+        REQUIRE_THROWS_AS(HydroStream(path, 3 * 5 * 4 * NODES * sizeof(float)), std::runtime_error);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("HydroStream rejects damaged files", "[hydro_stream]") {
+    const std::string path = writeTestStream("whidbey_hydro_stream_damaged_test.bin");
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    REQUIRE_THROWS_AS(HydroStream(path, BUDGET), std::runtime_error);
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(HydroStream(path, BUDGET), std::runtime_error);
+}
+
+TEST_CASE("Streamed hydrology matches hydrology held in memory", "[hydro_stream]") {
+    const std::string path = (std::filesystem::temp_directory_path() / "whidbey_hydro_stream_model_test.bin").string();
+    const std::vector<float> tables(HOURS, 1.0f);
+    std::vector<DistribHydroNode> fullNodes, streamNodes;
+    for (size_t i = 0; i < NODES; ++i) {
+        fullNodes.emplace_back(i);
+        fullNodes[i].x = 1.0f + (float) i;
+        fullNodes[i].y = 10.0f + 10.0f * (float) i;
+        streamNodes.push_back(fullNodes[i]);
+        for (size_t t = 0; t < HOURS; ++t) {
+            fullNodes[i].us.push_back(hydroValue(i, t, 0));
+            fullNodes[i].vs.push_back(hydroValue(i, t, 1));
+            fullNodes[i].wses.push_back(hydroValue(i, t, 2));
+            // Within the limits getTemp clamps to
+            fullNodes[i].temps.push_back(hydroValue(i, t, 3) / 200.0f);
+        }
+    }
+    {
+        HydroStreamWriter writer(path, {1.0f, 2.0f, 3.0f}, {10.0f, 20.0f, 30.0f});
+        for (size_t t = 0; t < HOURS; ++t) {
+            float values[4][NODES];
+            for (size_t i = 0; i < NODES; ++i) {
+                values[0][i] = fullNodes[i].us[t];
+                values[1][i] = fullNodes[i].vs[t];
+                values[2][i] = fullNodes[i].wses[t];
+                values[3][i] = fullNodes[i].temps[t];
+            }
+            writer.addHour(values[0], values[1], values[2], values[3]);
+        }
+        writer.finish();
+    }
+    HydroModel inMemory(tables, tables, tables, fullNodes, 2);
+    HydroModel streamed(tables, tables, tables, streamNodes, 2, std::make_unique<HydroStream>(path, BUDGET));
+
+    std::vector<MapNode> locations;
+    for (size_t i = 0; i < NODES; ++i) {
+        locations.emplace_back(HabitatType::Distributary, 100.0f, 2000.0f + (float) i, 0.0f);
+        locations.back().nearestHydroNodeID = i;
+    }
+    for (int stepHours : {1, 3}) {
+        for (long time = 0; time + 2 < (long) HOURS; time += stepHours) {
+            inMemory.updateTime(time, stepHours);
+            streamed.updateTime(time, stepHours);
+            for (MapNode &location : locations) {
+                REQUIRE(streamed.getCurrentU(location) == inMemory.getCurrentU(location));
+                REQUIRE(streamed.getCurrentV(location) == inMemory.getCurrentV(location));
+                REQUIRE(streamed.getDepth(location) == inMemory.getDepth(location));
+                REQUIRE(streamed.getTemp(location) == inMemory.getTemp(location));
+            }
+        }
+    }
+
+    SECTION("elevations are fixed the same way from the lowest water surface elevations") {
+        std::vector<MapNode *> fullMap, streamMap;
+        for (size_t i = 0; i < NODES; ++i) {
+            for (std::vector<MapNode *> *map : {&fullMap, &streamMap}) {
+                map->push_back(new MapNode(HabitatType::Distributary, 100.0f, 2001.0f, 0.0f));
+                map->back()->x = 1.0f + (float) i;
+                map->back()->y = 10.0f + 10.0f * (float) i;
+            }
+        }
+        assignMapHydro(fullMap, fullNodes);
+        assignMapHydro(streamMap, streamNodes, HydroStream(path, BUDGET).getMinWses());
+        for (size_t i = 0; i < NODES; ++i) {
+            REQUIRE(streamMap[i]->nearestHydroNodeID == fullMap[i]->nearestHydroNodeID);
+            REQUIRE(streamMap[i]->elev == fullMap[i]->elev);
+            delete fullMap[i];
+            delete streamMap[i];
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("hydroMemoryBudgetMB can't be negative", "[hydro_stream]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::HydroMemoryBudgetMB) == 0);
+    config.set(ModelParamKey::HydroMemoryBudgetMB, -1);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
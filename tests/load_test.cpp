@@ -3,9 +3,14 @@
 //
 
 #include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
 #include <memory>
 #include "load.h"
 #include "map.h"
+#include "model_config_map.h"
 
 // Helper function to create a MapNode for testing
 auto createTestNode(int id = 0, HabitatType type = HabitatType::Distributary) {
@@ -118,4 +123,62 @@ TEST_CASE("checkAndAddEdge functionality", "[edges]") {
         REQUIRE(target->edgesIn[0].source == source.get());
         REQUIRE(target->edgesIn[0].target == target.get());
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("parseMap leaves linking to the hydrology to assignMapHydro", "[load]") {
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string locationPath = (dir / "load_test_locations.csv").string();
+    std::string edgePath = (dir / "load_test_edges.csv").string();
+    std::string geometryPath = (dir / "load_test_geometry.csv").string();
+    {
+        // Three distributary locations in a row, 100m apart; columns as in the real map files
+        std::ofstream locations(locationPath);
+        locations << "id,c1,c2,c3,c4,area,habitat,sourceDistance,c8,c9,elev,edge,monitoring,c13,c14,c15,site,c17\n";
+        for (int id = 1; id <= 3; ++id) {
+            locations << id << ",,,,,1000,distributary channel," << id * 100 << ",,,0.5,0,0,,,,,0\n";
+        }
+        std::ofstream edges(edgePath);
+        edges << "c0,name,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,source,target,c16,c17,length\n";
+        edges << ",a,,,,,,,,,,,,,1,2,,,100\n";
+        edges << ",b,,,,,,,,,,,,,2,3,,,100\n";
+        std::ofstream geometry(geometryPath);
+        geometry << "x,y,id\n0,0,1\n100,0,2\n200,0,3\n";
+    }
+    std::vector<MapNode *> map, recPoints, monitoringPoints;
+    std::vector<SamplingSite *> samplingSites;
+    std::vector<unsigned> recPointIds = {1};
+    MapCoarsening coarsening;
+    ModelConfigMap config;
+    parseMap(map, locationPath, edgePath, geometryPath, recPointIds, recPoints, monitoringPoints, samplingSites,
+             0.0f, config, coarsening);
+    REQUIRE(map.size() == 3);
+    REQUIRE(recPoints.size() == 1);
+    for (MapNode *node : map) {
+        REQUIRE(node->nearestHydroNodeID == std::numeric_limits<unsigned>::max());
+    }
+
+    std::vector<DistribHydroNode> hydroNodes = {DistribHydroNode(0), DistribHydroNode(1)};
+    hydroNodes[0].x = 0.0f;
+    hydroNodes[1].x = 200.0f;
+    for (DistribHydroNode &hydroNode : hydroNodes) {
+        hydroNode.y = 0.0f;
+        hydroNode.wses = {1.0f, 2.0f};
+    }
+    assignMapHydro(map, hydroNodes);
+    for (MapNode *node : map) {
+        if (node->id == 1) {
+            REQUIRE(node->nearestHydroNodeID == 0);
+        } else if (node->id == 3) {
+            REQUIRE(node->nearestHydroNodeID == 1);
+        }
+        // The lowest water is 1m over 0.5m, so there's no elevation correction
+        REQUIRE(node->elev == 0.5f);
+    }
+
+    for (MapNode *node : map) {
+        delete node;
+    }
+    std::remove(locationPath.c_str());
+    std::remove(edgePath.c_str());
+    std::remove(geometryPath.c_str());
+}
@@ -0,0 +1,149 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "map_arena.h"
+#include "map_gen.h"
+#include "model.h"
+#include "test_utilities.h"
+#include "util.h"
+
+// Each location's position in map, with -1 for locations outside it
+static std::vector<std::vector<int>> edgePositions(const std::vector<MapNode *> &map) {
+    std::unordered_map<const MapNode *, int> positions;
+    for (size_t i = 0; i < map.size(); ++i) {
+        positions[map[i]] = (int) i;
+    }
+    auto position = [&positions](const MapNode *node) {
+        return positions.count(node) ? positions.at(node) : -1;
+    };
+    std::vector<std::vector<int>> out;
+    for (const MapNode *node : map) {
+        out.emplace_back();
+        for (const Edge &edge : node->edgesIn) {
+            out.back().insert(out.back().end(), {position(edge.source), position(edge.target), (int) edge.length});
+        }
+        for (const Edge &edge : node->edgesOut) {
+            out.back().insert(out.back().end(), {position(edge.source), position(edge.target), (int) edge.length});
+        }
+    }
+    return out;
+}
+
+TEST_CASE("Compacting a map keeps its graph in two blocks", "[map_arena]") {
+    MapArena arena;
+    std::vector<MapNode *> map;
+    for (int i = 0; i < 5; ++i) {
+        map.push_back(new MapNode(HabitatType::Distributary, 100.0f * (float) (i + 1), 0.5f, 0.0f,
+                                  arena.buildMemory()));
+        map.back()->id = i;
+        map.back()->x = 10.0f * (float) i;
+    }
+    for (int i = 0; i + 1 < 5; ++i) {
+        connectNodes(map[i], map[i + 1], 10.0f + (float) i);
+    }
+    connectNodes(map[4], map[0], 40.0f);
+    map[2]->crossChannelA = &map[1]->edgesOut[0];
+    map[2]->crossChannelB = &map[2]->edgesIn[0];
+    map[3]->residentIds = {7L, 9L};
+    std::vector<MapNode *> recPoints = {map[0]};
+    std::vector<MapNode *> sitePoints = {map[4], map[2]};
+    const std::vector<std::vector<int>> before = edgePositions(map);
+
+    SECTION("a location outside the map is an error, and the map is left as it was") {
+        MapNode outside(HabitatType::Nearshore, 1.0f, 0.0f, 0.0f);
+        std::vector<MapNode *> stray = {&outside};
+        std::vector<MapNode *> original = map;
+        REQUIRE_THROWS_AS(arena.compact(map, {&recPoints, &stray}), std::runtime_error);
+        REQUIRE(map == original);
+        REQUIRE_FALSE(arena.owns(map[0]));
+        for (MapNode *node : map) {
+            delete node;
+        }
+    }
+
+    SECTION("everything is re-pointed at the moved locations") {
+        arena.compact(map, {&recPoints, &sitePoints});
+        REQUIRE(arena.size() == 5);
+        for (size_t i = 0; i < map.size(); ++i) {
+            REQUIRE(arena.owns(map[i]));
+            REQUIRE(map[i] == map[0] + i);
+            REQUIRE(map[i]->id == (int) i);
+            REQUIRE(map[i]->area == 100.0f * (float) (i + 1));
+            REQUIRE(map[i]->x == 10.0f * (float) i);
+        }
+        REQUIRE(edgePositions(map) == before);
+        REQUIRE(map[2]->crossChannelA == &map[1]->edgesOut[0]);
+        REQUIRE(map[2]->crossChannelB == &map[2]->edgesIn[0]);
+        REQUIRE(map[0]->crossChannelA == nullptr);
+        REQUIRE(map[3]->residentIds == std::vector<long>{7L, 9L});
+        REQUIRE(recPoints == std::vector<MapNode *>{map[0]});
+        REQUIRE(sitePoints == std::vector<MapNode *>{map[4], map[2]});
+        // Every edge list sits in one block, one after another
+        REQUIRE(map[1]->edgesIn.data() + map[1]->edgesIn.size() == map[1]->edgesOut.data());
+        REQUIRE(map[1]->edgesOut.data() + map[1]->edgesOut.size() == map[2]->edgesIn.data());
+        REQUIRE_FALSE(arena.owns(recPoints[0] + 5));
+
+        REQUIRE_THROWS_AS(arena.buildMemory(), std::runtime_error);
+        REQUIRE_THROWS_AS(arena.compact(map, {}), std::runtime_error);
+        // Compacted locations can still gain edges
+        connectNodes(map[0], map[2], 20.0f);
+        REQUIRE(map[2]->edgesIn.back().source == map[0]);
+    }
+}
+
+TEST_CASE("A generated map runs the same from an arena", "[map_arena]") {
+    std::vector<MapNode *> plainMap, plainRecPoints;
+    GlobalRand::reseed(3U);
+    generateMap(plainMap, plainRecPoints, 4, 13, 10.0f, 0.2f, 0.3f);
+
+    std::unique_ptr<MapArena> arena = std::make_unique<MapArena>();
+    std::vector<MapNode *> map, recPoints;
+    GlobalRand::reseed(3U);
+    generateMap(map, recPoints, 4, 13, 10.0f, 0.2f, 0.3f, arena->buildMemory());
+    const std::vector<std::vector<int>> built = edgePositions(map);
+    REQUIRE(built == edgePositions(plainMap));
+    arena->compact(map, {&recPoints});
+    REQUIRE(edgePositions(map) == built);
+    REQUIRE(recPoints.size() == plainRecPoints.size());
+    for (size_t i = 0; i < recPoints.size(); ++i) {
+        REQUIRE(recPoints[i] - map[0] == (long) (std::find(plainMap.begin(), plainMap.end(), plainRecPoints[i])
+                                                 - plainMap.begin()));
+    }
+
+    // Run both maps; the model frees the heap map's locations and the arena's block
+    auto run = [](std::vector<MapNode *> &locations, std::vector<MapNode *> &recruitPoints,
+                  std::unique_ptr<MapArena> locationArena) {
+        MockHydroModel hydroModel;
+        Model model(&hydroModel);
+        model.mapArena = std::move(locationArena);
+        model.map = locations;
+        for (size_t i = 0; i < model.map.size(); ++i) {
+            model.map[i]->id = (int) i;
+            // The mock hydrology has no hydro nodes for blind channel flow to be scaled from
+            if (model.map[i]->type == HabitatType::BlindChannel) {
+                model.map[i]->type = HabitatType::Distributary;
+            }
+        }
+        model.recCounts.assign(60, 0);
+        model.recCounts[0] = 100;
+        model.recSizeDists.assign(10, {1.0f, 1.0f, 1.0f});
+        model.recPoints = recruitPoints;
+        model.recDayPlan.resize(24, 0UL);
+        GlobalRand::reseed(4U);
+        while (model.getHour() < 30) {
+            model.masterUpdate();
+        }
+        std::vector<int> locationIds;
+        for (const Fish &fish : model.individuals) {
+            locationIds.push_back(fish.location->id);
+        }
+        return locationIds;
+    };
+    std::vector<int> plainLocations = run(plainMap, plainRecPoints, nullptr);
+    REQUIRE(run(map, recPoints, std::move(arena)) == plainLocations);
+    REQUIRE_FALSE(plainLocations.empty());
+}
@@ -0,0 +1,199 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include "map_cache.h"
+#include "map_coarsen.h"
+#include "model_config_map.h"
+#include "test_utilities.h"
+
+// A chain of six Distributary locations 0 - 1 - ... - 5, 100m apart, plus a blind channel off location 3
+struct ChainMapFixture {
+    std::vector<MapNode *> map;
+
+    ChainMapFixture() {
+        for (int i = 0; i < 7; ++i) {
+            MapNode *node = new MapNode(i < 6 ? HabitatType::Distributary : HabitatType::BlindChannel,
+                                        1000.0f * (float) (i + 1), 1.0f, 100.0f * (float) i);
+            node->id = 10 + i;
+            node->x = 100.0f * (float) (i < 6 ? i : 3);
+            node->y = i < 6 ? 0.0f : 50.0f;
+            map.push_back(node);
+        }
+        for (int i = 0; i < 5; ++i) {
+            connectNodes(map[i], map[i + 1], 100.0f + (float) i);
+        }
+        connectNodes(map[3], map[6], 50.0f);
+    }
+
+    ~ChainMapFixture() {
+        for (MapNode *node : map) {
+            delete node;
+        }
+    }
+};
+
+static void requireConsistentEdges(const std::vector<MapNode *> &map) {
+    for (MapNode *node : map) {
+        for (const Edge &e : node->edgesOut) {
+            REQUIRE(e.source == node);
+            REQUIRE(std::find(map.begin(), map.end(), e.target) != map.end());
+            size_t matches = 0;
+            for (const Edge &in : e.target->edgesIn) {
+                matches += in.source == node && in.length == e.length;
+            }
+            REQUIRE(matches == 1);
+        }
+    }
+}
+
+TEST_CASE("Coarsening merges similar neighbors down to the target count", "[map_coarsen]") {
+    ChainMapFixture fixture;
+    std::vector<MapNode *> &map = fixture.map;
+    MapNode *recruitPoint = map[0];
+    MapNode *blindChannel = map[6];
+    CoarsenCriteria criteria = {4, 1.0f, 1000.0f};
+
+    MapCoarsening coarsening = coarsenMap(map, {recruitPoint}, criteria);
+    REQUIRE(map.size() == 4);
+    REQUIRE(map[0] == recruitPoint);
+    REQUIRE(recruitPoint->area == 1000.0f);
+    // The blind channel has no blind channel neighbors
+    REQUIRE(std::find(map.begin(), map.end(), blindChannel) != map.end());
+    float area = 0.0f;
+    for (MapNode *node : map) {
+        area += node->area;
+    }
+    REQUIRE(area == Catch::Approx(28000.0f));
+    requireConsistentEdges(map);
+
+    REQUIRE(coarsening.fineIds.size() == 7);
+    REQUIRE(coarsening.coarseIds.size() == 7);
+    std::map<int, int> groupSizes;
+    for (size_t i = 0; i < coarsening.fineIds.size(); ++i) {
+        ++groupSizes[coarsening.coarseIds[i]];
+        // Merged locations keep the ID of their first member
+        REQUIRE(coarsening.coarseIds[i] <= coarsening.fineIds[i]);
+    }
+    REQUIRE(groupSizes.size() == 4);
+    REQUIRE(groupSizes[10] == 1);
+    REQUIRE(groupSizes[16] == 1);
+    for (MapNode *node : map) {
+        REQUIRE(groupSizes.count(node->id) == 1);
+    }
+}
+
+TEST_CASE("Coarsening respects elevation and pathDist limits", "[map_coarsen]") {
+    ChainMapFixture fixture;
+    std::vector<MapNode *> &map = fixture.map;
+    map[2]->elev = 5.0f;
+    CoarsenCriteria criteria = {1, 1.0f, 150.0f};
+
+    MapCoarsening coarsening = coarsenMap(map, {}, criteria);
+    // 0-1 and 3-4-5 can merge; 2 is too high and 6 is another habitat type
+    REQUIRE(map.size() == 4);
+    std::map<int, int> coarseIdOf;
+    for (size_t i = 0; i < coarsening.fineIds.size(); ++i) {
+        coarseIdOf[coarsening.fineIds[i]] = coarsening.coarseIds[i];
+    }
+    REQUIRE(coarseIdOf[11] == 10);
+    REQUIRE(coarseIdOf[12] == 12);
+    REQUIRE(coarseIdOf[14] == 13);
+    REQUIRE(coarseIdOf[15] == 13);
+    REQUIRE(coarseIdOf[16] == 16);
+    // Area-weighted location, elevation and pathDist
+    REQUIRE(map[0]->x == Catch::Approx(100.0f * 2.0f / 3.0f));
+    REQUIRE(map[0]->pathDist == Catch::Approx(100.0f * 2.0f / 3.0f));
+    REQUIRE(map[0]->elev == Catch::Approx(1.0f));
+    requireConsistentEdges(map);
+}
+
+TEST_CASE("Coarse outputs project back onto the full map", "[map_coarsen]") {
+    MapCoarsening coarsening;
+    coarsening.fineIds = {1, 2, 3};
+    coarsening.coarseIds = {1, 1, 3};
+    coarsening.fineAreas = {100.0f, 300.0f, 50.0f};
+    std::map<int, double> fish = {{1, 8.0}, {3, 2.0}};
+    std::vector<double> projected = coarsening.projectAmount([&fish](int id) { return fish[id]; });
+    REQUIRE(projected == std::vector<double>{2.0, 6.0, 2.0});
+    std::vector<double> densities = coarsening.projectValue([&fish](int id) { return fish[id] / 10.0; });
+    REQUIRE(densities[1] == Catch::Approx(0.8));
+    REQUIRE(densities[2] == Catch::Approx(0.2));
+}
+
+TEST_CASE("Map cache round-trips a prepared map", "[map_coarsen]") {
+    ChainMapFixture fixture;
+    std::vector<MapNode *> &map = fixture.map;
+    map[4]->nearestHydroNodeID = 7;
+    map[4]->hydroNodeDistance = 12.5f;
+    std::vector<MapNode *> recPoints = {map[0]};
+    std::vector<MapNode *> monitoringPoints = {map[5], map[3]};
+    SamplingSite site("Site A", 0);
+    site.points = {map[6], map[3]};
+    std::vector<SamplingSite *> samplingSites = {&site};
+    MapCoarsening coarsening = coarsenMap(map, {map[0], map[3], map[5], map[6]}, {6, 1.0f, 1000.0f});
+    REQUIRE(map.size() == 6);
+    std::string path = (std::filesystem::temp_directory_path() / "map_coarsen_test_cache.bin").string();
+    writeMapCache(path, map, recPoints, monitoringPoints, samplingSites, coarsening);
+
+    std::vector<MapNode *> loaded, loadedRecPoints, loadedMonitoringPoints;
+    std::vector<SamplingSite *> loadedSites;
+    MapCoarsening loadedCoarsening;
+    REQUIRE(readMapCache(path, loaded, loadedRecPoints, loadedMonitoringPoints, loadedSites, loadedCoarsening));
+    REQUIRE(loaded.size() == map.size());
+    for (size_t i = 0; i < map.size(); ++i) {
+        REQUIRE(loaded[i]->id == map[i]->id);
+        REQUIRE(loaded[i]->type == map[i]->type);
+        REQUIRE(loaded[i]->x == map[i]->x);
+        REQUIRE(loaded[i]->area == map[i]->area);
+        REQUIRE(loaded[i]->pathDist == map[i]->pathDist);
+        REQUIRE(loaded[i]->nearestHydroNodeID == map[i]->nearestHydroNodeID);
+        REQUIRE(loaded[i]->hydroNodeDistance == map[i]->hydroNodeDistance);
+        REQUIRE(loaded[i]->edgesOut.size() == map[i]->edgesOut.size());
+        REQUIRE(loaded[i]->edgesIn.size() == map[i]->edgesIn.size());
+        for (size_t k = 0; k < map[i]->edgesOut.size(); ++k) {
+            REQUIRE(loaded[i]->edgesOut[k].target->id == map[i]->edgesOut[k].target->id);
+            REQUIRE(loaded[i]->edgesOut[k].length == map[i]->edgesOut[k].length);
+        }
+    }
+    requireConsistentEdges(loaded);
+    REQUIRE(loadedRecPoints.size() == 1);
+    REQUIRE(loadedRecPoints[0]->id == 10);
+    REQUIRE(loadedMonitoringPoints.size() == 2);
+    REQUIRE(loadedMonitoringPoints[1]->id == 13);
+    REQUIRE(loadedSites.size() == 1);
+    REQUIRE(loadedSites[0]->siteName == "Site A");
+    REQUIRE(loadedSites[0]->points.size() == 2);
+    REQUIRE(loadedSites[0]->points[0]->id == 16);
+    REQUIRE(loadedCoarsening.coarseIds == coarsening.coarseIds);
+    REQUIRE(loadedCoarsening.fineAreas == coarsening.fineAreas);
+    for (MapNode *node : loaded) {
+        delete node;
+    }
+    delete loadedSites[0];
+
+    // A truncated file is rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 16);
+    loaded.clear();
+    loadedRecPoints.clear();
+    loadedMonitoringPoints.clear();
+    loadedSites.clear();
+    REQUIRE_FALSE(readMapCache(path, loaded, loadedRecPoints, loadedMonitoringPoints, loadedSites, loadedCoarsening));
+    REQUIRE(loaded.empty());
+    REQUIRE(loadedCoarsening.empty());
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Map coarsening parameters are validated", "[map_coarsen]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::MapCoarsenTargetNodes) == 0);
+    REQUIRE(config.getString(ModelParamKey::MapCacheDir).empty());
+    config.set(ModelParamKey::MapCoarsenTargetNodes, -1);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::MapCoarsenTargetNodes, 5000);
+    config.set(ModelParamKey::MapCoarsenMaxPathDistDifference, -1.0f);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+
+#include "monitoring_history.h"
+#include "test_utilities.h"
+
+TEST_CASE("MonitoringHistory records one time-major row per timestep", "[monitoring_history]") {
+    MockHydroModel hydroModel;
+    std::vector<std::unique_ptr<MapNode>> nodes;
+    std::vector<MapNode *> points;
+    for (int i = 0; i < 3; ++i) {
+        nodes.push_back(createMapNode((float) i, 0.0f));
+        nodes.back()->residentIds.assign(i, 0L);
+        nodes.back()->residentWeight = (float) i;
+        nodes.back()->popDensity = 0.25f * i;
+        points.push_back(nodes.back().get());
+    }
+
+    MonitoringHistory history;
+    history.reset(points.size());
+    history.reserve(10);
+    hydroModel.depthValue = 2.0f;
+    hydroModel.tempValue = 11.0f;
+    history.record(points, hydroModel, 1);
+    nodes[0]->residentIds.push_back(7L);
+    nodes[0]->residentWeight += 1.0f;
+    hydroModel.depthValue = 3.0f;
+    history.record(points, hydroModel, 1);
+
+    REQUIRE(history.getNumPoints() == 3);
+    REQUIRE(history.getNumTimesteps() == 2);
+    REQUIRE(history.get(0, 0).population == 0);
+    REQUIRE(history.get(1, 0).population == 1);
+    REQUIRE(history.get(0, 2).population == 2);
+    REQUIRE(history.get(1, 2).populationDensity == 0.5f);
+    REQUIRE(history.get(0, 1).depth == 2.0f);
+    REQUIRE(history.get(1, 1).depth == 3.0f);
+    REQUIRE(history.get(1, 1).temp == 11.0f);
+
+    SECTION("Rows can be appended directly and are visited in timestep order") {
+        history.appendRow({MonitoringRecord(5, 1.0f, 4.0f, 12.0f), MonitoringRecord(6, 1.5f, 4.0f, 12.0f),
+                           MonitoringRecord(7, 2.0f, 4.0f, 12.0f)});
+        REQUIRE_THROWS_AS(history.appendRow({MonitoringRecord(1, 0.0f, 0.0f, 0.0f)}), std::runtime_error);
+        size_t visited = 0;
+        std::vector<int> populations;
+        history.forEachBlock([&](size_t t0, size_t count, const int *p, const float *, const float *z, const float *) {
+            REQUIRE(t0 == visited);
+            populations.insert(populations.end(), p, p + count * 3);
+            REQUIRE(z[0] == 2.0f);
+            visited += count;
+        });
+        REQUIRE(visited == 3);
+        REQUIRE(populations == std::vector<int>{0, 1, 2, 1, 1, 2, 5, 6, 7});
+    }
+
+    SECTION("Reset drops every row") {
+        history.reset(2);
+        REQUIRE(history.getNumPoints() == 2);
+        REQUIRE(history.getNumTimesteps() == 0);
+        REQUIRE_FALSE(history.isStreaming());
+    }
+}
+
+TEST_CASE("MonitoringHistory fills large rows in parallel", "[monitoring_history]") {
+    MockHydroModel hydroModel;
+    const size_t P = 3 * 4096 + 17;
+    std::vector<std::unique_ptr<MapNode>> nodes;
+    std::vector<MapNode *> points;
+    for (size_t i = 0; i < P; ++i) {
+        nodes.push_back(createMapNode(0.0f, 0.0f));
+        nodes.back()->residentIds.assign(i % 5, 0L);
+        nodes.back()->residentWeight = (float) (i % 5);
+        nodes.back()->popDensity = (float) i;
+        points.push_back(nodes.back().get());
+    }
+
+    MonitoringHistory history;
+    history.reset(P);
+    history.record(points, hydroModel, 4);
+    history.record(points, hydroModel, 1);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < P; ++i) {
+        MonitoringRecord parallel = history.get(0, i);
+        MonitoringRecord serial = history.get(1, i);
+        if (parallel.population != i % 5 || parallel.populationDensity != (float) i
+            || serial.population != parallel.population || serial.populationDensity != parallel.populationDensity) {
+            ++mismatches;
+        }
+    }
+    REQUIRE(mismatches == 0);
+}
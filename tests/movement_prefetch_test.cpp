@@ -0,0 +1,107 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+
+#include "hydro_stream.h"
+#include "model.h"
+#include "movement_prefetch.h"
+#include "test_utilities.h"
+#include "util.h"
+
+// A side x side grid of Distributary locations sharing a few hydro nodes with varying flow, with fish scattered
+// over it
+struct PrefetchFixture {
+    std::unique_ptr<HydroModel> hydroModel;
+    std::unique_ptr<Model> model;
+
+    PrefetchFixture(int side, size_t numFish, int prefetchDistance, int hoursPerTimestep) {
+        std::vector<DistribHydroNode> hydroNodes;
+        for (unsigned i = 0; i < 7; ++i) {
+            hydroNodes.emplace_back(i);
+            for (int hour = 0; hour < 96; ++hour) {
+                hydroNodes.back().us.push_back(0.05f * (float) ((i + hour) % 5));
+                hydroNodes.back().vs.push_back(-0.03f * (float) ((i * 3 + hour) % 4));
+                hydroNodes.back().wses.push_back(1.0f + 0.1f * (float) i);
+                hydroNodes.back().temps.push_back(10.0f + 0.2f * (float) hour);
+            }
+        }
+        hydroModel = std::make_unique<HydroModel>(std::vector<float>(96, 0.0f), std::vector<float>(96, 0.0f),
+                                                  std::vector<float>(96, 10.0f), std::move(hydroNodes), 0);
+        model = std::make_unique<Model>(hydroModel.get());
+        for (int i = 0; i < side * side; ++i) {
+            MapNode *node = new MapNode(HabitatType::Distributary, 1000.0f, 0.0f, 0.0f);
+            node->id = i;
+            node->x = 10.0f * (float) (i % side);
+            node->y = 10.0f * (float) (i / side);
+            node->nearestHydroNodeID = (unsigned) (i % 7);
+            model->map.push_back(node);
+        }
+        for (int i = 0; i < side * side; ++i) {
+            if (i % side + 1 < side) {
+                connectNodes(model->map[i], model->map[i + 1], 10.0f);
+            }
+            if (i + side < side * side) {
+                connectNodes(model->map[i + side], model->map[i], 10.0f);
+            }
+        }
+        model->recCounts.assign(60, 0);
+        model->recSizeDists.assign(10, {1.0f, 1.0f, 1.0f});
+        model->recPoints = {model->map[0]};
+        model->recDayPlan.resize(24, 0UL);
+        model->setMaxThreads(1);
+        ModelConfigMap config = model->getConfigMap();
+        config.set(ModelParamKey::MovementPrefetchDistance, prefetchDistance);
+        config.set(ModelParamKey::HoursPerTimestep, hoursPerTimestep);
+        model->setConfigMap(config);
+        GlobalRand::reseed(11U);
+        for (size_t id = 0; id < numFish; ++id) {
+            MapNode *location = model->map[(size_t) GlobalRand::int_rand(0, side * side - 1)];
+            model->individuals.emplace_back(id, 0L, 45.0f + 30.0f * unit_rand(), location);
+            model->livingIndividuals.push_back(id);
+        }
+    }
+};
+
+TEST_CASE("Prefetching doesn't change movement", "[movement_prefetch]") {
+    for (int hoursPerTimestep : {1, 3}) {
+        PrefetchFixture plain(12, 600, 0, hoursPerTimestep);
+        PrefetchFixture prefetched(12, 600, 3, hoursPerTimestep);
+        // Without commonRandomNumbers, so the fish must also draw in the same order
+        GlobalRand::reseed(21U);
+        for (int step = 0; step < 6; ++step) {
+            plain.model->masterUpdate();
+        }
+        GlobalRand::reseed(21U);
+        for (int step = 0; step < 6; ++step) {
+            prefetched.model->masterUpdate();
+        }
+        REQUIRE(prefetched.model->livingIndividuals == plain.model->livingIndividuals);
+        REQUIRE_FALSE(plain.model->livingIndividuals.empty());
+        for (size_t id = 0; id < plain.model->individuals.size(); ++id) {
+            REQUIRE(prefetched.model->individuals[id].location->id == plain.model->individuals[id].location->id);
+            REQUIRE(prefetched.model->individuals[id].travel == plain.model->individuals[id].travel);
+        }
+    }
+}
+
+TEST_CASE("The prefetch pipeline stays within its batch", "[movement_prefetch]") {
+    PrefetchFixture fixture(4, 10, 0, 1);
+    const std::vector<size_t> &living = fixture.model->livingIndividuals;
+    // Exactly as long as the batch, so reading past its end trips the address sanitizer
+    const std::vector<size_t> batch(living.begin() + 3, living.begin() + 7);
+    // Batches shorter than the pipeline, and a distance longer than the batch
+    for (size_t distance : {1, 2, 50}) {
+        MovementPrefetch prefetch(*fixture.model, batch.begin(), batch.end(), distance);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            prefetch.advance(i);
+        }
+    }
+    // A fish without a location has nothing to fetch
+    fixture.model->individuals[5].location = nullptr;
+    MovementPrefetch(*fixture.model, living.begin(), living.end(), 1).advance(0);
+
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::MovementPrefetchDistance) == 8);
+    config.set(ModelParamKey::MovementPrefetchDistance, -1);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,136 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "numa.h"
+#include "test_utilities.h"
+#include "util.h"
+
+TEST_CASE("parseCpuList reads kernel CPU lists", "[numa]") {
+    REQUIRE(parseCpuList("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+    REQUIRE(parseCpuList("5") == std::vector<int>{5});
+    REQUIRE(parseCpuList("").empty());
+    REQUIRE_THROWS_AS(parseCpuList("0-"), std::runtime_error);
+    REQUIRE_THROWS_AS(parseCpuList("3-1"), std::runtime_error);
+    REQUIRE_THROWS_AS(parseCpuList("a"), std::runtime_error);
+}
+
+// A sysfs node directory with two nodes of four CPUs and a memory-only node
+static std::filesystem::path fakeNodeDir() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "whidbey_numa_test";
+    std::filesystem::remove_all(dir);
+    for (const auto &[name, cpus] : std::vector<std::pair<std::string, std::string>>{
+             {"node0", "0-3"}, {"node1", ""}, {"node2", "4-7"}}) {
+        std::filesystem::create_directories(dir / name);
+        std::ofstream(dir / name / "cpulist") << cpus << std::endl;
+    }
+    std::ofstream(dir / "has_cpu") << "0,2" << std::endl;
+    return dir;
+}
+
+TEST_CASE("NUMA topology and worker placement", "[numa]") {
+    std::filesystem::path dir = fakeNodeDir();
+    NumaTopology topology = readNumaTopology(dir.string());
+    std::filesystem::remove_all(dir);
+    REQUIRE(topology.nodeIds == std::vector<int>{0, 2});
+    REQUIRE(topology.numCpus() == 8);
+    REQUIRE(topology.describe() == "2 NUMA nodes: 0 (CPUs 0-3), 2 (CPUs 4-7)");
+    REQUIRE(readNumaTopology((dir / "missing").string()).numNodes() == 0);
+
+    SECTION("spread shares consecutive workers out between the nodes") {
+        NumaPlacement placement(topology, ThreadPinning::Spread);
+        std::vector<size_t> nodes;
+        std::vector<int> cpus;
+        for (size_t worker = 0; worker < 6; ++worker) {
+            nodes.push_back(placement.nodeForWorker(worker, 6));
+            cpus.push_back(placement.cpuForWorker(worker, 6));
+        }
+        REQUIRE(nodes == std::vector<size_t>{0, 0, 0, 1, 1, 1});
+        REQUIRE(cpus == std::vector<int>{0, 1, 2, 4, 5, 6});
+        // More workers than CPUs on a node share them
+        REQUIRE(placement.cpuForWorker(4, 10) == 0);
+    }
+
+    SECTION("compact fills one node first") {
+        NumaPlacement placement(topology, ThreadPinning::Compact);
+        std::vector<size_t> nodes;
+        std::vector<int> cpus;
+        for (size_t worker = 0; worker < 6; ++worker) {
+            nodes.push_back(placement.nodeForWorker(worker, 6));
+            cpus.push_back(placement.cpuForWorker(worker, 6));
+        }
+        REQUIRE(nodes == std::vector<size_t>{0, 0, 0, 0, 1, 1});
+        REQUIRE(cpus == std::vector<int>{0, 1, 2, 3, 4, 5});
+    }
+
+    SECTION("this machine") {
+        NumaTopology machine = detectNumaTopology();
+        REQUIRE(machine.numNodes() >= 1);
+        REQUIRE(machine.numCpus() >= 1);
+        NumaPlacement placement(machine, ThreadPinning::Spread);
+        std::vector<char> buffer(1 << 20, 1);
+        // Advice only, so a refusal isn't an error; the memory must be intact either way
+        placement.moveToNode(buffer.data(), buffer.data() + buffer.size(), 0);
+        placement.interleave(buffer.data(), buffer.data() + buffer.size());
+        REQUIRE(buffer[12345] == 1);
+        REQUIRE_THROWS_AS(NumaPlacement(NumaTopology(), ThreadPinning::Spread), std::runtime_error);
+    }
+}
+
+// A row of Distributary locations with recruits entering at one end on the first day
+static std::unique_ptr<Model> placementModel(MockHydroModel *hydroModel, const std::string &pinning,
+                                             const std::string &placement) {
+    std::unique_ptr<Model> model = std::make_unique<Model>(hydroModel);
+    for (int i = 0; i < 20; ++i) {
+        MapNode *node = new MapNode(HabitatType::Distributary, 1000.0f, 0.0f, 0.0f);
+        node->id = i;
+        node->x = 10.0f * (float) i;
+        model->map.push_back(node);
+        if (i > 0) {
+            connectNodes(model->map[i - 1], node, 10.0f);
+        }
+    }
+    model->recCounts.assign(60, 0);
+    model->recCounts[0] = 200;
+    model->recSizeDists.assign(10, {1.0f, 1.0f, 1.0f});
+    model->recPoints = {model->map[0]};
+    model->recDayPlan.resize(24, 0UL);
+    model->setMaxThreads(4);
+    ModelConfigMap config = model->getConfigMap();
+    config.set(ModelParamKey::CommonRandomNumbers, 1);
+    config.set(ModelParamKey::ThreadPinning, pinning);
+    config.set(ModelParamKey::HydroPlacement, placement);
+    model->setConfigMap(config);
+    return model;
+}
+
+TEST_CASE("Pinned and placed runs match unplaced runs", "[numa]") {
+    MockHydroModel hydroA, hydroB;
+    std::unique_ptr<Model> plain = placementModel(&hydroA, "off", "default");
+    std::unique_ptr<Model> placed = placementModel(&hydroB, "spread", "interleave");
+    GlobalRand::reseed(9U);
+    while (plain->getHour() < 36) {
+        plain->masterUpdate();
+    }
+    GlobalRand::reseed(9U);
+    while (placed->getHour() < 36) {
+        placed->masterUpdate();
+    }
+    REQUIRE(placed->livingIndividuals == plain->livingIndividuals);
+    REQUIRE(placed->populationHistory == plain->populationHistory);
+    for (size_t id = 0; id < plain->individuals.size(); ++id) {
+        REQUIRE(placed->individuals[id].location->id == plain->individuals[id].location->id);
+        REQUIRE(placed->individuals[id].mass == plain->individuals[id].mass);
+    }
+
+    ModelConfigMap config;
+    config.set(ModelParamKey::ThreadPinning, "sockets");
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    config.set(ModelParamKey::ThreadPinning, "compact");
+    config.set(ModelParamKey::HydroPlacement, "replicate");
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <vector>
+
+#include "model_config_map.h"
+#include "output_storage.h"
+
+TEST_CASE("NcStorageOptions parses storage specs", "[output_storage]") {
+    NcStorageOptions storage = NcStorageOptions::parse("deflate:6,shuffle:0,chunk:8x100");
+    REQUIRE_FALSE(storage.contiguous);
+    REQUIRE(storage.deflateLevel == 6);
+    REQUIRE_FALSE(storage.shuffle);
+    REQUIRE(storage.chunkRows == 8);
+    REQUIRE(storage.chunkColumns == 100);
+
+    SECTION("Settings that are left out keep their defaults") {
+        NcStorageOptions partial = NcStorageOptions::parse("deflate:2");
+        REQUIRE(partial.deflateLevel == 2);
+        REQUIRE(partial.shuffle);
+        REQUIRE(partial.chunkRows == 32);
+        REQUIRE(partial.chunkColumns == 720);
+    }
+
+    SECTION("Contiguous storage has no filters") {
+        NcStorageOptions contiguous = NcStorageOptions::parse("contiguous");
+        REQUIRE(contiguous.contiguous);
+        REQUIRE(contiguous.deflateLevel == 0);
+        REQUIRE_FALSE(contiguous.shuffle);
+    }
+
+    SECTION("Malformed specs are rejected") {
+        REQUIRE_THROWS_AS(NcStorageOptions::parse("deflate:12"), std::runtime_error);
+        REQUIRE_THROWS_AS(NcStorageOptions::parse("deflate:"), std::runtime_error);
+        REQUIRE_THROWS_AS(NcStorageOptions::parse("chunk:32"), std::runtime_error);
+        REQUIRE_THROWS_AS(NcStorageOptions::parse("chunk:0x10"), std::runtime_error);
+        REQUIRE_THROWS_AS(NcStorageOptions::parse("level:4"), std::runtime_error);
+    }
+}
+
+TEST_CASE("getChunkSizes fits chunks to the variable's shape", "[output_storage]") {
+    NcStorageOptions storage = NcStorageOptions::parse("chunk:32x720");
+    // Fish x timestep
+    REQUIRE(getChunkSizes({5000, 3984}, storage) == std::vector<size_t>{32, 720});
+    REQUIRE(getChunkSizes({10, 100}, storage) == std::vector<size_t>{10, 100});
+    // 1-D variables get rows*columns elements per chunk
+    REQUIRE(getChunkSizes({100000}, storage) == std::vector<size_t>{32 * 720});
+    REQUIRE(getChunkSizes({50}, storage) == std::vector<size_t>{50});
+    // Scalars, empty variables and contiguous storage aren't chunked
+    REQUIRE(getChunkSizes({}, storage).empty());
+    REQUIRE(getChunkSizes({0, 720}, storage).empty());
+    REQUIRE(getChunkSizes({5000, 3984}, NcStorageOptions::parse("contiguous")).empty());
+}
+
+TEST_CASE("Default output storage settings are valid", "[output_storage]") {
+    ModelConfigMap config;
+    REQUIRE_NOTHROW(config.validate());
+    NcStorageOptions tagged = NcStorageOptions::parse(config.getString(ModelParamKey::TaggedHistoryStorage));
+    REQUIRE(tagged.deflateLevel > 0);
+    REQUIRE(tagged.shuffle);
+}
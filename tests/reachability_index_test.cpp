@@ -0,0 +1,161 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "fish_movement_high_awareness.h"
+#include "map_cache.h"
+#include "model_config_map.h"
+#include "reachability_index.h"
+#include "test_utilities.h"
+
+// A side x side grid with random edge lengths, ids matching positions and a mix of habitat types
+struct GridMapFixture {
+    std::vector<MapNode *> map;
+
+    explicit GridMapFixture(int side) {
+        std::mt19937 rng(17);
+        std::uniform_real_distribution<float> lengths(5.0f, 60.0f);
+        for (int i = 0; i < side * side; ++i) {
+            HabitatType type = i % 7 == 0 || i % 5 == 0 ? HabitatType::Nearshore : HabitatType::Distributary;
+            MapNode *node = new MapNode(type, 100.0f, 1.0f, 0.0f);
+            node->id = i;
+            node->x = 40.0f * (float) (i % side);
+            node->y = 40.0f * (float) (i / side);
+            map.push_back(node);
+        }
+        for (int i = 0; i < side * side; ++i) {
+            if (i % side + 1 < side) {
+                connectNodes(map[i], map[i + 1], lengths(rng));
+            }
+            if (i + side < side * side) {
+                connectNodes(map[i], map[i + side], lengths(rng));
+            }
+            // A few long edges, some of them out of the fish's first hop into a distributary
+            if (i % 11 == 0 && i + 3 * side + 2 < side * side) {
+                connectNodes(map[i + 3 * side + 2], map[i], 400.0f);
+            }
+        }
+    }
+
+    ~GridMapFixture() {
+        for (MapNode *node : map) {
+            delete node;
+        }
+    }
+};
+
+TEST_CASE("ReachabilityIndex holds each location's nearest locations by path length", "[reachability_index]") {
+    std::vector<MapNode *> map;
+    for (int i = 0; i < 5; ++i) {
+        map.push_back(new MapNode(i == 2 ? HabitatType::Distributary : HabitatType::Nearshore, 1.0f, 1.0f, 0.0f));
+        map.back()->id = i;
+    }
+    // 0 - 1 - 2 - 3 - 4, with a long hop from 0 into distributary 2
+    connectNodes(map[0], map[1], 10.0f);
+    connectNodes(map[1], map[2], 20.0f);
+    connectNodes(map[2], map[3], 30.0f);
+    connectNodes(map[3], map[4], 40.0f);
+    connectNodes(map[0], map[2], 500.0f);
+
+    ReachabilityIndex index = ReachabilityIndex::build(map, 3, 2);
+    REQUIRE(index.getNumNodes() == 5);
+    REQUIRE(index.getNeighborhoodSize() == 3);
+
+    // The first hop into a distributary is free, so 2 is nearest to 0 and 3 is next, at 30
+    REQUIRE(index.neighborCount(0) == 3);
+    REQUIRE(index.neighborIds(0)[0] == 0);
+    REQUIRE(index.neighborIds(0)[1] == 2);
+    REQUIRE(index.neighborLengths(0)[1] == 0.0f);
+    REQUIRE(index.neighborIds(0)[2] == 1);
+    REQUIRE(index.covers(0, 29.0));
+    REQUIRE_FALSE(index.covers(0, 30.0));
+
+    // From 4, only the first hop's end could be free, and it isn't a distributary
+    REQUIRE(index.neighborIds(4)[1] == 3);
+    REQUIRE(index.neighborLengths(4)[2] == 70.0f);
+    REQUIRE_FALSE(index.covers(4, 90.0));
+
+    // A neighborhood holding everything reachable covers any path length
+    ReachabilityIndex whole = ReachabilityIndex::build(map, 5, 1);
+    REQUIRE(whole.neighborCount(4) == 5);
+    REQUIRE(whole.covers(4, 1.0e9));
+    REQUIRE(whole.getIds() == ReachabilityIndex::build(map, 5, 4).getIds());
+
+    REQUIRE(ReachabilityIndex::build(map, 0, 1).empty());
+    map[3]->id = 7;
+    REQUIRE(ReachabilityIndex::build(map, 3, 1).empty());
+    for (MapNode *node : map) {
+        delete node;
+    }
+}
+
+TEST_CASE("High-awareness searches through the index match searches over the whole map", "[reachability_index]") {
+    GridMapFixture fixture(16);
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model testModel(hydroModel.get());
+    auto fitnessCalc = [](Model &, MapNode &node, float cost) -> float { return (float) node.id + cost; };
+
+    for (size_t neighborhoodSize : {(size_t) 24, (size_t) 300}) {
+        ReachabilityIndex index = ReachabilityIndex::build(fixture.map, neighborhoodSize, 3);
+        size_t indexedSearches = 0;
+        for (float u : {0.0f, 0.3f}) {
+            hydroModel->uValue = u;
+            hydroModel->vValue = -u / 2.0f;
+            for (float swimRange : {30.0f, 150.0f, 600.0f}) {
+                const float swimSpeed = 0.5f;
+                FishMovementHighAwareness full(testModel, swimSpeed, swimRange, fitnessCalc);
+                FishMovementHighAwareness indexed(testModel, swimSpeed, swimRange, fitnessCalc, &index);
+                const double reach = swimRange * (swimSpeed + hydroModel->getMaxFlowSpeed()) / swimSpeed;
+                for (MapNode *start : fixture.map) {
+                    indexedSearches += index.covers((size_t) start->id, reach);
+                    auto expected = full.getReachableNeighbors(start, 0.0f, start);
+                    auto actual = indexed.getReachableNeighbors(start, 0.0f, start);
+                    REQUIRE(actual == expected);
+                }
+            }
+        }
+        REQUIRE(indexedSearches > 0);
+    }
+}
+
+TEST_CASE("Map cache round-trips the reachability index", "[reachability_index]") {
+    GridMapFixture fixture(6);
+    ReachabilityIndex index = ReachabilityIndex::build(fixture.map, 8, 2);
+    std::vector<MapNode *> recPoints, monitoringPoints;
+    std::vector<SamplingSite *> samplingSites;
+    std::string path = (std::filesystem::temp_directory_path() / "reachability_index_test_cache.bin").string();
+    writeMapCache(path, fixture.map, recPoints, monitoringPoints, samplingSites, MapCoarsening(), index);
+
+    std::vector<MapNode *> loaded;
+    MapCoarsening loadedCoarsening;
+    ReachabilityIndex loadedIndex;
+    REQUIRE(readMapCache(path, loaded, recPoints, monitoringPoints, samplingSites, loadedCoarsening, &loadedIndex));
+    REQUIRE(loadedIndex.getNeighborhoodSize() == 8);
+    REQUIRE(loadedIndex.getOffsets() == index.getOffsets());
+    REQUIRE(loadedIndex.getRadii() == index.getRadii());
+    REQUIRE(loadedIndex.getIds() == index.getIds());
+    REQUIRE(loadedIndex.getLengths() == index.getLengths());
+    for (MapNode *node : loaded) {
+        delete node;
+    }
+    loaded.clear();
+
+    // A map cached without an index reads back with an empty one
+    writeMapCache(path, fixture.map, recPoints, monitoringPoints, samplingSites, MapCoarsening());
+    REQUIRE(readMapCache(path, loaded, recPoints, monitoringPoints, samplingSites, loadedCoarsening, &loadedIndex));
+    REQUIRE(loadedIndex.empty());
+    for (MapNode *node : loaded) {
+        delete node;
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("reachabilityNeighborhoodSize can't be negative", "[reachability_index]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::ReachabilityNeighborhoodSize) == 256);
+    config.set(ModelParamKey::ReachabilityNeighborhoodSize, -1);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,179 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "fish.h"
+#include "model.h"
+#include "render_snapshot.h"
+#include "simulation_runner.h"
+#include "test_utilities.h"
+
+// Model with two connected locations (owned by the model) and enough recruitment state for masterUpdate
+struct SnapshotTestFixture {
+    std::unique_ptr<MockHydroModel> hydroModel;
+    std::unique_ptr<Model> model;
+
+    SnapshotTestFixture() {
+        hydroModel = std::make_unique<MockHydroModel>();
+        model = std::make_unique<Model>(hydroModel.get());
+        for (int i = 0; i < 2; ++i) {
+            MapNode *node = new MapNode(HabitatType::Distributary, 4.0f, 0.0f, 0.0f);
+            node->id = i;
+            node->x = (float) i;
+            node->y = 0.0f;
+            model->map.push_back(node);
+        }
+        connectNodes(model->map[0], model->map[1], 1.0f);
+        model->recCounts.resize(30, 0);
+        model->recDayPlan.resize(24, 0UL);
+    }
+
+    void addFish(unsigned long id, MapNode *location) {
+        model->individuals.emplace_back(id, 0L, 50.0f, location);
+        model->livingIndividuals.push_back(id);
+    }
+};
+
+TEST_CASE("RenderSnapshotSlot hands over only the latest snapshot", "[render_snapshot]") {
+    RenderSnapshotSlot slot;
+    REQUIRE(slot.take() == nullptr);
+
+    auto first = std::make_unique<RenderSnapshot>();
+    first->time = 1;
+    auto second = std::make_unique<RenderSnapshot>();
+    second->time = 2;
+    slot.publish(std::move(first));
+    slot.publish(std::move(second));
+
+    std::unique_ptr<RenderSnapshot> taken = slot.take();
+    REQUIRE(taken != nullptr);
+    REQUIRE(taken->time == 2);
+    REQUIRE(slot.take() == nullptr);
+}
+
+TEST_CASE("RenderSnapshotSlot delivers every snapshot's contents intact across threads", "[render_snapshot]") {
+    RenderSnapshotSlot slot;
+    constexpr long LAST = 2000;
+    std::thread producer([&slot]() {
+        for (long t = 1; t <= LAST; ++t) {
+            auto s = std::make_unique<RenderSnapshot>();
+            s->time = t;
+            s->occupancy.assign(64, (unsigned) t);
+            slot.publish(std::move(s));
+        }
+    });
+    long lastSeen = 0;
+    bool consistent = true;
+    while (lastSeen < LAST) {
+        std::unique_ptr<RenderSnapshot> s = slot.take();
+        if (s == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+        consistent = consistent && s->time > lastSeen;
+        for (unsigned v : s->occupancy) {
+            consistent = consistent && v == (unsigned) s->time;
+        }
+        lastSeen = s->time;
+    }
+    producer.join();
+    REQUIRE(consistent);
+}
+
+TEST_CASE("captureRenderSnapshot copies occupancy and selection details", "[render_snapshot]") {
+    SnapshotTestFixture fixture;
+    Model &model = *fixture.model;
+    fixture.addFish(0UL, model.map[1]);
+    fixture.addFish(1UL, model.map[1]);
+    model.countAll(false);
+
+    SECTION("No selection") {
+        auto snapshot = captureRenderSnapshot(model, -1, -1L);
+        REQUIRE(snapshot->livingCount == 2);
+        REQUIRE(snapshot->occupancy.size() == 2);
+        REQUIRE(snapshot->occupancy[0] == 0U);
+        REQUIRE(snapshot->occupancy[1] == 2U);
+        REQUIRE(snapshot->popDensity[1] == model.map[1]->popDensity);
+        REQUIRE(snapshot->selectedNodeId == -1);
+        REQUIRE(snapshot->selectedFishId == -1L);
+        REQUIRE(snapshot->selectedNodeResidents.empty());
+    }
+
+    SECTION("Selected location lists its residents and environment") {
+        fixture.hydroModel->depthValue = 2.5f;
+        auto snapshot = captureRenderSnapshot(model, 1, -1L);
+        REQUIRE(snapshot->selectedNodeId == 1);
+        REQUIRE(snapshot->selectedNodeResidents == std::vector<long>{0L, 1L});
+        REQUIRE(snapshot->selectedNode.depth == 2.5f);
+    }
+
+    SECTION("Selected fish overrides the selected location with the fish's location") {
+        auto snapshot = captureRenderSnapshot(model, 0, 1L);
+        REQUIRE(snapshot->selectedFishId == 1L);
+        REQUIRE(snapshot->selectedFish.id == 1UL);
+        REQUIRE(snapshot->selectedFish.locationId == 1);
+        REQUIRE(snapshot->selectedNodeId == 1);
+        REQUIRE_FALSE(snapshot->selectedFishRange.empty());
+    }
+
+    SECTION("Snapshot is unaffected by later model changes") {
+        auto snapshot = captureRenderSnapshot(model, -1, -1L);
+        model.livingIndividuals.clear();
+        model.countAll(false);
+        REQUIRE(snapshot->occupancy[1] == 2U);
+        REQUIRE(snapshot->livingCount == 2);
+    }
+}
+
+TEST_CASE("SimulationRunner steps the model on a worker thread", "[render_snapshot][simulation_runner]") {
+    SnapshotTestFixture fixture;
+    Model &model = *fixture.model;
+    std::atomic<int> publishCount{0};
+    SimulationRunner runner(&model, [&publishCount]() { ++publishCount; });
+
+    SECTION("Runs the requested number of steps, publishing a snapshot per step") {
+        REQUIRE(runner.start(5, SimulationRunner::UNTHROTTLED));
+        while (runner.isRunning()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        runner.cancel();
+        REQUIRE(model.time == 5);
+        // One notification per step plus one for the end of the run
+        REQUIRE(publishCount.load() == 6);
+        std::unique_ptr<RenderSnapshot> latest = runner.takeLatest();
+        REQUIRE(latest != nullptr);
+        REQUIRE(latest->time == 5);
+    }
+
+    SECTION("Refuses to start a second concurrent run") {
+        REQUIRE(runner.start(SimulationRunner::RUN_UNTIL_CANCELLED, 1000.0));
+        REQUIRE_FALSE(runner.start(1, SimulationRunner::UNTHROTTLED));
+        runner.cancel();
+    }
+
+    SECTION("Play mode runs until cancelled") {
+        REQUIRE(runner.start(SimulationRunner::RUN_UNTIL_CANCELLED, 200.0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        runner.cancel();
+        REQUIRE_FALSE(runner.isRunning());
+        long stoppedAt = model.time;
+        REQUIRE(stoppedAt > 0);
+        // Throttled to ~200 steps/s, so well under the unthrottled rate
+        REQUIRE(stoppedAt < 200);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(model.time == stoppedAt);
+    }
+
+    SECTION("publishNow captures the current selection while idle") {
+        fixture.addFish(0UL, model.map[0]);
+        model.countAll(false);
+        runner.setSelection(0, -1L);
+        runner.publishNow();
+        std::unique_ptr<RenderSnapshot> latest = runner.takeLatest();
+        REQUIRE(latest != nullptr);
+        REQUIRE(latest->selectedNodeId == 0);
+        REQUIRE(latest->selectedNodeResidents == std::vector<long>{0L});
+    }
+}
@@ -0,0 +1,208 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#include "fish.h"
+#include "model.h"
+#include "replay_store.h"
+#include "test_utilities.h"
+
+// Three tagged fish over 6 timesteps on a 3-location map:
+//   fish 0: tagged at 0, active 0-3, then died (exitTime 4)
+//   fish 1: tagged at 2, active 2-5, still in the model at the end
+//   fish 2: tagged at 1, active 1-2, then exited (exitTime 3)
+static TaggedHistoryData makeHistories() {
+    TaggedHistoryData data;
+    data.numFish = 3;
+    data.numTimesteps = 6;
+    const size_t T = data.numTimesteps;
+    ReplayFishInfo base{0, 0, -1, 40.0f, 1.0f, 50.0f, 2.0f, (int32_t) FishStatus::Alive, 0};
+    data.fish.assign(3, base);
+    data.fish[0].taggedTime = 0;
+    data.fish[0].exitTime = 4;
+    data.fish[0].finalStatus = (int32_t) FishStatus::DeadMortality;
+    data.fish[0].finalMass = 3.0f;
+    data.fish[1].taggedTime = 2;
+    data.fish[2].taggedTime = 1;
+    data.fish[2].exitTime = 3;
+    data.fish[2].finalStatus = (int32_t) FishStatus::Exited;
+    data.locationHistory = {
+        0, 1, 1, 2, -1, -1,
+        -1, -1, 2, 2, 0, 1,
+        -1, 0, 1, -1, -1, -1
+    };
+    std::vector<std::vector<float> *> columns = {
+        &data.growthHistory, &data.pmaxHistory, &data.mortalityHistory, &data.tempHistory, &data.depthHistory,
+        &data.flowSpeedHistory, &data.flowVelocityUHistory, &data.flowVelocityVHistory
+    };
+    for (size_t c = 0; c < columns.size(); ++c) {
+        columns[c]->resize(data.numFish * T);
+        for (size_t i = 0; i < data.numFish * T; ++i) {
+            // Encode fish, timestep and column so records can be traced back
+            (*columns[c])[i] = (float) (100 * (i / T) + 10 * (i % T) + c) * 0.01f;
+        }
+    }
+    return data;
+}
+
+struct ReplayFileFixture {
+    std::string path;
+    TaggedHistoryData data;
+
+    ReplayFileFixture() : data(makeHistories()) {
+        path = (std::filesystem::temp_directory_path() / "whidbey_replay_store_test.replay").string();
+        ReplayStore::write(data, path);
+    }
+
+    ~ReplayFileFixture() {
+        std::filesystem::remove(path);
+    }
+};
+
+TEST_CASE("ReplayStore indexes tagged histories by timestep", "[replay_store]") {
+    ReplayFileFixture fixture;
+    REQUIRE(ReplayStore::isReplayFile(fixture.path));
+    ReplayStore store(fixture.path);
+    REQUIRE(store.getNumFish() == 3);
+    REQUIRE(store.getNumTimesteps() == 6);
+
+    SECTION("Each timestep lists exactly the active fish with their fields") {
+        const size_t T = fixture.data.numTimesteps;
+        for (long t = 0; t < 6; ++t) {
+            size_t begin, end;
+            store.getTimestepRange(t, begin, end);
+            std::vector<uint32_t> ids(store.getFishIds() + begin, store.getFishIds() + end);
+            std::vector<uint32_t> expected;
+            for (uint32_t n = 0; n < 3; ++n) {
+                if (t >= fixture.data.fish[n].taggedTime && fixture.data.locationHistory[n * T + t] != -1) {
+                    expected.push_back(n);
+                }
+            }
+            std::sort(ids.begin(), ids.end());
+            REQUIRE(ids == expected);
+            for (size_t r = begin; r < end; ++r) {
+                size_t i = store.getFishIds()[r] * T + t;
+                REQUIRE(store.getLocations()[r] == fixture.data.locationHistory[i]);
+                REQUIRE(store.getColumn(ReplayColumn::Growth)[r] == fixture.data.growthHistory[i]);
+                REQUIRE(store.getColumn(ReplayColumn::FlowVelocityV)[r] == fixture.data.flowVelocityVHistory[i]);
+            }
+        }
+    }
+
+    SECTION("Timesteps outside the histories are empty") {
+        size_t begin, end;
+        store.getTimestepRange(-1, begin, end);
+        REQUIRE(begin == end);
+        store.getTimestepRange(6, begin, end);
+        REQUIRE(begin == end);
+    }
+
+    SECTION("Mass is back-calculated from the final mass and growth") {
+        std::vector<float> masses(4);
+        for (long t = 0; t < 4; ++t) {
+            size_t begin, end;
+            store.getTimestepRange(t, begin, end);
+            for (size_t r = begin; r < end; ++r) {
+                if (store.getFishIds()[r] == 0U) {
+                    masses[t] = store.getColumn(ReplayColumn::Mass)[r];
+                }
+            }
+        }
+        REQUIRE(masses[3] == 3.0f);
+        for (long t = 3; t > 0; --t) {
+            REQUIRE(masses[t - 1] == masses[t] - fixture.data.growthHistory[t]);
+        }
+        REQUIRE(store.getFish(0).finalLocation == 2);
+    }
+
+    SECTION("Exit counts by timestep") {
+        REQUIRE(store.getExitOrder() == std::vector<uint32_t>{2U, 0U});
+        REQUIRE(store.getDeadCountAt(3) == 0);
+        REQUIRE(store.getExitedCountAt(3) == 1);
+        REQUIRE(store.getDeadCountAt(4) == 1);
+        REQUIRE(store.getExitedCountAt(5) == 1);
+    }
+}
+
+TEST_CASE("ReplayStore rejects files in other formats", "[replay_store]") {
+    std::string path = (std::filesystem::temp_directory_path() / "whidbey_replay_store_test.txt").string();
+    {
+        std::ofstream out(path);
+        out << "not a replay file";
+    }
+    REQUIRE_FALSE(ReplayStore::isReplayFile(path));
+    REQUIRE_THROWS_AS(ReplayStore(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Model::setHistoryTimestep seeks to any timestep of a replay", "[replay_store]") {
+    ReplayFileFixture fixture;
+    MockHydroModel hydroModel;
+    Model model(&hydroModel);
+    for (int i = 0; i < 3; ++i) {
+        MapNode *node = new MapNode(HabitatType::Distributary, 4.0f, 0.0f, 0.0f);
+        node->id = i;
+        node->area = 1.0f;
+        model.map.push_back(node);
+    }
+    model.loadTaggedHistories(fixture.path);
+    REQUIRE(model.individuals.size() == 3);
+    REQUIRE(model.time == 0);
+    REQUIRE(model.livingIndividuals == std::vector<size_t>{0});
+
+    // Jump around in both directions and compare against the source arrays
+    const size_t T = fixture.data.numTimesteps;
+    for (long t : {4L, 1L, 5L, 2L, 3L, 0L, 2L}) {
+        model.setHistoryTimestep(t);
+        REQUIRE(model.time == t);
+        std::vector<size_t> living = model.livingIndividuals;
+        std::sort(living.begin(), living.end());
+        std::vector<size_t> expected;
+        std::vector<size_t> residents(3, 0);
+        for (size_t n = 0; n < 3; ++n) {
+            int loc = fixture.data.locationHistory[n * T + t];
+            if (t >= fixture.data.fish[n].taggedTime && loc != -1) {
+                expected.push_back(n);
+                ++residents[loc];
+                REQUIRE(model.individuals[n].location == model.map[loc]);
+                REQUIRE(model.individuals[n].status == FishStatus::Alive);
+                REQUIRE(model.individuals[n].lastTemp == fixture.data.tempHistory[n * T + t]);
+            } else if (fixture.data.fish[n].exitTime != -1 && t >= fixture.data.fish[n].exitTime) {
+                REQUIRE(model.individuals[n].status == (FishStatus) fixture.data.fish[n].finalStatus);
+            } else {
+                REQUIRE(model.individuals[n].status == FishStatus::Alive);
+            }
+        }
+        REQUIRE(living == expected);
+        for (size_t loc = 0; loc < 3; ++loc) {
+            REQUIRE(model.map[loc]->residentIds.size() == residents[loc]);
+            REQUIRE(model.map[loc]->popDensity == (float) residents[loc]);
+        }
+        REQUIRE(model.deadCount == (t >= 4 ? 1 : 0));
+        REQUIRE(model.exitedCount == (t >= 3 ? 1 : 0));
+    }
+}
+
+TEST_CASE("Converted replay files are found again in the temp directory", "[replay_store]") {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "whidbey_replay_cache_test";
+    std::filesystem::create_directories(dir);
+    const std::string historyPath = (dir / "histories.nc").string();
+    std::ofstream(historyPath) << "histories";
+
+    std::vector<std::string> paths = ReplayStore::cachePaths(historyPath);
+    REQUIRE(paths.size() == 2);
+    REQUIRE(paths[0] == historyPath + ".replay");
+    REQUIRE(std::filesystem::path(paths[1]).parent_path() == std::filesystem::temp_directory_path());
+    // The same history file maps to the same fallback on every load...
+    REQUIRE(ReplayStore::cachePaths(historyPath) == paths);
+    // ...but a different one, or the same one changed since, doesn't reuse it
+    const std::string otherPath = (dir / "other.nc").string();
+    REQUIRE(ReplayStore::cachePaths(otherPath)[1] != paths[1]);
+    std::filesystem::last_write_time(historyPath,
+                                     std::filesystem::last_write_time(historyPath) + std::chrono::seconds(5));
+    REQUIRE(ReplayStore::cachePaths(historyPath)[1] != paths[1]);
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+#include "simulation_server.h"
+#include "test_utilities.h"
+
+// Two connected locations with a recruit entry point and a sampling site, owned by the model
+struct ServerTestFixture : RecruitingModel {
+    ServerTestFixture() : RecruitingModel(pairedMap(), {0}) {
+        model->recCounts.assign(30, 6);
+        SamplingSite *site = new SamplingSite("site", 0);
+        site->points = {model->map[0], model->map[1]};
+        model->samplingSites.push_back(site);
+    }
+
+    SimulationJob job(const std::string &id, unsigned int seed) const {
+        SimulationJob job;
+        job.id = id;
+        job.seed = seed;
+        job.steps = 36;
+        job.mortConstA = model->mortConstA;
+        job.mortConstC = model->mortConstC;
+        job.config = model->getConfigMap();
+        return job;
+    }
+};
+
+TEST_CASE("runSimulationJob resets the model and reproduces seeded runs", "[simulation_server]") {
+    ServerTestFixture fixture;
+    std::atomic<bool> cancelled(false);
+
+    SimulationJob job = fixture.job("a", 1234U);
+    job.config.set(ModelParamKey::GrowthSlope, 0.001f);
+    SimulationResult first = runSimulationJob(*fixture.model, job, cancelled);
+    REQUIRE(first.status == "done");
+    REQUIRE(first.id == "a");
+    REQUIRE(first.time == 36);
+    REQUIRE(first.samples.size() == 1);
+    REQUIRE(first.samples[0].time == 12);
+    REQUIRE(fixture.model->getFloat(ModelParamKey::GrowthSlope) == 0.001f);
+    REQUIRE(fixture.model->individuals.size() >= 6);
+
+    // A different run in between doesn't affect the repeat
+    runSimulationJob(*fixture.model, fixture.job("b", 99U), cancelled);
+    SimulationResult second = runSimulationJob(*fixture.model, job, cancelled);
+    REQUIRE(second.time == first.time);
+    REQUIRE(second.living == first.living);
+    REQUIRE(second.dead == first.dead);
+    REQUIRE(second.samples[0].population == first.samples[0].population);
+    REQUIRE(second.samples[0].meanLength == first.samples[0].meanLength);
+
+    cancelled = true;
+    SimulationResult stopped = runSimulationJob(*fixture.model, job, cancelled);
+    REQUIRE(stopped.status == "cancelled");
+    REQUIRE(stopped.time == 0);
+}
+
+TEST_CASE("SimulationServer bounds its queue and cancels jobs", "[simulation_server]") {
+    std::atomic<bool> release(false);
+    std::atomic<int> started(0);
+    auto runner = [&](const SimulationJob &job, const std::atomic<bool> &cancelled) {
+        ++started;
+        while (!release && !cancelled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        SimulationResult result;
+        result.id = job.id;
+        result.status = cancelled ? "cancelled" : "done";
+        return result;
+    };
+    std::mutex resultsMutex;
+    std::vector<SimulationResult> results;
+    auto collect = [&](const SimulationResult &result) {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        results.push_back(result);
+    };
+    auto waitForResults = [&](size_t count) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            if (results.size() >= count) {
+                return;
+            }
+        }
+    };
+
+    SimulationServer server(runner, 1);
+    SimulationJob job;
+    job.id = "running";
+    REQUIRE(server.submit(job, collect));
+    while (started == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    job.id = "queued";
+    REQUIRE(server.submit(job, collect));
+    REQUIRE(server.getQueueLength() == 1);
+    // Full queue, and IDs already in use, are refused
+    job.id = "extra";
+    REQUIRE_FALSE(server.submit(job, collect));
+    job.id = "running";
+    REQUIRE_FALSE(server.submit(job, collect));
+
+    REQUIRE(server.cancel("queued"));
+    REQUIRE_FALSE(server.cancel("unknown"));
+    REQUIRE(server.getQueueLength() == 0);
+    REQUIRE(server.cancel("running"));
+    waitForResults(2);
+    {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].id == "queued");
+        REQUIRE(results[0].status == "cancelled");
+        REQUIRE(results[1].id == "running");
+        REQUIRE(results[1].status == "cancelled");
+    }
+
+    release = true;
+    job.id = "next";
+    REQUIRE(server.submit(job, collect));
+    waitForResults(3);
+    std::lock_guard<std::mutex> lock(resultsMutex);
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[2].status == "done");
+}
+
+TEST_CASE("Server replies are single JSON lines", "[simulation_server]") {
+    SimulationResult result;
+    result.id = "run-7";
+    result.status = "error";
+    result.message = "bad \"value\"\nhere";
+    result.samples.emplace_back(2, 12L, 5, 1.5f, 41.0f, 3.0f);
+    std::string line = formatSimulationResult(result);
+    REQUIRE(line.find('\n') == std::string::npos);
+    REQUIRE(line.find("\"message\":\"bad \\\"value\\\"\\u000ahere\"") != std::string::npos);
+    REQUIRE(line.find("\"samples\":[{\"site\":2,\"time\":12,\"population\":5") != std::string::npos);
+    REQUIRE(formatServerReply("x", "busy", "") == "{\"id\":\"x\",\"status\":\"busy\"}");
+}
@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <memory>
+
+#include "model.h"
+#include "size_sketch.h"
+#include "test_utilities.h"
+
+TEST_CASE("Histograms bin weighted values and merge", "[size_sketch]") {
+    FixedHistogram histogram(30.0f, 5.0f, 4);
+    histogram.add(31.0f, 1.0f);
+    histogram.add(35.0f, 2.0f);
+    // Out of range values go in the end bins
+    histogram.add(10.0f, 0.5f);
+    histogram.add(99.0f, 3.0f);
+    REQUIRE(histogram.getCounts() == std::vector<float>{1.5f, 2.0f, 0.0f, 3.0f});
+
+    FixedHistogram other(30.0f, 5.0f, 4);
+    other.add(42.0f, 1.0f);
+    histogram.merge(other);
+    REQUIRE(histogram.getCounts() == std::vector<float>{1.5f, 2.0f, 1.0f, 3.0f});
+    REQUIRE_THROWS_AS(histogram.merge(FixedHistogram(30.0f, 1.0f, 4)), std::runtime_error);
+}
+
+TEST_CASE("t-digest quantiles are accurate, bounded in size and mergeable", "[size_sketch]") {
+    TDigest digest;
+    TDigest firstHalf, secondHalf;
+    for (int i = 1; i <= 10000; ++i) {
+        // Interleaved, so neither half is a contiguous range
+        int value = (i * 7919) % 10000 + 1;
+        digest.add((float) value, 1.0f);
+        (i % 2 ? firstHalf : secondHalf).add((float) value, 1.0f);
+    }
+    digest.compress();
+    REQUIRE(digest.getCentroids().size() <= digest.capacity());
+    REQUIRE(digest.getTotalWeight() == 10000.0);
+    REQUIRE(digest.quantile(0.0f) == 1.0f);
+    REQUIRE(digest.quantile(1.0f) == 10000.0f);
+    for (float q : {0.01f, 0.1f, 0.5f, 0.9f, 0.99f}) {
+        REQUIRE(digest.quantile(q) == Catch::Approx(10000.0f * q).margin(10000.0f * 0.005f));
+    }
+
+    firstHalf.merge(secondHalf);
+    REQUIRE(firstHalf.getCentroids().size() <= firstHalf.capacity());
+    REQUIRE(firstHalf.getTotalWeight() == 10000.0);
+    for (float q : {0.05f, 0.5f, 0.95f}) {
+        REQUIRE(firstHalf.quantile(q) == Catch::Approx(digest.quantile(q)).margin(10000.0f * 0.005f));
+    }
+
+    // A weighted value counts as that many copies
+    TDigest weighted;
+    weighted.add(10.0f, 3.0f);
+    weighted.add(20.0f, 1.0f);
+    REQUIRE(weighted.quantile(0.25f) == 10.0f);
+    REQUIRE(weighted.quantile(0.99f) > 15.0f);
+    REQUIRE(TDigest().quantile(0.5f) == 0.0f);
+}
+
+TEST_CASE("Sampling records weighted size distributions", "[size_sketch]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    Model model(hydroModel.get());
+    MapNode *node = new MapNode(HabitatType::Distributary, 1000.0f, 0.0f, 0.0f);
+    model.map = {node};
+    SamplingSite *site = new SamplingSite("site", 0);
+    site->points = {node};
+    model.samplingSites = {site};
+    model.individuals.emplace_back(0UL, 0L, 41.0f, node, 3.0f);
+    model.individuals.emplace_back(1UL, 0L, 52.0f, node, 1.0f);
+    model.individuals[0].mass = 0.6f;
+    model.individuals[1].mass = 1.1f;
+    model.livingIndividuals = {0, 1};
+    model.countAll(false);
+    model.sampling();
+
+    REQUIRE(model.sampleHistory.size() == 1);
+    const SizeSketch &sizes = model.sampleHistory[0].sizes;
+    REQUIRE(sizes.lengthHistogram.getCounts()[2] == 3.0f);
+    REQUIRE(sizes.lengthHistogram.getCounts()[4] == 1.0f);
+    REQUIRE(sizes.massHistogram.getCounts()[2] == 3.0f);
+    REQUIRE(sizes.massHistogram.getCounts()[4] == 1.0f);
+    REQUIRE(sizes.lengthDigest.getTotalWeight() == 4.0);
+    REQUIRE(sizes.lengthDigest.quantile(0.25f) == 41.0f);
+
+    // Sketches of separate samples merge into the sketch of all their fish
+    SizeSketch pooled = sizes;
+    pooled.merge(sizes);
+    REQUIRE(pooled.lengthHistogram.getCounts()[2] == 6.0f);
+    REQUIRE(pooled.massDigest.getTotalWeight() == 8.0);
+}
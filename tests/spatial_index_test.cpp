@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <memory>
+#include <limits>
+#include <random>
+
+#include "map.h"
+#include "spatial_index.h"
+#include "test_utilities.h"
+
+// Random map: nodes scattered over a 1km x 500m area, each linked to its predecessor
+struct SpatialTestMap {
+    std::vector<std::unique_ptr<MapNode>> owned;
+    std::vector<MapNode *> map;
+
+    explicit SpatialTestMap(size_t count, unsigned seed = 7) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> xDist(500000.0f, 501000.0f);
+        std::uniform_real_distribution<float> yDist(5350000.0f, 5350500.0f);
+        for (size_t i = 0; i < count; ++i) {
+            owned.push_back(createMapNode(xDist(rng), yDist(rng)));
+            owned.back()->id = (int) i;
+            map.push_back(owned.back().get());
+            if (i > 0) {
+                connectNodes(map[i - 1], map[i], getDistance(map[i - 1], map[i]));
+            }
+        }
+    }
+};
+
+TEST_CASE("SpatialGrid::queryNodes matches a brute-force scan", "[spatial_index]") {
+    SpatialTestMap t(2000);
+    SpatialGrid grid(t.map);
+
+    std::vector<int> found;
+    grid.queryNodes(500200.0f, 5350100.0f, 500450.0f, 5350300.0f, found);
+    std::sort(found.begin(), found.end());
+
+    std::vector<int> expected;
+    for (size_t i = 0; i < t.map.size(); ++i) {
+        MapNode *n = t.map[i];
+        if (n->x >= 500200.0f && n->x <= 500450.0f && n->y >= 5350100.0f && n->y <= 5350300.0f) {
+            expected.push_back((int) i);
+        }
+    }
+    REQUIRE_FALSE(expected.empty());
+    REQUIRE(found == expected);
+
+    SECTION("Rectangles outside the map return nothing") {
+        std::vector<int> none;
+        grid.queryNodes(0.0f, 0.0f, 10.0f, 10.0f, none);
+        REQUIRE(none.empty());
+    }
+}
+
+TEST_CASE("SpatialGrid::querySegments returns every overlapping segment once", "[spatial_index]") {
+    SpatialTestMap t(500);
+    SpatialGrid grid(t.map, 25.0f);
+    REQUIRE(grid.getSegments().size() == 499);
+
+    float qx0 = 500300.0f, qy0 = 5350200.0f, qx1 = 500400.0f, qy1 = 5350260.0f;
+    std::vector<size_t> found;
+    grid.querySegments(qx0, qy0, qx1, qy1, found);
+    REQUIRE(std::is_sorted(found.begin(), found.end()));
+    REQUIRE(std::adjacent_find(found.begin(), found.end()) == found.end());
+
+    for (size_t si = 0; si < grid.getSegments().size(); ++si) {
+        const MapSegment &s = grid.getSegments()[si];
+        MapNode *a = t.map[s.sourceIndex];
+        MapNode *b = t.map[s.targetIndex];
+        bool overlaps = std::max(a->x, b->x) >= qx0 && std::min(a->x, b->x) <= qx1
+            && std::max(a->y, b->y) >= qy0 && std::min(a->y, b->y) <= qy1;
+        if (overlaps) {
+            REQUIRE(std::binary_search(found.begin(), found.end(), si));
+        }
+    }
+}
+
+TEST_CASE("SpatialGrid::nearestNode matches a brute-force search", "[spatial_index]") {
+    SpatialTestMap t(1000, 11);
+    SpatialGrid grid(t.map);
+    std::mt19937 rng(3);
+    // Include query points outside the map's bounding box
+    std::uniform_real_distribution<float> xDist(499800.0f, 501200.0f);
+    std::uniform_real_distribution<float> yDist(5349800.0f, 5350700.0f);
+    for (int q = 0; q < 200; ++q) {
+        float x = xDist(rng);
+        float y = yDist(rng);
+        int best = 0;
+        float bestDist = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < t.map.size(); ++i) {
+            float dx = t.map[i]->x - x;
+            float dy = t.map[i]->y - y;
+            if (dx*dx + dy*dy < bestDist) {
+                bestDist = dx*dx + dy*dy;
+                best = (int) i;
+            }
+        }
+        REQUIRE(grid.nearestNode(x, y) == best);
+    }
+
+    SECTION("Empty map") {
+        std::vector<MapNode *> empty;
+        SpatialGrid emptyGrid(empty);
+        REQUIRE(emptyGrid.nearestNode(0.0f, 0.0f) == -1);
+    }
+}
+
+TEST_CASE("SpatialGrid records segment colours and dangling edges", "[spatial_index]") {
+    auto a = createMapNode(0.0f, 0.0f, HabitatType::DistributaryEdge);
+    auto b = createMapNode(10.0f, 0.0f, HabitatType::DistributaryEdge);
+    auto c = createMapNode(20.0f, 0.0f, HabitatType::BlindChannel);
+    auto outside = createMapNode(30.0f, 0.0f);
+    connectNodes(a.get(), b.get(), 10.0f);
+    connectNodes(c.get(), b.get(), 10.0f);
+    connectNodes(c.get(), outside.get(), 10.0f);
+    std::vector<MapNode *> map{a.get(), b.get(), c.get()};
+
+    SpatialGrid grid(map);
+    REQUIRE(grid.getSegments().size() == 2);
+    REQUIRE(grid.getSegments()[0].type == HabitatType::DistributaryEdge);
+    REQUIRE(grid.getSegments()[1].type == HabitatType::BlindChannel);
+    REQUIRE(grid.getDanglingNodes() == std::vector<int>{2});
+}
@@ -0,0 +1,111 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <memory>
+
+#include "model.h"
+#include "test_utilities.h"
+
+// Two connected Distributary locations (no exits, no stranding), with recruits entering at the first
+struct SuperIndividualFixture : RecruitingModel {
+    explicit SuperIndividualFixture(int superIndividualSize) : RecruitingModel(pairedMap(), {0}) {
+        model->recSizeDists.assign(5, {1.0f, 1.0f});
+        configure(ModelParamKey::SuperIndividualSize, superIndividualSize);
+        GlobalRand::reseed(17U);
+    }
+};
+
+TEST_CASE("Super-individual recruits are grouped by entry point and size bucket", "[super_individual]") {
+    SuperIndividualFixture fixture(10);
+    Model &model = *fixture.model;
+    model.recDayPlan[0] = 45;
+    model.recruit();
+
+    // 45 recruits in two size buckets at one entry point: each bucket's recruits are split evenly
+    // over as few agents as hold at most 10
+    REQUIRE(model.livingIndividuals.size() >= 5);
+    REQUIRE(model.livingIndividuals.size() <= 6);
+    float total = 0.0f;
+    for (size_t id : model.livingIndividuals) {
+        const Fish &f = model.individuals[id];
+        REQUIRE(f.weight <= 10.0f);
+        REQUIRE(f.weight > 5.0f);
+        REQUIRE(f.location == model.map[0]);
+        total += f.weight;
+    }
+    REQUIRE(total == Catch::Approx(45.0f));
+}
+
+TEST_CASE("Super-individual density and sampling are weighted", "[super_individual]") {
+    SuperIndividualFixture fixture(10);
+    Model &model = *fixture.model;
+    model.individuals.emplace_back(0UL, 0L, 40.0f, model.map[0], 3.0f);
+    model.individuals.emplace_back(1UL, 6L, 60.0f, model.map[0], 1.0f);
+    model.individuals[0].mass = 1.0f;
+    model.individuals[1].mass = 5.0f;
+    model.livingIndividuals = {0, 1};
+    SamplingSite *site = new SamplingSite("site", 0);
+    site->points = {model.map[0]};
+    model.samplingSites.push_back(site);
+
+    model.countAll(false);
+    REQUIRE(model.map[0]->residentWeight == 4.0f);
+    REQUIRE(model.map[0]->popDensity == Catch::Approx(4.0f / 1000.0f));
+    REQUIRE(model.map[1]->popDensity == 0.0f);
+
+    model.sampling();
+    REQUIRE(model.sampleHistory.size() == 1);
+    const Sample &s = model.sampleHistory[0];
+    REQUIRE(s.population == 4);
+    REQUIRE(s.meanMass == Catch::Approx((3.0f * 1.0f + 5.0f) / 4.0f));
+    REQUIRE(s.meanLength == Catch::Approx((3.0f * 40.0f + 60.0f) / 4.0f));
+    REQUIRE(s.meanSpawnTime == Catch::Approx(6.0f / 4.0f));
+}
+
+TEST_CASE("Mortality thins super-individuals instead of removing them", "[super_individual]") {
+    SuperIndividualFixture fixture(100);
+    Model &model = *fixture.model;
+    model.individuals.emplace_back(0UL, 0L, 50.0f, model.map[0], 100.0f);
+    model.livingIndividuals = {0};
+    model.countAll(false);
+
+    Fish &f = model.individuals[0];
+    const float mortality = f.getMortality(model, *f.location);
+    REQUIRE(mortality > 0.0f);
+    REQUIRE(mortality < 0.99f);
+    REQUIRE(f.growAndDie(model));
+    REQUIRE(f.status == FishStatus::Alive);
+    REQUIRE(f.weight == Catch::Approx(100.0f * (1.0f - mortality)));
+    REQUIRE(f.lostWeight == Catch::Approx(100.0f * mortality));
+}
+
+TEST_CASE("Super-individual runs conserve abundance through splits and thinning", "[super_individual]") {
+    SuperIndividualFixture fixture(16);
+    Model &model = *fixture.model;
+    model.recCounts.assign(30, 200);
+    model.reset();
+    for (int i = 0; i < 72; ++i) {
+        model.masterUpdate();
+    }
+    // Distributary-only map with water everywhere: nothing exits or strands, so every recruit is
+    // living or dead
+    REQUIRE(model.exitedAbundance == 0.0);
+    REQUIRE(model.livingAbundance + model.deadAbundance == Catch::Approx(3 * 200.0).epsilon(1e-4));
+    double living = 0.0;
+    for (size_t id : model.livingIndividuals) {
+        const Fish &f = model.individuals[id];
+        REQUIRE(f.weight >= 1.0f);
+        REQUIRE(f.weight <= 16.0f);
+        living += f.weight;
+    }
+    REQUIRE(living == Catch::Approx(model.livingAbundance).epsilon(1e-5));
+    REQUIRE(model.populationHistory.back() == (int) std::lround(model.livingAbundance));
+    // Far fewer agents than fish
+    REQUIRE(model.individuals.size() < 3 * 200 / 2);
+}
+
+TEST_CASE("superIndividualSize must be positive", "[super_individual]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::SuperIndividualSize) == 1);
+    config.set(ModelParamKey::SuperIndividualSize, 0);
+    REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "model.h"
+#include "telemetry.h"
+#include "test_utilities.h"
+
+static std::string tempSocketPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static int connectReader(const std::string &path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    REQUIRE(connect(fd, (sockaddr *) &addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+static void waitForReaders(const TelemetryServer &server, size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.getNumReaders() != count && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(server.getNumReaders() == count);
+}
+
+// Read from fd until the received text contains `until` (or a few seconds pass)
+static std::string readUntil(int fd, const std::string &until) {
+    std::string received;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    char buf[4096];
+    while (received.find(until) == std::string::npos && std::chrono::steady_clock::now() < deadline) {
+        pollfd p{fd, POLLIN, 0};
+        if (poll(&p, 1, 100) > 0) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            received.append(buf, (size_t) n);
+        }
+    }
+    return received;
+}
+
+TEST_CASE("TelemetryServer sends records to every attached reader", "[telemetry]") {
+    std::string path = tempSocketPath("whidbey_telemetry_test.sock");
+    TelemetryServer server(path);
+    server.publish("{\"before\":true}");
+    int a = connectReader(path);
+    int b = connectReader(path);
+    waitForReaders(server, 2);
+
+    server.publish("{\"time\":1}");
+    server.publish("{\"time\":2}");
+    REQUIRE(readUntil(a, "{\"time\":2}\n") == "{\"time\":1}\n{\"time\":2}\n");
+    REQUIRE(readUntil(b, "{\"time\":2}\n") == "{\"time\":1}\n{\"time\":2}\n");
+
+    // Readers can detach without affecting the others
+    close(b);
+    server.publish("{\"time\":3}");
+    REQUIRE(readUntil(a, "{\"time\":3}\n") == "{\"time\":3}\n");
+    waitForReaders(server, 1);
+    close(a);
+}
+
+TEST_CASE("TelemetryServer drops the oldest records for a reader that falls behind", "[telemetry]") {
+    std::string path = tempSocketPath("whidbey_telemetry_slow_test.sock");
+    TelemetryServer server(path, 8);
+    int slow = connectReader(path);
+    waitForReaders(server, 1);
+
+    // Far more than the socket buffers hold, published while the reader reads nothing
+    const std::string padding(4096, 'x');
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 2000; ++i) {
+        server.publish("{\"seq\":" + std::to_string(i) + ",\"pad\":\"" + padding + "\"}");
+    }
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    std::string received = readUntil(slow, "{\"seq\":1999,");
+    REQUIRE(received.find("{\"seq\":1999,") != std::string::npos);
+    REQUIRE(server.getNumDropped() > 0);
+    close(slow);
+}
+
+TEST_CASE("formatStepRecord reports counts, timings and new samples", "[telemetry]") {
+    MockHydroModel hydroModel;
+    Model model(&hydroModel);
+    model.time = 37;
+    model.deadCount = 4;
+    model.exitedCount = 2;
+    model.lastStepTimings.move = 0.5;
+    model.sampleHistory.emplace_back(1, 12L, 3, 2.0f, 40.0f, 5.0f);
+    model.sampleHistory.emplace_back(2, 36L, 0, 0.0f, 0.0f, 0.0f);
+
+    std::string record = formatStepRecord(model, 7, 0.75, 1);
+    REQUIRE(record.find("\"run\":7,\"time\":37,\"living\":0,\"exited\":2,\"dead\":4,\"stepSeconds\":0.75") != std::string::npos);
+    REQUIRE(record.find("\"move\":0.5") != std::string::npos);
+    REQUIRE(record.find("\"samples\":[{\"site\":2,\"time\":36,\"population\":0") != std::string::npos);
+    REQUIRE(record.find("\"site\":1") == std::string::npos);
+    REQUIRE(record.find('\n') == std::string::npos);
+}
+
+TEST_CASE("formatStartupRecord reports the input loading phases", "[telemetry]") {
+    MockHydroModel hydroModel;
+    Model model(&hydroModel);
+    model.startupTimings.map = 1.5;
+    model.startupTimings.hydroGrid = 2.0;
+    model.startupTimings.total = 2.25;
+
+    std::string record = formatStartupRecord(model, 7);
+    REQUIRE(record.find("{\"run\":7,\"startup\":{\"hydroTables\":0,\"hydroGrid\":2,\"map\":1.5") == 0);
+    REQUIRE(record.find("\"total\":2.25}}") != std::string::npos);
+    REQUIRE(record.find('\n') == std::string::npos);
+}
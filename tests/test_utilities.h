@@ -5,8 +5,10 @@
 #ifndef TEST_UTILITIES_H
 #define TEST_UTILITIES_H
 
+#include <cmath>
 #include <memory>
 #include <functional>
+#include <unordered_set>
 
 #include "hydro.h"
 #include "map.h"
@@ -21,17 +23,28 @@ public:
     float getCurrentV(const MapNode& node) const override { return vValue; }
     float getDepth(MapNode& node) override { return depthValue; }
     float getTemp(MapNode& node) override { return tempValue; }
+    bool isHighTide() override {
+        for (long t = getTime(); t < getTime() + getStepHours(); ++t) {
+            if (highTideHours.count(t) > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    float getMaxFlowSpeed() const override { return std::sqrt(uValue * uValue + vValue * vValue); }
 
     // Values to be set in tests
     float uValue = 0.0f;
     float vValue = 0.0f;
     float depthValue = 1.0f;
     float tempValue = 10.0f;
+    std::unordered_set<long> highTideHours;
 
 private:
-    std::vector<MapNode *> empty_nodes_;
-    std::vector<std::vector<float>> empty_depths_;
-    std::vector<std::vector<float>> empty_temps_;
+    // Static, since they're passed to the base constructor before any non-static members exist
+    static inline std::vector<MapNode *> empty_nodes_;
+    static inline std::vector<std::vector<float>> empty_depths_;
+    static inline std::vector<std::vector<float>> empty_temps_;
 };
 
 // Helper function to create MapNodes for testing
@@ -55,6 +68,70 @@ inline void connectNodes(MapNode* nodeA, MapNode* nodeB, float length) {
     nodeB->edgesIn.push_back(edge);
 }
 
+// Two connected Distributary locations 1m apart
+inline std::vector<MapNode *> pairedMap() {
+    std::vector<MapNode *> map;
+    for (int i = 0; i < 2; ++i) {
+        MapNode *node = new MapNode(HabitatType::Distributary, 1000.0f, 0.0f, 0.0f);
+        node->id = i;
+        map.push_back(node);
+    }
+    connectNodes(map[0], map[1], 1.0f);
+    return map;
+}
+
+// A side x side grid of Distributary locations 10m apart
+inline std::vector<MapNode *> gridMap(int side) {
+    std::vector<MapNode *> map;
+    for (int i = 0; i < side * side; ++i) {
+        MapNode *node = new MapNode(HabitatType::Distributary, 1000.0f, 0.0f, 0.0f);
+        node->id = i;
+        node->x = 10.0f * (float) (i % side);
+        node->y = 10.0f * (float) (i / side);
+        map.push_back(node);
+    }
+    for (int i = 0; i < side * side; ++i) {
+        if (i % side + 1 < side) {
+            connectNodes(map[i], map[i + 1], 10.0f);
+        }
+        if (i + side < side * side) {
+            connectNodes(map[i], map[i + side], 10.0f);
+        }
+    }
+    return map;
+}
+
+// A model on mock hydrology that owns the given locations, with recruits entering at the given ones; nobody is
+// recruited until a test sets recCounts or recDayPlan
+struct RecruitingModel {
+    std::unique_ptr<MockHydroModel> hydroModel;
+    std::unique_ptr<Model> model;
+
+    RecruitingModel(std::vector<MapNode *> map, const std::vector<size_t> &recruitPoints) {
+        hydroModel = std::make_unique<MockHydroModel>();
+        model = std::make_unique<Model>(hydroModel.get());
+        model->map = std::move(map);
+        model->recCounts.assign(60, 0);
+        model->recSizeDists.assign(10, {1.0f, 1.0f, 1.0f});
+        for (size_t i : recruitPoints) {
+            model->recPoints.push_back(model->map[i]);
+        }
+        model->recDayPlan.resize(24, 0UL);
+    }
+
+    void configure(ModelParamKey key, const ConfigValue &value) {
+        ModelConfigMap config = model->getConfigMap();
+        config.set(key, value);
+        model->setConfigMap(config);
+    }
+
+    void runHours(long hours) {
+        while (model->getHour() < hours) {
+            model->masterUpdate();
+        }
+    }
+};
+
 // Helper to set depth for a node in the mock hydro model
 inline void setNodeDepth(MockHydroModel* hydroModel, float depth) {
     hydroModel->depthValue = depth;
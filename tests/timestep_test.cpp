@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cmath>
+#include <memory>
+
+#include "model.h"
+#include "test_utilities.h"
+
+// Two connected Distributary locations with a sampling site on the first
+struct TimestepFixture : RecruitingModel {
+    explicit TimestepFixture(int hoursPerTimestep) : RecruitingModel(pairedMap(), {0}) {
+        SamplingSite *site = new SamplingSite("site", 0);
+        site->points = {model->map[0]};
+        model->samplingSites.push_back(site);
+        configure(ModelParamKey::HoursPerTimestep, hoursPerTimestep);
+        GlobalRand::reseed(3U);
+    }
+};
+
+TEST_CASE("Multi-hour timesteps recruit every hour they cover", "[timestep]") {
+    TimestepFixture fixture(3);
+    Model &model = *fixture.model;
+    REQUIRE(model.getSecondsPerTimestep() == 3.0f * 3600.0f);
+    model.recDayPlan[0] = 1;
+    model.recDayPlan[1] = 2;
+    model.recDayPlan[2] = 3;
+    model.recDayPlan[3] = 4;
+    model.recruit();
+    REQUIRE(model.livingIndividuals.size() == 6);
+    model.time = 1;
+    REQUIRE(model.getHour() == 3);
+    model.recruit();
+    REQUIRE(model.livingIndividuals.size() == 10);
+}
+
+TEST_CASE("Growth, mortality and exit hours scale with the timestep", "[timestep]") {
+    TimestepFixture hourly(1);
+    TimestepFixture threeHourly(3);
+    for (TimestepFixture *fixture : {&hourly, &threeHourly}) {
+        fixture->model->individuals.emplace_back(0UL, 0L, 50.0f, fixture->model->map[0]);
+        fixture->model->individuals[0].mass = 1.0f;
+        fixture->model->livingIndividuals = {0};
+        fixture->model->countAll(false);
+    }
+    Fish &f1 = hourly.model->individuals[0];
+    Fish &f3 = threeHourly.model->individuals[0];
+    const float growth1 = f1.getGrowth(*hourly.model, *f1.location, 0.0f);
+    const float growth3 = f3.getGrowth(*threeHourly.model, *f3.location, 0.0f);
+    REQUIRE(growth3 == Catch::Approx(3.0f * growth1));
+    const float mortality1 = f1.getMortality(*hourly.model, *f1.location);
+    const float mortality3 = f3.getMortality(*threeHourly.model, *f3.location);
+    REQUIRE(mortality1 > 0.0f);
+    REQUIRE(mortality3 == Catch::Approx(1.0f - std::pow(1.0f - mortality1, 3.0f)));
+
+    f3.incrementExitHabitatHoursByOneTimestep(*threeHourly.model);
+    REQUIRE(f3.numExitHabitatHours == 3.0f);
+}
+
+TEST_CASE("Sampling happens in the step covering noon", "[timestep]") {
+    for (int hours : {1, 2, 3, 6}) {
+        TimestepFixture fixture(hours);
+        Model &model = *fixture.model;
+        model.reset();
+        while (model.getHour() < 24) {
+            model.masterUpdate();
+        }
+        REQUIRE(model.time == 24 / hours);
+        REQUIRE(model.sampleHistory.size() == 1);
+        REQUIRE(model.sampleHistory[0].time * hours == 12);
+    }
+}
+
+TEST_CASE("Fyke sampling finds a high tide in the middle of a step", "[timestep]") {
+    for (int hours : {1, 3, 6}) {
+        TimestepFixture fixture(hours);
+        Model &model = *fixture.model;
+        model.samplingCampaigns = {{{0}, 0L, 0L, SamplingMethod::Fyke}};
+        // The day's only high tide, inside the multi-hour step starting at hour 12
+        fixture.hydroModel->highTideHours = {13L};
+        model.reset();
+        while (model.getHour() < 24) {
+            model.masterUpdate();
+        }
+        REQUIRE(model.sampleHistory.size() == 1);
+        REQUIRE(model.sampleHistory[0].time * hours == 13 / hours * hours);
+    }
+}
+
+TEST_CASE("hoursPerTimestep must be 1, 2, 3 or 6", "[timestep]") {
+    ModelConfigMap config;
+    REQUIRE(config.getInt(ModelParamKey::HoursPerTimestep) == 1);
+    for (int hours : {0, 4, 5, 12}) {
+        config.set(ModelParamKey::HoursPerTimestep, hours);
+        REQUIRE_THROWS_AS(config.validate(), std::runtime_error);
+    }
+    config.set(ModelParamKey::HoursPerTimestep, 6);
+    REQUIRE_NOTHROW(config.validate());
+}
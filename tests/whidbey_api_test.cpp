@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "whidbey.h"
+#include "test_utilities.h"
+
+// A two-location model with recruitment and one sampling site, handed to the C API
+static wb_model *adoptTestModel(MockHydroModel *hydroModel) {
+    Model *model = new Model(hydroModel);
+    for (int i = 0; i < 2; ++i) {
+        MapNode *node = new MapNode(HabitatType::Distributary, 4.0f, 0.0f, 0.0f);
+        node->id = i;
+        node->area = 1000.0f;
+        model->map.push_back(node);
+    }
+    connectNodes(model->map[0], model->map[1], 1.0f);
+    model->recCounts.assign(30, 6);
+    model->recSizeDists.assign(5, {1.0f, 1.0f});
+    model->recPoints = {model->map[0]};
+    model->recDayPlan.resize(24, 0UL);
+    SamplingSite *site = new SamplingSite("site", 0);
+    site->points = {model->map[0], model->map[1]};
+    model->samplingSites.push_back(site);
+    return wb_model_adopt(model);
+}
+
+TEST_CASE("C API runs, resets and reads a model in place", "[whidbey_api]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    wb_model *model = adoptTestModel(hydroModel.get());
+    REQUIRE(model != nullptr);
+    REQUIRE(wb_api_version() == WB_API_VERSION);
+
+    REQUIRE(wb_model_reset(model, 42U) == WB_OK);
+    REQUIRE(wb_model_step(model, 36) == WB_OK);
+    long time = 0;
+    REQUIRE(wb_model_time(model, &time) == WB_OK);
+    REQUIRE(time == 36);
+
+    size_t living = 0, exited = 0, dead = 0;
+    REQUIRE(wb_model_counts(model, &living, &exited, &dead) == WB_OK);
+    REQUIRE(living + exited + dead >= 6);
+
+    wb_fish_columns columns;
+    REQUIRE(wb_model_fish_columns(model, &columns) == WB_OK);
+    REQUIRE(columns.count == living);
+    std::vector<float> masses;
+    for (size_t i = 0; i < columns.count; ++i) {
+        float mass = WB_FISH_VALUE(columns, mass, columns.living[i]);
+        REQUIRE(mass > 0.0f);
+        masses.push_back(mass);
+    }
+    std::vector<int> locations(living);
+    size_t written = 0;
+    REQUIRE(wb_model_fish_locations(model, locations.data(), locations.size(), &written) == WB_OK);
+    REQUIRE(written == living);
+    for (int id : locations) {
+        REQUIRE((id == 0 || id == 1));
+    }
+
+    size_t numSamples = 0;
+    wb_sample sample;
+    REQUIRE(wb_model_num_samples(model, &numSamples) == WB_OK);
+    REQUIRE(numSamples == 1);
+    REQUIRE(wb_model_get_sample(model, 0, &sample) == WB_OK);
+    REQUIRE(sample.time == 12);
+    REQUIRE(wb_model_get_sample(model, 1, &sample) == WB_ERROR_INVALID_ARGUMENT);
+
+    // The same seed repeats the run on the same inputs
+    REQUIRE(wb_model_reset(model, 42U) == WB_OK);
+    REQUIRE(wb_model_time(model, &time) == WB_OK);
+    REQUIRE(time == 0);
+    REQUIRE(wb_model_step(model, 36) == WB_OK);
+    REQUIRE(wb_model_fish_columns(model, &columns) == WB_OK);
+    REQUIRE(columns.count == masses.size());
+    for (size_t i = 0; i < columns.count; ++i) {
+        REQUIRE(WB_FISH_VALUE(columns, mass, columns.living[i]) == masses[i]);
+    }
+
+    wb_model_destroy(model);
+}
+
+TEST_CASE("C API parameters are typed, validated and limited to run-time ones", "[whidbey_api]") {
+    auto hydroModel = std::make_unique<MockHydroModel>();
+    wb_model *model = adoptTestModel(hydroModel.get());
+
+    float slope = 0.0f;
+    REQUIRE(wb_model_set_float(model, "growthSlope", 0.001f) == WB_OK);
+    REQUIRE(wb_model_get_float(model, "growthSlope", &slope) == WB_OK);
+    REQUIRE(slope == 0.001f);
+
+    char awareness[4];
+    size_t length = 0;
+    REQUIRE(wb_model_set_string(model, "agentAwareness", "high") == WB_OK);
+    REQUIRE(wb_model_get_string(model, "agentAwareness", awareness, sizeof(awareness), &length) == WB_OK);
+    REQUIRE(length == 4);
+    REQUIRE(std::string(awareness) == "hig");
+
+    REQUIRE(wb_model_set_string(model, "agentAwareness", "psychic") == WB_ERROR_MODEL);
+    REQUIRE(std::string(wb_last_error()).find("AgentAwareness") != std::string::npos);
+    REQUIRE(wb_model_get_string(model, "agentAwareness", awareness, sizeof(awareness), nullptr) == WB_OK);
+    REQUIRE(std::string(awareness) == "hig");
+
+    REQUIRE(wb_model_set_float(model, "noSuchParameter", 1.0f) == WB_ERROR_INVALID_ARGUMENT);
+    REQUIRE(wb_model_set_int(model, "growthSlope", 1) == WB_ERROR_INVALID_ARGUMENT);
+    REQUIRE(wb_model_set_int(model, "directionlessEdges", 0) == WB_ERROR_INVALID_ARGUMENT);
+    REQUIRE(std::string(wb_last_error()).find("only read when the inputs are loaded") != std::string::npos);
+    REQUIRE(wb_model_set_int(model, "processes", 4) == WB_ERROR_INVALID_ARGUMENT);
+    int directionless = -1;
+    REQUIRE(wb_model_get_int(model, "directionlessEdges", &directionless) == WB_OK);
+    REQUIRE(directionless == 1);
+
+    REQUIRE(wb_model_step(nullptr, 1) == WB_ERROR_INVALID_ARGUMENT);
+    wb_model *missing = nullptr;
+    REQUIRE(wb_model_create("/nonexistent/config.json", &missing) == WB_ERROR_MODEL);
+    REQUIRE(missing == nullptr);
+
+    wb_model_destroy(model);
+}